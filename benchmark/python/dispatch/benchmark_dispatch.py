@@ -0,0 +1,89 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Measures the per call overhead of small imperative operators with and without
+the imperative dispatch cache (MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE).
+
+Every configuration runs in its own process since the cache size is read when
+a thread first dispatches an operator. NaiveEngine runs the kernels inline, so
+the numbers are the full cost of a call on tiny arrays.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import timeit
+
+
+def workloads(mx):
+    a = mx.nd.ones((2, 2))
+    b = mx.nd.ones((2, 2))
+    out = mx.nd.zeros((2, 2))
+    return {
+        "elemwise_add": lambda: mx.nd.elemwise_add(a, b),
+        "broadcast_mul": lambda: mx.nd.broadcast_mul(a, b),
+        "relu": lambda: mx.nd.relu(a),
+        "sum(axis=0)": lambda: mx.nd.sum(a, axis=0),
+        "reshape": lambda: mx.nd.reshape(a, shape=(4,)),
+        "transpose": lambda: mx.nd.transpose(a),
+        "dot": lambda: mx.nd.dot(a, b),
+        "elemwise_add(out=)": lambda: mx.nd.elemwise_add(a, b, out=out),
+        "softmax": lambda: mx.nd.softmax(a, axis=-1),
+        "random_uniform": lambda: mx.nd.random.uniform(shape=(2, 2)),
+    }
+
+
+def run_worker(number, repeat):
+    import mxnet as mx
+    results = {}
+    for name, f in workloads(mx).items():
+        f()
+        mx.nd.waitall()
+        results[name] = min(timeit.repeat(f, number=number, repeat=repeat)) / number
+        mx.nd.waitall()
+    print(json.dumps(results))
+
+
+def run_config(cache_size, number, repeat):
+    env = dict(os.environ)
+    env["MXNET_ENGINE_TYPE"] = "NaiveEngine"
+    env["MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE"] = str(cache_size)
+    cmd = [sys.executable, __file__, "--worker",
+           "--number", str(number), "--repeat", str(repeat)]
+    output = subprocess.check_output(cmd, env=env).decode()
+    return json.loads(output.strip().splitlines()[-1])
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--number", type=int, default=10000,
+                        help="calls per measurement")
+    parser.add_argument("--repeat", type=int, default=5,
+                        help="measurements per operator, the fastest is reported")
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+    if args.worker:
+        run_worker(args.number, args.repeat)
+        sys.exit(0)
+
+    uncached = run_config(0, args.number, args.repeat)
+    cached = run_config(4096, args.number, args.repeat)
+    print("{:>24}{:>16}{:>16}{:>12}".format("operator", "uncached(us)", "cached(us)", "speedup"))
+    for name in uncached:
+        before, after = uncached[name] * 1e6, cached[name] * 1e6
+        print("{:>24}{:>16.2f}{:>16.2f}{:>11.2f}x".format(name, before, after, before / after))
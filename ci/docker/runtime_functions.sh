@@ -907,6 +907,7 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --no-multiprecision
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
+    python3 ../../tools/launch.py --p3 -n 4 --launcher local python3 dist_sync_kvstore.py --type=p3_slices_cpu
     python3 ../../tools/launch.py -n 3 --launcher local python3 test_server_profiling.py
     popd
 }
@@ -365,6 +365,39 @@ MXNET_DLL int MXDumpProfile(int finished);
 MXNET_DLL int MXAggregateProfileStatsPrint(const char **out_str, int reset, int format,
                                            int sort_by, int ascending);
 
+/*!
+ * \brief Enable or disable the always-on operator latency histograms
+ * \param enable whether to record the latency of every operator
+ * \param prev returns the previous state unless it is NULL
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileSetOpHistograms(int enable, int* prev);
+
+/*!
+ * \brief Print the operator latency histograms merged over threads to a JSON string
+ * \param out_str will receive a pointer to the output string
+ * \param reset whether the next dump only covers operators that complete after this one
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileDumpOpHistograms(const char **out_str, int reset);
+
+/*!
+ * \brief Record the time a DataLoader iterator blocked for a batch, when the
+ *  operator latency histograms are enabled
+ * \param wait_ns the time in nanoseconds
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileRecordDataLoaderWait(uint64_t wait_ns);
+
+/*!
+ * \brief Print the runtime metrics in the OpenMetrics text format: engine queue
+ *  depths, memory of the pooled storage managers, kvstore traffic and the latency
+ *  histograms of operators and DataLoader iterators
+ * \param out_str will receive a pointer to the output string
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileDumpMetrics(const char **out_str);
+
 /*!
  * \brief Pause profiler tuning collection
  * \param paused If nonzero, profiling pauses. Otherwise, profiling resumes/continues
@@ -501,6 +534,13 @@ MXNET_DLL int MXEngineSetBulkSize(int bulk_size, int* prev_bulk_size);
  */
 MXNET_DLL int MXGetGPUCount(int* out);
 
+/*!
+ * \brief Get the maximum number of weights one multi-tensor optimizer update accepts.
+ * \param out pointer to int that will hold the maximum
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXGetMultiTensorMaxWeights(int* out);
+
 /*!
  * \brief get the free and total available memory on a GPU
  *  Note: Deprecated, use MXGetGPUMemoryInformation64 instead.
@@ -1376,6 +1416,23 @@ MXNET_DLL int MXNDArrayIsDeferredCompute(int *curr);
  */
 MXNET_DLL int MXNDArraySetIsDeferredCompute(int deferred_compute_enabled, int *prev);
 
+/*!
+ * \brief Get current status of lazy mode
+ * \param curr returns the current status.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayIsLazy(int *curr);
+
+/*!
+ * \brief set whether to enable lazy mode, in which imperative operators are
+ *  recorded and run as a cached graph once one of their outputs is read.
+ *  Disabling it runs the operators recorded so far.
+ * \param lazy_enabled 1 to enable, 0 to disable.
+ * \param prev returns the previous status before this set.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySetIsLazy(int lazy_enabled, int *prev);
+
 /*!
  * \brief Associate variables with deferred compute arrays
  * \param arrays ndarray handles to be matched with variables
@@ -28,6 +28,7 @@
 #include <nnvm/graph.h>
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <utility>
 #include <string>
 #include <unordered_map>
@@ -50,6 +51,8 @@ namespace mxnet {
 /*! \brief runtime functions for NDArray */
 class Imperative {
  public:
+  /*! \brief operators recorded in lazy mode and not yet executed */
+  class LazyTrace;
   /*! \brief */
   class AGInfo {
    public:
@@ -155,6 +158,13 @@ class Imperative {
 
     /*! \brief Remember if the outputs associated with this DCInfo have been computed already */
     bool is_computed_ = false;
+
+    /*! \brief Trace that computes the outputs if they were recorded in lazy mode
+     *
+     * Computing any of its arrays executes the whole trace, after which the
+     * DCInfo is cleared and the arrays behave like eagerly computed ones.
+     */
+    std::shared_ptr<LazyTrace> lazy_trace_;
   };
 
   /*! \brief whether operator recording is on. */
@@ -185,6 +195,10 @@ class Imperative {
     is_deferred_compute_ = is_deferred_compute;
     return old;
   }
+  /*! \brief whether lazy mode is on. */
+  bool is_lazy() const { return is_lazy_; }
+  /*! \brief turn on or turn off lazy mode. Turning it off executes the pending trace. */
+  bool set_is_lazy(bool is_lazy);
   /*! \brief return current numpy compatibility status,
    *  GlobalOn(2), ThreadLocalOn(1), Off(0).
    * */
@@ -248,11 +262,25 @@ class Imperative {
   nnvm::Symbol GetDeferredComputeSymbol(const std::vector<NDArray *> &outputs);
   /*! \brief associate arrays with variables for deferred compute */
   void SetDeferredComputeVariable(NDArrayHandle *arrays, SymbolHandle *variables, const int num);
-  /*! \brief */
+  /*!
+   * \brief append an operator to the lazy trace of this thread instead of running it.
+   * \return false if the operator can not be traced and must run eagerly.
+   */
+  bool RecordLazy(const nnvm::NodeAttrs& attrs,
+                  const std::vector<NDArray*>& inputs,
+                  const std::vector<NDArray*>& outputs);
+  /*! \brief execute the operators recorded in lazy mode by this thread. */
+  void FlushLazy();
+  /*!
+   * \brief run an operator on NDArrays.
+   * \param attrs_from_dict whether attrs.parsed was parsed from attrs.dict. Only then
+   *  calls of operators with parameters can reuse cached attribute inference and dispatch.
+   */
   OpStatePtr Invoke(const Context& default_ctx,
                     const nnvm::NodeAttrs& attrs,
                     const std::vector<NDArray*>& inputs,
-                    const std::vector<NDArray*>& outputs);
+                    const std::vector<NDArray*>& outputs,
+                    const bool attrs_from_dict = false);
   /*! \brief */
   OpStatePtr InvokeOp(const Context& ctx,
                       const nnvm::NodeAttrs& attrs,
@@ -310,6 +338,7 @@ class Imperative {
   static thread_local bool is_train_;
   static thread_local bool is_recording_;
   static thread_local bool is_deferred_compute_;
+  static thread_local bool is_lazy_;
   // TOOD(junwu): Added numpy compatibility switch for backward compatibility.
   // Delete it in the next major release.
   static thread_local bool is_np_shape_thread_local_;
@@ -317,6 +346,7 @@ class Imperative {
   static MX_THREAD_LOCAL bool is_train_;
   static MX_THREAD_LOCAL bool is_recording_;
   static MX_THREAD_LOCAL bool is_deferred_compute_;
+  static MX_THREAD_LOCAL bool is_lazy_;
   // TOOD(junwu): Added numpy compatibility switch for backward compatibility.
   // Delete it in the next major release.
   static MX_THREAD_LOCAL bool is_np_shape_thread_local_;
@@ -319,6 +319,29 @@ using FInferStorageType = std::function<bool (const NodeAttrs& attrs,
                                               std::vector<int>* in_attrs,
                                               std::vector<int>* out_attrs)>;
 
+/*! \brief work done by one call of an operator */
+struct OpCost {
+  /*! \brief floating point operations, a multiply-add counting as two */
+  uint64_t flops = 0;
+  /*! \brief bytes read from the inputs */
+  uint64_t bytes_read = 0;
+  /*! \brief bytes written to the outputs */
+  uint64_t bytes_written = 0;
+};
+
+/*!
+ * \brief Register a cost model of the operator based on the shapes and types of
+ *        the inputs and outputs. The profiler reports the achieved GFLOP/s and GB/s
+ *        from it. Operators without it only count the bytes of their arrays.
+ *
+ * \note Register under "FOpCost"
+ */
+using FOpCost = std::function<OpCost (const NodeAttrs& attrs,
+                                      const mxnet::ShapeVector& in_shapes,
+                                      const std::vector<int>& in_types,
+                                      const mxnet::ShapeVector& out_shapes,
+                                      const std::vector<int>& out_types)>;
+
 /*!
  * \brief Register a quantized node creation function based on the attrs of the node
  * \note Register under "FQuantizedOp" for non-quantized operators
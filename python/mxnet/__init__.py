@@ -83,6 +83,7 @@ from . import test_utils
 from . import gluon
 
 from . import _deferred_compute
+from . import lazy
 
 # With the native kvstore module (such as 'dist_sync_device'), the module launches a separate
 # process when role is set to "server". This should be done after other modules are initialized.
@@ -172,6 +172,8 @@ class Pad(object):
     round_to : int, default None
         If specified, the padded dimension will be rounded to be multiple of this argument.
 
+    See `Pack` for batching variable length samples without padding.
+
     Examples
     --------
     >>> from mxnet.gluon.data import batchify
@@ -256,6 +258,75 @@ class Pad(object):
         from ._internal import PadBatchify
         return PadBatchify(pad_val=self._pad_val, dtype=self._dtype if self._dtype is not None else -1)
 
+class Pack(object):
+    """Concatenate the input ndarrays along the first axis without padding, and return
+    the packed batch together with the cumulative offsets of the samples.
+
+    This is the ragged counterpart of `Pad`: instead of padding every sample to the
+    longest one, sample `i` of the batch is stored in rows `offsets[i]` to
+    `offsets[i+1]` of the output. The offsets can be fed to operators working on packed
+    sequences such as `mx.nd.contrib.varlen_selfatt`, so no compute is spent on padding.
+
+    Parameters
+    ----------
+    dtype : str or numpy.dtype, default None
+        The value type of the output. If it is set to None, the input data type is used.
+    offset_dtype : str or numpy.dtype, default 'int32'
+        The value type of the offsets.
+    use_shared_mem : bool, default False
+        If True, the packed batch and the offsets are allocated in shared memory, so
+        that worker processes of a `DataLoader` can pass them without a copy.
+
+    Examples
+    --------
+    >>> from mxnet.gluon.data import batchify
+    >>> a = [1, 2, 3, 4]
+    >>> b = [4, 5, 6]
+    >>> c = [8, 2]
+    >>> data, offsets = batchify.Pack()([a, b, c])
+    >>> data
+    [1 2 3 4 4 5 6 8 2]
+    <NDArray 9 @cpu(0)>
+    >>> offsets
+    [0 4 7 9]
+    <NDArray 4 @cpu(0)>
+    """
+    def __init__(self, dtype=None, offset_dtype='int32', use_shared_mem=False):
+        self._dtype = dtype
+        self._offset_dtype = offset_dtype
+        self._use_shared_mem = use_shared_mem
+
+    def __call__(self, data):
+        """Batchify the input data.
+
+        Parameters
+        ----------
+        data : List[np.ndarray] or List[List[dtype]] or List[nd.NDArray]
+            List of samples to pack. All samples must have the same shape except for
+            the first axis.
+        Returns
+        -------
+        batch_data: NDArray
+            Data in the minibatch. Shape is (sum of lengths, ...)
+        offsets: NDArray
+            Cumulative offsets of the samples. Shape is (N + 1,)
+        """
+        _arr = _np if is_np_array() else nd
+        _arr_cls = _arr.ndarray if is_np_array() else _arr.NDArray
+        if not isinstance(data[0], (_arr_cls, np.ndarray, list)):
+            raise NotImplementedError(
+                "Pack() does not support multiple items, use Group(Pack(), Pack(), ...) instead")
+        if isinstance(data[0], _arr_cls):
+            arrs = [arr.asnumpy() for arr in data]
+        else:
+            arrs = [np.asarray(arr) for arr in data]
+        dtype = arrs[0].dtype if self._dtype is None else self._dtype
+        offsets = np.zeros((len(arrs) + 1,), dtype=self._offset_dtype)
+        offsets[1:] = np.cumsum([arr.shape[0] for arr in arrs])
+        ctx = Context('cpu_shared', 0) if self._use_shared_mem else cpu()
+        return (_arr.array(np.concatenate(arrs, axis=0), ctx=ctx, dtype=dtype),
+                _arr.array(offsets, ctx=ctx, dtype=self._offset_dtype))
+
 def _append_arrs(arrs, use_shared_mem=False, expand=False, batch_axis=0):
     """Internal impl for returning appened arrays as list."""
     _arr = _np if is_np_array() else nd
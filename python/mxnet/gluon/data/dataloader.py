@@ -30,6 +30,8 @@ import multiprocessing.queues
 from multiprocessing.reduction import ForkingPickler
 from multiprocessing.pool import ThreadPool
 import threading
+import time
+import ctypes
 import numpy as np
 
 try:
@@ -40,6 +42,7 @@ except ImportError:
 from . import sampler as _sampler
 from . import batchify as _batchify
 from ... import ndarray as nd, context
+from ...base import _LIB, check_call
 from ...util import is_np_shape, is_np_array, set_np
 from ... import numpy as _mx_np  # pylint: disable=reimported
 
@@ -437,6 +440,13 @@ def _thread_worker_fn(samples, batchify_fn, dataset):
     """Threadpool worker function for processing data."""
     return batchify_fn([dataset[i] for i in samples])
 
+def _record_wait(start):
+    """Record the time since start, in seconds of time.perf_counter, that an
+    iterator blocked for a batch in the DataLoader latency histogram."""
+    wait_ns = int((time.perf_counter() - start) * 1e9)
+    check_call(_LIB.MXProfileRecordDataLoaderWait(ctypes.c_uint64(wait_ns)))
+
+
 class _MultiWorkerIter(object):
     """Internal multi-worker iterator for DataLoader."""
     def __init__(self, worker_pool, batchify_fn, batch_sampler, pin_memory=False,
@@ -481,6 +491,7 @@ class _MultiWorkerIter(object):
         assert self._rcvd_idx < self._sent_idx, "rcvd_idx must be smaller than sent_idx"
         assert self._rcvd_idx in self._data_buffer, "fatal error with _push_next, rcvd_idx missing"
         ret = self._data_buffer.pop(self._rcvd_idx)
+        start = time.perf_counter()
         try:
             if self._dataset is None:
                 batch = pickle.loads(ret.get(self._timeout))
@@ -489,6 +500,7 @@ class _MultiWorkerIter(object):
             if self._pin_memory:
                 batch = _as_in_context(batch, context.cpu_pinned(self._pin_device_id))
             self._rcvd_idx += 1
+            _record_wait(start)
             return batch
         except multiprocessing.context.TimeoutError:
             msg = '''Worker timed out after {} seconds. This might be caused by \n
@@ -671,9 +683,11 @@ class DataLoader(object):
         if self._num_workers == 0:
             def same_process_iter():
                 for batch in self._batch_sampler:
+                    start = time.perf_counter()
                     ret = self._batchify_fn([self._dataset[idx] for idx in batch])
                     if self._pin_memory:
                         ret = _as_in_context(ret, context.cpu_pinned(self._pin_device_id))
+                    _record_wait(start)
                     yield ret
             return same_process_iter()
 
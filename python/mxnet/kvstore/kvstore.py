@@ -20,7 +20,6 @@
 
 import pickle
 import ctypes
-import os
 from ..ndarray import NDArray
 from ..ndarray import _ndarray_cls
 from ..base import _LIB, c_str
@@ -46,11 +45,38 @@ def _get_kvstore_server_command_type(command):
                      'kStopServer': 2,
                      'kSyncMode': 3,
                      'kSetGradientCompression': 4,
-                     'kSetProfilerParams': 5}
+                     'kSetProfilerParams': 5,
+                     'kSetRowStoreOptimizer': 6}
     assert (command in command_types), "Unknown command type to send to server"
     return command_types[command]
 
 
+def _get_row_store_optimizer_params(optimizer):
+    """Returns the parameters of the optimizer applied by server side row stores
+    as a comma separated string, or None if the optimizer cannot be applied lazily
+    per row by the servers."""
+    if optimizer.lr_scheduler is not None or optimizer.multi_precision:
+        return None
+    if optimizer.lr_mult or optimizer.wd_mult:
+        return None
+    if any(p.lr_mult != 1.0 or p.wd_mult != 1.0 for p in optimizer.param_dict.values()):
+        return None
+    if isinstance(optimizer, opt.SGD) and optimizer.lazy_update:
+        params = {'optimizer': 'sgd', 'momentum': optimizer.momentum}
+    elif isinstance(optimizer, opt.Adam) and optimizer.lazy_update:
+        params = {'optimizer': 'adam', 'beta1': optimizer.beta1,
+                  'beta2': optimizer.beta2, 'epsilon': optimizer.epsilon}
+    elif isinstance(optimizer, opt.AdaGrad):
+        params = {'optimizer': 'adagrad', 'epsilon': optimizer.epsilon}
+    else:
+        return None
+    params.update({'learning_rate': optimizer.lr, 'wd': optimizer.wd,
+                   'rescale_grad': optimizer.rescale_grad,
+                   'clip_gradient': optimizer.clip_gradient
+                                    if optimizer.clip_gradient is not None else -1.0})
+    return ','.join('{},{}'.format(k, v) for k, v in params.items())
+
+
 class KVStore(KVStoreBase):
     """A key-value store for synchronization of values, over multiple devices."""
 
@@ -67,7 +93,6 @@ class KVStore(KVStoreBase):
         self._updater = None
         self._updater_func = None
         self._str_updater_func = None
-        self._is_p3 = (os.getenv('DMLC_PS_VAN_TYPE', '') == 'p3')
 
     def __del__(self):
         check_call(_LIB.MXKVStoreFree(self.handle))
@@ -133,7 +158,7 @@ class KVStore(KVStoreBase):
             Whether the capability is supported or not.
         """
         if capability.lower() == KVStoreBase.OPTIMIZER:
-            return not self._is_p3
+            return True
         else:
             raise ValueError('Unknown capability: {}'.format(capability))
 
@@ -535,6 +560,14 @@ class KVStore(KVStoreBase):
         a dictionary which includes `threshold` like:
         {'type': '2bit', 'threshold': 0.5}
 
+        Top-k sparsification (`TopKCompressor`) sends (index, value) pairs for the
+        largest-magnitude fraction `ratio` of the gradient; `RandomKCompressor` sends a
+        uniformly sampled fraction instead. The gradient is processed in blocks and
+        `pairs_per_block` pairs are selected from every block. Values which are not sent
+        are kept in the residual and added to the gradient of the next iteration.
+        Sparsifying compressors are only supported on CPU, e.g.
+        {'name': 'TopKCompressor', 'ratio': 0.01}
+
         Parameters
         ----------
         compression_params : dict
@@ -599,6 +632,12 @@ class KVStore(KVStoreBase):
             if optimizer.multi_precision:
                 cmd = _get_kvstore_server_command_type('kSetMultiPrecision')
                 self._send_command_to_servers(cmd, '')
+            # large row_sparse keys kept in server side row stores
+            # (MXNET_KVSTORE_ROW_STORE_MIN_ROWS) are updated lazily in C++
+            row_store_params = _get_row_store_optimizer_params(optimizer)
+            if row_store_params is not None:
+                cmd = _get_kvstore_server_command_type('kSetRowStoreOptimizer')
+                self._send_command_to_servers(cmd, row_store_params)
         else:
             self._set_updater(opt.get_updater(optimizer))
 
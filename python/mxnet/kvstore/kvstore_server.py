@@ -22,10 +22,40 @@ import sys
 import pickle
 import logging
 from ..base import _LIB, check_call
+from .. import optimizer as opt
 from .base import create
 
 __all__ = ['KVStoreServer']
 
+# P3StoreDist gives slice i > 0 of a large key the server key
+# _P3_SLICE_KEY_OFFSET + (key << _P3_SLICE_KEY_BITS) + i. Keep in sync with
+# kSliceKeyOffset and kSliceKeyBits in src/kvstore/p3store_dist.h
+_P3_SLICE_KEY_OFFSET = 1 << 30
+_P3_SLICE_KEY_BITS = 12
+
+
+def _p3_parent_key(key):
+    """Returns the key a P3StoreDist slice key was sliced from, or `key` itself."""
+    if isinstance(key, int) and key >= _P3_SLICE_KEY_OFFSET:
+        return (key - _P3_SLICE_KEY_OFFSET) >> _P3_SLICE_KEY_BITS
+    return key
+
+
+def _p3_slice_updater(updater, optimizer):
+    """Wraps `updater` to apply the hyper-parameters of the sliced key to its slices.
+    Every slice keeps its own key, and so its own optimizer state."""
+    aliased = set()
+    def slice_updater(key, grad, weight):
+        parent = _p3_parent_key(key)
+        if parent != key and key not in aliased:
+            for mapping in (optimizer.param_dict, optimizer.lr_mult,
+                            optimizer.wd_mult, optimizer.idx2name):
+                if parent in mapping:
+                    mapping[key] = mapping[parent]
+            aliased.add(key)
+        updater(key, grad, weight)
+    return slice_updater
+
 class KVStoreServer(object):
     """The key-value store server."""
     def __init__(self, kvstore):
@@ -56,7 +86,8 @@ class KVStoreServer(object):
                     optimizer = pickle.loads(cmd_body)
                 except:
                     raise
-                self.kvstore.set_optimizer(optimizer)
+                self.kvstore._set_updater(
+                    _p3_slice_updater(opt.get_updater(optimizer), optimizer))
             else:
                 print("server %d, unknown command (%d, %s)" % (
                     self.kvstore.rank, cmd_id, cmd_body))
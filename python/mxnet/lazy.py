@@ -0,0 +1,76 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Lazy execution of imperative NDArray operators.
+
+In lazy mode operators are recorded instead of executed. The recorded operators
+run as a single cached graph once one of their outputs is read, for example by
+``asnumpy()`` or ``wait_to_read()``, or when an operator that can not be
+recorded is called. Graphs are cached on their structure, so a loop that issues
+the same operators in every iteration runs the graph optimized and memory
+planned on its first iteration.
+"""
+
+import ctypes
+import contextlib
+
+from .base import _LIB, check_call
+
+__all__ = ['is_lazy', 'set_lazy', 'scope']
+
+
+def is_lazy():
+    """Get status of lazy mode."""
+    curr = ctypes.c_int()
+    check_call(_LIB.MXNDArrayIsLazy(ctypes.byref(curr)))
+    return bool(curr.value)
+
+
+def set_lazy(state):
+    """Enable / Disable lazy mode. Disabling it runs the operators recorded so far.
+
+    Parameters
+    ----------
+    state: bool
+
+    Returns
+    -------
+    Previous lazy state.
+    """
+    prev = ctypes.c_int()
+    check_call(_LIB.MXNDArraySetIsLazy(ctypes.c_int(state), ctypes.byref(prev)))
+    return bool(prev.value)
+
+
+@contextlib.contextmanager
+def scope(state=True):
+    """Set lazy state to `state` within context. Reset afterwards to previous value.
+
+    Example::
+
+        with mx.lazy.scope():
+            for x, y in data:
+                with autograd.record():
+                    loss = loss_fn(net(x), y)
+                loss.backward()
+                trainer.step(x.shape[0])
+    """
+    val = set_lazy(state)
+    try:
+        yield
+    finally:
+        set_lazy(val)
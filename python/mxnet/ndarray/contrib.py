@@ -30,7 +30,8 @@ try:
 except ImportError:
     pass
 
-__all__ = ["rand_zipfian", "foreach", "while_loop", "cond", "isinf", "isfinite", "isnan"]
+__all__ = ["rand_zipfian", "foreach", "while_loop", "cond", "isinf", "isfinite", "isnan",
+           "KVCache"]
 
 def _flatten_list(nested_list):
     return [item for sublist in nested_list for item in sublist]
@@ -545,6 +546,103 @@ def isnan(data):
     """
     return data != data  # pylint: disable=comparison-with-itself
 
+class KVCache(object):
+    """Per-sequence key/value caches for incremental self attention decoding.
+
+    Holds caches of layout (batch_size, heads, capacity, head_dim) and the number of
+    cached steps of every sequence, and feeds them to `kv_cache_selfatt`. When a
+    sequence reaches the capacity the caches are grown by doubling, so appending a step
+    is amortized O(1) and every decoding step costs O(length).
+
+    Parameters
+    ----------
+    batch_size : int
+        Number of sequences decoded together.
+    heads : int
+        Number of attention heads.
+    head_dim : int
+        Dimension of every head.
+    capacity : int, default 64
+        Initial number of steps the caches can hold.
+    ring : bool, default False
+        If True the caches never grow and a full cache overwrites its oldest step,
+        i.e. attention over a sliding window of `capacity` steps.
+    dtype : str or numpy.dtype, default 'float32'
+        Data type of the caches, must match the projections.
+    ctx : Context, optional
+        Device of the caches, defaults to the current context.
+
+    Examples
+    --------
+    >>> cache = mx.nd.contrib.KVCache(batch_size=2, heads=4, head_dim=16)
+    >>> for step in range(10):
+    ...     qkv = proj(x)                  # (batch_size, 3 * heads * head_dim)
+    ...     out = cache.step(qkv)          # (batch_size, heads * head_dim)
+    """
+    def __init__(self, batch_size, heads, head_dim, capacity=64, ring=False,
+                 dtype='float32', ctx=None):
+        if ctx is None:
+            ctx = current_context()
+        self._heads = heads
+        self._ring = ring
+        shape = (batch_size, heads, capacity, head_dim)
+        self.key_cache = ndarray.zeros(shape, ctx=ctx, dtype=dtype)
+        self.value_cache = ndarray.zeros(shape, ctx=ctx, dtype=dtype)
+        self.lengths = ndarray.zeros((batch_size,), ctx=ctx, dtype='int32')
+        # host copy of the lengths, so that growing does not wait for the device
+        self._host_lengths = np.zeros((batch_size,), dtype=np.int64)
+
+    @property
+    def capacity(self):
+        """Number of steps every sequence can currently hold."""
+        return self.key_cache.shape[2]
+
+    def _grow(self, capacity):
+        shape = self.key_cache.shape[:2] + (capacity,) + self.key_cache.shape[3:]
+        for name in ('key_cache', 'value_cache'):
+            old = getattr(self, name)
+            new = ndarray.zeros(shape, ctx=old.context, dtype=old.dtype)
+            new[:, :, :old.shape[2]] = old
+            setattr(self, name, new)
+
+    def step(self, queries_keys_values, block_size=64):
+        """Appends the keys and values of one step and attends the new queries over
+        all cached steps.
+
+        Parameters
+        ----------
+        queries_keys_values : NDArray
+            Interleaved projections of one step, of shape (batch_size, 3 * heads * head_dim).
+        block_size : int, default 64
+            Number of cached keys in one tile.
+
+        Returns
+        -------
+        NDArray
+            Attention output of shape (batch_size, heads * head_dim).
+        """
+        longest = int(self._host_lengths.max())
+        if not self._ring and longest >= self.capacity:
+            capacity = self.capacity
+            while capacity <= longest:
+                capacity *= 2
+            self._grow(capacity)
+        self._host_lengths += 1
+        # pylint: disable=undefined-variable
+        return kv_cache_selfatt(queries_keys_values, self.key_cache, self.value_cache,
+                                self.lengths, heads=self._heads, ring=self._ring,
+                                block_size=block_size)
+
+    def reset(self, index=None):
+        """Empties the cache of sequence `index`, or of all sequences if `index` is None,
+        so that a new sequence can be decoded in its slot."""
+        if index is None:
+            self.lengths[:] = 0
+            self._host_lengths[:] = 0
+        else:
+            self.lengths[index] = 0
+            self._host_lengths[index] = 0
+
 def _get_rescale_grad(rescale_grad, ctx=mx.cpu()):
     if not isinstance(rescale_grad, ndarray.NDArray):
         return ndarray.full(shape=(1,), val=rescale_grad, ctx=ctx)
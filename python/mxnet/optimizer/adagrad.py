@@ -19,7 +19,9 @@
 from __future__ import absolute_import
 from ..ndarray import (zeros, clip, sqrt, square)
 from ..ndarray import sparse
+from ..ndarray import multi_adagrad_update
 from .optimizer import Optimizer, register
+from .utils import _flatten_list, _use_multi_tensor, _multi_tensor_slices
 
 __all__ = ['AdaGrad']
 
@@ -45,6 +47,10 @@ class AdaGrad(Optimizer):
     ----------
     :meth:`mxnet.ndarray.sparse.adagrad_update`.
 
+    When ``aggregate_num`` is larger than 1, dense weights are updated
+    ``aggregate_num`` at a time by :meth:`~mxnet.ndarray.multi_adagrad_update`, which removes
+    the per-parameter launch overhead for models with many small parameters.
+
     Parameters
     ----------
     learning_rate : float, default 0.01
@@ -121,6 +127,9 @@ class AdaGrad(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
+        if _use_multi_tensor(self.aggregate_num, weights, grads):
+            self._fused_multi_step(indices, weights, grads, states)
+            return
         for index, weight, grad, state in zip(indices, weights, grads, states):
             is_sparse = grad.stype == 'row_sparse'
 
@@ -139,3 +148,18 @@ class AdaGrad(Optimizer):
             else:
                 # When the grad is not sparse, the func step is called to update weight and state
                 self.step([index], [weight], [grad], [state])
+
+    def _fused_multi_step(self, indices, weights, grads, states):
+        """Update dense weights with the multi-tensor kernel, `aggregate_num` at a time."""
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+
+        kwargs = {'epsilon': self.epsilon, 'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        for sl in _multi_tensor_slices(len(indices), self.aggregate_num):
+            multi_adagrad_update(*_flatten_list(zip(weights[sl], grads[sl], states[sl])),
+                                 out=weights[sl], num_weights=len(weights[sl]),
+                                 lrs=lrs[sl], wds=wds[sl], **kwargs)
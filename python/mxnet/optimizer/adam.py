@@ -19,8 +19,9 @@
 from __future__ import absolute_import
 import math
 from ..ndarray import (zeros, clip, sqrt, square)
-from ..ndarray import adam_update
+from ..ndarray import adam_update, multi_adam_update
 from .optimizer import Optimizer, register
+from .utils import _flatten_list, _use_multi_tensor, _multi_tensor_slices
 
 __all__ = ['Adam']
 
@@ -61,6 +62,10 @@ class Adam(Optimizer):
 
     For details of the update algorithm, see :class:`~mxnet.ndarray.adam_update`.
 
+    When ``aggregate_num`` is larger than 1, dense weights are updated
+    ``aggregate_num`` at a time by :meth:`~mxnet.ndarray.multi_adam_update`, which removes
+    the per-parameter launch overhead for models with many small parameters.
+
     Parameters
     ----------
     learning_rate : float, default 0.001
@@ -163,6 +168,9 @@ class Adam(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
+        if _use_multi_tensor(self.aggregate_num, weights, grads):
+            self._fused_multi_step(indices, weights, grads, states)
+            return
         for index, weight, grad, state in zip(indices, weights, grads, states):
             self._update_count(index)
             lr = self._get_lr(index)
@@ -184,3 +192,25 @@ class Adam(Optimizer):
             # update weight with fused kernel
             adam_update(weight, grad, mean, var, out=weight,
                         lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
+
+    def _fused_multi_step(self, indices, weights, grads, states):
+        """Update dense weights with the multi-tensor kernel, `aggregate_num` at a time."""
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+        for i, index in enumerate(indices):
+            t = self._index_update_count[index]
+            coef1 = 1. - self.beta1**t
+            coef2 = 1. - self.beta2**t
+            lrs[i] *= math.sqrt(coef2) / coef1
+
+        kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        for sl in _multi_tensor_slices(len(indices), self.aggregate_num):
+            mean, var = zip(*states[sl])
+            multi_adam_update(*_flatten_list(zip(weights[sl], grads[sl], mean, var)),
+                              out=weights[sl], num_weights=len(weights[sl]),
+                              lrs=lrs[sl], wds=wds[sl], **kwargs)
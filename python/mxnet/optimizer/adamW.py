@@ -20,6 +20,7 @@ import math
 import os
 import numpy as np
 from .optimizer import Optimizer, register
+from .utils import _is_low_precision, _BFLOAT16
 from ..ndarray import (zeros, clip, sqrt, square, full, NDArray)
 from ..ndarray.contrib import mp_adamw_update, adamw_update,\
     multi_mp_adamw_update, multi_adamw_update
@@ -156,7 +157,7 @@ class AdamW(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
-        multi_precision = self.multi_precision and weights[0].dtype == np.float16
+        multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
         aggregate = self.aggregate_num > 1
         if not isinstance(indices, (tuple, list)):
             indices = [indices]
@@ -166,9 +167,11 @@ class AdamW(Optimizer):
         for w_i, g_i in zip(weights, grads):
             assert(isinstance(w_i, NDArray))
             assert(isinstance(g_i, NDArray))
+            # the multi-tensor AdamW kernels have no bfloat16 implementation
             aggregate = (aggregate and
                          w_i.stype == 'default' and
-                         g_i.stype == 'default')
+                         g_i.stype == 'default' and
+                         w_i.dtype != _BFLOAT16)
         self._update_count(indices)
         lrs = self._get_lrs(indices)
         wds = self._get_wds(indices)
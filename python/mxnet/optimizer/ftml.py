@@ -18,8 +18,9 @@
 """FTML optimizer."""
 from __future__ import absolute_import
 from ..ndarray import (zeros, clip, sqrt, square)
-from ..ndarray import ftml_update
+from ..ndarray import ftml_update, multi_ftml_update
 from .optimizer import Optimizer, register
+from .utils import _flatten_list, _use_multi_tensor, _multi_tensor_slices
 
 __all__ = ['FTML']
 
@@ -45,6 +46,10 @@ class FTML(Optimizer):
     This optimizer accepts the following parameters in addition to those accepted
     by :class:`.Optimizer`.
 
+    When ``aggregate_num`` is larger than 1, dense weights are updated
+    ``aggregate_num`` at a time by :meth:`~mxnet.ndarray.multi_ftml_update`, which removes
+    the per-parameter launch overhead for models with many small parameters.
+
     Parameters
     ----------
     learning_rate : float, default 0.0025
@@ -141,6 +146,9 @@ class FTML(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
+        if _use_multi_tensor(self.aggregate_num, weights, grads):
+            self._fused_multi_step(indices, weights, grads, states)
+            return
         for index, weight, grad, state in zip(indices, weights, grads, states):
             self._update_count(index)
             lr = self._get_lr(index)
@@ -156,3 +164,21 @@ class FTML(Optimizer):
 
             # update weight with fused kernel
             ftml_update(weight, grad, d, v, z, out=weight, lr=lr, wd=wd, **kwargs)
+
+    def _fused_multi_step(self, indices, weights, grads, states):
+        """Update dense weights with the multi-tensor kernel, `aggregate_num` at a time."""
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+        ts = [self._index_update_count[index] for index in indices]
+
+        kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_grad'] = self.clip_gradient
+
+        for sl in _multi_tensor_slices(len(indices), self.aggregate_num):
+            multi_ftml_update(*_flatten_list(zip(weights[sl], grads[sl],
+                                                 *zip(*states[sl]))),
+                              out=weights[sl], num_weights=len(weights[sl]),
+                              lrs=lrs[sl], wds=wds[sl], ts=ts[sl], **kwargs)
@@ -24,6 +24,7 @@ from ..ndarray import (lamb_update_phase1, lamb_update_phase2,
                        mp_lamb_update_phase1, mp_lamb_update_phase2)
 from ..ndarray.contrib import (multi_lamb_update, multi_mp_lamb_update)
 from .optimizer import Optimizer, register
+from .utils import _is_low_precision, _BFLOAT16
 
 __all__ = ['LAMB']
 
@@ -175,9 +176,11 @@ class LAMB(Optimizer):
         """
         aggregate = self.aggregate_num > 1
         for weight, grad in zip(weights, grads):
+            # the multi-tensor LAMB kernels have no bfloat16 implementation
             aggregate = (aggregate and
                          weight.stype == 'default' and
-                         grad.stype == 'default')
+                         grad.stype == 'default' and
+                         weight.dtype != _BFLOAT16)
         self._update_count(indices)
         lrs = self._get_lrs(indices)
         wds = self._get_wds(indices)
@@ -197,7 +200,7 @@ class LAMB(Optimizer):
             for index in indices:
                 step_counts.append(self._index_update_count[index])
 
-            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+            multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
 
             if not multi_precision:
                 mean, var = list(zip(*states))
@@ -223,7 +226,7 @@ class LAMB(Optimizer):
                 if self.clip_gradient:
                     kwargs['clip_gradient'] = self.clip_gradient
 
-                multi_precision = self.multi_precision and weight.dtype == numpy.float16
+                multi_precision = self.multi_precision and _is_low_precision(weight.dtype)
 
                 if multi_precision:
                     weight32 = state[0]
@@ -22,6 +22,7 @@ from ..ndarray import (zeros, clip, sqrt, where, square, ones_like,
                        maximum, minimum)
 from ..ndarray.contrib import (multi_lans_update, multi_mp_lans_update)
 from .optimizer import Optimizer, register
+from .utils import _is_low_precision
 
 __all__ = ['LANS']
 
@@ -196,7 +197,7 @@ class LANS(Optimizer):
         for index in indices:
             step_counts.append(self._index_update_count[index])
 
-        multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+        multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
 
         if not multi_precision:
             mean, var = list(zip(*states))
@@ -17,7 +17,6 @@
 # under the License.
 """LARS optimizer."""
 from __future__ import absolute_import
-import numpy
 from ..ndarray import (zeros, clip, array,
                        multi_sum_sq, multi_lars,
                        norm as NDnorm,
@@ -27,7 +26,7 @@ from ..ndarray import (sgd_update, sgd_mom_update,
                        preloaded_multi_sgd_update, preloaded_multi_sgd_mom_update,
                        preloaded_multi_mp_sgd_update, preloaded_multi_mp_sgd_mom_update)
 from .optimizer import Optimizer, register
-from .utils import _flatten_list
+from .utils import _flatten_list, _is_low_precision
 
 __all__ = ['LARS']
 
@@ -226,7 +225,7 @@ class LARS(Optimizer):
                            eta=self.eta, eps=self.epsilon, rescale_grad=self.rescale_grad,
                            out=new_lrs[:nb_lars])
             # Same than usual using preloaded sgd functions
-            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+            multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
             if not multi_precision:
                 if self.momentum > 0:
                     preloaded_multi_sgd_mom_update(
@@ -256,7 +255,7 @@ class LARS(Optimizer):
                 wd = wds[i]
                 lr = lrs[i]
                 lr *= self._get_lars(index, weight, grad, wd)
-                multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+                multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
                 if not multi_precision:
                     mom = state
                     if state is not None:
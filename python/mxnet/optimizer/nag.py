@@ -17,10 +17,12 @@
 # under the License.
 """NAG optimizer."""
 from __future__ import absolute_import
-import numpy
 from ..ndarray import (zeros, clip)
-from ..ndarray import (sgd_update, mp_sgd_update, nag_mom_update, mp_nag_mom_update)
+from ..ndarray import (sgd_update, mp_sgd_update, nag_mom_update, mp_nag_mom_update,
+                       multi_nag_mom_update)
 from .optimizer import Optimizer, register
+from .utils import (_flatten_list, _use_multi_tensor, _multi_tensor_slices,
+                    _is_low_precision)
 
 __all__ = ['NAG']
 
@@ -35,6 +37,11 @@ class NAG(Optimizer):
         state = momentum * state + lr * grad
         weight = weight - (momentum * state + lr * grad)
 
+    When ``aggregate_num`` is larger than 1 and momentum is used without
+    ``multi_precision``, dense weights are updated ``aggregate_num`` at a time by
+    :meth:`~mxnet.ndarray.multi_nag_mom_update`, which removes the per-parameter
+    launch overhead for models with many small parameters.
+
     Parameters
     ----------
     learning_rate : float, default 0.1
@@ -49,7 +56,8 @@ class NAG(Optimizer):
         False: results in using the same precision as the weights (default),
         True: makes internal 32-bit copy of the weights and applies gradients
         in 32-bit precision even if actual weights used in the model have lower precision.
-        Turning this on can improve convergence and accuracy when training with float16.
+        Turning this on can improve convergence and accuracy when training with float16
+        or bfloat16.
     use_fused_step : bool, default True
         Whether or not to use fused kernels for optimizer.
         When use_fused_step=False, step is called,
@@ -125,6 +133,11 @@ class NAG(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
+        if self.momentum > 0 and \
+                not (self.multi_precision and _is_low_precision(weights[0].dtype)) and \
+                _use_multi_tensor(self.aggregate_num, weights, grads):
+            self._fused_multi_step(indices, weights, grads, states)
+            return
         for index, weight, grad, state in zip(indices, weights, grads, states):
             self._update_count(index)
             lr = self._get_lr(index)
@@ -136,7 +149,7 @@ class NAG(Optimizer):
             if self.clip_gradient:
                 kwargs['clip_gradient'] = self.clip_gradient
 
-            multi_precision = self.multi_precision and weight.dtype == numpy.float16
+            multi_precision = self.multi_precision and _is_low_precision(weight.dtype)
 
             if not multi_precision:
                 mom = state
@@ -153,6 +166,21 @@ class NAG(Optimizer):
                     mp_sgd_update(weight, grad, weight32, out=weight,
                                   lr=lr, wd=wd, **kwargs)
 
+    def _fused_multi_step(self, indices, weights, grads, states):
+        """Update dense weights with the multi-tensor kernel, `aggregate_num` at a time."""
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+
+        kwargs = {'rescale_grad': self.rescale_grad, 'momentum': self.momentum}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        for sl in _multi_tensor_slices(len(indices), self.aggregate_num):
+            multi_nag_mom_update(*_flatten_list(zip(weights[sl], grads[sl], states[sl])),
+                                 out=weights[sl], num_weights=len(weights[sl]),
+                                 lrs=lrs[sl], wds=wds[sl], **kwargs)
+
     def update_multi_precision(self, indices, weights, grads, states):
         """Override update_multi_precision.
         """
@@ -20,8 +20,9 @@
 """Base Optimizer class."""
 import warnings
 import numpy
-from ..ndarray import (NDArray, zeros, cast)
+from ..ndarray import (NDArray, zeros, amp_cast)
 from ..util import is_np_array
+from .utils import _is_low_precision
 
 __all__ = ['Optimizer', 'Test', 'create', 'register']
 
@@ -65,7 +66,8 @@ class Optimizer(object):
        False: results in using the same precision as the weights (default),
        True: makes internal 32-bit copy of the weights and applies gradients
        in 32-bit precision even if actual weights used in the model have lower precision.
-       Turning this on can improve convergence and accuracy when training with float16.
+       Turning this on can improve convergence and accuracy when training with float16
+       or bfloat16.
 
     param_dict : dict of int -> gluon.Parameter, default None
         Dictionary of parameter index to gluon.Parameter, used to lookup parameter attributes
@@ -245,11 +247,11 @@ class Optimizer(object):
         state : any obj
             The state associated with the weight.
         """
-        if self.multi_precision and weight.dtype == numpy.float16:
+        if self.multi_precision and _is_low_precision(weight.dtype):
             weight_master_copy = weight.astype(numpy.float32)
             return (weight_master_copy,) + (self.create_state(index, weight_master_copy),)
-        if weight.dtype == numpy.float16 and not self.multi_precision:
-            warnings.warn("Accumulating with float16 in optimizer can lead to "
+        if _is_low_precision(weight.dtype) and not self.multi_precision:
+            warnings.warn("Accumulating with float16 or bfloat16 in optimizer can lead to "
                           "poor accuracy or slow convergence. "
                           "Consider using multi_precision=True option of the "
                           "optimizer")
@@ -338,7 +340,7 @@ class Optimizer(object):
         original_states = []
         grads32 = []
         for weight, grad, state in zip(weights, grads, states):
-            if self.multi_precision and weight.dtype == numpy.float16:
+            if self.multi_precision and _is_low_precision(weight.dtype):
                 weights_master_copy.append(state[0])
                 original_states.append(state[1])
                 grads32.append(grad.astype(numpy.float32))
@@ -348,8 +350,9 @@ class Optimizer(object):
                 grads32.append(grad)
         self.update(indices, weights_master_copy, grads32, original_states)
         for weight_master_copy, weight in zip(weights_master_copy, weights):
-            if self.multi_precision and weight.dtype == numpy.float16:
-                cast(weight_master_copy, dtype=weight.dtype, out=weight)
+            if self.multi_precision and _is_low_precision(weight.dtype):
+                # amp_cast rounds to nearest even, cast truncates bfloat16
+                amp_cast(weight_master_copy, dtype=weight.dtype, out=weight)
 
     def set_learning_rate(self, lr):
         """Sets a new learning rate of the optimizer.
@@ -17,8 +17,9 @@
 """RMSProp optimizer."""
 from __future__ import absolute_import
 from ..ndarray import (zeros, clip, sqrt, square)
-from ..ndarray import (rmsprop_update, rmspropalex_update)
+from ..ndarray import (rmsprop_update, rmspropalex_update, multi_rmsprop_update)
 from .optimizer import Optimizer, register
+from .utils import _flatten_list, _use_multi_tensor, _multi_tensor_slices
 
 __all__ = ['RMSProp']
 
@@ -41,6 +42,10 @@ class RMSProp(Optimizer):
     This optimizer accepts the following parameters in addition to those accepted
     by :class:`.Optimizer`.
 
+    When ``aggregate_num`` is larger than 1 and ``centered`` is False, dense weights
+    are updated ``aggregate_num`` at a time by :meth:`~mxnet.ndarray.multi_rmsprop_update`,
+    which removes the per-parameter launch overhead for models with many small parameters.
+
     Parameters
     ----------
     learning_rate : float, default 0.001
@@ -157,6 +162,9 @@ class RMSProp(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
+        if not self.centered and _use_multi_tensor(self.aggregate_num, weights, grads):
+            self._fused_multi_step(indices, weights, grads, states)
+            return
         for index, weight, grad, state in zip(indices, weights, grads, states):
             self._update_count(index)
             lr = self._get_lr(index)
@@ -179,3 +187,21 @@ class RMSProp(Optimizer):
                 mean, var, mom = state
                 rmspropalex_update(weight, grad, mean, var, mom, out=weight,
                                    lr=lr, wd=wd, **kwargs)
+
+    def _fused_multi_step(self, indices, weights, grads, states):
+        """Update dense weights with the multi-tensor kernel, `aggregate_num` at a time."""
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+
+        kwargs = {'rho': self.rho, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        if self.clip_weights:
+            kwargs['clip_weights'] = self.clip_weights
+
+        for sl in _multi_tensor_slices(len(indices), self.aggregate_num):
+            multi_rmsprop_update(*_flatten_list(zip(weights[sl], grads[sl], states[sl])),
+                                 out=weights[sl], num_weights=len(weights[sl]),
+                                 lrs=lrs[sl], wds=wds[sl], **kwargs)
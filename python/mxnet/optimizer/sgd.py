@@ -17,14 +17,13 @@
 # under the License.
 """SGD optimizer"""
 from __future__ import absolute_import
-import numpy
 from ..ndarray import (zeros, clip)
 from ..ndarray import (sgd_update, sgd_mom_update,
                        mp_sgd_update, mp_sgd_mom_update,
                        multi_sgd_update, multi_sgd_mom_update,
                        multi_mp_sgd_update, multi_mp_sgd_mom_update)
 from .optimizer import Optimizer, register
-from .utils import _flatten_list
+from .utils import _flatten_list, _is_low_precision
 
 __all__ = ['SGD']
 
@@ -83,7 +82,8 @@ class SGD(Optimizer):
         False: results in using the same precision as the weights (default),
         True: makes internal 32-bit copy of the weights and applies gradients
         in 32-bit precision even if actual weights used in the model have lower precision.
-        Turning this on can improve convergence and accuracy when training with float16.
+        Turning this on can improve convergence and accuracy when training with float16
+        or bfloat16.
     aggregate_num : int, default 1
         Number of weights to be aggregated in a list.
         They are passed to the optimizer for a single optimization step.
@@ -189,7 +189,7 @@ class SGD(Optimizer):
         if aggregate:
             # update `aggregate_num` number of weights in a single kernel.
             # this does not support sparse weight or gradient.
-            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+            multi_precision = self.multi_precision and _is_low_precision(weights[0].dtype)
             if not multi_precision:
                 if self.momentum > 0:
                     multi_sgd_mom_update(*_flatten_list(zip(weights, grads, states)), out=weights,
@@ -212,7 +212,7 @@ class SGD(Optimizer):
                                         lrs=lrs, wds=wds, **kwargs)
         else:
             for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
-                multi_precision = self.multi_precision and weight.dtype == numpy.float16
+                multi_precision = self.multi_precision and _is_low_precision(weight.dtype)
                 if not multi_precision:
                     mom = state
                     if mom is not None:
@@ -224,7 +224,7 @@ class SGD(Optimizer):
                 else:
                     # weight32 is a float32 copy of weight.
                     # in the kernel, we firstly update weight32,
-                    # and then cast the result to float16 and save it to weight.
+                    # and then cast the result to float16 or bfloat16 and save it to weight.
                     weight32, mom = state
                     if mom is not None:
                         mp_sgd_mom_update(weight, grad, mom, weight32, out=weight,
@@ -17,12 +17,49 @@
 # under the License.
 """Optimizer utility functions."""
 from __future__ import absolute_import
+import ctypes
+import numpy
+from ..base import _LIB, check_call
+from ..ndarray import _DTYPE_MX_TO_NP
+
+
+def _get_multi_tensor_max_weights():
+    """Maximum number of weights accepted by one multi-tensor update operator."""
+    size = ctypes.c_int()
+    check_call(_LIB.MXGetMultiTensorMaxWeights(ctypes.byref(size)))
+    return size.value
+
+
+_MAX_MULTI_TENSOR_WEIGHTS = _get_multi_tensor_max_weights()
+
+
+# numpy dtype of bfloat16 NDArrays (mshadow::kBfloat16)
+_BFLOAT16 = _DTYPE_MX_TO_NP[12]
+
+
+def _is_low_precision(dtype):
+    """Whether weights of `dtype` are kept with a float32 master copy when
+    multi-precision training is enabled."""
+    return dtype == numpy.float16 or dtype == _BFLOAT16
 
 
 def _flatten_list(nested_list):
     return [item for sublist in nested_list for item in sublist]
 
 
+def _use_multi_tensor(aggregate_num, weights, grads):
+    """Whether the weights can be updated by multi-tensor update operators,
+    which requires aggregation and dense weights and gradients."""
+    return aggregate_num > 1 and all(w.stype == 'default' and g.stype == 'default'
+                                     for w, g in zip(weights, grads))
+
+
+def _multi_tensor_slices(num_weights, aggregate_num):
+    """Split `num_weights` weights into slices updated by one multi-tensor operator each."""
+    step = int(min(aggregate_num, _MAX_MULTI_TENSOR_WEIGHTS))
+    return [slice(i, min(i + step, num_weights)) for i in range(0, num_weights, step)]
+
+
 def _as_classic(a, allow_np):
     # TODO(junwu): This is a temp solution for allowing converting
     # np.ndarray to mx.nd.NDArray to be fed into the optimizer since
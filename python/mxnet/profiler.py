@@ -21,7 +21,11 @@
 """Profiler setting methods."""
 import ctypes
 import contextlib
+import json
+import struct
 import contextvars
+import http.server
+import threading
 import warnings
 from .base import _LIB, check_call, c_str, ProfileHandle, c_str_array, py_str, KVStoreHandle
 
@@ -61,6 +65,11 @@ def set_config(**kwargs):
         whether to profile kvstore `server` or `worker`.
         server can only be profiled when kvstore is of type dist.
         if this is not passed, defaults to `worker`
+    trace_format : string
+        format of the output file, `json` for chrome trace events by default, or
+        `binary` for per-thread ring buffers of fixed size records that cost a fraction
+        of json and keep the latest MXNET_PROFILER_TRACE_BUFFER_SIZE records of every
+        thread between dumps. Convert binary traces with convert_trace.
     """
     kk = kwargs.keys()
     vv = kwargs.values()
@@ -143,6 +152,178 @@ def dump(finished=True, profile_process='worker'):
                                          profiler_kvstore_handle))
 
 
+def convert_trace(trace_file, json_file):
+    """Convert a trace written with trace_format='binary' to chrome trace json,
+    which chrome://tracing and the Perfetto UI open.
+
+    Parameters
+    ----------
+    trace_file : str
+        binary trace to read
+    json_file : str
+        chrome trace json to write
+
+    Returns
+    -------
+    int
+        the number of records overwritten in the ring buffers before they were dumped
+    """
+    record = struct.Struct('<QQIIIIc7x')
+    chunk = struct.Struct('<II')
+    names, device_names, category_pids = {}, {}, {}
+    # dependencies of an operator are recorded right before its begin record
+    deps = {}
+    dropped = 0
+    with open(trace_file, 'rb') as fin, open(json_file, 'w') as fout:
+        magic = fin.read(8)
+        if magic != b'MXTRACE\0':
+            raise ValueError('{} is not a binary MXNet trace'.format(trace_file))
+        version, record_size = chunk.unpack(fin.read(chunk.size))
+        if version != 1 or record_size != record.size:
+            raise ValueError('Unsupported trace version {}'.format(version))
+        fout.write('{\n    "traceEvents": [\n')
+        sep = ''
+
+        def write(event):
+            nonlocal sep
+            fout.write(sep + json.dumps(event))
+            sep = ',\n'
+
+        def read_names(count, table):
+            for _ in range(count):
+                key, length = chunk.unpack(fin.read(chunk.size))
+                table[key] = fin.read(length).decode('utf-8', 'replace')
+
+        while True:
+            header = fin.read(chunk.size)
+            if len(header) < chunk.size:
+                break
+            kind, count = chunk.unpack(header)
+            kind = chr(kind)
+            if kind == 'N':
+                read_names(count, names)
+            elif kind == 'D':
+                read_names(count, device_names)
+                for pid, name in sorted(device_names.items()):
+                    write({'ph': 'M', 'args': {'name': name}, 'pid': pid,
+                           'name': 'process_name'})
+            elif kind == 'L':
+                dropped += count
+            elif kind == 'R':
+                data = fin.read(count * record.size)
+                for ts, value, name, cat, pid, tid, phase in record.iter_unpack(data):
+                    name, cat, phase = names[name], names[cat], phase.decode()
+                    if pid == 0xFFFFFFFF:
+                        # events not bound to a device are grouped by category
+                        if cat not in category_pids:
+                            category_pids[cat] = len(device_names) + len(category_pids)
+                            write({'ph': 'M', 'args': {'name': cat},
+                                   'pid': category_pids[cat], 'name': 'process_name'})
+                        pid = category_pids[cat]
+                    if phase == 'f':
+                        deps.setdefault((pid, tid), []).append(value)
+                        continue
+                    event = {'name': name, 'cat': cat, 'ph': phase, 'ts': ts,
+                             'pid': pid, 'tid': tid}
+                    if phase == 'B' and value:
+                        event['args'] = {'id': value, 'deps': deps.pop((pid, tid), [])}
+                    elif phase == 'C':
+                        event['args'] = {name: value}
+                    elif phase in 'be':
+                        event['id'] = value
+                    elif phase in 'in':
+                        event['s'] = chr(value)
+                    write(event)
+            else:
+                raise ValueError('Unknown chunk {!r} in {}'.format(kind, trace_file))
+        fout.write('\n    ],\n    "displayTimeUnit": "ms"\n}\n')
+    return dropped
+
+
+def critical_path(trace_file, top=5):
+    """Find the chain of dependent operators that determines the step time.
+
+    The threaded engines record, for every profiled operator, the operators that
+    last wrote the variables it reads or writes. The longest chain of these
+    dependencies bounds the step time however many workers run the other operators,
+    so speeding up an operator off the chain does not make the step faster.
+
+    Parameters
+    ----------
+    trace_file : str
+        chrome trace json written by dump(), or by convert_trace()
+    top : int
+        number of operator names to report in 'speedup'
+
+    Returns
+    -------
+    dict
+        'span': microseconds from the first operator start to the last operator end
+        'critical_path': [(name, microseconds)] of the operators on the longest chain
+        'critical_time': sum of the durations on the longest chain, in microseconds
+        'idle': {(pid, tid): microseconds of the span the worker ran no operator}
+        'speedup': [(name, microseconds)] by how much the longest chain shrinks when
+            the operators of that name take no time, largest first
+    """
+    with open(trace_file) as f:
+        events = json.load(f)['traceEvents']
+    nodes, started = {}, {}
+    for event in events:
+        key = (event.get('pid'), event.get('tid'), event.get('name'))
+        if event.get('ph') == 'B' and 'id' in event.get('args', {}):
+            started[key] = event
+        elif event.get('ph') == 'E' and key in started:
+            begin = started.pop(key)
+            nodes[begin['args']['id']] = (begin['name'], begin['ts'], event['ts'],
+                                          key[:2], begin['args']['deps'])
+    if not nodes:
+        return {'span': 0, 'critical_path': [], 'critical_time': 0, 'idle': {}, 'speedup': []}
+    order = sorted(nodes)
+
+    def longest_chain(skip=None):
+        # an operator is pushed after the operators it depends on, so ids are topological
+        finish, prev = {}, {}
+        for i in order:
+            name, begin, end, _, deps = nodes[i]
+            deps = [d for d in deps if d in finish]
+            prev[i] = max(deps, key=finish.get) if deps else None
+            duration = 0 if name == skip else end - begin
+            finish[i] = duration + (finish[prev[i]] if deps else 0)
+        last = max(finish, key=finish.get)
+        return finish[last], last, prev
+
+    critical_time, last, prev = longest_chain()
+    chain = []
+    while last is not None:
+        chain.append(last)
+        last = prev[last]
+    chain.reverse()
+    path = [(nodes[i][0], nodes[i][2] - nodes[i][1]) for i in chain]
+
+    start = min(n[1] for n in nodes.values())
+    stop = max(n[2] for n in nodes.values())
+    busy = {}
+    for _, begin, end, worker, _ in nodes.values():
+        busy.setdefault(worker, []).append((begin, end))
+    idle = {}
+    for worker, intervals in busy.items():
+        covered, reach = 0, start
+        for begin, end in sorted(intervals):
+            if end > reach:
+                covered += end - max(begin, reach)
+                reach = end
+        idle[worker] = (stop - start) - covered
+
+    on_path = {}
+    for name, duration in path:
+        on_path[name] = on_path.get(name, 0) + duration
+    candidates = sorted(on_path, key=on_path.get, reverse=True)[:top]
+    speedup = sorted(((name, critical_time - longest_chain(name)[0]) for name in candidates),
+                     key=lambda s: s[1], reverse=True)
+    return {'span': stop - start, 'critical_path': path, 'critical_time': critical_time,
+            'idle': idle, 'speedup': speedup}
+
+
 def dump_profile():
     """Dump profile and stop profiler. Use this to save profile
     in advance in case your program cannot exit normally."""
@@ -193,6 +374,110 @@ def dumps(reset=False, format='table', sort_by='total', ascending=False):
     return py_str(debug_str.value)
 
 
+def set_op_histograms(enabled=True):
+    """Enable or disable the always-on operator latency histograms.
+
+    Unlike the profiler, the histograms keep no events and only cost a few
+    nanoseconds per operator, so they can stay enabled in production. They are
+    initially enabled when the environment variable MXNET_OP_HISTOGRAMS is set to 1.
+
+    Parameters
+    ----------
+    enabled : bool
+        whether to record the latency of every operator
+
+    Returns
+    -------
+    bool
+        the previous state
+    """
+    prev = ctypes.c_int()
+    check_call(_LIB.MXProfileSetOpHistograms(ctypes.c_int(enabled), ctypes.byref(prev)))
+    return bool(prev.value)
+
+
+def op_histograms(reset=False):
+    """Return the operator latency histograms recorded so far.
+
+    The result maps 'operator' to the histograms of the operators run by the
+    engine, keyed by their name, and 'node' to the histograms of the nodes of
+    hybridized graphs run in bulked segments on CPU, keyed by their scope and name,
+    and 'dataloader' to the time Gluon DataLoader iterators block for a batch.
+    Each histogram holds the count, sum, min, max and the 50th, 90th, 99th and
+    99.9th percentiles in nanoseconds, and its non-empty buckets as lists of lower
+    bound, upper bound and count. Percentiles are accurate to 1/16 of their value.
+
+    Parameters
+    ----------
+    reset : bool
+        whether the next call only covers operators that complete after this one
+
+    Returns
+    -------
+    dict
+    """
+    out_str = ctypes.c_char_p()
+    check_call(_LIB.MXProfileDumpOpHistograms(ctypes.byref(out_str), ctypes.c_int(reset)))
+    return json.loads(py_str(out_str.value))
+
+
+def metrics():
+    """Return the runtime metrics in the OpenMetrics text format, for scraping by
+    Prometheus or any other OpenMetrics collector.
+
+    The metrics are the engine queue depths and pending operators, the memory in use
+    and pooled by the pooled storage managers of every device, the bytes of dense
+    arrays pushed to and pulled from kvstores, and, while enabled with
+    set_op_histograms, the latency histograms of operators, of the nodes of
+    hybridized graphs and of the time Gluon DataLoader iterators block for a batch.
+
+    Returns
+    -------
+    str
+    """
+    out_str = ctypes.c_char_p()
+    check_call(_LIB.MXProfileDumpMetrics(ctypes.byref(out_str)))
+    return py_str(out_str.value)
+
+
+class _MetricsHandler(http.server.BaseHTTPRequestHandler):
+    """Serve the runtime metrics on GET of any path."""
+    def do_GET(self):  # pylint: disable=invalid-name
+        body = metrics().encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type',
+                         'application/openmetrics-text; version=1.0.0; charset=utf-8')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, *args):  # pylint: disable=arguments-differ
+        pass
+
+
+def start_metrics_server(port=0, host='127.0.0.1'):
+    """Serve the runtime metrics returned by metrics() over HTTP from a daemon thread.
+
+    Parameters
+    ----------
+    port : int
+        port to listen on, or 0 to pick a free one
+    host : str
+        address to listen on, only the local host by default
+
+    Returns
+    -------
+    http.server.ThreadingHTTPServer
+        the server, whose server_address holds the port and whose shutdown()
+        stops serving
+    """
+    server = http.server.ThreadingHTTPServer((host, port), _MetricsHandler)
+    server.daemon_threads = True
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    return server
+
+
 def pause(profile_process='worker'):
     """Pause profiling.
 
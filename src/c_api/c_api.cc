@@ -51,6 +51,7 @@
 #include "./c_api_common.h"
 #include "../operator/custom/custom-inl.h"
 #include "../operator/operator_common.h"
+#include "../operator/optimizer_op-inl.h"
 #include "../operator/subgraph/common.h"
 #include "../operator/tensor/matrix_op-inl.h"
 #include "../operator/tvmop/op_module.h"
@@ -1613,6 +1614,12 @@ int MXGetGPUCount(int* out) {
   API_END();
 }
 
+int MXGetMultiTensorMaxWeights(int* out) {
+  API_BEGIN();
+  *out = mxnet::op::MultiTensorKernelParam<float>::N;
+  API_END();
+}
+
 // Deprecated: use MXGetGPUMemoryInformation64() instead.
 int MXGetGPUMemoryInformation(int dev, int *free_mem, int *total_mem) {
   API_BEGIN();
@@ -1883,6 +1890,7 @@ int MXNDArrayWaitToWrite(NDArrayHandle handle) {
 
 int MXNDArrayWaitAll() {
   API_BEGIN();
+  Imperative::Get()->FlushLazy();
   Engine::Get()->WaitForAll();
   API_END();
 }
@@ -2358,6 +2366,10 @@ int MXNDArrayGetGrad(NDArrayHandle handle, NDArrayHandle *out) {
 int MXNDArrayDetach(NDArrayHandle handle, NDArrayHandle *out) {
   API_BEGIN();
   NDArray *arr = static_cast<NDArray*>(handle);
+  // the detached array does not track a pending deferred or lazy computation
+  if (!Imperative::Get()->is_deferred_compute()) {
+    Imperative::DCInfo::Compute(*arr);
+  }
   *out = new NDArray(arr->Detach());
   API_END();
 }
@@ -2798,11 +2810,25 @@ int MXKVStoreFree(KVStoreHandle handle) {
   API_END();
 }
 
+/*!
+ * \brief Make the arrays handed to a kvstore call safe to use outside of lazy and
+ *        deferred compute: pending values are computed and the lazy trace is flushed,
+ *        so that kvstore reads see computed data and its writes are ordered after the
+ *        reads already recorded in the trace.
+ */
+static void ComputePendingArrays(const NDArrayHandle* arrays, size_t num) {
+  Imperative::Get()->FlushLazy();
+  for (size_t i = 0; i < num; ++i) {
+    Imperative::DCInfo::Compute(*static_cast<NDArray*>(arrays[i]));
+  }
+}
+
 int MXKVStoreInit(KVStoreHandle handle,
                   uint32_t num,
                   const int* keys,
                   NDArrayHandle* vals) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<int> v_keys(num);
   std::vector<NDArray> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2818,6 +2844,7 @@ int MXKVStoreInitEx(KVStoreHandle handle,
                   const char** keys,
                   NDArrayHandle* vals) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<std::string> v_keys(num);
   std::vector<NDArray> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2834,6 +2861,7 @@ int MXKVStorePush(KVStoreHandle handle,
                   NDArrayHandle* vals,
                   int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<int> v_keys(num);
   std::vector<NDArray> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2850,6 +2878,7 @@ int MXKVStorePushEx(KVStoreHandle handle,
                   NDArrayHandle* vals,
                   int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<std::string> v_keys(num);
   std::vector<NDArray> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2866,6 +2895,7 @@ int MXKVStorePull(KVStoreHandle handle,
                   NDArrayHandle* vals,
                   int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<int> v_keys(num);
   std::vector<NDArray*> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2882,6 +2912,7 @@ int MXKVStorePullEx(KVStoreHandle handle,
                     NDArrayHandle* vals,
                     int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<std::string> v_keys(num);
   std::vector<NDArray*> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -2901,6 +2932,8 @@ int MXKVStoreBroadcast(KVStoreHandle handle,
                        NDArrayHandle* outs,
                        int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, vnum);
+  ComputePendingArrays(outs, onum);
   std::vector<int> v_vkeys(vnum);
   std::vector<int> v_okeys(onum);
   std::vector<NDArray> v_vals(vnum);
@@ -2927,6 +2960,8 @@ int MXKVStoreBroadcastEx(KVStoreHandle handle,
                          NDArrayHandle* outs,
                          int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, vnum);
+  ComputePendingArrays(outs, onum);
   std::vector<std::string> v_vkeys(vnum);
   std::vector<std::string> v_okeys(onum);
   std::vector<NDArray> v_vals(vnum);
@@ -2953,6 +2988,8 @@ int MXKVStorePushPull(KVStoreHandle handle,
                       NDArrayHandle* outs,
                       int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, vnum);
+  ComputePendingArrays(outs, onum);
   std::vector<int> v_vkeys(vnum);
   std::vector<int> v_okeys(onum);
   std::vector<NDArray> v_vals(vnum);
@@ -2979,6 +3016,8 @@ int MXKVStorePushPullEx(KVStoreHandle handle,
                         NDArrayHandle* outs,
                         int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, vnum);
+  ComputePendingArrays(outs, onum);
   std::vector<std::string> v_vkeys(vnum);
   std::vector<std::string> v_okeys(onum);
   std::vector<NDArray> v_vals(vnum);
@@ -3003,6 +3042,7 @@ int MXKVStorePullWithSparse(KVStoreHandle handle,
                             int priority,
                             bool ignore_sparse) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<int> v_keys(num);
   std::vector<NDArray*> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -3020,6 +3060,7 @@ int MXKVStorePullWithSparseEx(KVStoreHandle handle,
                               int priority,
                               bool ignore_sparse) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
   std::vector<std::string> v_keys(num);
   std::vector<NDArray*> v_vals(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -3037,6 +3078,8 @@ int MXKVStorePullRowSparse(KVStoreHandle handle,
                            const NDArrayHandle* row_ids,
                            int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
+  ComputePendingArrays(row_ids, num);
   std::vector<int> v_keys(num);
   std::vector<std::pair<NDArray*, NDArray>> v_val_rowids(num);
   for (uint32_t i = 0; i < num; ++i) {
@@ -3055,6 +3098,8 @@ int MXKVStorePullRowSparseEx(KVStoreHandle handle,
                              const NDArrayHandle* row_ids,
                              int priority) {
   API_BEGIN();
+  ComputePendingArrays(vals, num);
+  ComputePendingArrays(row_ids, num);
   std::vector<std::string> v_keys(num);
   std::vector<std::pair<NDArray*, NDArray>> v_val_rowids(num);
   for (uint32_t i = 0; i < num; ++i) {
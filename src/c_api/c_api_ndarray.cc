@@ -116,11 +116,16 @@ void MXImperativeInvokeImpl(AtomicSymbolCreator creator,
 
   if (Imperative::Get()->is_deferred_compute()) {
     Imperative::Get()->RecordDeferredCompute(std::move(attrs), ndinputs, ndoutputs);
+  } else if (Imperative::Get()->is_lazy() &&
+             Imperative::Get()->RecordLazy(attrs, ndinputs, ndoutputs)) {
+    if (Imperative::Get()->is_recording()) {
+      Imperative::Get()->RecordOp(std::move(attrs), ndinputs, ndoutputs);
+    }
   } else {
     for (NDArray* input : ndinputs) {
       Imperative::DCInfo::Compute(*input);
     }
-    auto state = Imperative::Get()->Invoke(Context::CPU(), attrs, ndinputs, ndoutputs);
+    auto state = Imperative::Get()->Invoke(Context::CPU(), attrs, ndinputs, ndoutputs, true);
     if (Imperative::Get()->is_recording()) {
       Imperative::Get()->RecordOp(std::move(attrs), ndinputs, ndoutputs, state);
     }
@@ -237,6 +242,7 @@ int MXInvokeCachedOp(CachedOpHandle handle,
   // construct default context
   Context ctx = Context::Create(static_cast<Context::DeviceType>(default_dev_type),
                                 default_dev_id);
+  Imperative::Get()->FlushLazy();
   op->Forward(op_shared, ndinputs, ndoutputs, ctx);
 
   if (*outputs == nullptr) {
@@ -426,10 +432,24 @@ int MXNDArrayIsDeferredCompute(int *curr) {
 
 int MXNDArraySetIsDeferredCompute(int deferred_compute, int *prev) {
   API_BEGIN();
+  // arrays pending in the lazy trace can not be inputs of a deferred compute graph
+  Imperative::Get()->FlushLazy();
   *prev = Imperative::Get()->set_is_deferred_compute(static_cast<bool>(deferred_compute));
   API_END();
 }
 
+int MXNDArrayIsLazy(int *curr) {
+  API_BEGIN();
+  *curr = Imperative::Get()->is_lazy();
+  API_END();
+}
+
+int MXNDArraySetIsLazy(int lazy, int *prev) {
+  API_BEGIN();
+  *prev = Imperative::Get()->set_is_lazy(static_cast<bool>(lazy));
+  API_END();
+}
+
 int MXNDArraySetDeferredComputeVariable(NDArrayHandle *arrays, SymbolHandle *variables, int num) {
   API_BEGIN();
   Imperative::Get()->SetDeferredComputeVariable(arrays, variables, num);
@@ -34,6 +34,8 @@
 #include "./c_api_common.h"
 #include "../profiler/storage_profiler.h"
 #include "../profiler/profiler.h"
+#include "../profiler/op_histogram.h"
+#include "../profiler/metrics.h"
 
 namespace mxnet {
 
@@ -168,6 +170,10 @@ enum class PrintFormat {
   table, json
 };
 
+enum class TraceFormat {
+  kJSON, kBinary
+};
+
 struct ProfileConfigParam : public dmlc::Parameter<ProfileConfigParam> {
   bool profile_all;
   bool profile_symbolic;
@@ -180,6 +186,7 @@ struct ProfileConfigParam : public dmlc::Parameter<ProfileConfigParam> {
   float dump_period;
   bool aggregate_stats;
   int profile_process;
+  int trace_format;
   DMLC_DECLARE_PARAMETER(ProfileConfigParam) {
     DMLC_DECLARE_FIELD(profile_all).set_default(false)
       .describe("Profile all. Default is False.");
@@ -213,6 +220,14 @@ struct ProfileConfigParam : public dmlc::Parameter<ProfileConfigParam> {
       .describe("Specifies which process to profile: "
                 "worker: this is default. for single node training it should always be worker."
                 "server: for distributed training, this profiles server process");
+    DMLC_DECLARE_FIELD(trace_format)
+      .add_enum("json", static_cast<int>(TraceFormat::kJSON))
+      .add_enum("binary", static_cast<int>(TraceFormat::kBinary))
+      .set_default(static_cast<int>(TraceFormat::kJSON))
+      .describe("Format of the profile file: "
+                "json: chrome trace events, this is default. "
+                "binary: per-thread ring buffers of fixed size records, which cost a "
+                "fraction of json and are converted to it by tools/profile/trace2json.py");
   }
 };
 
@@ -268,7 +283,9 @@ int MXSetProcessProfilerConfig(int num_params, const char* const* keys, const ch
                                            std::string(param.filename),
                                            param.continuous_dump,
                                            param.dump_period,
-                                           param.aggregate_stats);
+                                           param.aggregate_stats,
+                                           static_cast<TraceFormat>(param.trace_format) ==
+                                             TraceFormat::kBinary);
 #if MXNET_USE_CUDA
       profiler::GpuDeviceStorageProfiler::Get()->SetConfig(
           param.gpu_memory_profile_filename_prefix);
@@ -308,6 +325,44 @@ int MXAggregateProfileStatsPrint(const char **out_str, int reset, int format, in
   API_END();
 }
 
+int MXProfileSetOpHistograms(int enable, int* prev) {
+  API_BEGIN();
+    const bool old = profiler::OpHistograms::SetEnabled(enable != 0);
+    if (prev != nullptr) *prev = old;
+  API_END();
+}
+
+int MXProfileDumpOpHistograms(const char **out_str, int reset) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+    CHECK_NOTNULL(out_str);
+    std::ostringstream os;
+    profiler::OpHistograms::Get()->Snapshot(os, reset != 0);
+    ret->ret_str = os.str();
+    *out_str = (ret->ret_str).c_str();
+  API_END();
+}
+
+int MXProfileRecordDataLoaderWait(uint64_t wait_ns) {
+  API_BEGIN();
+    if (profiler::OpHistograms::Enabled()) {
+      profiler::OpHistograms::Get()->Record(profiler::OpHistograms::kDataLoader,
+                                            "DataLoader", wait_ns);
+    }
+  API_END();
+}
+
+int MXProfileDumpMetrics(const char **out_str) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+    CHECK_NOTNULL(out_str);
+    std::ostringstream os;
+    profiler::Metrics::Get()->Render(os);
+    ret->ret_str = os.str();
+    *out_str = (ret->ret_str).c_str();
+  API_END();
+}
+
 int MXDumpProfile(int finished) {
   return MXDumpProcessProfile(finished, static_cast<int>(ProfileProcess::kWorker), nullptr);
 }
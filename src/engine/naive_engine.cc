@@ -29,6 +29,7 @@
 #include <vector>
 #include "./engine_impl.h"
 #include "../profiler/profiler.h"
+#include "../profiler/op_histogram.h"
 #include "./openmp.h"
 #include "../common/object_pool.h"
 #include "../profiler/custom_op_profiler.h"
@@ -62,6 +63,8 @@ class NaiveEngine final : public Engine {
     bool profiling{false};
     /*! \brief operator execution statistics */
     std::unique_ptr<profiler::ProfileOperator> opr_profile;
+    /*! \brief work of the operator, reported by the aggregate stats of the profiler */
+    profiler::OprCost cost;
   };
 
   NaiveEngine() {
@@ -110,6 +113,7 @@ class NaiveEngine final : public Engine {
     opr->mutable_vars = mutable_vars;
     opr->prop = prop;
     opr->opr_name = opr_name ? std::string(opr_name) : std::string();
+    profiler::OprCostScope::Take(&opr->cost);
     return opr;
   }
 
@@ -130,6 +134,9 @@ class NaiveEngine final : public Engine {
           }
           opr->opr_profile = std::make_unique<profiler::ProfileOperator>(opr->opr_name.c_str(),
                                                                attrs.release());
+          if (opr->cost.flops || opr->cost.bytes) {
+            opr->opr_profile->SetCost(opr->cost);
+          }
           opr->opr_profile->startForDevice(exec_ctx.dev_type, exec_ctx.dev_id);
         }
         opr->fn(ctx, on_complete);
@@ -181,8 +188,13 @@ class NaiveEngine final : public Engine {
       }
       opr->opr_profile = std::make_unique<profiler::ProfileOperator>(opr->opr_name.c_str(),
                                                                      attrs.release());
+      if (opr->cost.flops || opr->cost.bytes) {
+        opr->opr_profile->SetCost(opr->cost);
+      }
       opr->opr_profile->startForDevice(exec_ctx.dev_type, exec_ctx.dev_id);
     }
+    const uint64_t hist_start = opr_name && profiler::OpHistograms::Enabled() ?
+                                profiler::OpHistograms::NowInNanosec() : 0;
     if (exec_ctx.dev_mask() == gpu::kDevMask) {
 #if MXNET_USE_CUDA
       size_t dev_id = static_cast<size_t>(exec_ctx.dev_id);
@@ -211,6 +223,10 @@ class NaiveEngine final : public Engine {
     if (profiling) {
       opr->opr_profile->stop();
     }
+    if (hist_start != 0) {
+      profiler::OpHistograms::Get()->Record(profiler::OpHistograms::kOperator, opr_name,
+                                            profiler::OpHistograms::NowInNanosec() - hist_start);
+    }
   }
 
   void DeleteVariable(SyncFn delete_fn, Context exec_ctx, VarHandle var) override {
@@ -19,6 +19,7 @@
 #include <dmlc/omp.h>
 #include <dmlc/base.h>
 #include <dmlc/parameter.h>
+#include <algorithm>
 #include <climits>
 #include "./openmp.h"
 
@@ -33,13 +34,22 @@ static inline bool is_env_set(const char *var) {
   return dmlc::GetEnv(var, INT_MIN) != INT_MIN;
 }
 
+/*!
+ * \brief Number of busy CPU workers seen when the operator running on this thread started,
+ *        0 outside of an OperatorScope
+ */
+static thread_local int sharing_workers = 0;
+
 OpenMP *OpenMP::Get() {
   static OpenMP openMP;
   return &openMP;
 }
 
 OpenMP::OpenMP()
-  : omp_num_threads_set_in_environment_(is_env_set("OMP_NUM_THREADS")) {
+  : share_threads_(dmlc::GetEnv("MXNET_OMP_SHARE_THREADS", true) &&
+                   !dmlc::GetEnv("MXNET_ENFORCE_DETERMINISM", false))
+  , min_iterations_per_thread_(dmlc::GetEnv("MXNET_OMP_MIN_ITERATIONS_PER_THREAD", size_t(1)))
+  , omp_num_threads_set_in_environment_(is_env_set("OMP_NUM_THREADS")) {
 #ifdef _OPENMP
   initialize_process();
   const int max = dmlc::GetEnv("MXNET_OMP_MAX_THREADS", INT_MIN);
@@ -104,10 +114,16 @@ int OpenMP::GetRecommendedOMPThreadCount(bool exclude_reserved) const {
       }
     }
     // Check that OMP doesn't suggest more than our 'omp_thread_max_' value
-    if (!omp_thread_max_ || thread_count < omp_thread_max_) {
-      return thread_count;
+    if (omp_thread_max_ && thread_count > omp_thread_max_) {
+      thread_count = omp_thread_max_;
+    }
+    // Split the threads between the operators that were running on the CPU workers when
+    // this one started, which would otherwise each start thread_count threads
+    const int busy = sharing_workers;
+    if (busy > 1) {
+      thread_count = thread_count > busy ? thread_count / busy : 1;
     }
-    return omp_thread_max_;
+    return thread_count;
   } else {
     return 1;
   }
@@ -116,6 +132,31 @@ int OpenMP::GetRecommendedOMPThreadCount(bool exclude_reserved) const {
 #endif
 }
 
+int OpenMP::GetRecommendedOMPThreadCountFor(size_t iterations) const {
+  const int thread_count = GetRecommendedOMPThreadCount();
+  const size_t chunks = min_iterations_per_thread_ > 1
+                        ? (iterations + min_iterations_per_thread_ - 1) / min_iterations_per_thread_
+                        : iterations;
+  return chunks < static_cast<size_t>(thread_count) ? static_cast<int>(std::max<size_t>(chunks, 1))
+                                                    : thread_count;
+}
+
+OpenMP::OperatorScope::OperatorScope(bool counted)
+  : counted_(counted), prev_sharing_workers_(sharing_workers) {
+  if (counted_) {
+    OpenMP *omp = OpenMP::Get();
+    omp->on_start_operator();
+    sharing_workers = omp->share_threads_ ? omp->busy_workers() : 0;
+  }
+}
+
+OpenMP::OperatorScope::~OperatorScope() {
+  if (counted_) {
+    OpenMP::Get()->on_finish_operator();
+    sharing_workers = prev_sharing_workers_;
+  }
+}
+
 OpenMP *__init_omp__ = OpenMP::Get();
 
 }  // namespace engine
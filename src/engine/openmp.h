@@ -19,6 +19,9 @@
 #ifndef MXNET_ENGINE_OPENMP_H_
 #define MXNET_ENGINE_OPENMP_H_
 
+#include <atomic>
+#include <cstddef>
+
 namespace mxnet {
 namespace engine {
 
@@ -38,6 +41,14 @@ class OpenMP {
    */
   int GetRecommendedOMPThreadCount(bool exclude_reserved = true) const;
 
+  /*!
+   * \brief Get the recommended number of OMP threads for a parallel loop
+   * \param iterations Number of iterations of the loop
+   * \return Recommended number of OMP threads, no more than there are chunks of
+   *         MXNET_OMP_MIN_ITERATIONS_PER_THREAD iterations
+   */
+  int GetRecommendedOMPThreadCountFor(size_t iterations) const;
+
   /*!
    * \brief Set whether clients of this class receive pro-OMP behavior guidance
    * \param enabled Set to 'true' if this class should provide OMP behavior
@@ -67,6 +78,38 @@ class OpenMP {
    */
   int reserve_cores() const { return reserve_cores_; }
 
+  /*!
+   * \brief Call when a worker of the normal CPU pool starts running an operator.  While
+   *        several operators run at once, they share the OMP threads instead of each using
+   *        all of them
+   */
+  void on_start_operator() { ++busy_workers_; }
+  /*!
+   * \brief Call when a worker of the normal CPU pool finished running an operator
+   */
+  void on_finish_operator() { --busy_workers_; }
+  /*!
+   * \brief Number of normal CPU pool workers running an operator
+   * \return Number of busy CPU worker threads
+   */
+  int busy_workers() const { return busy_workers_.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Marks the calling CPU worker thread busy for its lifetime.  The share of the
+   *        OMP threads is taken when the scope starts and stays the same for the whole
+   *        operator, so its parallel regions all use the same number of threads
+   */
+  class OperatorScope {
+   public:
+    explicit OperatorScope(bool counted);
+    ~OperatorScope();
+
+   private:
+    const bool counted_;
+    /*! \brief Share of the enclosing scope on this thread, restored on exit */
+    const int prev_sharing_workers_;
+  };
+
   /*!
    * \brief Call at the beginning of a worker thread's life.  This will set the omp_num_threads
    *        for omp regions created by this thread
@@ -101,6 +144,19 @@ class OpenMP {
    * \brief Number of cores to reserve for non-OMP regions
    */
   volatile int reserve_cores_ = 0;
+  /*!
+   * \brief Number of CPU worker threads running an operator
+   */
+  std::atomic<int> busy_workers_{0};
+  /*!
+   * \brief Whether operators running at once share the OMP threads (MXNET_OMP_SHARE_THREADS,
+   *        off when MXNET_ENFORCE_DETERMINISM is set)
+   */
+  const bool share_threads_;
+  /*!
+   * \brief Fewest iterations of a parallel loop given to each thread
+   */
+  const size_t min_iterations_per_thread_;
   /*!
    * \brief Whether OMP_NUM_THREADS was set in the environment.  If it is, we fall back to
    *        the OMP's implementation's handling of that environment variable
@@ -50,6 +50,9 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
   std::lock_guard<std::mutex> lock{mutex_};
+  if (opr_block->profile_id && last_writer_) {
+    opr_block->profile_deps.push_back(last_writer_);
+  }
   if (pending_write_ == nullptr) {
     // invariant: is_ready_to_read()
     CHECK_GE(num_pending_reads_, 0);
@@ -72,6 +75,10 @@ inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
 inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   auto&& new_var_block = VersionedVarBlock::New();
   std::lock_guard<std::mutex> lock{mutex_};
+  if (opr_block->profile_id && last_writer_) {
+    opr_block->profile_deps.push_back(last_writer_);
+  }
+  last_writer_ = opr_block->profile_id;
   // invariant.
   assert(head_->next == nullptr);
   assert(head_->trigger == nullptr);
@@ -220,6 +227,7 @@ ThreadedOpr* ThreadedEngine::NewOperator(
   ret->opr_name = opr_name ? std::string(opr_name) : std::string();
   ret->fn = std::move(fn);
   ret->prop = prop;
+  profiler::OprCostScope::Take(&ret->cost);
   ret->const_vars.resize(const_vars.size());
   ret->mutable_vars.resize(mutable_vars.size());
   ret->wait = wait;
@@ -301,6 +309,10 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
   opr_block->ctx = exec_ctx;
   opr_block->priority = priority;
   opr_block->profiling = profiling;
+  if (profiling) {
+    static std::atomic<uint64_t> profile_counter{0};
+    opr_block->profile_id = ++profile_counter;
+  }
   ++pending_;
   // Add read dependencies.
   for (auto&& i : threaded_opr->const_vars) {
@@ -519,6 +531,12 @@ void ThreadedEngine::OnCompleteStatic(Engine *engine, void *opr_block_,
     // record operator end timestamp
     opr_block->opr_profile->stop();
   }
+  if (opr_block->hist_start != 0) {
+    profiler::OpHistograms::Get()->Record(
+        profiler::OpHistograms::kOperator, threaded_opr->opr_name,
+        profiler::OpHistograms::NowInNanosec() - opr_block->hist_start);
+    opr_block->hist_start = 0;
+  }
   static_cast<ThreadedEngine*>(engine)->OnComplete(threaded_opr);
   OprBlock::Delete(opr_block);
 }
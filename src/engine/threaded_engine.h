@@ -41,6 +41,8 @@
 #include <thread>
 #include "./engine_impl.h"
 #include "../profiler/profiler.h"
+#include "../profiler/op_histogram.h"
+#include "../profiler/metrics.h"
 #include "./openmp.h"
 #include "../common/object_pool.h"
 #include "../profiler/custom_op_profiler.h"
@@ -83,6 +85,12 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
   bool profiling{false};
   /*! \brief operator execution statistics */
   std::unique_ptr<profiler::ProfileOperator> opr_profile;
+  /*! \brief start time in ns for the latency histograms, 0 if they are disabled */
+  uint64_t hist_start{0};
+  /*! \brief id in the profiler's dependency graph, 0 if not profiled */
+  uint64_t profile_id{0};
+  /*! \brief profile ids of the last writers of the variables this operator uses */
+  std::vector<uint64_t> profile_deps;
   // define possible debug information
   DEFINE_ENGINE_DEBUG_INFO(OprBlock);
   /*!
@@ -217,6 +225,11 @@ class ThreadedVar final
    * \brief If true, delete after operation completes.
    */
   bool to_delete_{false};
+  /*!
+   * \brief profile id of the last pushed write, which produces the next version.
+   *  The operators that use this version depend on it in the profiler's graph.
+   */
+  uint64_t last_writer_{0};
   /*! \brief special const on num_pending_reads_ to mark write being triggered */
   static constexpr int kWriteTriggered = -1;
   /*!
@@ -252,6 +265,8 @@ struct ThreadedOpr final : public Opr,
    * \brief Whether this is a WaitForVar operation
    */
   bool wait{false};
+  /*! \brief work of the operation, reported by the aggregate stats of the profiler */
+  profiler::OprCost cost;
   /*!
    * \brief Cast a Opr pointer to ThreadedOpr pointer
    * \param ptr pointer from base.
@@ -324,8 +339,16 @@ class ThreadedEngine : public Engine {
 
     // Get a ref to the profiler so that it doesn't get killed before us
     profiler::Profiler::Get(&profiler_);
+
+    metrics_collector_ = profiler::Metrics::Get()->AddCollector(
+        [this](std::vector<profiler::Metrics::Gauge>* gauges) {
+          gauges->push_back({"mxnet_engine_pending_operators",
+                             "Operators pushed to the engine that have not completed.",
+                             {}, static_cast<double>(pending_.load())});
+        });
   }
   ~ThreadedEngine() {
+    profiler::Metrics::Get()->RemoveCollector(metrics_collector_);
     {
       std::unique_lock<std::mutex> lock{finished_m_};
       kill_.store(true);
@@ -359,8 +382,17 @@ class ThreadedEngine : public Engine {
       const Context& ctx = opr_block->ctx;
       opr_block->opr_profile.reset(new profiler::ProfileOperator(threaded_opr->opr_name.c_str(),
                                                                  attrs.release()));
+      if (threaded_opr->cost.flops || threaded_opr->cost.bytes) {
+        opr_block->opr_profile->SetCost(threaded_opr->cost);
+      }
+      if (opr_block->profile_id) {
+        opr_block->opr_profile->SetDependencies(opr_block->profile_id, &opr_block->profile_deps);
+      }
       opr_block->opr_profile->startForDevice(ctx.dev_type, ctx.dev_id);
     }
+    if (profiler::OpHistograms::Enabled() && threaded_opr->opr_name.size()) {
+      opr_block->hist_start = profiler::OpHistograms::NowInNanosec();
+    }
     CallbackOnComplete callback =
         this->CreateCallback(ThreadedEngine::OnCompleteStatic, opr_block);
     const bool debug_info = (engine_info_ && debug_push_opr_ == opr_block);
@@ -442,6 +474,8 @@ class ThreadedEngine : public Engine {
     std::vector<VarHandle> const_vars;
     /*! \brief mutable variables */
     std::vector<VarHandle> mutable_vars;
+    /*! \brief summed work of current ops */
+    profiler::OprCost cost;
   };
   /*! thread local store for bulk */
   typedef dmlc::ThreadLocalStore<BulkStatus> BulkStatusStore;
@@ -521,6 +555,12 @@ class ThreadedEngine : public Engine {
         bulk_status.const_vars.end(), const_vars.begin(), const_vars.end());
     bulk_status.mutable_vars.insert(
         bulk_status.mutable_vars.end(), mutable_vars.begin(), mutable_vars.end());
+    profiler::OprCost cost;
+    if (profiler::OprCostScope::Take(&cost)) {
+      bulk_status.cost.flops += cost.flops;
+      bulk_status.cost.bytes += cost.bytes;
+      bulk_status.cost.group = std::move(cost.group);
+    }
 
     if (bulk_status.count >= bulk_status.bulk_size) BulkFlush();
   }
@@ -531,6 +571,12 @@ class ThreadedEngine : public Engine {
     bulk_status.count = 0;
     DeduplicateVarHandle(&bulk_status.const_vars, &bulk_status.mutable_vars);
     auto functions = bulk_status.functions;
+    // the bulk takes the summed cost of its ops
+    std::unique_ptr<profiler::OprCostScope> cost_scope;
+    if (bulk_status.cost.flops || bulk_status.cost.bytes) {
+      cost_scope.reset(new profiler::OprCostScope(bulk_status.cost));
+      bulk_status.cost = profiler::OprCost();
+    }
     this->PushAsync([functions](RunContext ctx, CallbackOnComplete on_complete) {
         ctx.is_bulk = true;
         for (auto& fn : *functions) {
@@ -554,6 +600,8 @@ class ThreadedEngine : public Engine {
    * \brief Number of pending operations.
    */
   std::atomic<int> pending_{0};
+  /*! \brief id of the collector exporting the number of pending operations */
+  int metrics_collector_{-1};
   /*! \brief whether we want to kill the waiters */
   std::atomic<bool> kill_{false};
   /*! \brief whether it is during shutdown phase*/
@@ -30,6 +30,9 @@
 #include <dmlc/thread_group.h>
 
 #include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "../initialize.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
@@ -62,6 +65,10 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   }
 
   void StopNoWait() {
+    if (queue_collector_ >= 0) {
+      profiler::Metrics::Get()->RemoveCollector(queue_collector_);
+      queue_collector_ = -1;
+    }
     SignalQueuesForKill();
     gpu_normal_workers_.Clear();
     gpu_priority_workers_.Clear();
@@ -91,6 +98,10 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
           this->CPUWorker(Context(), cpu_priority_worker_.get(), ready_event);
         }, true);
     // GPU tasks will be created lazily
+    queue_collector_ = profiler::Metrics::Get()->AddCollector(
+        [this](std::vector<profiler::Metrics::Gauge>* gauges) {
+          this->CollectQueueDepths(gauges);
+        });
   }
 
  protected:
@@ -218,6 +229,8 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
 
   /*! \brief whether this is a worker thread. */
   static MX_THREAD_LOCAL bool is_worker_;
+  /*! \brief id of the collector exporting the queue depths, added while started */
+  int queue_collector_{-1};
   /*! \brief number of concurrent thread cpu worker uses */
   size_t cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
@@ -297,6 +310,9 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     OpenMP::Get()->on_start_worker_thread(true);
 
     while (task_queue->Pop(&opr_block)) {
+      // Only the normal pool shares the OMP threads: the priority worker and operators run
+      // inline on the pusher thread do not take threads away from the other operators
+      OpenMP::OperatorScope omp_scope(type == kWorkerQueue);
       this->ExecuteOprBlock(run_ctx, opr_block);
     }
   }
@@ -340,6 +356,40 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
   }
+
+  /*! \brief Export the depth of the task queue of a worker */
+  static inline void AddQueueDepth(Context::DeviceType dev_type, size_t dev_id,
+                                   const char *queue, size_t depth,
+                                   std::vector<profiler::Metrics::Gauge> *gauges) {
+    Context ctx;
+    ctx.dev_type = dev_type;
+    ctx.dev_id = static_cast<int32_t>(dev_id);
+    std::ostringstream device;
+    device << ctx;
+    gauges->push_back({"mxnet_engine_queue_depth",
+                       "Operators ready to run waiting in the task queue of a worker.",
+                       {{"device", device.str()}, {"queue", queue}},
+                       static_cast<double>(depth)});
+  }
+
+  /*! \brief Export the depths of the task queues of a kind of worker */
+  template<typename Object>
+  static inline void CollectQueueDepths(common::LazyAllocArray<Object> *array,
+                                        Context::DeviceType dev_type, const char *queue,
+                                        std::vector<profiler::Metrics::Gauge> *gauges) {
+    array->ForEach([=](size_t i, Object *block) {
+      AddQueueDepth(dev_type, i, queue, block->task_queue.Size(), gauges);
+    });
+  }
+
+  /*! Export the depths of all queues */
+  void CollectQueueDepths(std::vector<profiler::Metrics::Gauge> *gauges) {
+    CollectQueueDepths(&cpu_normal_workers_, Context::kCPU, "normal", gauges);
+    AddQueueDepth(Context::kCPU, 0, "priority", cpu_priority_worker_->task_queue.Size(), gauges);
+    CollectQueueDepths(&gpu_normal_workers_, Context::kGPU, "normal", gauges);
+    CollectQueueDepths(&gpu_priority_workers_, Context::kGPU, "priority", gauges);
+    CollectQueueDepths(&gpu_copy_workers_, Context::kGPU, "copy", gauges);
+  }
 };
 
 Engine *CreateThreadedEnginePerDevice() {
@@ -19,6 +19,7 @@
 #include <memory>
 #include <unordered_set>
 #include <iostream>
+#include <sstream>
 #include "./imperative_utils.h"
 #include "./cached_op.h"
 #include "./exec_pass.h"
@@ -52,8 +53,28 @@ CachedOp::CachedOp(
 
   auto grad_graph = nnvm::Graph();
   std::unordered_map<uint32_t, uint32_t> fwd_input_to_grad_output;
-  CreateFullGraph(sym.Copy(), &fwd_graph_, &grad_graph, &full_graph_,
-                  &ograd_entries_, &fwd_input_to_grad_output);
+  disk_cache_ = CachedOpDiskCache::Create(sym, flags);
+  if (disk_cache_ == nullptr ||
+      !disk_cache_->LoadGraph("base", &fwd_graph_, &grad_graph, &full_graph_,
+                              &ograd_entries_, &fwd_input_to_grad_output, nullptr)) {
+    CreateFullGraph(sym.Copy(), &fwd_graph_, &grad_graph, &full_graph_,
+                    &ograd_entries_, &fwd_input_to_grad_output);
+    if (disk_cache_ != nullptr) {
+      disk_cache_->SaveGraph("base", full_graph_, fwd_graph_.outputs.size(), ograd_entries_,
+                             fwd_input_to_grad_output, std::vector<size_t>());
+    }
+  }
+
+  // The profiler scope of the first output names the CachedOp, or else the output
+  if (!fwd_graph_.outputs.empty()) {
+    const nnvm::NodeAttrs& attrs = fwd_graph_.outputs[0].node->attrs;
+    profiler_name_ = common::NodeAttrsGetProfilerScope(attrs);
+    if (profiler_name_ == MXNET_STORAGE_DEFAULT_PROFILER_SCOPE_CSTR) {
+      profiler_name_ = attrs.name;
+    } else if (profiler_name_.back() == ':') {
+      profiler_name_.pop_back();
+    }
+  }
 
   {
     const auto& idx = fwd_graph_.indexed_graph();
@@ -131,6 +152,20 @@ std::vector<nnvm::NodeEntry> CachedOp::Gradient(
   return ret;
 }
 
+/*! \brief name of a forward plan in the disk cache */
+static std::string PlanName(const std::string& graph_name,
+                            const std::string& prefix,
+                            const mxnet::ShapeVector& shape_inputs,
+                            const nnvm::DTypeVector& dtype_inputs,
+                            const StorageTypeVector& storage_type_inputs) {
+  std::ostringstream os;
+  os << graph_name << '|' << prefix << '|';
+  for (size_t i = 0; i < shape_inputs.size(); ++i) {
+    os << shape_inputs[i] << ':' << dtype_inputs[i] << ':' << storage_type_inputs[i] << ';';
+  }
+  return os.str();
+}
+
 bool CachedOp::CheckDynamicShapeExists(const Context& default_ctx,
                                        const std::vector<NDArray*>& inputs,
                                        bool erase_result) {
@@ -151,6 +186,21 @@ bool CachedOp::CheckDynamicShapeExists(const Context& default_ctx,
   for (size_t i = 0; i < inputs.size(); ++i) {
     shape_inputs[i] = inputs[state.info.input_map[i]]->shape();
   }
+  // Plans are only saved for graphs without dynamic shape.
+  if (disk_cache_ != nullptr && !state.info.cache_name.empty()) {
+    DTypeVector dtype_inputs(inputs.size());
+    StorageTypeVector storage_type_inputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      dtype_inputs[i] = inputs[state.info.input_map[i]]->dtype();
+      storage_type_inputs[i] = inputs[state.info.input_map[i]]->storage_type();
+    }
+    for (const std::string& prefix : {FORWARD, FULL}) {
+      if (disk_cache_->HasPlan(PlanName(state.info.cache_name, prefix, shape_inputs,
+                                        dtype_inputs, storage_type_inputs))) {
+        return false;
+      }
+    }
+  }
   // We leverage the shape inference pass to detect whether dynamic shape exists.
   // If so, the pass will fail with `contain_dynamic_shape = true`,
   // This method is only called once, so the overhead is negligible.
@@ -184,6 +234,32 @@ bool CachedOp::SetForwardGraph(
     storage_type_inputs[i] = inputs[info->input_map[i]]->storage_type();
   }
 
+  const std::string& prefix = recording ? FULL : FORWARD;
+  std::string plan_name;
+  if (disk_cache_ != nullptr && !info->cache_name.empty()) {
+    plan_name = PlanName(info->cache_name, prefix, shape_inputs, dtype_inputs,
+                         storage_type_inputs);
+    const bool inputs_match =
+        g.attrs.count("shape_inputs") &&
+        g.GetAttr<ShapeVector>("shape_inputs") == shape_inputs &&
+        g.attrs.count("dtype_inputs") &&
+        g.GetAttr<DTypeVector>("dtype_inputs") == dtype_inputs &&
+        g.attrs.count("storage_type_inputs") &&
+        g.GetAttr<StorageTypeVector>("storage_type_inputs") == storage_type_inputs &&
+        g.attrs.count("dev_mask") &&
+        g.GetAttr<exec::DevMaskVector>("dev_mask") ==
+            exec::DevMaskVector(g.indexed_graph().num_nodes(), default_ctx.dev_mask());
+    if (!inputs_match) {
+      g.attrs.erase(AddPrefix(FORWARD, MEM_PLAN));
+      g.attrs.erase(AddPrefix(FULL, MEM_PLAN));
+      if (disk_cache_->LoadPlan(plan_name, AddPrefix(prefix, MEM_PLAN),
+                                AddPrefix(prefix, STORAGE_PLAN), default_ctx.dev_mask(),
+                                shape_inputs, dtype_inputs, storage_type_inputs, &g)) {
+        return false;
+      }
+    }
+  }
+
   bool match = true;
   bool contain_dynamic_shape = false;
   match &= CheckAndInferShape(&g, std::move(shape_inputs), true,
@@ -199,7 +275,6 @@ bool CachedOp::SetForwardGraph(
     g.attrs.erase(AddPrefix(FULL, MEM_PLAN));
     return false;
   }
-  const std::string& prefix = recording ? FULL : FORWARD;
   if (!match) {
     g.attrs.erase(AddPrefix(FORWARD, MEM_PLAN));
     g.attrs.erase(AddPrefix(FULL, MEM_PLAN));
@@ -227,6 +302,10 @@ bool CachedOp::SetForwardGraph(
       AddPrefix(prefix, STORAGE_PLAN));
   g.attrs[AddPrefix(prefix, MEM_PLAN)] =
       std::make_shared<dmlc::any>(std::move(mem_plan));
+  if (!plan_name.empty()) {
+    disk_cache_->SavePlan(plan_name, AddPrefix(prefix, MEM_PLAN),
+                          AddPrefix(prefix, STORAGE_PLAN), g);
+  }
 
   return false;
 }
@@ -373,7 +452,7 @@ OpStatePtr CachedOp::GetCachedOpState(
     }
   }
   auto state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph_,
-                                                     inlining_);
+                                                     inlining_, disk_cache_.get());
 
   cached_op_states_[ctx].push_back(state_ptr);
   return state_ptr;
@@ -813,6 +892,9 @@ OpStatePtr CachedOp::Forward(
     }
   }
 
+  // The aggregate stats of the profiler also sum the operators of the forward pass
+  // under the CachedOp
+  profiler::OprCostScope cost_scope(profiler_name_);
   int prev_bulk_size = Engine::Get()->set_bulk_size(config_.forward_bulk_size);
 
   OpStatePtr op_state;
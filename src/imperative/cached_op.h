@@ -31,6 +31,7 @@
 #include "../operator/operator_common.h"
 #include "../operator/subgraph/common.h"
 #include "./imperative_utils.h"
+#include "./cached_op_cache.h"
 #include "../nnvm/error.h"
 
 namespace mxnet {
@@ -536,20 +537,39 @@ class CachedOp {
     std::unordered_map<uint32_t, uint32_t> fwd_input_to_grad_output;
     std::vector<OpReqType> bwd_output_reqs;
     std::vector<uint32_t> bwd_input_eid;
+    // name of the graph in the disk cache, empty if it is not cached
+    std::string cache_name;
   };
 
   struct CachedOpState {
     CachedOpState(const Context &context_, const nnvm::Graph &fwd_graph_,
-                  const nnvm::Graph &full_graph_, const bool inlining_) {
+                  const nnvm::Graph &full_graph_, const bool inlining_,
+                  CachedOpDiskCache* disk_cache = nullptr) {
       context = context_;
-      nnvm::Symbol sym;
-      sym.outputs = fwd_graph_.outputs;
-      CreateFullGraph(sym.Copy(), &info.fwd_graph, &info.grad_graph,
-                      &info.full_graph, &info.ograd_entries,
-                      &info.fwd_input_to_grad_output);
-
-      OptimizeGraph(&info.full_graph, &info.fwd_graph, &info.grad_graph, &info.input_map,
-                    context_, fwd_graph_.outputs.size(), inlining_);
+      if (disk_cache != nullptr) {
+        info.cache_name = "optimized_" + std::to_string(context_.dev_mask()) +
+                          "_" + std::to_string(inlining_);
+      }
+      if (disk_cache != nullptr &&
+          disk_cache->LoadGraph(info.cache_name, &info.fwd_graph, &info.grad_graph,
+                                &info.full_graph, &info.ograd_entries,
+                                &info.fwd_input_to_grad_output, &info.input_map)) {
+        SetRefCounts(&info.fwd_graph, info.full_graph);
+      } else {
+        nnvm::Symbol sym;
+        sym.outputs = fwd_graph_.outputs;
+        CreateFullGraph(sym.Copy(), &info.fwd_graph, &info.grad_graph,
+                        &info.full_graph, &info.ograd_entries,
+                        &info.fwd_input_to_grad_output);
+
+        OptimizeGraph(&info.full_graph, &info.fwd_graph, &info.grad_graph, &info.input_map,
+                      context_, fwd_graph_.outputs.size(), inlining_);
+        if (disk_cache != nullptr) {
+          disk_cache->SaveGraph(info.cache_name, info.full_graph, fwd_graph_.outputs.size(),
+                                info.ograd_entries, info.fwd_input_to_grad_output,
+                                info.input_map);
+        }
+      }
 
       size_t max_nodes = info.full_graph.indexed_graph().num_nodes();
       size_t max_entries = info.full_graph.indexed_graph().num_node_entries();
@@ -657,6 +677,10 @@ class CachedOp {
   std::vector<uint32_t> bwd_in_dep_, bwd_out_dep_, bwd_ograd_dep_;
   std::vector<bool> save_inputs_, save_outputs_;
   std::vector<OpReqType> bwd_output_reqs_;
+  // persists the graphs and forward memory plans, see MXNET_CACHED_OP_CACHE_DIR
+  std::shared_ptr<CachedOpDiskCache> disk_cache_;
+  // name of the CachedOp in the aggregate stats of the profiler
+  std::string profiler_name_;
 
   std::function<void(const char*, const char*, NDArrayHandle)> monitor_callback_{nullptr};
   bool monitor_all_{false};
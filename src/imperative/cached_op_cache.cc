@@ -0,0 +1,446 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cached_op_cache.cc
+ * \brief Persists the graphs and memory plans CachedOp derives from a symbol
+ */
+#include <mxnet/libinfo.h>
+#include <nnvm/pass_functions.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include "./cached_op_cache.h"
+#include "./imperative_utils.h"
+#include "../common/utils.h"
+
+namespace mxnet {
+
+namespace {
+
+/*! \brief whether every node of the graph can be rebuilt from its JSON */
+bool IsSerializable(const std::vector<nnvm::NodeEntry>& outputs) {
+  bool ret = true;
+  nnvm::DFSVisit(outputs, [&ret](const nnvm::ObjectPtr& n) {
+    if (!ret || n->is_variable()) return;
+    // Nodes such as the fusion helpers hold state that is not in their attributes.
+    if (!n->attrs.parsed.empty() && n->op()->attr_parser == nullptr) {
+      ret = false;
+      return;
+    }
+    for (const auto& subgraph : n->attrs.subgraphs) {
+      if (!IsSerializable(subgraph->outputs)) {
+        ret = false;
+        return;
+      }
+    }
+  });
+  return ret;
+}
+
+}  // namespace
+
+void CachedOpDiskCache::GraphRecord::Save(dmlc::JSONWriter* writer) const {
+  writer->BeginObject();
+  writer->WriteObjectKeyValue("graph", graph);
+  writer->WriteObjectKeyValue("num_forward_outputs", num_forward_outputs);
+  writer->WriteObjectKeyValue("ograd_nodes", ograd_nodes);
+  writer->WriteObjectKeyValue("ograd_names", ograd_names);
+  writer->WriteObjectKeyValue("grad_inputs", grad_inputs);
+  writer->WriteObjectKeyValue("grad_outputs", grad_outputs);
+  writer->WriteObjectKeyValue("input_map", input_map);
+  writer->EndObject();
+}
+
+void CachedOpDiskCache::GraphRecord::Load(dmlc::JSONReader* reader) {
+  dmlc::JSONObjectReadHelper helper;
+  helper.DeclareField("graph", &graph);
+  helper.DeclareField("num_forward_outputs", &num_forward_outputs);
+  helper.DeclareField("ograd_nodes", &ograd_nodes);
+  helper.DeclareField("ograd_names", &ograd_names);
+  helper.DeclareField("grad_inputs", &grad_inputs);
+  helper.DeclareField("grad_outputs", &grad_outputs);
+  helper.DeclareField("input_map", &input_map);
+  helper.ReadAllFields(reader);
+}
+
+void CachedOpDiskCache::PlanRecord::Save(dmlc::JSONWriter* writer) const {
+  writer->BeginObject();
+  writer->WriteObjectKeyValue("shapes", shapes);
+  writer->WriteObjectKeyValue("dtypes", dtypes);
+  writer->WriteObjectKeyValue("storage_types", storage_types);
+  writer->WriteObjectKeyValue("dispatch_modes", dispatch_modes);
+  writer->WriteObjectKeyValue("storage_plan", storage_plan);
+  writer->WriteObjectKeyValue("mem_plan", mem_plan);
+  writer->EndObject();
+}
+
+void CachedOpDiskCache::PlanRecord::Load(dmlc::JSONReader* reader) {
+  dmlc::JSONObjectReadHelper helper;
+  helper.DeclareField("shapes", &shapes);
+  helper.DeclareField("dtypes", &dtypes);
+  helper.DeclareField("storage_types", &storage_types);
+  helper.DeclareField("dispatch_modes", &dispatch_modes);
+  helper.DeclareField("storage_plan", &storage_plan);
+  helper.DeclareField("mem_plan", &mem_plan);
+  helper.ReadAllFields(reader);
+}
+
+std::shared_ptr<CachedOpDiskCache> CachedOpDiskCache::Create(
+    const nnvm::Symbol& sym,
+    const std::vector<std::pair<std::string, std::string> >& flags) {
+  const std::string dir = dmlc::GetEnv("MXNET_CACHED_OP_CACHE_DIR", std::string());
+  if (dir.empty() || !IsSerializable(sym.outputs)) return nullptr;
+
+  nnvm::Graph g;
+  g.outputs = sym.outputs;
+  std::string json;
+  try {
+    json = nnvm::pass::SaveJSON(g);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "CachedOp graph cache disabled for a graph that can not be saved: "
+                 << e.what();
+    return nullptr;
+  }
+  std::vector<std::pair<std::string, std::string> > sorted_flags(flags);
+  std::sort(sorted_flags.begin(), sorted_flags.end());
+  std::ostringstream os;
+  os << MXNET_VERSION << ';';
+  // Operators dispatch and infer storage differently depending on the build.
+  for (const auto& feature : features::LibInfo::getInstance()->getFeatures()) {
+    if (feature.enabled) os << feature.name << ',';
+  }
+  os << ';'
+     << dmlc::GetEnv("MXNET_ELIMINATE_COMMON_EXPR", true) << ';'
+     << dmlc::GetEnv("MXNET_USE_FUSION", true) << ';'
+     << dmlc::GetEnv("MXNET_MKLDNN_ENABLED", true) << ';'
+     << dmlc::GetEnv("MXNET_EXEC_INPLACE_GRAD_SUM_CAP", 8) << ';';
+  for (const auto& kv : sorted_flags) {
+    os << kv.first.size() << ':' << kv.first << kv.second.size() << ':' << kv.second;
+  }
+  os << ';' << json;
+  std::string key = os.str();
+
+  std::ostringstream path;
+  path << dir << "/cached_op_" << std::hex << std::hash<std::string>()(key);
+  std::shared_ptr<CachedOpDiskCache> ret(new CachedOpDiskCache(path.str(), std::move(key)));
+  ret->ReadGraphs();
+  return ret;
+}
+
+std::string CachedOpDiskCache::PlanPath(const std::string& name) const {
+  std::ostringstream path;
+  path << path_ << "_plan_" << std::hex << std::hash<std::string>()(name) << ".json";
+  return path.str();
+}
+
+void CachedOpDiskCache::ReadGraphs() {
+  const std::string path = path_ + ".json";
+  std::ifstream is(path);
+  if (!is.good()) return;
+  std::string key;
+  std::map<std::string, GraphRecord> graphs;
+  try {
+    dmlc::JSONReader reader(&is);
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("key", &key);
+    helper.DeclareField("graphs", &graphs);
+    helper.ReadAllFields(&reader);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Ignoring unreadable CachedOp cache file " << path << ": " << e.what();
+    return;
+  }
+  // A different key with the same hash is overwritten by the next save.
+  if (key != key_) return;
+  graphs_.swap(graphs);
+}
+
+bool CachedOpDiskCache::FindPlan(const std::string& name, PlanRecord* record) {
+  auto it = plans_.find(name);
+  if (it != plans_.end()) {
+    if (record != nullptr) *record = it->second;
+    return true;
+  }
+  const std::string path = PlanPath(name);
+  std::ifstream is(path);
+  if (!is.good()) return false;
+  std::string key, plan_name;
+  PlanRecord plan;
+  try {
+    dmlc::JSONReader reader(&is);
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("key", &key);
+    helper.DeclareField("name", &plan_name);
+    helper.DeclareField("plan", &plan);
+    helper.ReadAllFields(&reader);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Ignoring unreadable CachedOp cache file " << path << ": " << e.what();
+    return false;
+  }
+  if (key != key_ || plan_name != name) return false;
+  if (record != nullptr) *record = plan;
+  plans_.emplace(name, std::move(plan));
+  return true;
+}
+
+void CachedOpDiskCache::WriteFile(const std::string& path,
+                                  const std::function<void(dmlc::JSONWriter*)>& fn) {
+  // Other processes may read the file at any time, so it is replaced as a whole.
+  std::ostringstream tmp_path;
+  tmp_path << path << ".tmp" << common::current_process_id() << '_' << this;
+  {
+    std::ofstream os(tmp_path.str());
+    if (!os.good()) {
+      LOG(WARNING) << "Can not write CachedOp cache file " << tmp_path.str();
+      return;
+    }
+    dmlc::JSONWriter writer(&os);
+    writer.BeginObject();
+    writer.WriteObjectKeyValue("key", key_);
+    fn(&writer);
+    writer.EndObject();
+    if (!os.good()) {
+      LOG(WARNING) << "Can not write CachedOp cache file " << tmp_path.str();
+      os.close();
+      std::remove(tmp_path.str().c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Can not replace CachedOp cache file " << path;
+    std::remove(tmp_path.str().c_str());
+  }
+}
+
+bool CachedOpDiskCache::LoadGraph(
+    const std::string& name,
+    nnvm::Graph* fwd_graph,
+    nnvm::Graph* grad_graph,
+    nnvm::Graph* full_graph,
+    std::vector<nnvm::NodeEntry>* ograd_entries,
+    std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output,
+    std::vector<size_t>* input_map) {
+  GraphRecord record;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = graphs_.find(name);
+    if (it == graphs_.end()) return false;
+    record = it->second;
+  }
+  nnvm::Graph g;
+  try {
+    g = nnvm::pass::LoadJSON(record.graph);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Ignoring CachedOp graph " << name << " from " << path_
+                 << " that can not be loaded: " << e.what();
+    return false;
+  }
+  const auto& idx = g.indexed_graph();
+  if (record.num_forward_outputs > g.outputs.size() ||
+      record.ograd_nodes.size() != record.ograd_names.size() ||
+      record.grad_inputs.size() != record.grad_outputs.size() ||
+      (input_map != nullptr && record.input_map.size() != idx.input_nodes().size())) {
+    LOG(WARNING) << "Ignoring inconsistent CachedOp graph " << name << " from " << path_;
+    return false;
+  }
+  std::vector<nnvm::NodeEntry> ograds;
+  ograds.reserve(record.ograd_nodes.size());
+  for (size_t i = 0; i < record.ograd_nodes.size(); ++i) {
+    const int64_t nid = record.ograd_nodes[i];
+    if (nid < 0) {
+      // Head gradients of outputs that do not take part in backward.
+      nnvm::ObjectPtr np = nnvm::Node::Create();
+      np->attrs.name = record.ograd_names[i];
+      ograds.emplace_back(np);
+    } else if (static_cast<size_t>(nid) < idx.num_nodes() && idx[nid].source->is_variable()) {
+      ograds.emplace_back(idx[nid].weak_ref.lock());
+    } else {
+      LOG(WARNING) << "Ignoring inconsistent CachedOp graph " << name << " from " << path_;
+      return false;
+    }
+  }
+
+  *full_graph = nnvm::Graph();
+  full_graph->outputs = g.outputs;
+  *fwd_graph = nnvm::Graph();
+  fwd_graph->outputs = std::vector<nnvm::NodeEntry>(
+      g.outputs.begin(), g.outputs.begin() + record.num_forward_outputs);
+  *grad_graph = nnvm::Graph();
+  grad_graph->outputs = std::vector<nnvm::NodeEntry>(
+      g.outputs.begin() + record.num_forward_outputs, g.outputs.end());
+  *ograd_entries = std::move(ograds);
+  fwd_input_to_grad_output->clear();
+  for (size_t i = 0; i < record.grad_inputs.size(); ++i) {
+    (*fwd_input_to_grad_output)[record.grad_inputs[i]] = record.grad_outputs[i];
+  }
+  if (input_map != nullptr) *input_map = record.input_map;
+  return true;
+}
+
+void CachedOpDiskCache::SaveGraph(
+    const std::string& name,
+    const nnvm::Graph& full_graph,
+    size_t num_forward_outputs,
+    const std::vector<nnvm::NodeEntry>& ograd_entries,
+    const std::unordered_map<uint32_t, uint32_t>& fwd_input_to_grad_output,
+    const std::vector<size_t>& input_map) {
+  // The gradient and fusion passes may add nodes that the symbol did not have.
+  if (!IsSerializable(full_graph.outputs)) return;
+  GraphRecord record;
+  nnvm::Graph g;
+  g.outputs = full_graph.outputs;
+  try {
+    record.graph = nnvm::pass::SaveJSON(g);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Can not save CachedOp graph " << name << ": " << e.what();
+    return;
+  }
+  record.num_forward_outputs = num_forward_outputs;
+  const auto& idx = full_graph.indexed_graph();
+  for (const auto& e : ograd_entries) {
+    const nnvm::Node* node = e.node.get();
+    record.ograd_nodes.push_back(idx.exist(node) ? idx.node_id(node) : -1);
+    record.ograd_names.push_back(node->attrs.name);
+  }
+  std::vector<std::pair<uint32_t, uint32_t> > grad_io(fwd_input_to_grad_output.begin(),
+                                                       fwd_input_to_grad_output.end());
+  std::sort(grad_io.begin(), grad_io.end());
+  for (const auto& kv : grad_io) {
+    record.grad_inputs.push_back(kv.first);
+    record.grad_outputs.push_back(kv.second);
+  }
+  record.input_map = input_map;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  graphs_[name] = std::move(record);
+  WriteFile(path_ + ".json", [this](dmlc::JSONWriter* writer) {
+    writer->WriteObjectKeyValue("graphs", graphs_);
+  });
+}
+
+bool CachedOpDiskCache::HasPlan(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return FindPlan(name, nullptr);
+}
+
+bool CachedOpDiskCache::LoadPlan(const std::string& name,
+                                 const std::string& mem_plan_attr,
+                                 const std::string& storage_plan_attr,
+                                 int dev_mask,
+                                 const mxnet::ShapeVector& shape_inputs,
+                                 const nnvm::DTypeVector& dtype_inputs,
+                                 const StorageTypeVector& storage_type_inputs,
+                                 nnvm::Graph* g) {
+  PlanRecord record;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!FindPlan(name, &record)) return false;
+  }
+  const auto& idx = g->indexed_graph();
+  const size_t num_entries = idx.num_node_entries();
+  if (record.shapes.size() != num_entries || record.dtypes.size() != num_entries ||
+      record.storage_types.size() != num_entries ||
+      record.storage_plan.size() != num_entries ||
+      record.mem_plan.size() != 4 * num_entries ||
+      record.dispatch_modes.size() != idx.num_nodes()) {
+    LOG(WARNING) << "Ignoring inconsistent CachedOp plan " << name << " from " << path_;
+    return false;
+  }
+  mxnet::ShapeVector shapes;
+  shapes.reserve(num_entries);
+  for (const auto& s : record.shapes) {
+    // an unknown shape is saved as its ndim of -1 alone
+    const bool valid = !s.empty() && s[0] >= -1 &&
+        static_cast<int64_t>(s.size()) == std::max<int64_t>(s[0], 0) + 1;
+    if (!valid) {
+      LOG(WARNING) << "Ignoring inconsistent CachedOp plan " << name << " from " << path_;
+      return false;
+    }
+    mxnet::TShape shape(static_cast<int>(s[0]), -1);
+    for (int i = 0; i < shape.ndim(); ++i) shape[i] = s[i + 1];
+    shapes.push_back(std::move(shape));
+  }
+  DispatchModeVector dispatch_modes;
+  dispatch_modes.reserve(record.dispatch_modes.size());
+  for (int mode : record.dispatch_modes) {
+    dispatch_modes.push_back(static_cast<DispatchMode>(mode));
+  }
+  imperative::MemoryPlanVector mem_plan(num_entries);
+  for (size_t i = 0; i < num_entries; ++i) {
+    mem_plan[i] = {static_cast<int>(record.mem_plan[4 * i]),
+                   static_cast<uint32_t>(record.mem_plan[4 * i + 1]),
+                   static_cast<size_t>(record.mem_plan[4 * i + 2]),
+                   record.mem_plan[4 * i + 3] != 0};
+  }
+
+  g->attrs["shape"] = std::make_shared<dmlc::any>(std::move(shapes));
+  g->attrs["shape_inputs"] = std::make_shared<dmlc::any>(shape_inputs);
+  g->attrs["dtype"] = std::make_shared<dmlc::any>(std::move(record.dtypes));
+  g->attrs["dtype_inputs"] = std::make_shared<dmlc::any>(dtype_inputs);
+  g->attrs["storage_type"] = std::make_shared<dmlc::any>(std::move(record.storage_types));
+  g->attrs["storage_type_inputs"] = std::make_shared<dmlc::any>(storage_type_inputs);
+  g->attrs["dev_mask"] = std::make_shared<dmlc::any>(
+      exec::DevMaskVector(idx.num_nodes(), dev_mask));
+  g->attrs["dispatch_mode"] = std::make_shared<dmlc::any>(std::move(dispatch_modes));
+  g->attrs[storage_plan_attr] = std::make_shared<dmlc::any>(std::move(record.storage_plan));
+  g->attrs[mem_plan_attr] = std::make_shared<dmlc::any>(std::move(mem_plan));
+  return true;
+}
+
+void CachedOpDiskCache::SavePlan(const std::string& name,
+                                 const std::string& mem_plan_attr,
+                                 const std::string& storage_plan_attr,
+                                 const nnvm::Graph& g) {
+  {
+    // Graphs fed with ever new shapes would otherwise fill the disk.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (num_saved_plans_ >= max_plans_) return;
+    ++num_saved_plans_;
+  }
+  PlanRecord record;
+  for (const auto& shape : g.GetAttr<mxnet::ShapeVector>("shape")) {
+    std::vector<int64_t> s{shape.ndim()};
+    for (int i = 0; i < shape.ndim(); ++i) s.push_back(shape[i]);
+    record.shapes.push_back(std::move(s));
+  }
+  record.dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+  record.storage_types = g.GetAttr<StorageTypeVector>("storage_type");
+  for (DispatchMode mode : g.GetAttr<DispatchModeVector>("dispatch_mode")) {
+    record.dispatch_modes.push_back(static_cast<int>(mode));
+  }
+  record.storage_plan = g.GetAttr<std::vector<int> >(storage_plan_attr);
+  for (const auto& info : g.GetAttr<imperative::MemoryPlanVector>(mem_plan_attr)) {
+    record.mem_plan.push_back(info.storage_id);
+    record.mem_plan.push_back(info.root);
+    record.mem_plan.push_back(static_cast<int64_t>(info.size));
+    record.mem_plan.push_back(info.inplace);
+  }
+
+  // Every plan has a file of its own, so saving one does not rewrite the others.
+  std::lock_guard<std::mutex> lock(mutex_);
+  WriteFile(PlanPath(name), [&name, &record](dmlc::JSONWriter* writer) {
+    writer->WriteObjectKeyValue("name", name);
+    writer->WriteObjectKeyValue("plan", record);
+  });
+  plans_[name] = std::move(record);
+}
+
+}  // namespace mxnet
@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cached_op_cache.h
+ * \brief Persists the graphs and memory plans CachedOp derives from a symbol
+ */
+#ifndef MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
+#define MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
+
+#include <dmlc/json.h>
+#include <dmlc/parameter.h>
+#include <mxnet/graph_attr_types.h>
+#include <mxnet/tuple.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <nnvm/symbolic.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+
+/*!
+ * \brief On disk cache of a CachedOp, enabled by MXNET_CACHED_OP_CACHE_DIR.
+ *
+ *  Files are named after the hash of the symbol JSON, the flags, the graph pass
+ *  settings, the enabled build features and the library version. One file per
+ *  CachedOp holds
+ *  - the full graph after common expression elimination and the gradient pass,
+ *  - the full graph optimized for a device, such as by pointwise fusion,
+ *  and one file per input signature seen holds the inferred shapes, dtypes,
+ *  storage types and dispatch modes and the memory plan of the forward graph.
+ *  Every file repeats the complete key, so hash collisions are detected on load.
+ *  Graphs with nodes whose parsed attributes can not be rebuilt from JSON are not
+ *  cached.
+ */
+class CachedOpDiskCache {
+ public:
+  /*! \brief a full graph and the CachedOp bookkeeping that refers to its nodes */
+  struct GraphRecord {
+    std::string graph;
+    size_t num_forward_outputs{0};
+    // node id in the full graph of every head gradient, -1 if it is unused
+    std::vector<int64_t> ograd_nodes;
+    std::vector<std::string> ograd_names;
+    std::vector<uint32_t> grad_inputs;
+    std::vector<uint32_t> grad_outputs;
+    std::vector<size_t> input_map;
+
+    void Save(dmlc::JSONWriter* writer) const;
+    void Load(dmlc::JSONReader* reader);
+  };
+
+  /*! \brief inferred attributes and memory plan of a forward graph */
+  struct PlanRecord {
+    // ndim followed by the dims of every entry
+    std::vector<std::vector<int64_t>> shapes;
+    std::vector<int> dtypes;
+    std::vector<int> storage_types;
+    std::vector<int> dispatch_modes;
+    std::vector<int> storage_plan;
+    // storage id, root, size and inplace of every entry
+    std::vector<int64_t> mem_plan;
+
+    void Save(dmlc::JSONWriter* writer) const;
+    void Load(dmlc::JSONReader* reader);
+  };
+
+  /*!
+   * \brief the cache of a CachedOp
+   * \return nullptr if the cache is disabled or the symbol can not be cached
+   */
+  static std::shared_ptr<CachedOpDiskCache> Create(
+      const nnvm::Symbol& sym,
+      const std::vector<std::pair<std::string, std::string> >& flags);
+
+  /*!
+   * \brief restore a graph saved under name, splitting the outputs of the full
+   *  graph into fwd_graph and grad_graph like CreateFullGraph does.
+   * \param input_map filled with the saved input map unless nullptr
+   * \return false if there is no usable graph under name
+   */
+  bool LoadGraph(const std::string& name,
+                 nnvm::Graph* fwd_graph,
+                 nnvm::Graph* grad_graph,
+                 nnvm::Graph* full_graph,
+                 std::vector<nnvm::NodeEntry>* ograd_entries,
+                 std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output,
+                 std::vector<size_t>* input_map);
+
+  /*! \brief save a full graph and its bookkeeping under name */
+  void SaveGraph(const std::string& name,
+                 const nnvm::Graph& full_graph,
+                 size_t num_forward_outputs,
+                 const std::vector<nnvm::NodeEntry>& ograd_entries,
+                 const std::unordered_map<uint32_t, uint32_t>& fwd_input_to_grad_output,
+                 const std::vector<size_t>& input_map);
+
+  /*! \brief whether a plan is saved under name */
+  bool HasPlan(const std::string& name);
+
+  /*!
+   * \brief restore the inferred attributes and the memory plan saved under name
+   *  onto g, as CheckAndInferShape, CheckAndInferType, CheckAndInferStorageType
+   *  and MXPlanMemory would have set them for the given inputs.
+   * \return false if there is no usable plan under name
+   */
+  bool LoadPlan(const std::string& name,
+                const std::string& mem_plan_attr,
+                const std::string& storage_plan_attr,
+                int dev_mask,
+                const mxnet::ShapeVector& shape_inputs,
+                const nnvm::DTypeVector& dtype_inputs,
+                const StorageTypeVector& storage_type_inputs,
+                nnvm::Graph* g);
+
+  /*! \brief save the inferred attributes and memory plan of g under name */
+  void SavePlan(const std::string& name,
+                const std::string& mem_plan_attr,
+                const std::string& storage_plan_attr,
+                const nnvm::Graph& g);
+
+ private:
+  CachedOpDiskCache(std::string path, std::string key)
+    : path_(std::move(path)), key_(std::move(key)),
+      max_plans_(dmlc::GetEnv("MXNET_CACHED_OP_CACHE_MAX_PLANS", 64)) {}
+  /*! \brief path of the file of the plan saved under name */
+  std::string PlanPath(const std::string& name) const;
+  /*! \brief read the graph file if it holds entries for the same key */
+  void ReadGraphs();
+  /*!
+   * \brief find the plan saved under name, reading its file the first time
+   * \param record filled with the plan unless nullptr
+   */
+  bool FindPlan(const std::string& name, PlanRecord* record);
+  /*! \brief replace the file at path atomically with the key and the fields fn writes */
+  void WriteFile(const std::string& path, const std::function<void(dmlc::JSONWriter*)>& fn);
+
+  std::mutex mutex_;
+  // path of the cache files without the suffix
+  std::string path_;
+  std::string key_;
+  std::map<std::string, GraphRecord> graphs_;
+  // plans read or saved so far
+  std::map<std::string, PlanRecord> plans_;
+  // plans this cache saves at most, MXNET_CACHED_OP_CACHE_MAX_PLANS
+  const size_t max_plans_;
+  size_t num_saved_plans_{0};
+};
+
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_CACHED_OP_CACHE_H_
@@ -0,0 +1,176 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dispatch_cache.h
+ * \brief Memoizes attribute inference and dispatch of imperative operator calls
+ */
+#ifndef MXNET_IMPERATIVE_DISPATCH_CACHE_H_
+#define MXNET_IMPERATIVE_DISPATCH_CACHE_H_
+
+#include <dmlc/common.h>
+#include <dmlc/thread_local.h>
+#include <mxnet/imperative.h>
+#include <mxnet/ndarray.h>
+#include <mxnet/op_attr_types.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../common/utils.h"
+
+namespace mxnet {
+namespace imperative {
+
+/*!
+ * \brief Everything Imperative::Invoke derives from the operator, its attributes
+ *  and the inputs and outputs before pushing to the engine.
+ */
+struct DispatchEntry {
+  // key
+  const nnvm::Op* op{nullptr};
+  std::unordered_map<std::string, std::string> dict;
+  std::vector<int64_t> meta;
+  // inferred attributes
+  mxnet::ShapeVector in_shapes;
+  std::vector<int> in_types;
+  mxnet::ShapeVector out_shapes;
+  std::vector<int> out_types;
+  std::vector<int> out_storage_types;
+  DispatchMode dispatch_mode{DispatchMode::kUndefined};
+  // resolved dispatch
+  FCompute fn;
+  FComputeEx fn_ex;
+  std::vector<ResourceRequest> resource_reqs;
+  std::vector<uint32_t> mutate_idx;
+};
+
+/*!
+ * \brief Per thread cache of DispatchEntry. A call is keyed on the operator, its
+ *  attribute dict, the device type, the numpy and training modes, and the shape,
+ *  dtype and storage type of every input and output. Calls that cannot be keyed
+ *  soundly, such as dynamic shape operators or parsed attributes without a matching
+ *  dict, always take the slow path.
+ */
+class DispatchCache {
+ public:
+  DispatchCache()
+    : capacity_(dmlc::GetEnv("MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE", 4096)) {}
+
+  static DispatchCache* Get() {
+    return dmlc::ThreadLocalStore<DispatchCache>::Get();
+  }
+
+  /*!
+   * \brief find the entry of a call. On a miss the key of a cacheable call is kept
+   *  for the Insert that follows the slow path.
+   * \param attrs_from_dict whether attrs.parsed was parsed from attrs.dict
+   */
+  const DispatchEntry* Lookup(const Context& ctx,
+                              const nnvm::NodeAttrs& attrs,
+                              const std::vector<NDArray*>& inputs,
+                              const std::vector<NDArray*>& outputs,
+                              const bool attrs_from_dict) {
+    static auto& infershape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
+    pending_ = false;
+    if (capacity_ == 0 || !infershape.count(attrs.op) || !attrs.subgraphs.empty() ||
+        (!attrs_from_dict && !attrs.parsed.empty())) {
+      return nullptr;
+    }
+    meta_.clear();
+    meta_.push_back(ctx.dev_mask());
+    meta_.push_back(Imperative::Get()->is_np_shape());
+    meta_.push_back(Imperative::Get()->is_np_default_dtype());
+    meta_.push_back(Imperative::Get()->is_training());
+    meta_.push_back(inputs.size());
+    for (const NDArray* i : inputs) {
+      if (!AppendMeta(*i)) return nullptr;
+    }
+    for (const NDArray* i : outputs) {
+      if (i->is_none()) {
+        meta_.push_back(-1);
+      } else if (!AppendMeta(*i)) {
+        return nullptr;
+      }
+    }
+    size_t hash = std::hash<const void*>()(attrs.op);
+    for (const int64_t v : meta_) {
+      hash = dmlc::HashCombine(hash, v);
+    }
+    // the dict is unordered, so its entries are combined commutatively
+    size_t dict_hash = 0;
+    for (const auto& kv : attrs.dict) {
+      dict_hash += dmlc::HashCombine(std::hash<std::string>()(kv.first), kv.second);
+    }
+    hash_ = dmlc::HashCombine(hash, dict_hash);
+    pending_ = true;
+
+    auto it = entries_.find(hash_);
+    if (it == entries_.end()) return nullptr;
+    const DispatchEntry& entry = it->second;
+    if (entry.op != attrs.op || entry.meta != meta_ || entry.dict != attrs.dict) {
+      return nullptr;
+    }
+    pending_ = false;
+    return &entry;
+  }
+
+  /*! \brief whether the last missed Lookup can be inserted */
+  bool pending() const {
+    return pending_;
+  }
+
+  /*! \brief insert the entry of the last missed Lookup, filling in its key */
+  void Insert(const nnvm::NodeAttrs& attrs, DispatchEntry&& entry) {
+    CHECK(pending_);
+    pending_ = false;
+    for (const auto& s : entry.out_shapes) {
+      if (!shape_is_known(s)) return;
+    }
+    if (entries_.size() >= capacity_) entries_.clear();
+    entry.op = attrs.op;
+    entry.dict = attrs.dict;
+    entry.meta = meta_;
+    entries_[hash_] = std::move(entry);
+  }
+
+ private:
+  /*! \brief append ndim, dims, dtype and storage type, false for unknown shapes */
+  bool AppendMeta(const NDArray& arr) {
+    const mxnet::TShape& shape = arr.shape();
+    if (!shape_is_known(shape)) return false;
+    meta_.push_back(shape.ndim());
+    meta_.insert(meta_.end(), shape.begin(), shape.end());
+    meta_.push_back(arr.dtype());
+    meta_.push_back(arr.storage_type());
+    return true;
+  }
+
+  size_t capacity_;
+  std::unordered_map<size_t, DispatchEntry> entries_;
+  // key of the last Lookup
+  std::vector<int64_t> meta_;
+  size_t hash_{0};
+  bool pending_{false};
+};
+
+}  // namespace imperative
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_DISPATCH_CACHE_H_
@@ -23,6 +23,8 @@
 
 #include "./imperative_utils.h"
 #include "./cached_op.h"
+#include "./dispatch_cache.h"
+#include "./lazy_trace.h"
 
 namespace nnvm {
 ObjectPtr CreateVariableNode(const std::string &name);
@@ -33,11 +35,13 @@ namespace mxnet {
 thread_local bool Imperative::is_train_ = false;
 thread_local bool Imperative::is_recording_ = false;
 thread_local bool Imperative::is_deferred_compute_ = false;
+thread_local bool Imperative::is_lazy_ = false;
 thread_local bool Imperative::is_np_shape_thread_local_ = false;
 #else
 MX_THREAD_LOCAL bool Imperative::is_train_ = false;
 MX_THREAD_LOCAL bool Imperative::is_recording_ = false;
 MX_THREAD_LOCAL bool Imperative::is_deferred_compute_ = false;
+MX_THREAD_LOCAL bool Imperative::is_lazy_ = false;
 MX_THREAD_LOCAL bool Imperative::is_np_shape_thread_local_ = false;
 #endif
 
@@ -46,45 +50,57 @@ Imperative* Imperative::Get() {
   return &inst;
 }
 
-OpStatePtr Imperative::InvokeOp(
-    const Context& ctx,
-    const nnvm::NodeAttrs& attrs,
-    const std::vector<NDArray*>& inputs,
-    const std::vector<NDArray*>& outputs,
-    const std::vector<OpReqType>& req,
-    const DispatchMode dispatch_mode,
-    OpStatePtr state) {
+namespace {
+
+/*! \brief push the operator with resolved dispatch and dependencies */
+OpStatePtr PushOp(const Context& ctx,
+                  const nnvm::NodeAttrs& attrs,
+                  const std::vector<NDArray*>& inputs,
+                  const std::vector<NDArray*>& outputs,
+                  const std::vector<OpReqType>& req,
+                  const DispatchMode dispatch_mode,
+                  OpStatePtr state,
+                  const FCompute& fn,
+                  const FComputeEx& fn_ex,
+                  const mxnet::ShapeVector& in_shapes,
+                  const std::vector<int>& in_types,
+                  const std::vector<engine::VarHandle>& read_vars,
+                  std::vector<engine::VarHandle>* write_vars,
+                  const std::vector<Resource>& requested,
+                  const std::vector<uint32_t>& mutate_idx) {
   using namespace imperative;
   static auto& createop = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
   static auto& is_layer_backward = Op::GetAttr<bool>("TIsLayerOpBackward");
-  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
 
-  const nnvm::Op *op = attrs.op;
+  static auto& fexec_type = nnvm::Op::GetAttr<FExecType>("FExecType");
 
-  std::vector<engine::VarHandle> read_vars, write_vars;
-  std::vector<Resource> requested;
-  std::vector<uint32_t> mutate_idx;
-  SetDependency(attrs, ctx, inputs, outputs,
-      &read_vars, &write_vars, &requested, &mutate_idx, dispatch_mode);
+  const nnvm::Op *op = attrs.op;
 
-  FCompute fn = common::GetFCompute<FCompute>(op, "FCompute", ctx);
-  FComputeEx fn_ex = common::GetFCompute<FComputeEx>(op, "FComputeEx", ctx);
+  // The engine takes the cost of the operator for the aggregate stats. Operators
+  // running a subgraph push the operators of the subgraph instead.
+  std::unique_ptr<profiler::OprCostScope> cost_scope;
+  if (profiler::Profiler::Get()->AggregateRunning() &&
+      !(fexec_type.count(op) && fexec_type[op](attrs) == ExecType::kSubgraphExec)) {
+    const OpCost cost = GetOpCost(attrs, inputs, outputs);
+    cost_scope.reset(new profiler::OprCostScope(cost.flops,
+                                                cost.bytes_read + cost.bytes_written));
+  }
 
   // FComputeEx is dispatched only when dispatch_mode is DispatchMode::kFComputeEx
   CHECK(dispatch_mode != DispatchMode::kUndefined);
   bool dispatch_fcompex = dispatch_mode == DispatchMode::kFComputeEx;
   if (fn_ex && dispatch_fcompex) {
-    PushFComputeEx(fn_ex, op, attrs, ctx, read_vars, write_vars,
+    PushFComputeEx(fn_ex, op, attrs, ctx, read_vars, *write_vars,
         requested, inputs, outputs, req);
   } else if (fn) {
-    PushFCompute(fn, op, attrs, ctx, read_vars, write_vars,
+    PushFCompute(fn, op, attrs, ctx, read_vars, *write_vars,
         requested, inputs, outputs, mutate_idx, req);
   } else if (createop.count(op) || is_layer_backward.get(op, false)) {
     if (!state) {
-      state = createop[op](attrs, ctx, ret->arg_shapes, ret->arg_types);
+      state = createop[op](attrs, ctx, in_shapes, in_types);
     }
-    write_vars.push_back(state.get_var());
-    PushOperator(state, op, attrs, ctx, read_vars, write_vars,
+    write_vars->push_back(state.get_var());
+    PushOperator(state, op, attrs, ctx, read_vars, *write_vars,
         requested, inputs, outputs, mutate_idx, req, dispatch_mode);
   } else {
     LOG(FATAL)
@@ -95,13 +111,46 @@ OpStatePtr Imperative::InvokeOp(
   return state;
 }
 
+}  // namespace
+
+OpStatePtr Imperative::InvokeOp(
+    const Context& ctx,
+    const nnvm::NodeAttrs& attrs,
+    const std::vector<NDArray*>& inputs,
+    const std::vector<NDArray*>& outputs,
+    const std::vector<OpReqType>& req,
+    const DispatchMode dispatch_mode,
+    OpStatePtr state) {
+  using namespace imperative;
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+
+  const nnvm::Op *op = attrs.op;
+
+  std::vector<engine::VarHandle> read_vars, write_vars;
+  std::vector<Resource> requested;
+  std::vector<uint32_t> mutate_idx;
+  SetDependency(attrs, ctx, inputs, outputs,
+      &read_vars, &write_vars, &requested, &mutate_idx, dispatch_mode);
+
+  FCompute fn = common::GetFCompute<FCompute>(op, "FCompute", ctx);
+  FComputeEx fn_ex = common::GetFCompute<FComputeEx>(op, "FComputeEx", ctx);
+
+  return PushOp(ctx, attrs, inputs, outputs, req, dispatch_mode, state, fn, fn_ex,
+                ret->arg_shapes, ret->arg_types, read_vars, &write_vars, requested, mutate_idx);
+}
+
 OpStatePtr Imperative::Invoke(
     const Context& default_ctx,
     const nnvm::NodeAttrs& attrs,
     const std::vector<NDArray*>& inputs,
-    const std::vector<NDArray*>& outputs) {
+    const std::vector<NDArray*>& outputs,
+    const bool attrs_from_dict) {
   using namespace imperative;
   static auto& ndfunc = nnvm::Op::GetAttr<FNDArrayFunction>("FNDArrayFunction");
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+
+  // An eager call may access arrays that the lazy trace reads or writes
+  FlushLazy();
 
   if (ndfunc.count(attrs.op)) {
     std::vector<NDArray> p_inputs, p_outputs;
@@ -114,10 +163,48 @@ OpStatePtr Imperative::Invoke(
   // TODO(piiswrong): infer ctx
   DispatchMode dispatch_mode = DispatchMode::kUndefined;
   Context ctx = GetContext(attrs, inputs, outputs, default_ctx);
-  SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+  // Repeated calls with the same attributes skip inference and dispatch resolution
+  DispatchCache* cache = DispatchCache::Get();
+  const DispatchEntry* entry = cache->Lookup(ctx, attrs, inputs, outputs, attrs_from_dict);
+  DispatchEntry new_entry;
+  if (entry == nullptr) {
+    SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+    if (cache->pending()) {
+      MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+      new_entry.in_shapes = ret->arg_shapes;
+      new_entry.in_types = ret->arg_types;
+      new_entry.out_shapes = ret->out_shapes;
+      new_entry.out_types = ret->out_types;
+      new_entry.out_storage_types = ret->out_storage_types;
+      new_entry.dispatch_mode = dispatch_mode;
+      new_entry.fn = common::GetFCompute<FCompute>(attrs.op, "FCompute", ctx);
+      new_entry.fn_ex = common::GetFCompute<FComputeEx>(attrs.op, "FComputeEx", ctx);
+      new_entry.resource_reqs = GetResourceRequests(attrs, ctx, dispatch_mode);
+      if (fmutate.count(attrs.op)) {
+        new_entry.mutate_idx = fmutate[attrs.op](attrs);
+      }
+      entry = &new_entry;
+    }
+  } else {
+    dispatch_mode = entry->dispatch_mode;
+    SetOutputShapeType(ctx, attrs, outputs, entry->out_shapes, entry->out_types,
+                       entry->out_storage_types, false);
+  }
   std::vector<OpReqType> req;
   SetWriteInplaceReq(inputs, outputs, &req);
-  OpStatePtr ret = InvokeOp(ctx, attrs, inputs, outputs, req, dispatch_mode);
+  OpStatePtr ret;
+  if (entry != nullptr) {
+    std::vector<engine::VarHandle> read_vars, write_vars;
+    std::vector<Resource> requested;
+    SetDependency(ctx, inputs, outputs, entry->resource_reqs, entry->mutate_idx,
+                  dispatch_mode, &read_vars, &write_vars, &requested);
+    ret = PushOp(ctx, attrs, inputs, outputs, req, dispatch_mode, OpStatePtr(),
+                 entry->fn, entry->fn_ex, entry->in_shapes, entry->in_types,
+                 read_vars, &write_vars, requested, entry->mutate_idx);
+    if (entry == &new_entry) cache->Insert(attrs, std::move(new_entry));
+  } else {
+    ret = InvokeOp(ctx, attrs, inputs, outputs, req, dispatch_mode);
+  }
   // the followinng loop is used for finding out the correct shape when some shapes are dynamic
   for (auto output : outputs) {
     if (!shape_is_known(output->shape())) {
@@ -395,6 +482,9 @@ std::vector<NDArray*> Imperative::Backward(
   static const std::vector<const Op*> zero_ops{Op::Get("zeros_like"), Op::Get("_zeros")};
   static const Op* copy_op = Op::Get("_copy");
 
+  // The recorded outputs may still be pending in the lazy trace
+  FlushLazy();
+
   // Construct forward graph
   Graph graph;
   graph.outputs.reserve(outputs.size());
@@ -698,6 +788,12 @@ void Imperative::DCInfo::Compute(const NDArray &arr) {
   }
 
   DCInfo &info = Imperative::DCInfo::Get(arr.deferredcompute_entry_.node);
+  if (info.lazy_trace_) {
+    // Flushing clears the info and with it the last reference the array holds.
+    std::shared_ptr<LazyTrace> trace = info.lazy_trace_;
+    trace->Flush();
+    return;
+  }
   info.is_computed_ = true;  // We will Invoke at the end of this function.
 
   // Recursively compute input arrays
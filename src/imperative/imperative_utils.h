@@ -30,6 +30,8 @@
 #include "../common/exec_utils.h"
 #include "../operator/nn/mkldnn/mkldnn_base-inl.h"
 #include "../operator/operator_common.h"
+#include "../profiler/op_histogram.h"
+#include "../profiler/profiler.h"
 
 #ifndef MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
 #define MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
@@ -160,6 +162,50 @@ inline Context GetContext(const nnvm::NodeAttrs& attrs,
   return ctx;
 }
 
+/*! \brief Allocate the outputs that are none, or check the existing ones, against
+ * the inferred shapes, dtypes and storage types
+ */
+inline void SetOutputShapeType(const Context& ctx,
+                               const nnvm::NodeAttrs& attrs,
+                               const std::vector<NDArray*>& outputs,
+                               const mxnet::ShapeVector& out_shapes,
+                               const std::vector<int>& out_types,
+                               const std::vector<int>& out_storage_types,
+                               const bool is_dynamic_shape_existing) {
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (outputs[i]->is_none() || (mxnet::op::shape_is_none(outputs[i]->shape()) &&
+                                   Imperative::DCInfo::IsNone(*outputs[i]))) {
+      if (!is_dynamic_shape_existing) {
+        const auto storage_type = static_cast<NDArrayStorageType>(out_storage_types[i]);
+        outputs[i]->ReInit(storage_type, out_shapes[i], ctx, out_types[i]);
+      } else {
+       *outputs[i] = NDArray(ctx, out_types[i]);
+      }
+      outputs[i]->AssignStorageInfo(common::NodeAttrsGetProfilerScope(attrs), attrs.name);
+    } else if (mxnet::op::shape_is_none(outputs[i]->shape())) {
+      // For deferred computed arrays with unknown shape (following dynamic
+      // shape operator), don't use copy assignment as it would destroy the
+      // deferredcompute metadata.
+      if (!is_dynamic_shape_existing) {
+        outputs[i]->Init(out_shapes[i]);
+      }
+      CHECK_EQ(outputs[i]->dtype(), out_types[i])
+        << i << "-th output has invalid dtype. "
+        << "Expecting " << out_types[i] << " got " << outputs[i]->dtype()
+        << " in operator " << attrs.op->name;
+    } else {
+      CHECK_EQ(outputs[i]->shape(), out_shapes[i])
+        << i << "-th output has invalid shape. "
+        << "Expecting " << out_shapes[i] << " got "
+        << outputs[i]->shape() << " in operator " << attrs.op->name;
+      CHECK_EQ(outputs[i]->dtype(), out_types[i])
+        << i << "-th output has invalid dtype. "
+        << "Expecting " << out_types[i] << " got "
+        << outputs[i]->dtype()  << " in operator " << attrs.op->name;
+    }
+  }
+}
+
 /*! \brief Set the shape, dtype, storage type and dispatch mode via the
  * attribute inference functions
  *
@@ -277,96 +323,66 @@ inline void SetShapeType(const Context& ctx,
 
   CHECK_EQ(out_storage_types.size(), outputs.size());
   CHECK(*dispatch_mode != DispatchMode::kUndefined);
-  for (size_t i = 0; i < outputs.size(); ++i) {
-    if (outputs[i]->is_none() || (mxnet::op::shape_is_none(outputs[i]->shape()) &&
-                                   Imperative::DCInfo::IsNone(*outputs[i]))) {
-      if (!is_dynamic_shape_existing) {
-        const auto storage_type = static_cast<NDArrayStorageType>(out_storage_types[i]);
-        outputs[i]->ReInit(storage_type, out_shapes[i], ctx, out_types[i]);
-      } else {
-       *outputs[i] = NDArray(ctx, out_types[i]);
-      }
-      outputs[i]->AssignStorageInfo(common::NodeAttrsGetProfilerScope(attrs), attrs.name);
-    } else if (mxnet::op::shape_is_none(outputs[i]->shape())) {
-      // For deferred computed arrays with unknown shape (following dynamic
-      // shape operator), don't use copy assignment as it would destroy the
-      // deferredcompute metadata.
-      if (!is_dynamic_shape_existing) {
-        outputs[i]->Init(out_shapes[i]);
-      }
-      CHECK_EQ(outputs[i]->dtype(), out_types[i])
-        << i << "-th output has invalid dtype. "
-        << "Expecting " << out_types[i] << " got " << outputs[i]->dtype()
-        << " in operator " << attrs.op->name;
-    } else {
-      CHECK_EQ(outputs[i]->shape(), out_shapes[i])
-        << i << "-th output has invalid shape. "
-        << "Expecting " << out_shapes[i] << " got "
-        << outputs[i]->shape() << " in operator " << attrs.op->name;
-      CHECK_EQ(outputs[i]->dtype(), out_types[i])
-        << i << "-th output has invalid dtype. "
-        << "Expecting " << out_types[i] << " got "
-        << outputs[i]->dtype()  << " in operator " << attrs.op->name;
-    }
+  SetOutputShapeType(ctx, attrs, outputs, out_shapes, out_types, out_storage_types,
+                     is_dynamic_shape_existing);
+}
+
+/*! \brief Resource requests of the operator for the context and dispatch mode */
+inline std::vector<ResourceRequest> GetResourceRequests(const nnvm::NodeAttrs& attrs,
+                                                        const Context& ctx,
+                                                        const DispatchMode dispatch_mode) {
+  static auto& ftmp_resource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& ftmp_resource_ex = nnvm::Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
+  if (ftmp_resource_ex.count(attrs.op)) {
+    return ftmp_resource_ex[attrs.op](attrs, static_cast<int>(ctx.dev_mask()), dispatch_mode);
+  } else if (ftmp_resource.count(attrs.op)) {
+    return ftmp_resource[attrs.op](attrs);
   }
+  return std::vector<ResourceRequest>();
 }
 
-/*! \brief Set read and write vars, resource requests and mutate_idx
+/*! \brief Set read and write vars and requested resources from resolved resource
+ * requests and mutate_idx
  *
  * For inputs and outputs arguments only NDArray::var() is accessed.
  */
-inline void SetDependency(const nnvm::NodeAttrs& attrs,
-                   const Context& ctx,
-                   const std::vector<NDArray*>& inputs,
-                   const std::vector<NDArray*>& outputs,
-                   std::vector<engine::VarHandle> *p_read_vars,
-                   std::vector<engine::VarHandle> *p_write_vars,
-                   std::vector<Resource> *p_requested,
-                   std::vector<uint32_t> *p_mutate_idx,
-                   const DispatchMode dispatch_mode) {
-  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
-  static auto& ftmp_resource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
-  static auto& ftmp_resource_ex = nnvm::Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
-
+inline void SetDependency(const Context& ctx,
+                          const std::vector<NDArray*>& inputs,
+                          const std::vector<NDArray*>& outputs,
+                          const std::vector<ResourceRequest>& resource_reqs,
+                          const std::vector<uint32_t>& mutate_idx,
+                          const DispatchMode dispatch_mode,
+                          std::vector<engine::VarHandle> *p_read_vars,
+                          std::vector<engine::VarHandle> *p_write_vars,
+                          std::vector<Resource> *p_requested) {
   std::vector<engine::VarHandle>& read_vars  = *p_read_vars;
   std::vector<engine::VarHandle>& write_vars = *p_write_vars;
   std::vector<Resource>& requested = *p_requested;
-  std::vector<uint32_t>& mutate_idx = *p_mutate_idx;
 
-  if (fmutate.count(attrs.op)) {
-    mutate_idx = fmutate[attrs.op](attrs);
-  }
-  const bool rsc_req = (ftmp_resource.count(attrs.op) != 0);
-  const bool rsc_ex_req = (ftmp_resource_ex.count(attrs.op) != 0);
-  if (rsc_req || rsc_ex_req) {
-    int ntmp = 0;
-    auto resource_reqs = rsc_ex_req ? ftmp_resource_ex[attrs.op](attrs,
-                                          static_cast<int>(ctx.dev_mask()), dispatch_mode)
-                                    : ftmp_resource[attrs.op](attrs);
-    for (const auto& req : resource_reqs) {
-      switch (req.type) {
-       case ResourceRequest::kTempSpace:
-        ++ntmp;
-       case ResourceRequest::kRandom:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
-       case ResourceRequest::kParallelRandom:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
+  int ntmp = 0;
+  for (const auto& req : resource_reqs) {
+    switch (req.type) {
+     case ResourceRequest::kTempSpace:
+      ++ntmp;
+     case ResourceRequest::kRandom:
+      requested.push_back(ResourceManager::Get()->Request(ctx, req));
+      write_vars.push_back(requested.back().var);
+      break;
+     case ResourceRequest::kParallelRandom:
+      requested.push_back(ResourceManager::Get()->Request(ctx, req));
+      write_vars.push_back(requested.back().var);
+      break;
 #if MXNET_USE_CUDNN == 1
-       case ResourceRequest::kCuDNNDropoutDesc:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
+     case ResourceRequest::kCuDNNDropoutDesc:
+      requested.push_back(ResourceManager::Get()->Request(ctx, req));
+      write_vars.push_back(requested.back().var);
+      break;
 #endif  // MXNET_USE_CUDNN == 1
-       default:
-        LOG(FATAL) << "resource type not yet supported";
-      }
+     default:
+      LOG(FATAL) << "resource type not yet supported";
     }
-    CHECK_LE(ntmp, 1) << "Only support 1 temp space request";
   }
+  CHECK_LE(ntmp, 1) << "Only support 1 temp space request";
 
   // append extra resource requests for storage fallback
   if (dispatch_mode == DispatchMode::kFComputeFallback) {
@@ -388,6 +404,29 @@ inline void SetDependency(const nnvm::NodeAttrs& attrs,
   Engine::Get()->DeduplicateVarHandle(&read_vars, &write_vars);
 }
 
+/*! \brief Set read and write vars, resource requests and mutate_idx
+ *
+ * For inputs and outputs arguments only NDArray::var() is accessed.
+ */
+inline void SetDependency(const nnvm::NodeAttrs& attrs,
+                   const Context& ctx,
+                   const std::vector<NDArray*>& inputs,
+                   const std::vector<NDArray*>& outputs,
+                   std::vector<engine::VarHandle> *p_read_vars,
+                   std::vector<engine::VarHandle> *p_write_vars,
+                   std::vector<Resource> *p_requested,
+                   std::vector<uint32_t> *p_mutate_idx,
+                   const DispatchMode dispatch_mode) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  std::vector<uint32_t>& mutate_idx = *p_mutate_idx;
+
+  if (fmutate.count(attrs.op)) {
+    mutate_idx = fmutate[attrs.op](attrs);
+  }
+  SetDependency(ctx, inputs, outputs, GetResourceRequests(attrs, ctx, dispatch_mode),
+                mutate_idx, dispatch_mode, p_read_vars, p_write_vars, p_requested);
+}
+
 /*! \brief Reset vector of OpReqType *req based on input and output NDArrays.
  *
  * Set to kWriteInplace if corresponding output shares variable with any input
@@ -633,6 +672,52 @@ inline void SetupDefaultBlobsInOut(const std::vector<NDArray *> &ndinputs,
       DerefInputOutput(in, out, &newIn, &newOut);             \
       DerefInputOutputRelease(in, out)
 
+/*! \brief bytes of the values and, for sparse arrays, the indices an array stores */
+inline uint64_t StoredBytes(const NDArray& nd) {
+  if (nd.is_none()) return 0;
+  if (nd.storage_type() == kDefaultStorage) {
+    return op::ArrayBytes({nd.shape()}, {nd.dtype()});
+  }
+  return op::ArrayBytes({nd.storage_shape()}, {nd.dtype()}) +
+         op::ArrayBytes(nd.aux_shapes(), nd.aux_types());
+}
+
+/*!
+ * \brief Cost of an operator from its FOpCost, or from the bytes of its arrays if it
+ *  has none, for the profiler to report the achieved GFLOP/s and GB/s
+ */
+inline OpCost GetOpCost(const nnvm::NodeAttrs& attrs,
+                        const std::vector<NDArray*>& inputs,
+                        const std::vector<NDArray*>& outputs) {
+  static auto& fopcost = nnvm::Op::GetAttr<FOpCost>("FOpCost");
+  // FOpCost assumes dense arrays, the work on sparse ones depends on their number
+  // of stored values, so only the stored bytes are counted.
+  const auto is_sparse = [](const NDArray* nd) {
+    return nd->storage_type() != kDefaultStorage;
+  };
+  if (std::any_of(inputs.begin(), inputs.end(), is_sparse) ||
+      std::any_of(outputs.begin(), outputs.end(), is_sparse)) {
+    OpCost cost;
+    for (const NDArray* nd : inputs) cost.bytes_read += StoredBytes(*nd);
+    for (const NDArray* nd : outputs) cost.bytes_written += StoredBytes(*nd);
+    return cost;
+  }
+  mxnet::ShapeVector in_shapes, out_shapes;
+  std::vector<int> in_types, out_types;
+  for (const NDArray* nd : inputs) {
+    in_shapes.push_back(nd->shape());
+    in_types.push_back(nd->dtype());
+  }
+  for (const NDArray* nd : outputs) {
+    out_shapes.push_back(nd->shape());
+    out_types.push_back(nd->dtype());
+  }
+  if (fopcost.count(attrs.op)) {
+    return fopcost[attrs.op](attrs, in_shapes, in_types, out_shapes, out_types);
+  }
+  return op::ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+}
+
 inline void PushFCompute(const FCompute& fn,
                   const nnvm::Op* op,
                   const nnvm::NodeAttrs& attrs,
@@ -1170,7 +1255,9 @@ inline void SetupOpExec(
 inline Engine::OprHandle CreateEngineOp(
     const Context& default_ctx,
     const std::vector<std::shared_ptr<exec::OpExecutor> >& execs,
-    const char* opr_names) {
+    const char* opr_names,
+    const std::vector<std::string>& node_names = std::vector<std::string>(),
+    const OpCost& cost = OpCost()) {
   CHECK_GT(execs.size(), 0);
   std::vector<Engine::VarHandle> use_vars, mutate_vars;
 
@@ -1198,12 +1285,25 @@ inline Engine::OprHandle CreateEngineOp(
   bool is_gpu = default_ctx.dev_mask() == gpu::kDevMask;
   bool is_async = execs.size() > 1 ? false : execs[0]->exec_type() == ExecType::kAsync;
 
-  auto exec_fun = [execs, is_async, is_gpu] (
+  auto exec_fun = [execs, is_async, is_gpu, node_names] (
       RunContext ctx, Engine::CallbackOnComplete on_complete) {
     if (is_async) {
       execs[0]->op_ctx.async_on_complete = on_complete;
     }
-    for (const auto& exec : execs) exec->Run(ctx, is_gpu);
+    // Kernels on CPU finish within Run, so the nodes of a bulked segment can be
+    // timed one by one.
+    if (!is_async && !is_gpu && node_names.size() == execs.size() &&
+        profiler::OpHistograms::Enabled()) {
+      profiler::OpHistograms* histograms = profiler::OpHistograms::Get();
+      for (size_t i = 0; i < execs.size(); ++i) {
+        const uint64_t start = profiler::OpHistograms::NowInNanosec();
+        execs[i]->Run(ctx, is_gpu);
+        histograms->Record(profiler::OpHistograms::kNode, node_names[i],
+                           profiler::OpHistograms::NowInNanosec() - start);
+      }
+    } else {
+      for (const auto& exec : execs) exec->Run(ctx, is_gpu);
+    }
     // call on complete only if it is async op
     if (!is_async) {
       if (is_gpu) {
@@ -1218,6 +1318,8 @@ inline Engine::OprHandle CreateEngineOp(
     }
   };
 
+  // The operator keeps the cost of its nodes for every push
+  profiler::OprCostScope cost_scope(cost.flops, cost.bytes_read + cost.bytes_written);
   return Engine::Get()->NewOperator(
       exec_fun, use_vars, mutate_vars, FnProperty::kNormal, opr_names);
 }
@@ -1234,6 +1336,8 @@ inline void CreateEngineOpSeg(
   size_t seg_start = start_nid;
   std::vector<std::shared_ptr<exec::OpExecutor> > seg_execs;
   std::string opr_names;
+  std::vector<std::string> node_names;
+  OpCost seg_cost;
   for (size_t nid = start_nid; nid < end_nid; ++nid) {
     const auto& node = idx[nid];
     if (node.source->is_variable()) continue;
@@ -1251,30 +1355,49 @@ inline void CreateEngineOpSeg(
       auto& seg = (*opr_segs)[seg_start];
       if (seg_execs.size()) {
         seg = EngineOprSeg{false, nid};
-        seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
+        seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str(), node_names,
+                                     seg_cost));
       } else {
         seg = EngineOprSeg{true, nid, nullptr};
       }
       seg_start = nid;
       seg_execs.clear();
       opr_names.clear();
+      node_names.clear();
+      seg_cost = OpCost();
     }
 
     seg_execs.push_back(exec);
     if (opr_names.size()) opr_names += ",";
     opr_names += op_name;
+    node_names.push_back(common::NodeAttrsGetProfilerScope(node.source->attrs) +
+                         node.source->attrs.name);
+    if (valid) {
+      std::vector<NDArray*> ndinputs, ndoutputs;
+      for (auto& nd : exec->in_array) ndinputs.push_back(&nd);
+      for (auto& nd : exec->out_array) ndoutputs.push_back(&nd);
+      const OpCost cost = GetOpCost(node.source->attrs, ndinputs, ndoutputs);
+      seg_cost.flops += cost.flops;
+      seg_cost.bytes_read += cost.bytes_read;
+      seg_cost.bytes_written += cost.bytes_written;
+    }
 
     auto& seg = (*opr_segs)[nid];
     if (!valid) {
       seg = EngineOprSeg{false, nid + 1, nullptr};
       seg_execs.clear();
       opr_names.clear();
+      node_names.clear();
+      seg_cost = OpCost();
       seg_start = nid + 1;
     } else if (is_async) {
       seg = EngineOprSeg{false, nid + 1};
-      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
+      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str(), node_names,
+                                   seg_cost));
       seg_execs.clear();
       opr_names.clear();
+      node_names.clear();
+      seg_cost = OpCost();
       seg_start = nid + 1;
     }
   }
@@ -1283,7 +1406,8 @@ inline void CreateEngineOpSeg(
     auto& seg = (*opr_segs)[seg_start];
     if (seg_execs.size()) {
       seg = EngineOprSeg{false, end_nid};
-      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
+      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str(), node_names,
+                                   seg_cost));
     } else {
       seg = EngineOprSeg{true, end_nid, nullptr};
     }
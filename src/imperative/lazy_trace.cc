@@ -0,0 +1,272 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file lazy_trace.cc
+ * \brief Records imperative operator calls in lazy mode and runs them as a CachedOp
+ */
+#include <dmlc/thread_local.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./lazy_trace.h"
+#include "./imperative_utils.h"
+
+namespace nnvm {
+ObjectPtr CreateVariableNode(const std::string &name);
+}
+
+namespace mxnet {
+
+std::shared_ptr<Imperative::LazyTrace> Imperative::LazyTrace::Get(bool create) {
+  std::shared_ptr<LazyTrace>* trace = dmlc::ThreadLocalStore<std::shared_ptr<LazyTrace>>::Get();
+  if (*trace == nullptr && create) {
+    *trace = std::make_shared<LazyTrace>();
+  }
+  return *trace;
+}
+
+bool Imperative::LazyTrace::IsTraceable(const nnvm::NodeAttrs& attrs,
+                                        const std::vector<NDArray*>& outputs) {
+  static auto& infershape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
+  static auto& createop = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
+  static auto& is_layer_backward = nnvm::Op::GetAttr<bool>("TIsLayerOpBackward");
+  static auto& mutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  const nnvm::Op* op = attrs.op;
+  // Dynamic shape operators need their inputs computed, stateful operators keep a
+  // state for backward and writes to existing arrays must stay ordered with their
+  // other readers and writers, so all of them run eagerly.
+  if (!infershape.count(op) || createop.count(op) || is_layer_backward.get(op, false) ||
+      mutate.count(op) || !attrs.subgraphs.empty()) {
+    return false;
+  }
+  for (const NDArray* output : outputs) {
+    if (!output->is_none()) return false;
+  }
+  return true;
+}
+
+nnvm::NodeEntry Imperative::LazyTrace::GetInputEntry(const NDArray& arr) {
+  if (!DCInfo::IsComputed(arr)) {
+    return arr.deferredcompute_entry_;
+  }
+  const auto range = input_index_.equal_range(arr.ptr_.get());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (inputs_[it->second].IsSame(arr)) {
+      return nnvm::NodeEntry{variables_[it->second], 0, 0};
+    }
+  }
+  input_index_.emplace(arr.ptr_.get(), inputs_.size());
+  variables_.push_back(nnvm::CreateVariableNode("data" + std::to_string(inputs_.size())));
+  inputs_.push_back(arr.Detach());
+  return nnvm::NodeEntry{variables_.back(), 0, 0};
+}
+
+bool Imperative::LazyTrace::Record(const nnvm::NodeAttrs& attrs,
+                                   const std::vector<NDArray*>& inputs,
+                                   const std::vector<NDArray*>& outputs) {
+  if (!IsTraceable(attrs, outputs)) return false;
+  // Arrays pending in the trace of another thread or from deferred compute are
+  // computed first and enter this trace as variables.
+  for (const NDArray* input : inputs) {
+    if (!DCInfo::IsComputed(*input) &&
+        DCInfo::Get(input->deferredcompute_entry_.node).lazy_trace_.get() != this) {
+      DCInfo::Compute(*input);
+    }
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  const Context ctx = imperative::GetContext(attrs, inputs, outputs, Context::CPU());
+  for (const NDArray* input : inputs) {
+    if (DCInfo::IsComputed(*input) &&
+        (input->ctx() != ctx || !shape_is_known(input->shape()))) {
+      return false;
+    }
+  }
+  const bool is_train = Imperative::Get()->is_training();
+  if (!nodes_.empty() && (ctx != ctx_ || is_train != is_train_)) {
+    Flush();
+  }
+  ctx_ = ctx;
+  is_train_ = is_train;
+
+  // Allocates the outputs without computing them, and reports errors in the
+  // arguments at the call site as eager execution does.
+  DispatchMode dispatch_mode = DispatchMode::kUndefined;
+  imperative::SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+
+  nnvm::ObjectPtr node = nnvm::Node::Create();
+  node->attrs = attrs;
+  node->attrs.name = "node_" + std::to_string(nodes_.size());
+  node->inputs.reserve(inputs.size());
+  for (const NDArray* input : inputs) {
+    node->inputs.emplace_back(GetInputEntry(*input));
+  }
+  for (uint32_t i = 0; i < outputs.size(); ++i) {
+    // The trace only observes whether the chunk is alive, so outputs the frontend
+    // drops are not computed unless another recorded operator consumes them.
+    Output output;
+    output.entry = nnvm::NodeEntry{node, i, 0};
+    output.array = outputs[i]->Detach();
+    output.array.ptr_ = nullptr;
+    output.chunk = outputs[i]->ptr_;
+    outputs_.emplace_back(std::move(output));
+    outputs[i]->deferredcompute_entry_ = nnvm::NodeEntry{node, i, 0};
+  }
+  DCInfo& info = DCInfo::Create(node, std::vector<NDArray*>(), std::vector<NDArray*>());
+  info.lazy_trace_ = shared_from_this();
+  nodes_.emplace_back(std::move(node));
+
+  if (nodes_.size() >= max_nodes_) {
+    Flush();
+  }
+  return true;
+}
+
+CachedOpPtr Imperative::LazyTrace::GetCachedOp(const nnvm::Symbol& sym) {
+  // Key on everything that determines the graph except node and variable names.
+  // Shapes are left out since the CachedOp infers them for every call.
+  std::ostringstream os;
+  std::unordered_map<const nnvm::Node*, size_t> index;
+  nnvm::DFSVisit(sym.outputs, [&](const nnvm::ObjectPtr& n) {
+    const size_t id = index.size();
+    index[n.get()] = id;
+    if (n->is_variable()) {
+      os << "var;";
+      return;
+    }
+    std::vector<std::pair<std::string, std::string>> dict(n->attrs.dict.begin(),
+                                                          n->attrs.dict.end());
+    std::sort(dict.begin(), dict.end());
+    os << n->op()->name << '(';
+    for (const auto& kv : dict) {
+      os << kv.first.size() << ':' << kv.first << kv.second.size() << ':' << kv.second;
+    }
+    os << ')';
+    for (const nnvm::NodeEntry& e : n->inputs) {
+      os << index.at(e.node.get()) << ':' << e.index << ',';
+    }
+    os << ';';
+  });
+  os << "->";
+  for (const nnvm::NodeEntry& e : sym.outputs) {
+    os << index.at(e.node.get()) << ':' << e.index << ',';
+  }
+  const std::string key = os.str();
+
+  auto it = cached_ops_.find(key);
+  if (it != cached_ops_.end()) return it->second;
+  const std::vector<std::pair<std::string, std::string>> flags = {{"static_alloc", "true"}};
+  CachedOpPtr op = std::make_shared<CachedOp>(sym.Copy(), flags);
+  if (cache_size_ > 0) {
+    if (cached_ops_.size() >= cache_size_) cached_ops_.clear();
+    cached_ops_.emplace(key, op);
+  }
+  return op;
+}
+
+void Imperative::LazyTrace::Flush() {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (nodes_.empty()) return;
+  // Take the recorded operators first, so that reads issued while the graph is
+  // being pushed find an empty trace.
+  std::vector<nnvm::ObjectPtr> nodes;
+  std::vector<Output> outputs;
+  std::vector<NDArray> inputs;
+  std::vector<nnvm::ObjectPtr> variables;
+  nodes.swap(nodes_);
+  outputs.swap(outputs_);
+  inputs.swap(inputs_);
+  variables.swap(variables_);
+  input_index_.clear();
+
+  nnvm::Symbol sym;
+  std::vector<NDArray> ndoutputs;
+  for (Output& output : outputs) {
+    std::shared_ptr<NDArray::Chunk> chunk = output.chunk.lock();
+    if (chunk == nullptr) continue;
+    sym.outputs.emplace_back(output.entry);
+    ndoutputs.emplace_back(output.array);
+    ndoutputs.back().ptr_ = std::move(chunk);
+  }
+  // Once pushed, or dropped after an error, the arrays behave like eager ones.
+  // Clearing the inputs releases the recorded graph.
+  auto release = [&nodes]() {
+    for (const nnvm::ObjectPtr& node : nodes) {
+      node->info.clear();
+      node->inputs.clear();
+    }
+  };
+  if (sym.outputs.empty()) {
+    release();
+    return;
+  }
+
+  std::unordered_map<const nnvm::Node*, NDArray*> bound;
+  for (size_t i = 0; i < variables.size(); ++i) {
+    bound[variables[i].get()] = &inputs[i];
+  }
+  std::vector<NDArray*> in_ptrs, out_ptrs;
+  for (const nnvm::ObjectPtr& var : sym.ListInputs(nnvm::Symbol::kAll)) {
+    in_ptrs.push_back(bound.at(var.get()));
+  }
+  for (NDArray& output : ndoutputs) {
+    out_ptrs.push_back(&output);
+  }
+
+  // Autograd recorded the operators when they were traced.
+  Imperative* imperative = Imperative::Get();
+  const bool prev_recording = imperative->set_is_recording(false);
+  const bool prev_training = imperative->set_is_training(is_train_);
+  try {
+    CachedOpPtr op = GetCachedOp(sym);
+    op->Forward(op, in_ptrs, out_ptrs, ctx_);
+  } catch (const dmlc::Error&) {
+    imperative->set_is_recording(prev_recording);
+    imperative->set_is_training(prev_training);
+    release();
+    throw;
+  }
+  imperative->set_is_recording(prev_recording);
+  imperative->set_is_training(prev_training);
+  release();
+}
+
+bool Imperative::set_is_lazy(bool is_lazy) {
+  const bool old = is_lazy_;
+  if (!is_lazy) FlushLazy();
+  is_lazy_ = is_lazy;
+  return old;
+}
+
+bool Imperative::RecordLazy(const nnvm::NodeAttrs& attrs,
+                            const std::vector<NDArray*>& inputs,
+                            const std::vector<NDArray*>& outputs) {
+  return LazyTrace::Get()->Record(attrs, inputs, outputs);
+}
+
+void Imperative::FlushLazy() {
+  if (!is_lazy_) return;
+  std::shared_ptr<LazyTrace> trace = LazyTrace::Get(false);
+  if (trace != nullptr) trace->Flush();
+}
+
+}  // namespace mxnet
@@ -0,0 +1,104 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file lazy_trace.h
+ * \brief Records imperative operator calls in lazy mode and runs them as a CachedOp
+ */
+#ifndef MXNET_IMPERATIVE_LAZY_TRACE_H_
+#define MXNET_IMPERATIVE_LAZY_TRACE_H_
+
+#include <mxnet/imperative.h>
+#include <mxnet/ndarray.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./cached_op.h"
+
+namespace mxnet {
+
+/*!
+ * \brief Operators called in lazy mode are appended to the trace of the calling
+ *  thread with their outputs allocated but not computed. The trace runs when one
+ *  of its arrays is read, when an operator that can not be traced is called, or
+ *  when it reaches MXNET_IMPERATIVE_LAZY_MAX_NODES operators.
+ *
+ *  Running the trace builds a graph whose outputs are the arrays that are still
+ *  referenced, so intermediates dropped by the frontend are neither computed nor
+ *  allocated. The graph is keyed on its structure and the CachedOp built for it,
+ *  with common expression elimination, fusion and static memory planning, is
+ *  reused when the same sequence of calls repeats.
+ */
+class Imperative::LazyTrace : public std::enable_shared_from_this<LazyTrace> {
+ public:
+  LazyTrace()
+    : max_nodes_(dmlc::GetEnv("MXNET_IMPERATIVE_LAZY_MAX_NODES", 512)),
+      cache_size_(dmlc::GetEnv("MXNET_IMPERATIVE_LAZY_CACHE_SIZE", 64)) {}
+
+  /*! \brief the trace of the calling thread, nullptr if it has none and create is false */
+  static std::shared_ptr<LazyTrace> Get(bool create = true);
+
+  /*!
+   * \brief append an operator whose outputs are none.
+   * \return false if the operator has to run eagerly.
+   */
+  bool Record(const nnvm::NodeAttrs& attrs,
+              const std::vector<NDArray*>& inputs,
+              const std::vector<NDArray*>& outputs);
+
+  /*! \brief run the recorded operators */
+  void Flush();
+
+ private:
+  /*! \brief whether the operator can be part of a CachedOp graph */
+  static bool IsTraceable(const nnvm::NodeAttrs& attrs,
+                          const std::vector<NDArray*>& outputs);
+  /*! \brief the graph entry of an input array, recording a variable for concrete ones */
+  nnvm::NodeEntry GetInputEntry(const NDArray& arr);
+  /*! \brief the CachedOp for the graph of the trace */
+  CachedOpPtr GetCachedOp(const nnvm::Symbol& sym);
+
+  /*! \brief an output and whether the frontend still references its chunk */
+  struct Output {
+    nnvm::NodeEntry entry;
+    NDArray array;
+    std::weak_ptr<NDArray::Chunk> chunk;
+  };
+
+  std::recursive_mutex mutex_;
+  size_t max_nodes_;
+  size_t cache_size_;
+  // context and training mode shared by the recorded operators
+  Context ctx_;
+  bool is_train_{false};
+  std::vector<nnvm::ObjectPtr> nodes_;
+  std::vector<Output> outputs_;
+  // concrete input arrays and their variables
+  std::vector<NDArray> inputs_;
+  std::vector<nnvm::ObjectPtr> variables_;
+  std::unordered_multimap<const NDArray::Chunk*, size_t> input_index_;
+  // CachedOps keyed on the graph structure
+  std::unordered_map<std::string, CachedOpPtr> cached_ops_;
+};
+
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_LAZY_TRACE_H_
@@ -50,6 +50,13 @@ class Compressor {
 
   virtual int GetCompressFactor() const = 0;
 
+  /*!
+   * \brief number of compressed elements which must stay together when the compressed
+   * array is sharded across servers. Block-structured formats (e.g. sparsification)
+   * override this so that every server receives whole blocks.
+   */
+  virtual int64_t GetCompressBlockSize() const { return 1; }
+
   virtual int64_t GetCompressedSize(const int64_t &original_size) {
     const int factor = this->GetCompressFactor();
     return ((original_size % factor == 0) ? original_size / factor : original_size / factor + 1);
@@ -0,0 +1,268 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file topk-inl.h
+ * \brief Top-k and random-k sparsifying compressors for kvstore.
+ *
+ * The gradient is split into blocks of `block_len` values. For every block the
+ * compressor keeps `pairs_per_block` (index, value) pairs, so the compressed
+ * array is laid out as a sequence of fixed-size blocks which can be sharded
+ * across servers on block boundaries. Indices are local to their block and are
+ * stored bitwise inside the float payload. Values that are not sent stay in the
+ * residual and are added to the next gradient (error feedback).
+ */
+
+#ifndef MXNET_KVSTORE_COMPRESSOR_IMPL_TOPK_INL_H_
+#define MXNET_KVSTORE_COMPRESSOR_IMPL_TOPK_INL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "../compressor.h"
+#include "../../../engine/openmp.h"
+#include "../../../operator/mxnet_op.h"
+#include "../../../operator/operator_common.h"
+
+namespace mxnet {
+namespace kvstore {
+namespace compressor {
+
+struct SparsifyCompressorParam : public dmlc::Parameter<SparsifyCompressorParam> {
+  float ratio;
+  int pairs_per_block;
+  int seed;
+  DMLC_DECLARE_PARAMETER(SparsifyCompressorParam) {
+    DMLC_DECLARE_FIELD(ratio).set_default(0.01f).set_range(0.0f, 0.5f).describe(
+        "Fraction of gradient values to send. The effective fraction is rounded so that "
+        "every compressed value stands for an integral number of original values.");
+    DMLC_DECLARE_FIELD(pairs_per_block).set_default(32).set_lower_bound(1).describe(
+        "Number of (index, value) pairs selected from every block of the gradient. "
+        "Larger values give a selection closer to global top-k at the cost of coarser "
+        "sharding granularity across servers.");
+    DMLC_DECLARE_FIELD(seed).set_default(0).describe(
+        "Seed of the random number generator used by random-k sparsification.");
+  }
+};
+
+/*! \brief reinterpret a block-local index as the float stored in the payload */
+inline float EncodeSparseIndex(int32_t idx) {
+  float ret;
+  std::memcpy(&ret, &idx, sizeof(ret));
+  return ret;
+}
+
+/*! \brief recover a block-local index from the float stored in the payload */
+inline int32_t DecodeSparseIndex(float val) {
+  int32_t ret;
+  std::memcpy(&ret, &val, sizeof(ret));
+  return ret;
+}
+
+/*!
+ * \brief Base class of the sparsifying compressors. Subclasses only decide which
+ * `k` values of a block are sent, the payload layout, error feedback and
+ * decompression are shared.
+ */
+class SparsifyCompressor : public Compressor {
+ public:
+  SparsifyCompressor() = default;
+
+  ~SparsifyCompressor() = default;
+
+  void Init(const kwarg_t &kwargs) override {
+    param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.ratio, 0) << "ratio for sparsifying compression must be larger than 0.";
+    factor_ = std::max(1, static_cast<int>(std::lround(0.5 / param_.ratio)));
+  }
+
+  /*!
+   * \brief every compressed value (half of a pair) stands for `factor_` original values
+   */
+  inline int GetCompressFactor() const override { return factor_; }
+
+  inline int64_t GetCompressBlockSize() const override { return 2 * param_.pairs_per_block; }
+
+  int64_t GetCompressedSize(const int64_t &original_size) override {
+    const int64_t block_len = BlockLength();
+    const int64_t num_full = original_size / block_len;
+    const int64_t tail = original_size % block_len;
+    int64_t size = num_full * GetCompressBlockSize();
+    if (tail > 0) {
+      const int64_t tail_pairs = (tail + 2 * factor_ - 1) / (2 * factor_);
+      size += 2 * std::min<int64_t>(std::max<int64_t>(tail_pairs, 1), param_.pairs_per_block);
+    }
+    return size;
+  }
+
+  std::map<std::string, std::string> GetParams() const override { return param_.__DICT__(); }
+
+  void Compress(mxnet::RunContext &rctx, const mxnet::TBlob &in, mxnet::TBlob &out,
+                mxnet::TBlob &residual) override {
+    CHECK_EQ(rctx.get_ctx().dev_mask(), cpu::kDevMask)
+        << TypeString() << " is only supported on CPU";
+    CHECK_EQ(in.type_flag_, mshadow::kFloat32) << TypeString() << " only supports float32";
+    CHECK_EQ(out.type_flag_, mshadow::kFloat32) << TypeString() << " only supports float32";
+    CHECK_EQ(residual.type_flag_, mshadow::kFloat32)
+        << TypeString() << " only supports float32";
+    CompressImpl(in, out, residual);
+  }
+
+  void Decompress(mxnet::RunContext &rctx, const mxnet::TBlob &in, mxnet::TBlob &out) override {
+    CHECK_EQ(rctx.get_ctx().dev_mask(), cpu::kDevMask)
+        << TypeString() << " is only supported on CPU";
+    CHECK_EQ(in.type_flag_, mshadow::kFloat32) << TypeString() << " only supports float32";
+    CHECK_EQ(out.type_flag_, mshadow::kFloat32) << TypeString() << " only supports float32";
+    DecompressImpl(in, out);
+  }
+
+ protected:
+  /*!
+   * \brief move the indices of the `k` values to send to the front of `idx`
+   * \param residual accumulated gradient of the block
+   * \param idx block-local indices, initialized to 0..len-1
+   * \param k number of values to select
+   * \param rng thread-local generator seeded for this block
+   */
+  virtual void Select(const float *residual, std::vector<int32_t> *idx, int64_t k,
+                      std::mt19937 *rng) const = 0;
+
+  inline int64_t BlockLength() const {
+    return static_cast<int64_t>(2) * param_.pairs_per_block * factor_;
+  }
+
+  SparsifyCompressorParam param_;
+
+ private:
+  void CompressImpl(const mxnet::TBlob &in, mxnet::TBlob &out, mxnet::TBlob &residual) {
+    const int64_t original_size = in.Size();
+    const int64_t compr_size = out.Size();
+    const int64_t block_len = BlockLength();
+    const int64_t block_compr = GetCompressBlockSize();
+    const int64_t num_blocks = (original_size + block_len - 1) / block_len;
+    const float *grad = in.dptr<float>();
+    float *res = residual.dptr<float>();
+    float *compr = out.dptr<float>();
+    const uint32_t step = step_++;
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      std::vector<int32_t> idx;
+      #pragma omp for schedule(static)
+      for (int64_t b = 0; b < num_blocks; ++b) {
+        const int64_t start = b * block_len;
+        const int64_t len = std::min(block_len, original_size - start);
+        const int64_t compr_start = b * block_compr;
+        const int64_t k = std::min(std::min(block_compr, compr_size - compr_start) / 2, len);
+        float *block_res = res + start;
+        float *block_out = compr + compr_start;
+        // error feedback: accumulate the gradient into the residual of the block
+        for (int64_t i = 0; i < len; ++i) {
+          block_res[i] += grad[start + i];
+        }
+        idx.resize(len);
+        std::iota(idx.begin(), idx.end(), 0);
+        std::seed_seq seq{static_cast<uint32_t>(param_.seed), step, static_cast<uint32_t>(b)};
+        std::mt19937 rng(seq);
+        Select(block_res, &idx, k, &rng);
+        // emit the pairs in index order so that decompression writes sequentially
+        std::sort(idx.begin(), idx.begin() + k);
+        for (int64_t j = 0; j < k; ++j) {
+          const int32_t i = idx[j];
+          block_out[2 * j] = EncodeSparseIndex(i);
+          block_out[2 * j + 1] = block_res[i];
+          block_res[i] = 0;
+        }
+      }
+    }
+  }
+
+  void DecompressImpl(const mxnet::TBlob &in, mxnet::TBlob &out) {
+    const int64_t original_size = out.Size();
+    const int64_t num_pairs = in.Size() / 2;
+    const int64_t block_len = BlockLength();
+    const int64_t pairs_per_block = param_.pairs_per_block;
+    const float *compr = in.dptr<float>();
+    float *dst = out.dptr<float>();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel for num_threads(omp_threads) schedule(static)
+    for (int64_t i = 0; i < original_size; ++i) {
+      dst[i] = 0;
+    }
+    #pragma omp parallel for num_threads(omp_threads) schedule(static)
+    for (int64_t j = 0; j < num_pairs; ++j) {
+      const int64_t pos = (j / pairs_per_block) * block_len + DecodeSparseIndex(compr[2 * j]);
+      // payload slots past the last selected pair of a block carry no data
+      if (pos >= 0 && pos < original_size) dst[pos] = compr[2 * j + 1];
+    }
+  }
+
+  int factor_ = 1;
+  std::atomic<uint32_t> step_{0};
+};
+
+/*!
+ * \brief Keeps the largest-magnitude values of every block. Selection uses
+ * introselect (std::nth_element), so it is linear in the block length, and ties
+ * are broken by the smaller index to keep the result deterministic.
+ */
+class TopKCompressor : public SparsifyCompressor {
+ public:
+  std::string TypeString() const override { return "TopKCompressor"; }
+
+ protected:
+  void Select(const float *residual, std::vector<int32_t> *idx, int64_t k,
+              std::mt19937 *rng) const override {
+    if (k <= 0 || k >= static_cast<int64_t>(idx->size())) return;
+    std::nth_element(idx->begin(), idx->begin() + k, idx->end(),
+                     [residual](int32_t a, int32_t b) {
+                       const float fa = std::fabs(residual[a]);
+                       const float fb = std::fabs(residual[b]);
+                       return fa > fb || (fa == fb && a < b);
+                     });
+  }
+};
+
+/*!
+ * \brief Keeps `k` uniformly sampled values of every block (partial Fisher-Yates).
+ */
+class RandomKCompressor : public SparsifyCompressor {
+ public:
+  std::string TypeString() const override { return "RandomKCompressor"; }
+
+ protected:
+  void Select(const float *residual, std::vector<int32_t> *idx, int64_t k,
+              std::mt19937 *rng) const override {
+    const int64_t len = idx->size();
+    for (int64_t j = 0; j < k && j < len - 1; ++j) {
+      std::uniform_int_distribution<int64_t> dist(j, len - 1);
+      std::swap((*idx)[j], (*idx)[dist(*rng)]);
+    }
+  }
+};
+
+}  // namespace compressor
+}  // namespace kvstore
+}  // namespace mxnet
+
+#endif  // MXNET_KVSTORE_COMPRESSOR_IMPL_TOPK_INL_H_
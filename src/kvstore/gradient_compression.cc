@@ -71,6 +71,8 @@ std::pair<std::string, kvstore::compressor::kwarg_t> GradientCompression::Decode
 
 int GradientCompression::GetCompressionFactor() { return compr_->GetCompressFactor(); }
 
+int64_t GradientCompression::GetCompressBlockSize() { return compr_->GetCompressBlockSize(); }
+
 int64_t GradientCompression::GetCompressedSize(const int64_t &original_size) {
   return compr_->GetCompressedSize(original_size);
 }
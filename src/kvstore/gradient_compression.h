@@ -73,6 +73,12 @@ class GradientCompression {
    */
   int GetCompressionFactor();
 
+  /*!
+   * \brief returns the granularity, in compressed elements, at which compressed
+   * gradients can be split across servers
+   */
+  int64_t GetCompressBlockSize();
+
   /*!
    * \brief returns the size of compressed gradients given an original sized gradient array
    */
@@ -261,29 +261,7 @@ class KVStoreDist : public KVStoreLocal {
       }
 
       CHECK(!gradient_compression_->IsInitialized()) << "Compression not supported with PushPull";
-      auto pushpull = [this, key, comm_buf](
-          RunContext rctx, Engine::CallbackOnComplete cb) {
-        size_t size = comm_buf.shape().Size();
-        const int dtype = comm_buf.dtype();
-        const int num_bytes = mshadow::mshadow_sizeof(dtype);
-        const int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
-
-        PSKV& pskv = EncodeDefaultKey(key, size, num_bytes);
-        char* data = static_cast<char*>(comm_buf.data().dptr_);
-        auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-
-        CHECK_NOTNULL(ps_worker_)->ZPushPull(
-          pskv.keys, *vals, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
-      };
-
-      CHECK_NOTNULL(Engine::Get())->PushAsync(
-          pushpull,
-          pinned_ctx_,
-          {},
-          {comm_buf.var()},
-          FnProperty::kNormal,
-          priority,
-          "KVStoreDistDefaultStoragePushPull");
+      PushPullDefault(key, comm_buf, priority);
 
       comm_->Broadcast(key, comm_buf, outs, priority);
     }
@@ -316,35 +294,7 @@ class KVStoreDist : public KVStoreLocal {
         recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
                            true, grouped_vals[i][0]->dtype());
       }
-      auto pull_from_servers = [this, key, recv_buf](
-          RunContext rctx, Engine::CallbackOnComplete cb) {
-        // convert to ps keys
-        size_t size = recv_buf.shape().Size();
-        const int dtype = recv_buf.dtype();
-        const int num_bytes = mshadow::mshadow_sizeof(dtype);
-        PSKV& pskv = (!gradient_compression_->IsInitialized())
-                         ? EncodeDefaultKey(key, size, num_bytes)
-                         : EncodeCompressedKey(key, size, false, num_bytes);
-        char* data = static_cast<char*> (recv_buf.data().dptr_);
-        // false means not to delete data when SArray is deleted
-        auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-        // issue pull
-        RequestType mode = (gradient_compression_->IsInitialized())
-                               ? RequestType::kCompressedPushPull
-                               : RequestType::kDefaultPushPull;
-        const int cmd = GetCommandType(mode, dtype);
-        CHECK_NOTNULL(ps_worker_)->ZPull(
-          pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
-      };
-
-      CHECK_NOTNULL(Engine::Get())->PushAsync(
-          pull_from_servers,
-          pinned_ctx_,
-          {},
-          {recv_buf.var()},
-          FnProperty::kNormal,
-          priority,
-          "KVStoreDistDefaultStoragePull");
+      PullDefault(key, recv_buf, priority);
 
       comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
     }
@@ -555,15 +505,16 @@ class KVStoreDist : public KVStoreLocal {
       size_t size = recv_buf.shape().Size();
       const int dtype = recv_buf.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
-      PSKV& pskv = (gradient_compression_->get_type() == CompressionType::kNone) ?
-                    EncodeDefaultKey(key, size, num_bytes) :
-                    EncodeCompressedKey(key, size, false, num_bytes);
+      PSKV& pskv = (!gradient_compression_->IsInitialized())
+                       ? EncodeDefaultKey(key, size, num_bytes)
+                       : EncodeCompressedKey(key, size, false, num_bytes);
       char* data = static_cast<char*> (recv_buf.data().dptr_);
       // false means not to delete data when SArray is deleted
       auto vals = new ps::SArray<char>(data, size * num_bytes, false);
       // issue pull
-      RequestType mode = (gradient_compression_->get_type() != CompressionType::kNone) ?
-                RequestType::kCompressedPushPull : RequestType::kDefaultPushPull;
+      RequestType mode = (gradient_compression_->IsInitialized())
+                             ? RequestType::kCompressedPushPull
+                             : RequestType::kDefaultPushPull;
       const int cmd = GetCommandType(mode, dtype);
       CHECK_NOTNULL(ps_worker_)->ZPull(
         pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
@@ -769,6 +720,9 @@ class KVStoreDist : public KVStoreLocal {
         // partition it to all servers
         push_pskv.size = 0;
         pull_pskv.size = 0;
+        // compressed parts must not split a block of the compressed format
+        const size_t compr_block = gradient_compression_->GetCompressBlockSize();
+        auto align = [compr_block](size_t n) { return n / compr_block * compr_block; };
 
         for (int i = 0; i < num_servers; ++i) {
           size_t part_compr, part_orig;
@@ -777,8 +731,10 @@ class KVStoreDist : public KVStoreLocal {
             part_orig = original_num_elem - pull_pskv.size;
           } else {
             part_compr =
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i+1))) -
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i)));
+              align(static_cast<size_t>(
+                  round(static_cast<double>(compr_num_elem)/num_servers*(i+1)))) -
+              align(static_cast<size_t>(
+                  round(static_cast<double>(compr_num_elem)/num_servers*(i))));
             part_orig = part_compr * gradient_compression_->GetCompressionFactor();
           }
 
@@ -38,6 +38,7 @@
 #include "../profiler/profiler.h"
 #include "../operator/tensor/elemwise_binary_op-inl.h"
 #include "../operator/tensor/init_op.h"
+#include "./row_store.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -45,7 +46,7 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kSetRowStoreOptimizer
 };
 
 enum class RequestType {
@@ -164,6 +165,9 @@ class KVStoreDistServer {
     sync_mode_ = false;
     gradient_compression_ = std::make_shared<GradientCompression>();
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    row_store_min_rows_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_STORE_MIN_ROWS", 0);
+    row_store_cache_rows_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_STORE_CACHE_ROWS", 65536);
+    row_store_cache_refresh_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_STORE_CACHE_REFRESH", 100);
   }
 
   ~KVStoreDistServer() {
@@ -208,6 +212,9 @@ class KVStoreDistServer {
       case CommandType::kSetGradientCompression:
         CreateCompressorOnServer(recved.body);
         break;
+      case CommandType::kSetRowStoreOptimizer:
+        SetRowStoreOptimizer(recved.body);
+        break;
       case CommandType::kSetProfilerParams:
         // last char is the type of profiler command
         ProcessServerProfilerCommands(static_cast<KVStoreServerProfilerCommand>
@@ -278,6 +285,25 @@ class KVStoreDistServer {
     gradient_compression_->Init(p.first, p.second);
   }
 
+  /**
+   * \brief configure the optimizer applied by row stores, body is
+   * a comma separated list of alternating parameter names and values
+   */
+  void SetRowStoreOptimizer(const std::string& body) {
+    std::vector<std::string> elems;
+    mxnet::kvstore::split(body, ',', std::back_inserter(elems));
+    CHECK_EQ(elems.size() % 2, 0) << "Improper row store optimizer passed from worker";
+    std::vector<std::pair<std::string, std::string>> kwargs;
+    for (size_t i = 0; i < elems.size(); i += 2) {
+      kwargs.emplace_back(elems[i], elems[i + 1]);
+    }
+    std::lock_guard<std::mutex> lock(row_store_mu_);
+    row_store_param_.Init(kwargs);
+    for (auto& entry : row_store_) {
+      entry.second->SetParam(row_store_param_);
+    }
+  }
+
   void ProcessServerProfilerCommands(KVStoreServerProfilerCommand type, const std::string& body) {
     switch (type) {
       case KVStoreServerProfilerCommand::kSetConfig:
@@ -524,11 +550,84 @@ class KVStoreDistServer {
     server->Response(req_meta);
   }
 
+  /**
+   * \brief whether a row_sparse key initialized with `num_rows` rows is kept in a RowStore
+   */
+  inline bool UseRowStore(const DataHandleType type, const size_t num_rows) {
+    return row_store_min_rows_ > 0 && num_rows >= row_store_min_rows_ &&
+           type.dtype == mshadow::kFloat32 && !multi_precision_;
+  }
+
+  void DataHandleRowStore(const DataHandleType type, const int master_key,
+                          const size_t num_rows, const ps::KVMeta& req_meta,
+                          const ps::KVPairs<char>& req_data,
+                          ps::KVServer<char>* server) {
+    std::vector<int64_t> indices(num_rows);
+    if (num_rows > 0) DecodeRowIds(req_data.keys, indices.data(), master_key, num_rows);
+    std::lock_guard<std::mutex> lock(row_store_mu_);
+    auto& row_store = row_store_[master_key];
+    if (!req_meta.push) {
+      if (log_verbose_) LOG(INFO) << "pull: " << master_key;
+      CHECK(row_store) << "init " << master_key << " first";
+      ps::KVPairs<char> response;
+      response.keys = req_data.keys;
+      const int unit_len = num_rows > 0 ? row_store->unit_len() : 0;
+      response.vals.resize(num_rows * unit_len * sizeof(float));
+      row_store->Pull(indices.data(), num_rows, reinterpret_cast<float*>(response.vals.data()));
+      std::vector<int> lens(req_data.keys.size(), unit_len);
+      lens[0] = 0;
+      response.lens.CopyFrom(lens.begin(), lens.end());
+      server->Response(req_meta, response);
+      return;
+    }
+    CHECK_GT(req_data.lens.size(), 0) << "req_data.lens cannot be empty";
+    CHECK_EQ(req_data.lens[0], 0);
+    const float* vals = reinterpret_cast<const float*>(req_data.vals.data());
+    if (!row_store) {
+      if (log_verbose_) LOG(INFO) << "initial push to row store: " << master_key;
+      CHECK_GT(num_rows, 0) << "init with empty data is not supported";
+      const int64_t unit_len = req_data.lens[1] / sizeof(float);
+      CHECK_GT(unit_len, 0);
+      CHECK_EQ(req_data.vals.size(), num_rows * unit_len * sizeof(float));
+      row_store.reset(new RowStore(num_rows, unit_len, row_store_param_,
+                                   row_store_cache_rows_, row_store_cache_refresh_));
+      row_store->Init(indices.data(), vals, num_rows);
+      server->Response(req_meta);
+      return;
+    }
+    CHECK(!updater_ || !row_store_param_.optimizer.empty())
+        << "Key " << master_key << " is kept in a row store, which can only apply lazy "
+        << "sgd, adagrad or adam updates with a constant learning rate. Unset "
+        << "MXNET_KVSTORE_ROW_STORE_MIN_ROWS to use other optimizers.";
+    if (log_verbose_) LOG(INFO) << "push to row store: " << master_key << " " << num_rows;
+    if (sync_mode_) {
+      if (num_rows > 0) row_store->Accumulate(indices.data(), vals, num_rows);
+      auto& updates = update_buf_[master_key];
+      updates.request.push_back(req_meta);
+      if (updates.request.size() == (size_t) ps::NumWorkers()) {
+        row_store->ApplyPending();
+        for (const auto& req : updates.request) {
+          server->Response(req);
+        }
+        updates.request.clear();
+      }
+    } else {
+      CHECK(!row_store_param_.optimizer.empty()) << "Updater needs to be set for async mode";
+      if (num_rows > 0) row_store->Update(indices.data(), vals, num_rows);
+      server->Response(req_meta);
+    }
+  }
+
   void DataHandleRowSparse(const DataHandleType type, const ps::KVMeta& req_meta,
                            const ps::KVPairs<char>& req_data,
                            ps::KVServer<char>* server) {
     int master_key = DecodeKey(req_data.keys[0]);
     auto num_rows = req_data.keys.size() - 1;
+    if (row_store_.count(master_key) ||
+        (req_meta.push && !store_.count(master_key) && UseRowStore(type, num_rows))) {
+      DataHandleRowStore(type, master_key, num_rows, req_meta, req_data, server);
+      return;
+    }
     auto& stored = store_[master_key];
     if (req_meta.push) {
       CHECK_GT(req_data.lens.size(), 0) << "req_data.lens cannot be empty";
@@ -818,6 +917,17 @@ class KVStoreDistServer {
    * currently there is no support for unsetting gradient compression
    */
   std::shared_ptr<kvstore::GradientCompression> gradient_compression_;
+
+  /**
+   * \brief row stores of row_sparse keys with at least `row_store_min_rows_` rows.
+   * These keys are not kept in store_.
+   */
+  std::unordered_map<int, std::unique_ptr<RowStore>> row_store_;
+  RowStoreParam row_store_param_;
+  std::mutex row_store_mu_;
+  size_t row_store_min_rows_;
+  size_t row_store_cache_rows_;
+  int row_store_cache_refresh_;
 };
 
 }  // namespace kvstore
@@ -38,6 +38,7 @@
 #include "./kvstore_utils.h"
 #include "../ndarray/ndarray_function.h"
 #include "../profiler/profiler.h"
+#include "../profiler/metrics.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -85,6 +86,10 @@ class KVStoreLocal : public KVStore {
     }
     pinned_ctx_ = comm_->pinned_ctx();
     gradient_compression_ = std::make_shared<GradientCompression>();
+    pushed_bytes_ = profiler::Metrics::Get()->Counter(
+        "mxnet_kvstore_pushed_bytes", "Bytes of dense arrays pushed to kvstores.");
+    pulled_bytes_ = profiler::Metrics::Get()->Counter(
+        "mxnet_kvstore_pulled_bytes", "Bytes of dense arrays pulled from kvstores.");
   }
 
   virtual ~KVStoreLocal() {
@@ -119,6 +124,7 @@ class KVStoreLocal : public KVStore {
             const std::vector<NDArray>& values,
             int priority) override {
     SetKeyType(kIntKey);
+    CountBytes(values, pushed_bytes_);
     PushImpl(keys, values, priority);
   }
 
@@ -127,6 +133,7 @@ class KVStoreLocal : public KVStore {
             int priority,
             bool ignore_sparse) override {
     SetKeyType(kIntKey);
+    CountBytes(values, pulled_bytes_);
     PullImpl(keys, values, priority, ignore_sparse);
   }
 
@@ -145,6 +152,8 @@ class KVStoreLocal : public KVStore {
                 const std::vector<NDArray*>& outs,
                 int priority) override {
     SetKeyType(kIntKey);
+    CountBytes(values, pushed_bytes_);
+    CountBytes(outs, pulled_bytes_);
     PushPullImpl(vkeys, okeys, values, outs, priority);
   }
 
@@ -161,6 +170,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
+    CountBytes(values, pushed_bytes_);
     PushImpl(keys, values, priority);
   }
 
@@ -171,6 +181,7 @@ class KVStoreLocal : public KVStore {
     SetKeyType(kStringKey);
     std::vector<int> keys(str_keys.size());
     LookupKeys(str_keys, &keys);
+    CountBytes(values, pulled_bytes_);
     PullImpl(keys, values, priority, ignore_sparse);
   }
 
@@ -206,6 +217,8 @@ class KVStoreLocal : public KVStore {
     std::vector<int> okeys(str_okeys.size());
     LookupKeys(str_vkeys, &vkeys);
     LookupKeys(str_okeys, &okeys);
+    CountBytes(values, pushed_bytes_);
+    CountBytes(outs, pulled_bytes_);
     PushPullImpl(vkeys, okeys, values, outs, priority);
   }
 
@@ -224,6 +237,29 @@ class KVStoreLocal : public KVStore {
   }
 
  private:
+  /**
+   * \brief add the bytes of the dense arrays to a counter of the runtime metrics,
+   *  skipping sparse arrays whose size is only known once computed
+   */
+  static void CountBytes(const std::vector<NDArray>& arrays, std::atomic<uint64_t>* counter) {
+    uint64_t bytes = 0;
+    for (const auto& arr : arrays) {
+      if (arr.storage_type() == kDefaultStorage) {
+        bytes += arr.shape().Size() * mshadow::mshadow_sizeof(arr.dtype());
+      }
+    }
+    counter->fetch_add(bytes, std::memory_order_relaxed);
+  }
+  static void CountBytes(const std::vector<NDArray*>& arrays, std::atomic<uint64_t>* counter) {
+    uint64_t bytes = 0;
+    for (const auto* arr : arrays) {
+      if (arr->storage_type() == kDefaultStorage) {
+        bytes += arr->shape().Size() * mshadow::mshadow_sizeof(arr->dtype());
+      }
+    }
+    counter->fetch_add(bytes, std::memory_order_relaxed);
+  }
+
   virtual void InitImpl(const std::vector<int>& keys,
                         const std::vector<NDArray>& values) {
     for (size_t i = 0; i < keys.size(); ++i) {
@@ -549,6 +585,9 @@ class KVStoreLocal : public KVStore {
   std::unordered_set<int> warnings_printed_;
   /// whether int or string is used for keys
   KeyType key_type_ = kUndefinedKey;
+  /// counters of the runtime metrics, shared by all kvstores
+  std::atomic<uint64_t>* pushed_bytes_;
+  std::atomic<uint64_t>* pulled_bytes_;
 };
 }  // namespace kvstore
 }  // namespace mxnet
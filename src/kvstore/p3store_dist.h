@@ -27,6 +27,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
 #include <utility>
 #include "./kvstore_dist.h"
 #include "mxnet/engine.h"
@@ -36,6 +37,11 @@ namespace kvstore {
 
 /**
  * \brief distributed p3store
+ *
+ * Every default storage key is split into slices of at most `MXNET_KVSTORE_SLICE_THRESHOLD`
+ * elements, row_sparse keys are split by rows across the servers. Each slice is a separate key on the servers and is
+ * pushed and pulled as its own message carrying the priority of the originating
+ * operation, so that slices of urgent layers overtake large, less urgent transfers.
  */
 class P3StoreDist : public KVStoreDist {
  public:
@@ -44,40 +50,188 @@ class P3StoreDist : public KVStoreDist {
     slice_threshold_ = dmlc::GetEnv("MXNET_KVSTORE_SLICE_THRESHOLD", 40 * 1000);
   }
 
-  void PullRowSparse(const std::vector<int>& str_keys,
-                     const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                     int priority) final {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not supported in P3StoreDist.";
+ private:
+  /**
+   * \brief placement of the slices of one key on the servers
+   */
+  struct SliceInfo {
+    // server key of every slice
+    std::vector<ps::Key> keys;
+    // index of the server holding every slice
+    std::vector<int> servers;
+    // number of elements (default storage) or rows (row_sparse storage) of every slice
+    std::vector<size_t> sizes;
+  };
+
+  inline void InitKV(const int key, const NDArray& value) override {
+    comm_->Init(key, value.storage_type(), value.shape(), value.dtype());
+    const int num_bytes = mshadow::mshadow_sizeof(value.dtype());
+    if (value.storage_type() == kDefaultStorage) {
+      const size_t size = value.shape().Size();
+      AllocateSlices(key, size, slice_threshold_);
+      EncodeDefaultKey(key, size, num_bytes);
+    } else {
+      CHECK_EQ(value.storage_type(), kRowSparseStorage)
+          << "Default or row_sparse storage type for values expected in P3StoreDist";
+      // row_sparse pushes only carry the touched rows and every slice costs one message
+      // per push, so rows are split into one slice per server like KVStoreDist does
+      const auto& shape = value.shape();
+      const size_t num_rows = shape[0];
+      const size_t num_slices = (shape.Size() >= bigarray_bound_) ?
+                                ps::Postoffice::Get()->GetServerKeyRanges().size() : 1;
+      AllocateSlices(key, num_rows, (num_rows + num_slices - 1) / num_slices);
+    }
   }
 
-  void PullRowSparse(const std::vector<std::string>& str_keys,
-                     const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
-                     int priority) final {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not supported in P3StoreDist.";
+  /**
+   * \brief assign server keys to the slices of `key`. The first slice keeps the key
+   * itself, so unsliced keys keep their optimizer index on the server; slice i > 0 gets
+   * kSliceKeyOffset + (key << kSliceKeyBits) + i, from which the server recovers the key
+   * to look up its optimizer hyper-parameters. Slices are spread round-robin. Workers
+   * initialize keys in the same order, so the assignment is identical across workers.
+   */
+  void AllocateSlices(const int key, const size_t total, size_t slice_size) {
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    const int num_servers = krs.size();
+    CHECK_GT(num_servers, 0);
+    CHECK_LT(key, kSliceKeyOffset) << "P3StoreDist supports keys smaller than "
+                                   << kSliceKeyOffset;
+    // grow the slices of huge keys so that their slice index fits in kSliceKeyBits
+    const size_t max_slices = size_t(1) << kSliceKeyBits;
+    slice_size = std::max(slice_size, (total + max_slices - 1) / max_slices);
+    CHECK(total <= slice_size || key < (kSliceKeyOffset >> kSliceKeyBits))
+        << "P3StoreDist slices keys smaller than " << (kSliceKeyOffset >> kSliceKeyBits)
+        << ", key " << key << " has " << total << " elements";
+    std::lock_guard<std::mutex> lock(mu_);
+    SliceInfo& info = slices_[key];
+    if (!info.keys.empty()) return;
+    const int first_server = static_cast<int>((static_cast<uint64_t>(key) * 9973) % num_servers);
+    size_t remaining = total;
+    do {
+      const size_t part = std::min(remaining, slice_size);
+      const size_t slice = info.keys.size();
+      const int server = (first_server + slice) % num_servers;
+      ps::Key ps_key = krs[server].begin() + key;
+      if (slice > 0) {
+        ps_key = krs[server].begin() + kSliceKeyOffset +
+                 (static_cast<ps::Key>(key) << kSliceKeyBits) + slice;
+      }
+      CHECK_LT(ps_key, krs[server].end());
+      info.keys.push_back(ps_key);
+      info.servers.push_back(server);
+      info.sizes.push_back(part);
+      remaining -= part;
+    } while (remaining > 0);
   }
 
-  void set_updater(const Updater& updater) final {
-      LOG(FATAL) << "NotImplementedError: Update on P3StoreDist is not supported. "
-          << "Please set MXNET_UPDATE_ON_KVSTORE to false.";
+  inline const SliceInfo& GetSlices(const int key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = slices_.find(key);
+    CHECK(it != slices_.end()) << "init key " << key << " first";
+    return it->second;
   }
 
-  void SetGradientCompression(const std::vector<std::pair<std::string, std::string>>
-                              & kwargs) final {
-    LOG(FATAL) << "NotImplementedError: Gradient compression not supported in P3StoreDist.";
+  /**
+   * \brief split a pskv into per-server messages. A message starts at every key whose
+   * length is 0 (meta key of compressed and row_sparse requests) and at every key of
+   * default requests, which have no meta keys.
+   * \return pairs of [begin, end) indices into pskv.keys
+   */
+  static std::vector<std::pair<size_t, size_t>> SplitMessages(const PSKV& pskv,
+                                                               bool has_meta_key) {
+    std::vector<std::pair<size_t, size_t>> messages;
+    for (size_t i = 0; i < pskv.keys.size(); ++i) {
+      if (!has_meta_key || pskv.lens[i] == 0) {
+        if (!messages.empty()) messages.back().second = i;
+        messages.emplace_back(i, pskv.keys.size());
+      }
+    }
+    return messages;
   }
 
- private:
-  inline void InitKV(const int key, const NDArray& value) override {
-    CHECK_EQ(value.storage_type(), kDefaultStorage)
-        << "Default storage type for values expected in P3StoreDist";
-    comm_->Init(key, value.storage_type(), value.shape(), value.dtype());
-    /* Fix the key encoding */
-    EncodeDefaultKey(key, value.shape().Size(), mshadow::mshadow_sizeof(value.dtype()));
+  /**
+   * \brief push `vals` as one message per slice with the given priority
+   */
+  void ZPushSliced(const PSKV& pskv, const ps::SArray<char>& vals, bool has_meta_key,
+                   int cmd, int priority, const Engine::CallbackOnComplete& cb) {
+    auto messages = SplitMessages(pskv, has_meta_key);
+    auto counter = new std::atomic<int>(messages.size());
+    size_t off = 0;
+    for (const auto& msg : messages) {
+      size_t len = 0;
+      for (size_t i = msg.first; i < msg.second; ++i) len += pskv.lens[i];
+      auto ks = pskv.keys.segment(msg.first, msg.second);
+      auto ls = pskv.lens.segment(msg.first, msg.second);
+      auto vs = vals.segment(off, off + len);
+      CHECK_NOTNULL(ps_worker_)->ZPush(
+        ks, vs, ls, cmd, [counter, cb]() {
+            if (--(*counter) == 0) {
+              delete counter;
+              cb();
+            }
+          }, priority);
+      off += len;
+    }
   }
 
   void PushCompressed(int key, const NDArray& comm_buf, const PSKV& pskv,
-                      int priority) final {
-    LOG(FATAL) << "NotImplementedError: PushCompressed not implemented in P3StoreDist.";
+                      int priority) override {
+    const SliceInfo& info = GetSlices(key);
+    auto& small_buf = compr_buf_[key];
+    auto& res_buf = residual_[key];
+    auto& parts = compr_parts_[key];
+    const int64_t original_size = comm_buf.shape().Size();
+    const int dtype = comm_buf.dtype();
+    const int num_bytes = mshadow::mshadow_sizeof(dtype);
+
+    // Init the small buffer and residual_ buffer, and their per-slice views, once
+    if (small_buf.is_none()) {
+      small_buf = NDArray(mxnet::TShape{static_cast<int64_t>(pskv.size / num_bytes)},
+                          comm_buf.ctx(), false, dtype);
+      res_buf = NDArray(mxnet::TShape{original_size}, comm_buf.ctx(), false, dtype);
+      res_buf = 0;
+      int64_t off = 0, compr_off = 0;
+      for (size_t i = 0; i < info.sizes.size(); ++i) {
+        const int64_t size = info.sizes[i];
+        const int64_t compr_size = gradient_compression_->GetCompressedSize(size);
+        parts.compressed.push_back(small_buf.Slice(compr_off, compr_off + compr_size));
+        parts.residual.push_back(res_buf.Slice(off, off + size));
+        off += size;
+        compr_off += compr_size;
+      }
+      CHECK_EQ(off, original_size);
+      CHECK_EQ(compr_off, small_buf.shape().Size());
+    }
+    // compress every slice on its own so that the server of each slice can
+    // decompress its message independently
+    const NDArray flat = comm_buf.Reshape(mxnet::TShape{original_size});
+    int64_t off = 0;
+    for (size_t i = 0; i < info.sizes.size(); ++i) {
+      const int64_t size = info.sizes[i];
+      gradient_compression_->CompressEx(flat.Slice(off, off + size), &parts.compressed[i],
+                                        &parts.residual[i], priority);
+      off += size;
+    }
+    auto push_to_servers = [this, key, pskv, small_buf, priority]
+      (RunContext rctx, Engine::CallbackOnComplete cb) {
+        const int dtype = small_buf.dtype();
+        const size_t size = small_buf.shape().Size() * mshadow::mshadow_sizeof(dtype);
+        char* data = static_cast<char *>(small_buf.data().dptr_);
+        // do push. false means no delete
+        ps::SArray<char> vals(data, size, false);
+        const int cmd = GetCommandType(RequestType::kCompressedPushPull, dtype);
+        ZPushSliced(pskv, vals, true, cmd, priority, cb);
+      };
+    // acquire locks on both comm_buf and small_buf so that
+    // pull (which uses comm_buf) for the same key waits till push finishes
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {small_buf.var(), comm_buf.var()},
+        {},
+        FnProperty::kNormal,
+        priority,
+        "P3StoreDistCompressedPush");
   }
 
   void PushDefault(int key, const NDArray &send_buf, const PSKV& pskv,
@@ -91,22 +245,7 @@ class P3StoreDist : public KVStoreDist {
         // do push. false means no delete
         ps::SArray<char> vals(data, size, false);
         int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
-
-        size_t off = 0;
-        auto counter = new std::atomic<int>(pskv.keys.size());
-        for (size_t idx = 0; idx < pskv.keys.size(); idx++) {
-          auto ks = pskv.keys.segment(idx, idx+1);
-          auto ls = pskv.lens.segment(idx, idx+1);
-          auto vs = vals.segment(off, off + pskv.lens[idx]);
-          CHECK_NOTNULL(ps_worker_)->ZPush(
-            ks, vs, ls, cmd, [counter, cb]() {
-                if (--(*counter) == 0) {
-                  delete counter;
-                  cb();
-                }
-              }, priority);
-          off += pskv.lens[idx];
-        }
+        ZPushSliced(pskv, vals, false, cmd, priority, cb);
       };
     Engine::Get()->PushAsync(
         push_to_servers,
@@ -119,15 +258,40 @@ class P3StoreDist : public KVStoreDist {
   }
 
   void PushRowSparse(int key, const NDArray &send_buf, int priority) override {
-    LOG(FATAL) << "NotImplementedError: PushRowSparse not implemented in P3StoreDist.";
+    using namespace rowsparse;
+    auto push_to_servers = [this, key, send_buf, priority]
+      (RunContext rctx, Engine::CallbackOnComplete cb) {
+        char* data = static_cast<char *>(send_buf.data().dptr_);
+        const int64_t num_rows = send_buf.aux_shape(kIdx)[0];
+        const auto offsets = send_buf.aux_data(kIdx).dptr<int64_t>();
+        const auto unit_len = send_buf.shape().ProdShape(1, send_buf.shape().ndim());
+        const int num_bytes = mshadow::mshadow_sizeof(send_buf.dtype());
+        const int64_t size = num_rows * unit_len;
+        // convert to ps keys in row sparse format
+        PSKV& pskv = EncodeRowSparseKey(key, size, num_rows, offsets,
+                                        unit_len, send_buf.shape()[0], num_bytes);
+        if (this->log_verbose_) {
+          LOG(INFO) << "worker " << get_rank() << " push lens: " << pskv.lens << " keys: "
+                    << pskv.keys << " size: " << size;
+        }
+        ps::SArray<char> vals(data, size * num_bytes, false);
+        const int cmd = GetCommandType(RequestType::kRowSparsePushPull, send_buf.dtype());
+        ZPushSliced(pskv, vals, true, cmd, priority, cb);
+      };
+    Engine::Get()->PushAsync(
+        push_to_servers,
+        pinned_ctx_,
+        {send_buf.var()},
+        {},
+        FnProperty::kNormal,
+        priority,
+        "P3StoreDistRowSparsePush");
   }
 
   void PullDefault(int key, const NDArray &recv_buf, int priority) override {
-    CHECK(gradient_compression_->get_type() == CompressionType::kNone)
-       << "Gradient compression not supported in P3StoreDist.";
     auto pull_from_servers = [this, key, recv_buf, priority](
         RunContext rctx, Engine::CallbackOnComplete cb) {
-      // convert to ps keys
+      // convert to ps keys. pulls return uncompressed values, sliced like default keys
       size_t size = recv_buf.shape().Size();
       const int dtype = recv_buf.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
@@ -165,12 +329,68 @@ class P3StoreDist : public KVStoreDist {
 
   void PullRowSparse_(const int key, const NDArray& recv_buf,
                       const NDArray& indices, int priority) override {
-    LOG(FATAL) << "NotImplementedError: PullRowSparse not implemented in P3StoreDist.";
+    using namespace rowsparse;
+    auto pull_from_servers = [this, key, recv_buf, indices, priority]
+      (RunContext rctx, Engine::CallbackOnComplete cb) {
+      // allocate memory for the buffer
+      CHECK_EQ(indices.dtype(), mshadow::kInt64);
+      const TBlob idx_data = indices.data();
+      const size_t num_rows = idx_data.shape_.Size();
+      recv_buf.CheckAndAlloc({mshadow::Shape1(num_rows)});
+      const int dtype = recv_buf.dtype();
+      char* data = static_cast<char *>(recv_buf.data().dptr_);
+      const auto offsets = idx_data.dptr<int64_t>();
+      const auto unit_len = recv_buf.shape().ProdShape(1, recv_buf.shape().ndim());
+      const int64_t size = num_rows * unit_len;
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      // convert to ps keys in row sparse format
+      PSKV& pskv = EncodeRowSparseKey(key, size, num_rows, offsets,
+                                      unit_len, recv_buf.shape()[0],
+                                      num_bytes);
+      if (this->log_verbose_) {
+        LOG(INFO) << "worker " << get_rank() << " pull lens: " << pskv.lens << " keys: "
+                  << pskv.keys << " size: " << size;
+      }
+      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, recv_buf.dtype());
+      // copy indices to recv_buf. this needs to be done before ZPull
+      // because after pull is done, the callback function returns and locks are released.
+      // at this point, later functions may access the indices variable while copy happens
+      mshadow::Copy(recv_buf.aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
+                    idx_data.FlatTo1D<cpu, int64_t>());
+      auto messages = SplitMessages(pskv, true);
+      auto counter = new std::atomic<int>(messages.size());
+      size_t off = 0;
+      for (const auto& msg : messages) {
+        size_t len = 0;
+        for (size_t i = msg.first; i < msg.second; ++i) len += pskv.lens[i];
+        auto ks = pskv.keys.segment(msg.first, msg.second);
+        auto ls = new ps::SArray<int>(pskv.lens.segment(msg.first, msg.second));
+        auto vs = new ps::SArray<char>(data + off, len, false);
+        CHECK_NOTNULL(ps_worker_)->ZPull(
+          ks, vs, ls, cmd, [vs, ls, counter, cb]() {
+              delete vs;
+              delete ls;
+              if (--(*counter) == 0) {
+                delete counter;
+                cb();
+              }
+            }, priority);
+        off += len;
+      }
+    };
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {indices.var()},
+        {recv_buf.var()},
+        FnProperty::kNormal,
+        priority,
+        "P3StoreDistRowSparsePull");
   }
 
   void PushPullDefault(int key, const NDArray &comm_buf, int priority) override {
-    CHECK(gradient_compression_->get_type() == CompressionType::kNone)
-             << "Compression not supported in P3StoreDist";
+    CHECK(!gradient_compression_->IsInitialized())
+             << "Compression not supported with PushPull";
     auto pushpull = [this, key, comm_buf, priority](
         RunContext rctx, Engine::CallbackOnComplete cb) {
       size_t size = comm_buf.shape().Size();
@@ -219,34 +439,129 @@ class P3StoreDist : public KVStoreDist {
       CHECK_EQ(static_cast<size_t>(pskv.size), pskv_size)
         << "The value size cannot be changed " << pskv_size << ". Key is " << key;
     } else {
-      auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
-      const int num_servers = krs.size();
-      CHECK_GT(num_servers, 0);
-
-      int64_t num_params = num_arr_elems * num_bytes;
-      int64_t slice_bound = slice_threshold_ * num_bytes;
-      static size_t server = 0;
-      while (num_params > 0) {
-        ps::Key ps_key = krs[server%num_servers].begin()
-                         + (ps::Key)(key + server/num_servers);
-        CHECK_LT(ps_key, krs[server%num_servers].end());
-        pskv.keys.push_back(ps_key);
-        const size_t part_size = static_cast<size_t>((num_params > slice_bound)
-                ? slice_bound : num_params);
+      const SliceInfo& info = GetSlices(key);
+      pskv.size = 0;
+      for (size_t i = 0; i < info.keys.size(); ++i) {
+        pskv.keys.push_back(info.keys[i]);
+        const int part_size = info.sizes[i] * num_bytes;
         pskv.lens.push_back(part_size);
         pskv.size += part_size;
+      }
+      CHECK_EQ(static_cast<size_t>(pskv.size), pskv_size);
+    }
+    return pskv;
+  }
 
-        num_params -= part_size;
-        server++;
+  /**
+   * \brief push pskv sends one (original size, compressed slice) message per slice,
+   * pull pskv is identical to the default encoding
+   */
+  inline PSKV& EncodeCompressedKey(const int key, const size_t original_num_elem,
+                                   const bool is_push, const int num_bytes) override {
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    mu_.lock();
+    PSKV& pskv = (is_push) ? compr_ps_kv_[key].push : compr_ps_kv_[key].pull;
+    mu_.unlock();
+    if (pskv.keys.empty()) {
+      mu_.lock();
+      PSKV& pull_pskv = compr_ps_kv_[key].pull;
+      PSKV& push_pskv = compr_ps_kv_[key].push;
+      mu_.unlock();
+      const SliceInfo& info = GetSlices(key);
+      push_pskv.size = 0;
+      pull_pskv.size = 0;
+      for (size_t i = 0; i < info.keys.size(); ++i) {
+        const size_t part_orig = info.sizes[i];
+        const size_t part_compr = gradient_compression_->GetCompressedSize(part_orig);
+        // meta info
+        ps::Key ps_key_dummy = krs[info.servers[i]].begin() + part_orig;
+        CHECK_LT(ps_key_dummy, krs[info.servers[i]].end());
+        push_pskv.keys.push_back(ps_key_dummy);
+        push_pskv.lens.push_back(0);
+        // data
+        push_pskv.keys.push_back(info.keys[i]);
+        pull_pskv.keys.push_back(info.keys[i]);
+        push_pskv.lens.push_back(part_compr * num_bytes);
+        pull_pskv.lens.push_back(part_orig * num_bytes);
+        push_pskv.size += part_compr * num_bytes;
+        pull_pskv.size += part_orig * num_bytes;
       }
+      CHECK_EQ(static_cast<size_t>(pull_pskv.size), original_num_elem * num_bytes);
     }
     return pskv;
   }
 
+  /**
+   * \brief every slice of rows is a separate key on the servers, so the encoding
+   * has one meta (master) key per slice followed by the rows falling into it
+   */
+  inline PSKV& EncodeRowSparseKey(const int key, const int64_t num_elem,
+                                  const int64_t num_rows, const int64_t *offsets,
+                                  const size_t unit_len, const int64_t total_num_rows,
+                                  const int num_bytes) override {
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    mu_.lock();
+    PSKV& pskv = ps_kv_[key];
+    mu_.unlock();
+    pskv.keys.clear();
+    pskv.lens.clear();
+    pskv.size = 0;
+    const SliceInfo& info = GetSlices(key);
+    int64_t start_row = 0;
+    const int64_t* lb = offsets;
+    for (size_t i = 0; i < info.keys.size(); ++i) {
+      const ps::Key master_key = info.keys[i];
+      const int64_t end_row = start_row + info.sizes[i];
+      pskv.keys.push_back(master_key);
+      pskv.lens.push_back(0);
+      if (offsets && num_elem > 0) {
+        // offsets are sorted, search for offsets in [start_row, end_row)
+        const int64_t* ub = std::lower_bound(lb, offsets + num_rows, end_row);
+        for (const int64_t* offset = lb; offset < ub; ++offset) {
+          ps::Key ps_key = master_key + (*offset - start_row);
+          CHECK_LT(ps_key, krs[info.servers[i]].end());
+          pskv.keys.push_back(ps_key);
+          const int part_size = unit_len * num_bytes;
+          pskv.lens.push_back(part_size);
+          pskv.size += part_size;
+        }
+        lb = ub;
+      }
+      start_row = end_row;
+    }
+    CHECK_EQ(start_row, total_num_rows);
+    CHECK_EQ(static_cast<size_t>(pskv.size), num_elem * num_bytes);
+    return pskv;
+  }
+
+  /**
+   * \brief per-slice views of compr_buf_ and residual_ for one key. They are kept
+   * alive here because compression captures them by pointer.
+   */
+  struct ComprParts {
+    std::vector<NDArray> compressed;
+    std::vector<NDArray> residual;
+  };
+
+  /**
+   * \brief server keys of slices other than the first start at this offset. Keep in sync
+   * with _P3_SLICE_KEY_OFFSET in python/mxnet/kvstore/kvstore_server.py
+   */
+  static constexpr int kSliceKeyOffset = 1 << 30;
+  /**
+   * \brief bits of the slice index in a slice key. Keep in sync with _P3_SLICE_KEY_BITS
+   * in python/mxnet/kvstore/kvstore_server.py
+   */
+  static constexpr int kSliceKeyBits = 12;
   /**
    * \brief threshold for the parameter slice size
    */
   size_t slice_threshold_;
+  /**
+   * \brief slice placement of every initialized key
+   */
+  std::unordered_map<int, SliceInfo> slices_;
+  std::unordered_map<int, ComprParts> compr_parts_;
 };
 
 }  // namespace kvstore
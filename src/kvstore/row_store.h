@@ -0,0 +1,410 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file row_store.h
+ * \brief server side storage for large row_sparse keys which only materializes
+ * the rows that are touched and keeps optimizer state per row
+ */
+#ifndef MXNET_KVSTORE_ROW_STORE_H_
+#define MXNET_KVSTORE_ROW_STORE_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../engine/openmp.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/*!
+ * \brief optimizer applied lazily to the touched rows of a RowStore. Mirrors the
+ * lazy_update semantics of the sgd, adagrad and adam optimizers with a constant
+ * learning rate.
+ */
+struct RowStoreParam : public dmlc::Parameter<RowStoreParam> {
+  std::string optimizer;
+  float learning_rate;
+  float wd;
+  float rescale_grad;
+  float clip_gradient;
+  float momentum;
+  float beta1;
+  float beta2;
+  float epsilon;
+  DMLC_DECLARE_PARAMETER(RowStoreParam) {
+    DMLC_DECLARE_FIELD(optimizer).set_default("")
+    .describe("Optimizer applied to touched rows: sgd, adagrad or adam. "
+              "Empty means pushed values are assigned to the rows.");
+    DMLC_DECLARE_FIELD(learning_rate).set_default(0.01f)
+    .describe("Learning rate");
+    DMLC_DECLARE_FIELD(wd).set_default(0.0f)
+    .describe("Weight decay");
+    DMLC_DECLARE_FIELD(rescale_grad).set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient).set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off.");
+    DMLC_DECLARE_FIELD(momentum).set_default(0.0f)
+    .describe("The decay rate of momentum estimates for sgd.");
+    DMLC_DECLARE_FIELD(beta1).set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates of adam.");
+    DMLC_DECLARE_FIELD(beta2).set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates of adam.");
+    DMLC_DECLARE_FIELD(epsilon).set_default(1e-8f)
+    .describe("A small constant for numerical stability of adagrad and adam.");
+  }
+
+  /*! \brief number of state vectors kept per row */
+  inline int NumStates() const {
+    if (optimizer == "sgd") return momentum != 0.0f ? 1 : 0;
+    if (optimizer == "adagrad") return 1;
+    if (optimizer == "adam") return 2;
+    CHECK(optimizer.empty()) << "Unsupported row store optimizer " << optimizer;
+    return 0;
+  }
+};
+
+/*!
+ * \brief Row storage of one row_sparse key on the server.
+ *
+ * Rows are hash-partitioned so that updates and pulls run one partition per thread
+ * without locking. The initial weights of the rows which are not all zeros are kept
+ * as pushed by the workers, and a row is materialized (weight and optimizer state) from
+ * them the first time it is pushed to; until then pulls read the initial weights, or
+ * zeros for rows without one. The most
+ * frequently pulled rows are mirrored in a contiguous buffer which serves pulls and is
+ * written through on updates.
+ */
+class RowStore {
+ public:
+  RowStore(int64_t num_rows, int64_t unit_len, const RowStoreParam& param,
+           size_t cache_capacity, int cache_refresh_interval)
+      : num_rows_(num_rows), unit_len_(unit_len), param_(param),
+        num_states_(param.NumStates()), partitions_(kNumPartitions),
+        cache_capacity_(cache_capacity), cache_refresh_interval_(cache_refresh_interval) {}
+
+  inline int64_t num_rows() const { return num_rows_; }
+
+  inline int64_t unit_len() const { return unit_len_; }
+
+  /*!
+   * \brief change the optimizer. Existing rows keep their weights, their state is
+   * reset when the number of state vectors changes.
+   */
+  void SetParam(const RowStoreParam& param) {
+    const int num_states = param.NumStates();
+    if (num_states != num_states_) {
+      const int64_t old_len = SlotLength();
+      num_states_ = num_states;
+      const int64_t new_len = SlotLength();
+      for (auto& part : partitions_) {
+        const int64_t num_slots = part.index.size();
+        std::vector<float> slots(num_slots * new_len, 0.0f);
+        for (int64_t slot = 0; slot < num_slots; ++slot) {
+          std::copy_n(part.slots.data() + slot * old_len, unit_len_,
+                      slots.data() + slot * new_len);
+        }
+        part.slots.swap(slots);
+      }
+    }
+    param_ = param;
+  }
+
+  /*! \brief number of rows holding weights and state */
+  int64_t NumMaterialized() const {
+    int64_t n = 0;
+    for (const auto& p : partitions_) n += p.index.size();
+    return n;
+  }
+
+  /*! \brief number of rows with a non-zero initial weight */
+  int64_t NumInitial() const { return init_rows_.size(); }
+
+  /*!
+   * \brief set the initial weights of `n` rows, given in increasing row order. No row
+   * is materialized; rows which are not all zeros are copied into one block, so that
+   * a dense initial value only costs memory for the rows it sets.
+   */
+  void Init(const int64_t* rows, const float* vals, int64_t n) {
+    CHECK(std::is_sorted(rows, rows + n)) << "row ids of the initial value must be sorted";
+    init_rows_.clear();
+    init_vals_.clear();
+    for (int64_t i = 0; i < n; ++i) {
+      const float* src = vals + i * unit_len_;
+      if (std::all_of(src, src + unit_len_, [](float v) { return v == 0.0f; })) continue;
+      init_rows_.push_back(rows[i]);
+      init_vals_.insert(init_vals_.end(), src, src + unit_len_);
+    }
+    init_rows_.shrink_to_fit();
+    init_vals_.shrink_to_fit();
+  }
+
+  /*! \brief add gradients of `n` rows to the pending gradient of this step */
+  void Accumulate(const int64_t* rows, const float* grads, int64_t n) {
+    ForEachPartition(rows, n, [this, rows, grads](Partition* part, int64_t i) {
+      const float* src = grads + i * unit_len_;
+      auto it = part->pending_index.find(rows[i]);
+      if (it == part->pending_index.end()) {
+        part->pending_index.emplace(rows[i], part->pending.size());
+        part->pending.insert(part->pending.end(), src, src + unit_len_);
+        return;
+      }
+      float* dst = part->pending.data() + it->second;
+      for (int64_t j = 0; j < unit_len_; ++j) dst[j] += src[j];
+    });
+  }
+
+  /*! \brief apply the pending gradients accumulated since the last call */
+  void ApplyPending() {
+    ++num_update_;
+    const float lr = StepLearningRate();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel for num_threads(omp_threads) schedule(dynamic)
+    for (int p = 0; p < kNumPartitions; ++p) {
+      Partition* part = &partitions_[p];
+      for (const auto& kv : part->pending_index) {
+        UpdateRow(part, kv.first, part->pending.data() + kv.second, lr);
+      }
+      part->pending_index.clear();
+      part->pending.clear();
+    }
+  }
+
+  /*! \brief apply the gradients of `n` rows right away (asynchronous mode) */
+  void Update(const int64_t* rows, const float* grads, int64_t n) {
+    ++num_update_;
+    const float lr = StepLearningRate();
+    ForEachPartition(rows, n, [this, rows, grads, lr](Partition* part, int64_t i) {
+      UpdateRow(part, rows[i], grads + i * unit_len_, lr);
+    });
+  }
+
+  /*! \brief copy the weights of `n` rows into `out`, row after row */
+  void Pull(const int64_t* rows, int64_t n, float* out) {
+    const size_t row_bytes = unit_len_ * sizeof(float);
+    ForEachPartition(rows, n, [this, rows, out, row_bytes](Partition* part, int64_t i) {
+      float* dst = out + i * unit_len_;
+      auto cached = cache_slot_.find(rows[i]);
+      if (cached != cache_slot_.end()) {
+        std::memcpy(dst, cache_.data() + cached->second * unit_len_, row_bytes);
+        ++cache_hits_[cached->second];
+        return;
+      }
+      auto it = part->index.find(rows[i]);
+      if (it == part->index.end()) {
+        const float* init = InitialWeight(rows[i]);
+        if (init != nullptr) {
+          std::memcpy(dst, init, row_bytes);
+        } else {
+          std::memset(dst, 0, row_bytes);
+        }
+        return;
+      }
+      std::memcpy(dst, part->slots.data() + it->second * SlotLength(), row_bytes);
+      ++part->hits[it->second];
+    });
+    if (cache_capacity_ > 0 && cache_refresh_interval_ > 0 &&
+        ++num_pull_ % cache_refresh_interval_ == 0) {
+      RefreshCache();
+    }
+  }
+
+ private:
+  static constexpr int kNumPartitions = 64;
+
+  struct Partition {
+    // row id -> slot of the row in `slots`
+    std::unordered_map<int64_t, int64_t> index;
+    // every slot holds the weight followed by the optimizer states of a row
+    std::vector<float> slots;
+    // number of pulls served from `slots` for every slot, decayed on cache refresh
+    std::vector<uint32_t> hits;
+    // row id -> offset of the pending gradient of the row in `pending`
+    std::unordered_map<int64_t, int64_t> pending_index;
+    std::vector<float> pending;
+  };
+
+  inline int64_t SlotLength() const { return (1 + num_states_) * unit_len_; }
+
+  static inline int PartitionOf(int64_t row) {
+    // multiplicative hashing so that consecutive ids spread across partitions
+    return static_cast<int>((static_cast<uint64_t>(row) * 0x9E3779B97F4A7C15ULL) >> 58);
+  }
+
+  /*!
+   * \brief bucket the `n` input rows by partition and call fn(partition, i) for every
+   * input position i, processing each partition on a single thread
+   */
+  template<typename Fn>
+  void ForEachPartition(const int64_t* rows, int64_t n, Fn fn) {
+    std::vector<int64_t> offsets(kNumPartitions + 1, 0);
+    std::vector<int64_t> order(n);
+    for (int64_t i = 0; i < n; ++i) {
+      CHECK(rows[i] >= 0 && rows[i] < num_rows_) << "row id " << rows[i] << " out of range";
+      ++offsets[PartitionOf(rows[i]) + 1];
+    }
+    for (int p = 0; p < kNumPartitions; ++p) offsets[p + 1] += offsets[p];
+    std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (int64_t i = 0; i < n; ++i) order[cursor[PartitionOf(rows[i])]++] = i;
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    #pragma omp parallel for num_threads(omp_threads) schedule(dynamic)
+    for (int p = 0; p < kNumPartitions; ++p) {
+      for (int64_t k = offsets[p]; k < offsets[p + 1]; ++k) {
+        fn(&partitions_[p], order[k]);
+      }
+    }
+  }
+
+  /*! \brief initial weight of `row`, or nullptr if it starts as zeros */
+  inline const float* InitialWeight(int64_t row) const {
+    auto it = std::lower_bound(init_rows_.begin(), init_rows_.end(), row);
+    if (it == init_rows_.end() || *it != row) return nullptr;
+    return init_vals_.data() + (it - init_rows_.begin()) * unit_len_;
+  }
+
+  /*!
+   * \brief return the slot of `row`, creating one with the initial weight and zero
+   * state if needed
+   */
+  float* Materialize(Partition* part, int64_t row) {
+    auto it = part->index.find(row);
+    if (it != part->index.end()) return part->slots.data() + it->second * SlotLength();
+    const int64_t slot = part->index.size();
+    part->index.emplace(row, slot);
+    part->slots.resize((slot + 1) * SlotLength(), 0.0f);
+    part->hits.push_back(0);
+    float* weight = part->slots.data() + slot * SlotLength();
+    const float* init = InitialWeight(row);
+    if (init != nullptr) std::memcpy(weight, init, unit_len_ * sizeof(float));
+    return weight;
+  }
+
+  /*! \brief learning rate of the current step, including adam bias correction */
+  inline float StepLearningRate() const {
+    if (param_.optimizer != "adam") return param_.learning_rate;
+    const double t = static_cast<double>(num_update_);
+    return param_.learning_rate * std::sqrt(1.0 - std::pow(param_.beta2, t)) /
+           (1.0 - std::pow(param_.beta1, t));
+  }
+
+  void UpdateRow(Partition* part, int64_t row, const float* grad, float lr) {
+    float* weight = Materialize(part, row);
+    if (param_.optimizer.empty()) {
+      std::memcpy(weight, grad, unit_len_ * sizeof(float));
+    } else {
+      float* state0 = weight + unit_len_;
+      float* state1 = state0 + unit_len_;
+      const float clip = param_.clip_gradient;
+      for (int64_t j = 0; j < unit_len_; ++j) {
+        float g = param_.rescale_grad * grad[j];
+        if (clip > 0.0f) g = std::max(-clip, std::min(clip, g));
+        g += param_.wd * weight[j];
+        if (param_.optimizer == "sgd") {
+          if (num_states_ > 0) {
+            state0[j] = param_.momentum * state0[j] - lr * g;
+            weight[j] += state0[j];
+          } else {
+            weight[j] -= lr * g;
+          }
+        } else if (param_.optimizer == "adagrad") {
+          state0[j] += g * g;
+          weight[j] -= lr * g / (std::sqrt(state0[j]) + param_.epsilon);
+        } else {
+          state0[j] = param_.beta1 * state0[j] + (1.0f - param_.beta1) * g;
+          state1[j] = param_.beta2 * state1[j] + (1.0f - param_.beta2) * g * g;
+          weight[j] -= lr * state0[j] / (std::sqrt(state1[j]) + param_.epsilon);
+        }
+      }
+    }
+    // write through to the hot row cache
+    auto cached = cache_slot_.find(row);
+    if (cached != cache_slot_.end()) {
+      std::memcpy(cache_.data() + cached->second * unit_len_, weight,
+                  unit_len_ * sizeof(float));
+    }
+  }
+
+  /*!
+   * \brief rebuild the hot row cache from the rows pulled most often since the
+   * last refresh. Hit counts are halved so that the cache follows shifts in the
+   * active vocabulary.
+   */
+  void RefreshCache() {
+    std::vector<std::pair<uint32_t, int64_t>> candidates;
+    for (auto& part : partitions_) {
+      for (const auto& kv : part.index) {
+        uint32_t& hits = part.hits[kv.second];
+        auto cached = cache_slot_.find(kv.first);
+        if (cached != cache_slot_.end()) hits += cache_hits_[cached->second];
+        if (hits > 0) candidates.emplace_back(hits, kv.first);
+        hits >>= 1;
+      }
+    }
+    const size_t capacity = std::min(cache_capacity_, candidates.size());
+    std::nth_element(candidates.begin(), candidates.begin() + capacity, candidates.end(),
+                     std::greater<std::pair<uint32_t, int64_t>>());
+    candidates.resize(capacity);
+    // store cached rows in id order so that pulls of nearby ids touch nearby memory
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<uint32_t, int64_t>& a, const std::pair<uint32_t, int64_t>& b) {
+                return a.second < b.second;
+              });
+    cache_slot_.clear();
+    cache_.resize(capacity * unit_len_);
+    cache_hits_.assign(capacity, 0);
+    for (size_t i = 0; i < capacity; ++i) {
+      const int64_t row = candidates[i].second;
+      Partition& part = partitions_[PartitionOf(row)];
+      const float* weight = part.slots.data() + part.index.at(row) * SlotLength();
+      std::memcpy(cache_.data() + i * unit_len_, weight, unit_len_ * sizeof(float));
+      cache_slot_.emplace(row, i);
+    }
+  }
+
+  int64_t num_rows_;
+  int64_t unit_len_;
+  RowStoreParam param_;
+  int num_states_;
+  std::vector<Partition> partitions_;
+  // initial weights of the rows in init_rows_, the other rows start as zeros
+  std::vector<int64_t> init_rows_;
+  std::vector<float> init_vals_;
+  uint64_t num_update_ = 0;
+  uint64_t num_pull_ = 0;
+  // hot row cache
+  size_t cache_capacity_;
+  int cache_refresh_interval_;
+  // row id -> slot of the row in `cache_`
+  std::unordered_map<int64_t, int64_t> cache_slot_;
+  std::vector<float> cache_;
+  // number of pulls served from every cache slot since the last refresh
+  std::vector<uint32_t> cache_hits_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_ROW_STORE_H_
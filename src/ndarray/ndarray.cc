@@ -1333,6 +1333,13 @@ void CopyFromTo(const NDArray& from, const NDArray& to, int priority, bool is_op
     // skip to copy to itself
     return;
   }
+  if (!is_opr) {
+    // the copy reads from and writes to the chunks directly, so pending arrays must be
+    // computed and operators in the lazy trace that access them pushed first
+    Imperative::DCInfo::Compute(from);
+    Imperative::DCInfo::Compute(to);
+    Imperative::Get()->FlushLazy();
+  }
   CHECK(from.shape() == to.shape())
       << "operands shape mismatch "
       << "from.shape = " << from.shape() << " to.shape=" << to.shape();
@@ -2018,6 +2025,8 @@ void NDArray::SyncCopyFromCPU(const void *data, size_t size) const {
     return;
   }
   TBlob src((void*)data, dshape, cpu::kDevMask, this->dtype_, 0); // NOLINT(*)
+  // operators pending in the lazy trace may access this array
+  Imperative::Get()->FlushLazy();
 
   if (this->ctx().dev_mask() == cpu::kDevMask) {
     this->WaitToWrite();
@@ -2231,6 +2240,8 @@ void NDArray::WaitToRead() const {
 void NDArray::WaitToWrite() const {
   if (is_none()) return;
   Imperative::DCInfo::Compute(*this);
+  // the lazy trace may still read this array
+  Imperative::Get()->FlushLazy();
   // Push an empty mutable function to flush all preceding reads to the variable.
   Engine::Get()->PushAsync(
       [](RunContext, Engine::CallbackOnComplete on_complete) { on_complete(); },
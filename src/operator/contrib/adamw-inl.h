@@ -29,6 +29,7 @@
 #include <vector>
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
+#include "../optimizer_op-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -117,7 +118,7 @@ struct MPAdamWKernel {
     w = w - param_eta * (param_lr * mean / (mshadow_op::square_root::Map(var) + param_epsilon)
                          + param_wd * w);
     weight32[i] = w;
-    KERNEL_ASSIGN(out_data[i], req, w);
+    KERNEL_ASSIGN(out_data[i], req, mxnet_op::CastFromFloat32<DType>(w));
   }
 };
 
@@ -132,7 +133,7 @@ struct MPAdamWUpdate {
     using namespace mxnet_op;
     const auto& param = nnvm::get<AdamWParam>(attrs.parsed);
     Stream<xpu>* s = ctx.get_stream<xpu>();
-    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
       Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
       Tensor<xpu, 2, DType> grad = inputs[1].FlatTo2D<xpu, DType>(s);
       Tensor<xpu, 2, float> mean = inputs[2].FlatTo2D<xpu, float>(s);
@@ -348,33 +349,30 @@ struct MultiAdamKernelParam {
 template<typename MPDType, bool has_mixed_precision>
 struct MultiMPAdamWKernel {
   template<typename DType>
-  MSHADOW_XINLINE static void Map(int i, const MultiAdamKernelParam<DType, MPDType>& param,
+  MSHADOW_XINLINE static void Map(int index, index_t i,
+                                  const MultiAdamKernelParam<DType, MPDType>& param,
                                   const OpReqType req, const float rescale_grad){
-    for (int index = 0; index < param.count; ++index) {
-      if ((size_t)i < param.sizes[index]) {
-        MPDType w = has_mixed_precision ? param.weights32[index][i]:
-                                          MPDType(param.weights[index][i]);
-        MPDType scaled_grad = static_cast<MPDType>(rescale_grad)*
-                              static_cast<MPDType>(param.grad_data[index][i]);
-
-        if (param.clip_gradient >= 0.0f)
-          scaled_grad = mshadow_op::clip::Map(scaled_grad, param.clip_gradient);
-
-        const auto mean = param.beta1 * (param.mean_data[index][i]- scaled_grad) + scaled_grad;
-        const auto adj = mshadow_op::square::Map(scaled_grad);
-        const auto var = param.beta2 * (param.var_data[index][i] - adj) + adj;
-
-        param.mean_data[index][i] = mean;
-        param.var_data[index][i] = var;
-        w = w - param.etas[index] * (param.lrs[index] *
-            mean / (mshadow_op::square_root::Map(var) + param.epsilon)
-            + param.wds[index] * w);
-        if (has_mixed_precision)
-          param.weights32[index][i] = w;
-
-        KERNEL_ASSIGN(param.out_data[index][i], req, w);
-      }
-    }
+    MPDType w = has_mixed_precision ? param.weights32[index][i]:
+                                      MPDType(param.weights[index][i]);
+    MPDType scaled_grad = static_cast<MPDType>(rescale_grad)*
+                          static_cast<MPDType>(param.grad_data[index][i]);
+
+    if (param.clip_gradient >= 0.0f)
+      scaled_grad = mshadow_op::clip::Map(scaled_grad, param.clip_gradient);
+
+    const auto mean = param.beta1 * (param.mean_data[index][i]- scaled_grad) + scaled_grad;
+    const auto adj = mshadow_op::square::Map(scaled_grad);
+    const auto var = param.beta2 * (param.var_data[index][i] - adj) + adj;
+
+    param.mean_data[index][i] = mean;
+    param.var_data[index][i] = var;
+    w = w - param.etas[index] * (param.lrs[index] *
+        mean / (mshadow_op::square_root::Map(var) + param.epsilon)
+        + param.wds[index] * w);
+    if (has_mixed_precision)
+      param.weights32[index][i] = w;
+
+    KERNEL_ASSIGN(param.out_data[index][i], req, w);
   }
 };
 
@@ -397,6 +395,8 @@ void FillMultiAdamKernelParam(const nnvm::NodeAttrs& attrs,
   pParam->epsilon = p.epsilon;
 
   pParam->count = p.num_weights;
+  CHECK_LE(pParam->count, static_cast<int>(MultiAdamKernelParam<DType, MPDType>::N))
+    << "Too many weights in a single multi-tensor update: " << pParam->count;
   pParam->max_size = 0;
   constexpr bool isSame = std::is_same<DType, MPDType>::value;
   for (int i = 0; i < pParam->count; ++i) {
@@ -436,8 +436,8 @@ static inline void MultiAdamWUpdate(const nnvm::NodeAttrs& attrs,
     FillMultiAdamKernelParam<xpu, DType, MPDType, MultiAdamWParam, input_stride>
             (attrs, ctx, inputs, outputs, &param);
 
-    Kernel<MultiMPAdamWKernel<MPDType, !std::is_same<DType, MPDType>::value>, xpu>::
-                              Launch(s, param.max_size, param, req[0], rescale_grad);
+    MultiTensorKernel<MultiMPAdamWKernel<MPDType, !std::is_same<DType, MPDType>::value>, xpu>::
+                              Launch(s, param, req[0], rescale_grad);
   });
 }
 
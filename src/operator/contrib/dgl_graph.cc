@@ -25,10 +25,15 @@
 #include <dmlc/logging.h>
 #include <dmlc/optional.h>
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <utility>
 
 #include "../elemwise_op_common.h"
+#include "../../engine/openmp.h"
 #include "../../imperative/imperative_utils.h"
 #include "../subgraph_op_common.h"
 #include "./dgl_graph-inl.h"
@@ -935,6 +940,585 @@ Example:
 .set_attr<std::string>("key_var_num_args", "num_args")
 .add_arguments(NeighborSampleParam::__FIELDS__());
 
+///////////////////////// Layer-wise neighbor sampling /////////////////////////
+
+struct NeighborLayerSampleParam : public dmlc::Parameter<NeighborLayerSampleParam> {
+  int num_args;
+  mxnet::Tuple<int> fanouts;
+  dgl_id_t max_num_vertices;
+  bool non_uniform;
+  DMLC_DECLARE_PARAMETER(NeighborLayerSampleParam) {
+    DMLC_DECLARE_FIELD(num_args).set_lower_bound(2)
+    .describe("Number of input NDArray.");
+    DMLC_DECLARE_FIELD(fanouts)
+      .describe("Number of neighbors sampled per vertex at every hop, starting from the seeds. "
+                "The number of hops is the length of fanouts.");
+    DMLC_DECLARE_FIELD(max_num_vertices)
+      .set_default(100)
+      .describe("Max number of vertices.");
+    DMLC_DECLARE_FIELD(non_uniform)
+      .set_default(false)
+      .describe("Whether neighbors are sampled by the probability vector given as the "
+                "second input instead of uniformly.");
+  }
+};
+
+DMLC_REGISTER_PARAMETER(NeighborLayerSampleParam);
+
+static inline size_t NumLayerSampleSubgraphs(const NeighborLayerSampleParam& params) {
+  return params.num_args - (params.non_uniform ? 2 : 1);
+}
+
+static inline size_t NumLayerSampleOutputs(const NeighborLayerSampleParam& params) {
+  return params.non_uniform ? 4 : 3;
+}
+
+static bool CSRNeighborLayerSampleStorageType(const nnvm::NodeAttrs& attrs,
+                                              const int dev_mask,
+                                              DispatchMode* dispatch_mode,
+                                              std::vector<int> *in_attrs,
+                                              std::vector<int> *out_attrs) {
+  const NeighborLayerSampleParam& params = nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+  const size_t num_subgraphs = NumLayerSampleSubgraphs(params);
+  const size_t num_outputs = NumLayerSampleOutputs(params);
+  CHECK_EQ(out_attrs->size(), num_outputs * num_subgraphs);
+
+  // input[0] is csr_graph, the rest are the probability and seed vectors
+  CHECK_EQ(in_attrs->at(0), mxnet::kCSRStorage);
+  for (size_t i = 1; i < in_attrs->size(); i++)
+    CHECK_EQ(in_attrs->at(i), mxnet::kDefaultStorage);
+
+  bool success = true;
+  for (size_t j = 0; j < num_outputs; j++) {
+    // the second set is sub_csr, the others are dense
+    const int stype = j == 1 ? mxnet::kCSRStorage : mxnet::kDefaultStorage;
+    for (size_t i = 0; i < num_subgraphs; i++) {
+      if (!type_assign(&(*out_attrs)[i + j*num_subgraphs], stype)) {
+        success = false;
+      }
+    }
+  }
+
+  *dispatch_mode = DispatchMode::kFComputeEx;
+
+  return success;
+}
+
+static bool CSRNeighborLayerSampleShape(const nnvm::NodeAttrs& attrs,
+                                        mxnet::ShapeVector *in_attrs,
+                                        mxnet::ShapeVector *out_attrs) {
+  const NeighborLayerSampleParam& params = nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+  const size_t num_subgraphs = NumLayerSampleSubgraphs(params);
+  const size_t num_outputs = NumLayerSampleOutputs(params);
+  CHECK_EQ(out_attrs->size(), num_outputs * num_subgraphs);
+  CHECK_GT(params.fanouts.ndim(), 0) << "fanouts needs at least one hop";
+  for (int i = 0; i < params.fanouts.ndim(); i++) {
+    CHECK_GT(params.fanouts[i], 0) << "fanouts must be positive";
+  }
+  // input[0] is csr graph
+  CHECK_EQ(in_attrs->at(0).ndim(), 2U);
+  CHECK_EQ(in_attrs->at(0)[0], in_attrs->at(0)[1]);
+  // the rest are the probability and seed vectors
+  for (size_t i = 1; i < in_attrs->size(); i++) {
+    CHECK_EQ(in_attrs->at(i).ndim(), 1U);
+  }
+
+  bool success = true;
+  // sample_id, the last element stores the actual number of vertices in the subgraph
+  mxnet::TShape out_shape(1, params.max_num_vertices + 1);
+  // sub_csr
+  mxnet::TShape out_csr_shape(2, -1);
+  out_csr_shape[0] = params.max_num_vertices;
+  out_csr_shape[1] = in_attrs->at(0)[1];
+  // sub_probability and sub_layer
+  mxnet::TShape out_vertex_shape(1, params.max_num_vertices);
+  for (size_t j = 0; j < num_outputs; j++) {
+    const mxnet::TShape& shape = j == 0 ? out_shape : (j == 1 ? out_csr_shape : out_vertex_shape);
+    for (size_t i = 0; i < num_subgraphs; i++) {
+      SHAPE_ASSIGN_CHECK(*out_attrs, i + j*num_subgraphs, shape);
+      success = success && !mxnet::op::shape_is_none(out_attrs->at(i + j*num_subgraphs));
+    }
+  }
+
+  return success;
+}
+
+static bool CSRNeighborLayerSampleType(const nnvm::NodeAttrs& attrs,
+                                       std::vector<int> *in_attrs,
+                                       std::vector<int> *out_attrs) {
+  const NeighborLayerSampleParam& params = nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+  const size_t num_subgraphs = NumLayerSampleSubgraphs(params);
+  const size_t num_outputs = NumLayerSampleOutputs(params);
+  CHECK_EQ(out_attrs->size(), num_outputs * num_subgraphs);
+
+  const int id_type = in_attrs->back();
+  bool success = true;
+  for (size_t i = 0; i < num_subgraphs; i++) {
+    TYPE_ASSIGN_CHECK(*out_attrs, i, id_type);
+    TYPE_ASSIGN_CHECK(*out_attrs, i + num_subgraphs, in_attrs->at(0));
+    if (params.non_uniform) {
+      TYPE_ASSIGN_CHECK(*out_attrs, i + 2*num_subgraphs, in_attrs->at(1));
+    }
+    TYPE_ASSIGN_CHECK(*out_attrs, i + (num_outputs - 1)*num_subgraphs, id_type);
+  }
+  for (int type : *out_attrs) {
+    success = success && type != -1;
+  }
+
+  return success;
+}
+
+/*
+ * Alias tables of the neighbor distribution of every vertex, laid out like the csr
+ * indices so that the table of vertex v is [indptr[v], indptr[v+1]). The alias of an
+ * entry is its position in the neighbor list.
+ */
+struct NeighborAliasTable {
+  std::vector<float> prob;
+  std::vector<int32_t> alias;
+};
+
+/*
+ * Alias tables are built once per graph and probability vector and shared by
+ * subsequent sampling calls. Entries are keyed by the storage of both arrays and
+ * hold references to them, so that the storage can not be freed and reused by
+ * another array while the table is cached. Writing to either array changes its
+ * engine version, which rebuilds the table.
+ */
+class NeighborAliasTableCache {
+ public:
+  static NeighborAliasTableCache* Get() {
+    // never destroyed, the cached arrays must not outlive the engine at exit
+    static NeighborAliasTableCache* inst = new NeighborAliasTableCache();
+    return inst;
+  }
+
+  std::shared_ptr<const NeighborAliasTable> Lookup(const NDArray &csr,
+                                                   const NDArray &probability) {
+    const Key key(csr.aux_data(csr::kIdx).dptr_, probability.data().dptr_);
+    const size_t csr_version = csr.version();
+    const size_t probability_version = probability.version();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = tables_.find(key);
+      if (it != tables_.end() && it->second.csr_version == csr_version &&
+          it->second.probability_version == probability_version) {
+        return it->second.table;
+      }
+    }
+    Entry entry{csr, probability, csr_version, probability_version,
+                Build(csr, probability)};
+    std::shared_ptr<const NeighborAliasTable> table = entry.table;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tables_.size() >= kCapacity && !tables_.count(key)) tables_.clear();
+    tables_[key] = std::move(entry);
+    return table;
+  }
+
+ private:
+  typedef std::pair<const void*, const void*> Key;
+  struct Entry {
+    NDArray csr;
+    NDArray probability;
+    size_t csr_version;
+    size_t probability_version;
+    std::shared_ptr<const NeighborAliasTable> table;
+  };
+  static const size_t kCapacity = 8;
+
+  static std::shared_ptr<const NeighborAliasTable> Build(const NDArray &csr,
+                                                         const NDArray &probability) {
+    const dgl_id_t* col_list = csr.aux_data(csr::kIdx).dptr<dgl_id_t>();
+    const dgl_id_t* indptr = csr.aux_data(csr::kIndPtr).dptr<dgl_id_t>();
+    const float* weight = probability.data().dptr<float>();
+    const int64_t num_vertices = csr.shape()[0];
+    auto table = std::make_shared<NeighborAliasTable>();
+    table->prob.resize(indptr[num_vertices]);
+    table->alias.resize(indptr[num_vertices]);
+    float* prob = table->prob.data();
+    int32_t* alias = table->alias.data();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+#pragma omp parallel num_threads(omp_threads)
+    {
+      std::vector<double> scaled;
+      std::vector<int32_t> small, large;
+#pragma omp for schedule(dynamic, 256)
+      for (int64_t v = 0; v < num_vertices; ++v) {
+        const dgl_id_t start = indptr[v];
+        const int32_t deg = static_cast<int32_t>(indptr[v + 1] - start);
+        double sum = 0;
+        for (int32_t j = 0; j < deg; ++j) sum += weight[col_list[start + j]];
+        // Vose's method, a row without mass falls back to uniform
+        scaled.resize(deg);
+        small.clear();
+        large.clear();
+        for (int32_t j = 0; j < deg; ++j) {
+          scaled[j] = sum > 0 ? weight[col_list[start + j]] * deg / sum : 1.0;
+          (scaled[j] < 1.0 ? small : large).push_back(j);
+        }
+        while (!small.empty() && !large.empty()) {
+          const int32_t s = small.back();
+          const int32_t l = large.back();
+          small.pop_back();
+          large.pop_back();
+          prob[start + s] = static_cast<float>(scaled[s]);
+          alias[start + s] = l;
+          scaled[l] -= 1.0 - scaled[s];
+          (scaled[l] < 1.0 ? small : large).push_back(l);
+        }
+        for (int32_t j : small) {
+          prob[start + j] = 1.0f;
+          alias[start + j] = j;
+        }
+        for (int32_t j : large) {
+          prob[start + j] = 1.0f;
+          alias[start + j] = j;
+        }
+      }
+    }
+    return table;
+  }
+
+  std::mutex mutex_;
+  std::map<Key, Entry> tables_;
+};
+
+/*
+ * Draws num distinct positions out of a neighbor list of length deg into pos, sorted.
+ * Uniform draws use Floyd's algorithm when num is small against deg and a partial
+ * Fisher-Yates shuffle otherwise. Non-uniform draws take the alias table with rejection
+ * of repeats, which is sequential sampling without replacement, and finish on an
+ * ArrayHeap when the mass is too concentrated for rejection to make progress.
+ */
+static void SampleNeighborPositions(dgl_id_t deg,
+                                    dgl_id_t num,
+                                    const dgl_id_t* col_list,
+                                    const float* probability,
+                                    const float* alias_prob,
+                                    const int32_t* alias,
+                                    std::mt19937* gen,
+                                    std::vector<dgl_id_t>* scratch,
+                                    dgl_id_t* pos) {
+  if (num == deg) {
+    std::iota(pos, pos + num, 0);
+    return;
+  }
+  dgl_id_t count = 0;
+  auto contains = [&](dgl_id_t p) {
+    return std::find(pos, pos + count, p) != pos + count;
+  };
+  if (probability == nullptr) {
+    if (num * num <= deg) {
+      for (dgl_id_t j = deg - num; j < deg; ++j) {
+        const dgl_id_t t = std::uniform_int_distribution<dgl_id_t>(0, j)(*gen);
+        pos[count] = contains(t) ? j : t;
+        ++count;
+      }
+    } else {
+      scratch->resize(deg);
+      std::iota(scratch->begin(), scratch->end(), 0);
+      for (dgl_id_t j = 0; j < num; ++j) {
+        const dgl_id_t t = std::uniform_int_distribution<dgl_id_t>(j, deg - 1)(*gen);
+        std::swap((*scratch)[j], (*scratch)[t]);
+        pos[j] = (*scratch)[j];
+      }
+    }
+  } else {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::uniform_int_distribution<dgl_id_t> bucket(0, deg - 1);
+    // rejection only pays off when the sample is a small part of the list
+    dgl_id_t attempts = num * 2 <= deg ? 4 * num + 16 : 0;
+    for (; count < num && attempts > 0; --attempts) {
+      const dgl_id_t j = bucket(*gen);
+      const dgl_id_t t = uniform(*gen) < alias_prob[j] ? j : alias[j];
+      if (!contains(t)) pos[count++] = t;
+    }
+    if (count < num) {
+      std::vector<float> weight(deg);
+      for (dgl_id_t j = 0; j < deg; ++j) weight[j] = probability[col_list[j]];
+      ArrayHeap heap(weight, (*gen)());
+      for (dgl_id_t j = 0; j < count; ++j) heap.Delete(pos[j]);
+      for (; count < num; ++count) {
+        pos[count] = heap.Sample();
+        heap.Delete(pos[count]);
+      }
+    }
+  }
+  std::sort(pos, pos + num);
+}
+
+/*
+ * Sample sub-graph from csr graph one hop at a time. The whole frontier of a hop is
+ * sampled in parallel with a generator per thread, and the sampled neighbors are
+ * compacted through a prefix sum over the per vertex counts. Vertex sets are kept
+ * as sorted id arrays, so new vertices come from a set difference instead of hash
+ * set lookups and the output is already ordered by id.
+ */
+static void SampleSubgraphByLayer(const NDArray &csr,
+                                  const NDArray &seed_arr,
+                                  const NDArray &sampled_ids,
+                                  const NDArray &sub_csr,
+                                  float* sub_prob,
+                                  const NDArray &sub_layer,
+                                  const float* probability,
+                                  const NeighborAliasTable* alias_table,
+                                  const mxnet::Tuple<int>& fanouts,
+                                  size_t max_num_vertices,
+                                  unsigned int random_seed) {
+  const size_t num_seeds = seed_arr.shape().Size();
+  CHECK_GE(max_num_vertices, num_seeds);
+
+  const dgl_id_t* val_list = csr.data().dptr<dgl_id_t>();
+  const dgl_id_t* col_list = csr.aux_data(csr::kIdx).dptr<dgl_id_t>();
+  const dgl_id_t* indptr = csr.aux_data(csr::kIndPtr).dptr<dgl_id_t>();
+  const dgl_id_t* seed = seed_arr.data().dptr<dgl_id_t>();
+  dgl_id_t* out = sampled_ids.data().dptr<dgl_id_t>();
+  dgl_id_t* out_layer = sub_layer.data().dptr<dgl_id_t>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  // sorted vertex ids of the subgraph and the hop they are reached at
+  std::vector<dgl_id_t> vertices(seed, seed + num_seeds);
+  std::sort(vertices.begin(), vertices.end());
+  vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+  std::vector<dgl_id_t> layers(vertices.size(), 0);
+  // the frontier of every sampled hop, and the sampled neighbors of each frontier
+  // vertex in [offsets[i], offsets[i+1]) of cols and edges
+  const int num_hops = fanouts.ndim();
+  std::vector<std::vector<dgl_id_t> > hop_frontier(num_hops);
+  std::vector<std::vector<dgl_id_t> > hop_offsets(num_hops);
+  std::vector<std::vector<dgl_id_t> > hop_cols(num_hops);
+  std::vector<std::vector<dgl_id_t> > hop_edges(num_hops);
+  std::vector<dgl_id_t> frontier = vertices;
+  std::vector<dgl_id_t> fresh, merged_vertices, merged_layers;
+  bool truncated = false;
+  int hop = 0;
+  for (; hop < num_hops && !frontier.empty() && vertices.size() < max_num_vertices; ++hop) {
+    const dgl_id_t fanout = fanouts[hop];
+    const int64_t num_frontier = frontier.size();
+    std::vector<dgl_id_t>& offsets = hop_offsets[hop];
+    std::vector<dgl_id_t>& cols = hop_cols[hop];
+    std::vector<dgl_id_t>& edges = hop_edges[hop];
+    offsets.resize(num_frontier + 1);
+    offsets[0] = 0;
+#pragma omp parallel for num_threads(omp_threads)
+    for (int64_t i = 0; i < num_frontier; ++i) {
+      const dgl_id_t v = frontier[i];
+      offsets[i + 1] = std::min(indptr[v + 1] - indptr[v], fanout);
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    cols.resize(offsets[num_frontier]);
+    edges.resize(offsets[num_frontier]);
+    const int64_t block_size = 64;
+    const int64_t num_blocks = (num_frontier + block_size - 1) / block_size;
+#pragma omp parallel num_threads(omp_threads)
+    {
+      std::vector<dgl_id_t> scratch;
+#pragma omp for schedule(dynamic)
+      for (int64_t b = 0; b < num_blocks; ++b) {
+        // seeded by the block of vertices rather than the thread, so that the sample
+        // only depends on random_seed and not on the schedule
+        std::seed_seq seq{random_seed, static_cast<unsigned int>(hop),
+                          static_cast<unsigned int>(b)};
+        std::mt19937 gen(seq);
+        const int64_t end = std::min(num_frontier, (b + 1) * block_size);
+        for (int64_t i = b * block_size; i < end; ++i) {
+          const dgl_id_t start = indptr[frontier[i]];
+          dgl_id_t* pos = cols.data() + offsets[i];
+          const dgl_id_t num = offsets[i + 1] - offsets[i];
+          SampleNeighborPositions(indptr[frontier[i] + 1] - start, num, col_list + start,
+                                  probability,
+                                  alias_table ? alias_table->prob.data() + start : nullptr,
+                                  alias_table ? alias_table->alias.data() + start : nullptr,
+                                  &gen, &scratch, pos);
+          for (dgl_id_t k = 0; k < num; ++k) {
+            edges[offsets[i] + k] = val_list[start + pos[k]];
+            pos[k] = col_list[start + pos[k]];
+          }
+        }
+      }
+    }
+    // the vertices first reached at this hop form the next frontier
+    std::vector<dgl_id_t> candidates(cols);
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    fresh.clear();
+    std::set_difference(candidates.begin(), candidates.end(),
+                        vertices.begin(), vertices.end(), std::back_inserter(fresh));
+    if (fresh.size() > max_num_vertices - vertices.size()) {
+      fresh.resize(max_num_vertices - vertices.size());
+      truncated = true;
+    }
+    merged_vertices.resize(vertices.size() + fresh.size());
+    merged_layers.resize(merged_vertices.size());
+    for (size_t i = 0, j = 0, k = 0; k < merged_vertices.size(); ++k) {
+      if (j == fresh.size() || (i < vertices.size() && vertices[i] < fresh[j])) {
+        merged_vertices[k] = vertices[i];
+        merged_layers[k] = layers[i++];
+      } else {
+        merged_vertices[k] = fresh[j++];
+        merged_layers[k] = hop + 1;
+      }
+    }
+    vertices.swap(merged_vertices);
+    layers.swap(merged_layers);
+    hop_frontier[hop].swap(frontier);
+    frontier.swap(fresh);
+  }
+  if (truncated || (hop < num_hops && !frontier.empty())) {
+    LOG(WARNING)
+      << "The sampling is truncated because we have reached the max number of vertices\n"
+      << "Please use a smaller number of seeds or a small neighborhood";
+  }
+
+  // Copy vertices and layers to output[0] and the layer output
+  const size_t num_vertices = vertices.size();
+  std::copy(vertices.begin(), vertices.end(), out);
+  std::copy(layers.begin(), layers.end(), out_layer);
+  // The last element stores the actual
+  // number of vertices in the subgraph.
+  out[max_num_vertices] = num_vertices;
+
+  // Copy sub_probability
+  if (sub_prob != nullptr) {
+    for (size_t i = 0; i < num_vertices; ++i) {
+      sub_prob[i] = probability[vertices[i]];
+    }
+  }
+
+  // Construct sub_csr_graph, the rows of the vertices reached at hop h are the
+  // frontier of hop h in the same order
+  std::vector<dgl_id_t> row_src(num_vertices, -1);
+  std::vector<dgl_id_t> rank(hop, 0);
+  mxnet::TShape shape_2(1, max_num_vertices + 1);
+  sub_csr.CheckAndAllocAuxData(csr::kIndPtr, shape_2);
+  dgl_id_t* indptr_out = sub_csr.aux_data(csr::kIndPtr).dptr<dgl_id_t>();
+  indptr_out[0] = 0;
+  for (size_t i = 0; i < num_vertices; i++) {
+    const dgl_id_t h = layers[i];
+    dgl_id_t edge_size = 0;
+    if (h < hop) {
+      row_src[i] = rank[h]++;
+      edge_size = hop_offsets[h][row_src[i] + 1] - hop_offsets[h][row_src[i]];
+    }
+    indptr_out[i + 1] = indptr_out[i] + edge_size;
+  }
+  for (size_t i = num_vertices + 1; i <= max_num_vertices; ++i) {
+    indptr_out[i] = indptr_out[i - 1];
+  }
+  mxnet::TShape shape_1(1, indptr_out[num_vertices]);
+  sub_csr.CheckAndAllocData(shape_1);
+  sub_csr.CheckAndAllocAuxData(csr::kIdx, shape_1);
+  dgl_id_t* val_list_out = sub_csr.data().dptr<dgl_id_t>();
+  dgl_id_t* col_list_out = sub_csr.aux_data(csr::kIdx).dptr<dgl_id_t>();
+#pragma omp parallel for num_threads(omp_threads) schedule(dynamic, 64)
+  for (int64_t i = 0; i < static_cast<int64_t>(num_vertices); i++) {
+    if (row_src[i] < 0) continue;
+    const dgl_id_t h = layers[i];
+    const dgl_id_t begin = hop_offsets[h][row_src[i]];
+    const dgl_id_t size = hop_offsets[h][row_src[i] + 1] - begin;
+    std::copy_n(hop_cols[h].begin() + begin, size, col_list_out + indptr_out[i]);
+    std::copy_n(hop_edges[h].begin() + begin, size, val_list_out + indptr_out[i]);
+  }
+}
+
+/*
+ * Operator: contrib_csr_neighbor_layer_sample
+ */
+static void CSRNeighborLayerSampleComputeExCPU(const nnvm::NodeAttrs& attrs,
+                                               const OpContext& ctx,
+                                               const std::vector<NDArray>& inputs,
+                                               const std::vector<OpReqType>& req,
+                                               const std::vector<NDArray>& outputs) {
+  const NeighborLayerSampleParam& params = nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+
+  const int num_subgraphs = NumLayerSampleSubgraphs(params);
+  const int seed_begin = params.non_uniform ? 2 : 1;
+  const int layer_output = NumLayerSampleOutputs(params) - 1;
+  CHECK_EQ(outputs.size(), NumLayerSampleOutputs(params) * num_subgraphs);
+
+  const float* probability = nullptr;
+  std::shared_ptr<const NeighborAliasTable> alias_table;
+  if (params.non_uniform) {
+    probability = inputs[1].data().dptr<float>();
+    alias_table = NeighborAliasTableCache::Get()->Lookup(inputs[0], inputs[1]);
+  }
+
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  mshadow::Random<cpu, unsigned int> *prnd = ctx.requested[0].get_random<cpu, unsigned int>(s);
+
+  // every subgraph is sampled in parallel internally
+  for (int i = 0; i < num_subgraphs; i++) {
+    SampleSubgraphByLayer(inputs[0],                     // graph_csr
+                          inputs[i + seed_begin],        // seed vector
+                          outputs[i],                    // sample_id
+                          outputs[i + 1*num_subgraphs],  // sub_csr
+                          params.non_uniform ?           // sample_id_probability
+                            outputs[i + 2*num_subgraphs].data().dptr<float>() : nullptr,
+                          outputs[i + layer_output*num_subgraphs],  // sample_id_layer
+                          probability,
+                          alias_table.get(),
+                          params.fanouts,
+                          params.max_num_vertices,
+                          prnd->GetRandInt());
+  }
+}
+
+NNVM_REGISTER_OP(_contrib_dgl_csr_neighbor_layer_sample)
+.describe(R"code(This operator samples sub-graphs from a csr graph one hop at a time,
+with a separate number of sampled neighbors for every hop. The operator is designed for DGL.
+
+It computes the same outputs as `dgl_csr_neighbor_uniform_sample`, or as
+`dgl_csr_neighbor_non_uniform_sample` when `non_uniform` is set and the second input is a
+probability vector. All vertices of a hop are sampled in parallel, and non-uniform sampling
+reuses alias tables that are built once per graph and probability vector.
+
+Sampling goes hop by hop, so when max_num_vertices is reached the vertices of the last hop
+are kept in the order of their ids rather than in the order they are visited.
+
+Example:
+
+   .. code:: python
+
+  shape = (5, 5)
+  data_np = np.array([1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20], dtype=np.int64)
+  indices_np = np.array([1,2,3,4,0,2,3,4,0,1,3,4,0,1,2,4,0,1,2,3], dtype=np.int64)
+  indptr_np = np.array([0,4,8,12,16,20], dtype=np.int64)
+  a = mx.nd.sparse.csr_matrix((data_np, indices_np, indptr_np), shape=shape)
+  seed = mx.nd.array([0], dtype=np.int64)
+  out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(a, seed, num_args=2, fanouts=(2, 1), max_num_vertices=5)
+
+  # out[0] holds the sampled vertex ids ordered by id followed by their count,
+  # out[1] the sampled edges of the seed (2 of them) and of its sampled
+  # neighbors (1 each), out[2] the hop every vertex is reached at.
+  out[0][-1]
+  [5]
+  <NDArray 1 @cpu(0)>
+
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<NeighborLayerSampleParam>)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const NeighborLayerSampleParam& params =
+    nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+  return params.num_args;
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  const NeighborLayerSampleParam& params =
+    nnvm::get<NeighborLayerSampleParam>(attrs.parsed);
+  return NumLayerSampleSubgraphs(params) * NumLayerSampleOutputs(params);
+})
+.set_attr<FInferStorageType>("FInferStorageType", CSRNeighborLayerSampleStorageType)
+.set_attr<mxnet::FInferShape>("FInferShape", CSRNeighborLayerSampleShape)
+.set_attr<nnvm::FInferType>("FInferType", CSRNeighborLayerSampleType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", CSRNeighborLayerSampleComputeExCPU)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kRandom};
+})
+.add_argument("csr_matrix", "NDArray-or-Symbol", "csr matrix")
+.add_argument("seed_arrays", "NDArray-or-Symbol[]",
+              "seed vertices, preceded by the probability vector if non_uniform is set")
+.set_attr<std::string>("key_var_num_args", "num_args")
+.add_arguments(NeighborLayerSampleParam::__FIELDS__());
+
 ///////////////////////// Create induced subgraph ///////////////////////////
 
 struct DGLSubgraphParam : public dmlc::Parameter<DGLSubgraphParam> {
@@ -0,0 +1,398 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fused_attention-inl.h
+ * \brief Tiled CPU kernels of fused scaled dot-product attention.
+ *
+ * Queries are processed in blocks of `block` rows. For every block the keys and
+ * values are streamed in tiles of `block` rows, the scores of a tile are turned
+ * into probabilities with an online softmax (running row maximum and row sum)
+ * and immediately multiplied with the value tile, so the seq_len x seq_len score
+ * matrix is never materialized. The backward pass recomputes the probabilities
+ * of a tile from the saved log-sum-exp of every query row.
+ *
+ * All tiles are converted to float on load, inputs may be float, half or bfloat16.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FUSED_ATTENTION_INL_H_
+#define MXNET_OPERATOR_CONTRIB_FUSED_ATTENTION_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+struct FusedSelfAttParam : public dmlc::Parameter<FusedSelfAttParam> {
+  int heads;
+  bool causal;
+  bool use_length;
+  int block_size;
+  DMLC_DECLARE_PARAMETER(FusedSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+    .describe("Set number of heads");
+    DMLC_DECLARE_FIELD(causal).set_default(false)
+    .describe("If true, every query only attends to the keys at the same or earlier positions.");
+    DMLC_DECLARE_FIELD(use_length).set_default(false)
+    .describe("If true, the second input valid_length of shape (batch_size,) masks "
+              "the keys at and after the valid length of every sequence.");
+    DMLC_DECLARE_FIELD(block_size).set_default(64).set_lower_bound(1)
+    .describe("Number of queries and keys in one tile. The default keeps the tiles "
+              "of a head of up to 128 dimensions in the L2 cache.");
+  }
+};
+
+struct VarlenSelfAttParam : public dmlc::Parameter<VarlenSelfAttParam> {
+  int heads;
+  bool causal;
+  int block_size;
+  DMLC_DECLARE_PARAMETER(VarlenSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+    .describe("Set number of heads");
+    DMLC_DECLARE_FIELD(causal).set_default(false)
+    .describe("If true, every query only attends to the keys at the same or earlier positions "
+              "of its sequence.");
+    DMLC_DECLARE_FIELD(block_size).set_default(64).set_lower_bound(1)
+    .describe("Number of queries and keys in one tile.");
+  }
+};
+
+struct KVCacheSelfAttParam : public dmlc::Parameter<KVCacheSelfAttParam> {
+  int heads;
+  bool ring;
+  int block_size;
+  DMLC_DECLARE_PARAMETER(KVCacheSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+    .describe("Set number of heads");
+    DMLC_DECLARE_FIELD(ring).set_default(false)
+    .describe("If true, the caches are used as ring buffers and a full cache overwrites "
+              "its oldest entry, i.e. attention over a sliding window of capacity steps. "
+              "Otherwise appending to a full cache is an error and the cache must be grown.");
+    DMLC_DECLARE_FIELD(block_size).set_default(64).set_lower_bound(1)
+    .describe("Number of cached keys in one tile.");
+  }
+};
+
+namespace fused_attention {
+
+/*! \brief per-thread tiles, sized for one block of queries and one block of keys */
+struct AttentionScratch {
+  std::vector<float> q, k, kt, v, vt, dout;
+  std::vector<float> s, dp;
+  std::vector<float> acc, dk, dv;
+  std::vector<float> row_max, row_sum;
+
+  void Resize(index_t block, index_t dim) {
+    const size_t tile = static_cast<size_t>(block) * dim;
+    for (auto* buf : {&q, &k, &kt, &v, &vt, &dout, &acc, &dk, &dv}) buf->resize(tile);
+    s.resize(static_cast<size_t>(block) * block);
+    dp.resize(static_cast<size_t>(block) * block);
+    row_max.resize(block);
+    row_sum.resize(block);
+  }
+};
+
+/*! \brief load `rows` rows of `dim` values into a dense row-major tile */
+template<typename DType>
+inline void LoadTile(const DType* src, index_t stride, index_t rows, index_t dim,
+                     float scale, float* dst) {
+  for (index_t r = 0; r < rows; ++r) {
+    const DType* row = src + r * stride;
+    float* out = dst + r * dim;
+    for (index_t d = 0; d < dim; ++d) {
+      out[d] = static_cast<float>(row[d]) * scale;
+    }
+  }
+}
+
+/*! \brief load `rows` rows of `dim` values into a dense dim x rows tile */
+template<typename DType>
+inline void LoadTileTransposed(const DType* src, index_t stride, index_t rows, index_t dim,
+                               float* dst) {
+  for (index_t r = 0; r < rows; ++r) {
+    const DType* row = src + r * stride;
+    for (index_t d = 0; d < dim; ++d) {
+      dst[d * rows + r] = static_cast<float>(row[d]);
+    }
+  }
+}
+
+/*!
+ * \brief c (m x n) (+)= a (m x k) * b (k x n), all row-major. The innermost loop
+ *  runs over contiguous columns of b and c so that it vectorizes.
+ */
+inline void TileGemm(const float* a, const float* b, index_t m, index_t n, index_t k,
+                     float* c, bool accumulate) {
+  for (index_t i = 0; i < m; ++i) {
+    float* crow = c + i * n;
+    if (!accumulate) std::fill(crow, crow + n, 0.f);
+    for (index_t kk = 0; kk < k; ++kk) {
+      const float av = a[i * k + kk];
+      if (av == 0.f) continue;
+      const float* brow = b + kk * n;
+      for (index_t j = 0; j < n; ++j) {
+        crow[j] += av * brow[j];
+      }
+    }
+  }
+}
+
+/*! \brief c (m x n) += a^T * b, with a stored as k x m and b as k x n */
+inline void TileGemmTransA(const float* a, const float* b, index_t m, index_t n, index_t k,
+                           float* c) {
+  for (index_t kk = 0; kk < k; ++kk) {
+    const float* brow = b + kk * n;
+    for (index_t i = 0; i < m; ++i) {
+      const float av = a[kk * m + i];
+      if (av == 0.f) continue;
+      float* crow = c + i * n;
+      for (index_t j = 0; j < n; ++j) {
+        crow[j] += av * brow[j];
+      }
+    }
+  }
+}
+
+/*!
+ * \brief number of keys of the tile starting at key `k0` visible from the query at
+ *  position `qpos`, visible keys always form a prefix of the tile
+ */
+inline index_t VisibleKeys(index_t qpos, index_t k0, index_t bk, index_t num_kv, bool causal) {
+  index_t end = std::min(bk, num_kv - k0);
+  if (causal) end = std::min(end, qpos - k0 + 1);
+  return std::max<index_t>(end, 0);
+}
+
+template<typename DType>
+inline void StoreValue(DType* dst, OpReqType req, float value) {
+  KERNEL_ASSIGN(*dst, req, mxnet_op::CastFromFloat32<DType>(value));
+}
+
+/*!
+ * \brief Attention of one block of queries against all keys of one head.
+ * \param q first query row of the head, rows are `q_stride` apart
+ * \param k first key row of the head
+ * \param v first value row of the head, keys and values rows are `kv_stride` apart
+ * \param q_begin first query row of the block
+ * \param num_q number of query rows in the block
+ * \param num_kv number of keys, later keys are masked
+ * \param q_offset position of query row 0, key j is at position j
+ * \param out first output row of the head, rows are `out_stride` apart
+ * \param lse log-sum-exp of every query row of the head, saved for backward, may be null
+ */
+template<typename DType, typename OType>
+inline void AttentionForwardQueryBlock(const DType* q, index_t q_stride,
+                                       const DType* k, const DType* v, index_t kv_stride,
+                                       index_t q_begin, index_t num_q, index_t num_kv,
+                                       index_t q_offset, index_t dim, float scale,
+                                       bool causal, index_t block,
+                                       OType* out, index_t out_stride, OpReqType req,
+                                       float* lse, AttentionScratch* ws) {
+  const float neg_inf = -std::numeric_limits<float>::infinity();
+  float* qt = ws->q.data();
+  float* kt = ws->kt.data();
+  float* vr = ws->v.data();
+  float* s = ws->s.data();
+  float* acc = ws->acc.data();
+  float* row_max = ws->row_max.data();
+  float* row_sum = ws->row_sum.data();
+  LoadTile(q + q_begin * q_stride, q_stride, num_q, dim, scale, qt);
+  std::fill(row_max, row_max + num_q, neg_inf);
+  std::fill(row_sum, row_sum + num_q, 0.f);
+  std::fill(acc, acc + num_q * dim, 0.f);
+  // with a causal mask, keys after the last query of the block are never visible
+  index_t kv_end = num_kv;
+  if (causal) kv_end = std::min(kv_end, q_offset + q_begin + num_q);
+  for (index_t k0 = 0; k0 < kv_end; k0 += block) {
+    const index_t bk = std::min(block, kv_end - k0);
+    LoadTileTransposed(k + k0 * kv_stride, kv_stride, bk, dim, kt);
+    LoadTile(v + k0 * kv_stride, kv_stride, bk, dim, 1.f, vr);
+    TileGemm(qt, kt, num_q, bk, dim, s, false);
+    for (index_t i = 0; i < num_q; ++i) {
+      float* srow = s + i * bk;
+      const index_t nvis = VisibleKeys(q_offset + q_begin + i, k0, bk, num_kv, causal);
+      float tile_max = neg_inf;
+      for (index_t j = 0; j < nvis; ++j) tile_max = std::max(tile_max, srow[j]);
+      std::fill(srow + nvis, srow + bk, 0.f);
+      if (nvis == 0) continue;
+      const float m_new = std::max(row_max[i], tile_max);
+      const float alpha = std::exp(row_max[i] - m_new);
+      if (alpha != 1.f) {
+        float* arow = acc + i * dim;
+        for (index_t d = 0; d < dim; ++d) arow[d] *= alpha;
+        row_sum[i] *= alpha;
+      }
+      float sum = 0.f;
+      for (index_t j = 0; j < nvis; ++j) {
+        srow[j] = std::exp(srow[j] - m_new);
+        sum += srow[j];
+      }
+      row_sum[i] += sum;
+      row_max[i] = m_new;
+    }
+    TileGemm(s, vr, num_q, dim, bk, acc, true);
+  }
+  for (index_t i = 0; i < num_q; ++i) {
+    const float inv = row_sum[i] > 0.f ? 1.f / row_sum[i] : 0.f;
+    OType* orow = out + (q_begin + i) * out_stride;
+    const float* arow = acc + i * dim;
+    for (index_t d = 0; d < dim; ++d) {
+      StoreValue(orow + d, req, arow[d] * inv);
+    }
+    if (lse != nullptr) {
+      lse[q_begin + i] = row_sum[i] > 0.f ? row_max[i] + std::log(row_sum[i]) : neg_inf;
+    }
+  }
+}
+
+/*!
+ * \brief probabilities P = exp(S - lse) and dS = P * (dP - delta) of one tile, in place
+ *  of `s` and `dp`. Masked keys and query rows without any visible key get zero.
+ */
+inline void TileSoftmaxGrad(float* s, float* dp, const float* lse, const float* delta,
+                            index_t q_pos0, index_t bq, index_t k0, index_t bk,
+                            index_t num_kv, bool causal) {
+  for (index_t i = 0; i < bq; ++i) {
+    float* srow = s + i * bk;
+    float* dprow = dp + i * bk;
+    const index_t nvis = std::isinf(lse[i]) ? 0 :
+                         VisibleKeys(q_pos0 + i, k0, bk, num_kv, causal);
+    for (index_t j = 0; j < nvis; ++j) {
+      srow[j] = std::exp(srow[j] - lse[i]);
+      dprow[j] = srow[j] * (dprow[j] - delta[i]);
+    }
+    std::fill(srow + nvis, srow + bk, 0.f);
+    std::fill(dprow + nvis, dprow + bk, 0.f);
+  }
+}
+
+/*!
+ * \brief Gradient of the keys and values of one block of keys, accumulated over
+ *  all queries of the head. `dout` has the layout of the forward output, `lse`
+ *  and `delta` (rowsum(dout * out)) hold one value per query row.
+ */
+template<typename DType>
+inline void AttentionBackwardKeyBlock(const DType* q, index_t q_stride,
+                                      const DType* k, const DType* v, index_t kv_stride,
+                                      const DType* dout, index_t dout_stride,
+                                      const float* lse, const float* delta,
+                                      index_t k_begin, index_t num_k, index_t num_q,
+                                      index_t num_kv, index_t q_offset, index_t dim,
+                                      float scale, bool causal, index_t block,
+                                      DType* dk, DType* dv, index_t dkv_stride,
+                                      OpReqType req, AttentionScratch* ws) {
+  float* qt = ws->q.data();
+  float* kt = ws->kt.data();
+  float* vt = ws->vt.data();
+  float* dot = ws->dout.data();
+  float* s = ws->s.data();
+  float* dp = ws->dp.data();
+  float* dk_acc = ws->dk.data();
+  float* dv_acc = ws->dv.data();
+  LoadTileTransposed(k + k_begin * kv_stride, kv_stride, num_k, dim, kt);
+  LoadTileTransposed(v + k_begin * kv_stride, kv_stride, num_k, dim, vt);
+  std::fill(dk_acc, dk_acc + num_k * dim, 0.f);
+  std::fill(dv_acc, dv_acc + num_k * dim, 0.f);
+  // with a causal mask, queries before the first key of the block see none of it
+  const index_t q_first = causal ? std::max<index_t>(0, k_begin - q_offset) : 0;
+  for (index_t q0 = k_begin < num_kv ? q_first : num_q; q0 < num_q; q0 += block) {
+    const index_t bq = std::min(block, num_q - q0);
+    LoadTile(q + q0 * q_stride, q_stride, bq, dim, scale, qt);
+    LoadTile(dout + q0 * dout_stride, dout_stride, bq, dim, 1.f, dot);
+    TileGemm(qt, kt, bq, num_k, dim, s, false);
+    TileGemm(dot, vt, bq, num_k, dim, dp, false);
+    TileSoftmaxGrad(s, dp, lse + q0, delta + q0, q_offset + q0, bq, k_begin, num_k,
+                    num_kv, causal);
+    TileGemmTransA(s, dot, num_k, dim, bq, dv_acc);
+    TileGemmTransA(dp, qt, num_k, dim, bq, dk_acc);
+  }
+  for (index_t j = 0; j < num_k; ++j) {
+    for (index_t d = 0; d < dim; ++d) {
+      StoreValue(dk + (k_begin + j) * dkv_stride + d, req, dk_acc[j * dim + d]);
+      StoreValue(dv + (k_begin + j) * dkv_stride + d, req, dv_acc[j * dim + d]);
+    }
+  }
+}
+
+/*! \brief Gradient of one block of queries, accumulated over all keys of the head. */
+template<typename DType>
+inline void AttentionBackwardQueryBlock(const DType* q, index_t q_stride,
+                                        const DType* k, const DType* v, index_t kv_stride,
+                                        const DType* dout, index_t dout_stride,
+                                        const float* lse, const float* delta,
+                                        index_t q_begin, index_t num_q, index_t num_kv,
+                                        index_t q_offset, index_t dim, float scale,
+                                        bool causal, index_t block,
+                                        DType* dq, index_t dq_stride, OpReqType req,
+                                        AttentionScratch* ws) {
+  float* qt = ws->q.data();
+  float* kt = ws->kt.data();
+  float* kr = ws->k.data();
+  float* vt = ws->vt.data();
+  float* dot = ws->dout.data();
+  float* s = ws->s.data();
+  float* dp = ws->dp.data();
+  float* dq_acc = ws->acc.data();
+  LoadTile(q + q_begin * q_stride, q_stride, num_q, dim, scale, qt);
+  LoadTile(dout + q_begin * dout_stride, dout_stride, num_q, dim, 1.f, dot);
+  std::fill(dq_acc, dq_acc + num_q * dim, 0.f);
+  index_t kv_end = num_kv;
+  if (causal) kv_end = std::min(kv_end, q_offset + q_begin + num_q);
+  for (index_t k0 = 0; k0 < kv_end; k0 += block) {
+    const index_t bk = std::min(block, kv_end - k0);
+    LoadTileTransposed(k + k0 * kv_stride, kv_stride, bk, dim, kt);
+    LoadTile(k + k0 * kv_stride, kv_stride, bk, dim, 1.f, kr);
+    LoadTileTransposed(v + k0 * kv_stride, kv_stride, bk, dim, vt);
+    TileGemm(qt, kt, num_q, bk, dim, s, false);
+    TileGemm(dot, vt, num_q, bk, dim, dp, false);
+    TileSoftmaxGrad(s, dp, lse + q_begin, delta + q_begin, q_offset + q_begin, num_q, k0, bk,
+                    num_kv, causal);
+    TileGemm(dp, kr, num_q, dim, bk, dq_acc, true);
+  }
+  for (index_t i = 0; i < num_q; ++i) {
+    for (index_t d = 0; d < dim; ++d) {
+      StoreValue(dq + (q_begin + i) * dq_stride + d, req, scale * dq_acc[i * dim + d]);
+    }
+  }
+}
+
+/*! \brief delta[i] = rowsum(dout[i] * out[i]) of `rows` rows */
+template<typename DType>
+inline void AttentionBackwardDelta(const DType* dout, const DType* out, index_t stride,
+                                   index_t rows, index_t dim, float* delta) {
+  for (index_t i = 0; i < rows; ++i) {
+    float sum = 0.f;
+    for (index_t d = 0; d < dim; ++d) {
+      sum += static_cast<float>(dout[i * stride + d]) * static_cast<float>(out[i * stride + d]);
+    }
+    delta[i] = sum;
+  }
+}
+
+}  // namespace fused_attention
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_FUSED_ATTENTION_INL_H_
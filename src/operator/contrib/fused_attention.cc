@@ -0,0 +1,713 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fused_attention.cc
+ * \brief CPU implementation of fused self attention on interleaved projections
+ */
+#include <mxnet/base.h>
+#include "./fused_attention-inl.h"
+#include "../elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(FusedSelfAttParam);
+DMLC_REGISTER_PARAMETER(VarlenSelfAttParam);
+DMLC_REGISTER_PARAMETER(KVCacheSelfAttParam);
+
+static bool FusedSelfAttShape(const NodeAttrs& attrs,
+                              mxnet::ShapeVector* in_shape,
+                              mxnet::ShapeVector* out_shape) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), params.use_length ? 2U : 1U);
+  const mxnet::TShape& qkv_shape = in_shape->at(0);
+  if (!mxnet::ndim_is_known(qkv_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 3U)
+    << "Input queries_keys_values should be 3D in seq_length-batch-3*proj_dim, "
+    << "currently is: " << qkv_shape.ndim() << "D";
+  CHECK_EQ(qkv_shape[2] % (3 * params.heads), 0)
+    << "queries_keys_values.shape[2] should be a multiple of 3 * heads, "
+    << "currently is " << qkv_shape[2];
+  if (params.use_length) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, mxnet::TShape(1, qkv_shape[1]));
+  }
+  out_shape->resize(2);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0,
+    mxnet::TShape({qkv_shape[0], qkv_shape[1], qkv_shape[2] / 3}));
+  SHAPE_ASSIGN_CHECK(*out_shape, 1,
+    mxnet::TShape({params.heads * qkv_shape[1], qkv_shape[0]}));
+  return shape_is_known(qkv_shape);
+}
+
+static bool FusedSelfAttType(const NodeAttrs& attrs,
+                             std::vector<int>* in_type,
+                             std::vector<int>* out_type) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), params.use_length ? 2U : 1U);
+  out_type->resize(2);
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  TYPE_ASSIGN_CHECK(*in_type, 0, out_type->at(0));
+  TYPE_ASSIGN_CHECK(*out_type, 1, mshadow::kFloat32);
+  return in_type->at(0) != -1;
+}
+
+/*! \brief valid number of keys of every sequence */
+static std::vector<index_t> FusedSelfAttLengths(const FusedSelfAttParam& params,
+                                                const std::vector<TBlob>& inputs,
+                                                index_t length_input,
+                                                index_t sequences, index_t seq_len) {
+  std::vector<index_t> lengths(sequences, seq_len);
+  if (params.use_length) {
+    const TBlob& valid_length = inputs[length_input];
+    MSHADOW_TYPE_SWITCH(valid_length.type_flag_, LType, {
+      const LType* len = valid_length.dptr<LType>();
+      for (index_t b = 0; b < sequences; ++b) {
+        lengths[b] = std::max<index_t>(0, std::min<index_t>(seq_len, static_cast<index_t>(len[b])));
+      }
+    });
+  }
+  return lengths;
+}
+
+void FusedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                     const OpContext &ctx,
+                     const std::vector<TBlob> &inputs,
+                     const std::vector<OpReqType> &req,
+                     const std::vector<TBlob> &outputs) {
+  using namespace fused_attention;
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+
+  const index_t qkv_seq_len    = inputs[0].shape_[0];
+  const index_t sequences      = inputs[0].shape_[1];
+  const index_t output_lin_dim = inputs[0].shape_[2];
+  const index_t embed_dim      = output_lin_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t attn_batches   = params.heads * sequences;
+  const index_t lead_dim       = attn_batches * 3 * head_dim;
+  const index_t batch_stride   = 3 * head_dim;
+  const index_t out_lead_dim   = attn_batches * head_dim;
+  const index_t block          = params.block_size;
+  const index_t num_blocks     = (qkv_seq_len + block - 1) / block;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  const std::vector<index_t> lengths =
+    FusedSelfAttLengths(params, inputs, 1, sequences, qkv_seq_len);
+  float* lse = req[1] == kNullOp ? nullptr : outputs[1].dptr<float>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
+    const DType* queries_keys_values = inputs[0].dptr<DType>();
+    DType* output = outputs[0].dptr<DType>();
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      AttentionScratch ws;
+      ws.Resize(block, head_dim);
+      // causal blocks have very different costs, balance them dynamically
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < attn_batches * num_blocks; ++task) {
+        const index_t batch = task / num_blocks;
+        const index_t q_begin = (task % num_blocks) * block;
+        const DType* q = queries_keys_values + batch * batch_stride;
+        AttentionForwardQueryBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                   q_begin, std::min(block, qkv_seq_len - q_begin),
+                                   lengths[batch / params.heads], 0, head_dim, scale,
+                                   params.causal, block,
+                                   output + batch * head_dim, out_lead_dim, req[0],
+                                   lse == nullptr ? nullptr : lse + batch * qkv_seq_len, &ws);
+      }
+    }
+  });
+}
+
+void BackwardFusedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                             const OpContext &ctx,
+                             const std::vector<TBlob> &inputs,
+                             const std::vector<OpReqType> &req,
+                             const std::vector<TBlob> &outputs) {
+  using namespace fused_attention;
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  // inputs: output_grads, queries_keys_values, [valid_length], output, lse
+  const size_t out_input = params.use_length ? 3 : 2;
+  if (params.use_length && req[1] != kNullOp) {
+    MSHADOW_TYPE_SWITCH(outputs[1].type_flag_, LType, {
+      LType* dlen = outputs[1].dptr<LType>();
+      if (req[1] != kAddTo) std::fill(dlen, dlen + outputs[1].Size(), LType(0));
+    });
+  }
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+
+  const index_t qkv_seq_len    = inputs[1].shape_[0];
+  const index_t sequences      = inputs[1].shape_[1];
+  const index_t output_lin_dim = inputs[1].shape_[2];
+  const index_t embed_dim      = output_lin_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t attn_batches   = params.heads * sequences;
+  const index_t lead_dim       = attn_batches * 3 * head_dim;
+  const index_t batch_stride   = 3 * head_dim;
+  const index_t out_lead_dim   = attn_batches * head_dim;
+  const index_t block          = params.block_size;
+  const index_t num_blocks     = (qkv_seq_len + block - 1) / block;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  const std::vector<index_t> lengths =
+    FusedSelfAttLengths(params, inputs, 2, sequences, qkv_seq_len);
+  const float* lse = inputs[out_input + 1].dptr<float>();
+  mshadow::Tensor<cpu, 1, float> delta = ctx.requested[0]
+    .get_space_typed<cpu, 1, float>(mshadow::Shape1(attn_batches * qkv_seq_len), s);
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[1].type_flag_, DType, {
+    const DType* output_grads = inputs[0].dptr<DType>();
+    const DType* queries_keys_values = inputs[1].dptr<DType>();
+    const DType* output = inputs[out_input].dptr<DType>();
+    DType* queries_keys_values_grads = outputs[0].dptr<DType>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t batch = 0; batch < attn_batches; ++batch) {
+      AttentionBackwardDelta(output_grads + batch * head_dim, output + batch * head_dim,
+                             out_lead_dim, qkv_seq_len, head_dim,
+                             delta.dptr_ + batch * qkv_seq_len);
+    }
+    // keys and values, then queries: every gradient row is written by exactly one task
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      AttentionScratch ws;
+      ws.Resize(block, head_dim);
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < attn_batches * num_blocks; ++task) {
+        const index_t batch = task / num_blocks;
+        const index_t k_begin = (task % num_blocks) * block;
+        const DType* q = queries_keys_values + batch * batch_stride;
+        DType* dq = queries_keys_values_grads + batch * batch_stride;
+        AttentionBackwardKeyBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                  output_grads + batch * head_dim, out_lead_dim,
+                                  lse + batch * qkv_seq_len, delta.dptr_ + batch * qkv_seq_len,
+                                  k_begin, std::min(block, qkv_seq_len - k_begin), qkv_seq_len,
+                                  lengths[batch / params.heads], 0, head_dim, scale,
+                                  params.causal, block,
+                                  dq + head_dim, dq + 2 * head_dim, lead_dim, req[0], &ws);
+      }
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < attn_batches * num_blocks; ++task) {
+        const index_t batch = task / num_blocks;
+        const index_t q_begin = (task % num_blocks) * block;
+        const DType* q = queries_keys_values + batch * batch_stride;
+        AttentionBackwardQueryBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                    output_grads + batch * head_dim, out_lead_dim,
+                                    lse + batch * qkv_seq_len,
+                                    delta.dptr_ + batch * qkv_seq_len,
+                                    q_begin, std::min(block, qkv_seq_len - q_begin),
+                                    lengths[batch / params.heads], 0, head_dim, scale,
+                                    params.causal, block,
+                                    queries_keys_values_grads + batch * batch_stride, lead_dim,
+                                    req[0], &ws);
+      }
+    }
+  });
+}
+
+NNVM_REGISTER_OP(_contrib_fused_selfatt)
+.describe(R"code(Compute multihead self attention on interleaved projections of queries,
+keys and values in a single fused operator.
+
+The input must be a single tensor of interleaved projections
+of queries, keys and values following the layout:
+(seq_length, batch_size, num_heads * head_dim * 3)
+
+and the output follows the layout (seq_length, batch_size, num_heads * head_dim),
+the same as `interleaved_matmul_selfatt_valatt`.
+
+The equivalent code would be::
+
+    att_score = mx.nd.contrib.interleaved_matmul_selfatt_qk(queries_keys_values, heads=num_heads)
+    att_weights = mx.nd.softmax(att_score + mask, axis=-1)
+    output = mx.nd.contrib.interleaved_matmul_selfatt_valatt(queries_keys_values, att_weights,
+                                                             heads=num_heads)
+
+where `mask` is -inf for the keys hidden by `causal` and `valid_length`. Keys and values are
+processed in tiles of `block_size` rows with an online softmax, so the attention scores of
+shape (batch_size * num_heads, seq_length, seq_length) are never stored, and the backward pass
+recomputes them tile by tile. float32, float16 and bfloat16 inputs are accepted, all
+accumulation is done in float32.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_num_outputs(2)
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+  [](const NodeAttrs& attrs) { return 1; })
+.set_attr_parser(ParamParser<FusedSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  return params.use_length ?
+    std::vector<std::string>{"queries_keys_values", "valid_length"} :
+    std::vector<std::string>{"queries_keys_values"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "lse"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", FusedSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", FusedSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", FusedSelfAttCPU)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::ObjectPtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads{ograds[0]};
+    heads.insert(heads.end(), n->inputs.begin(), n->inputs.end());
+    heads.emplace_back(n, 0, 0);
+    heads.emplace_back(n, 1, 0);
+    return MakeGradNode("_backward_fused_selfatt", n, heads, n->attrs.dict);
+  })
+.add_argument("queries_keys_values", "NDArray-or-Symbol", "Interleaved queries, keys and values")
+.add_argument("valid_length", "NDArray-or-Symbol",
+              "Valid number of keys of every sequence, used when use_length is true")
+.add_arguments(FusedSelfAttParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_fused_selfatt)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 5 : 4;
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<FusedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<FusedSelfAttParam>)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", BackwardFusedSelfAttCPU);
+
+static bool VarlenSelfAttShape(const NodeAttrs& attrs,
+                               mxnet::ShapeVector* in_shape,
+                               mxnet::ShapeVector* out_shape) {
+  const auto& params = nnvm::get<VarlenSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 2U);
+  const mxnet::TShape& qkv_shape = in_shape->at(0);
+  if (!mxnet::ndim_is_known(qkv_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 2U)
+    << "Input queries_keys_values should be 2D in total_tokens-3*proj_dim, "
+    << "currently is: " << qkv_shape.ndim() << "D";
+  CHECK_EQ(qkv_shape[1] % (3 * params.heads), 0)
+    << "queries_keys_values.shape[1] should be a multiple of 3 * heads, "
+    << "currently is " << qkv_shape[1];
+  if (mxnet::ndim_is_known(in_shape->at(1))) {
+    CHECK_EQ(in_shape->at(1).ndim(), 1U)
+      << "Input cu_seqlens should be 1D in num_sequences+1";
+  }
+  out_shape->resize(2);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, mxnet::TShape({qkv_shape[0], qkv_shape[1] / 3}));
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, mxnet::TShape({params.heads, qkv_shape[0]}));
+  return shape_is_known(qkv_shape) && shape_is_known(in_shape->at(1));
+}
+
+static bool VarlenSelfAttType(const NodeAttrs& attrs,
+                              std::vector<int>* in_type,
+                              std::vector<int>* out_type) {
+  CHECK_EQ(in_type->size(), 2U);
+  out_type->resize(2);
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  TYPE_ASSIGN_CHECK(*in_type, 0, out_type->at(0));
+  TYPE_ASSIGN_CHECK(*out_type, 1, mshadow::kFloat32);
+  return in_type->at(0) != -1 && in_type->at(1) != -1;
+}
+
+/*!
+ * \brief tiles of a packed batch: the first token and length of every block of
+ *  `block` queries (or keys) of every sequence
+ */
+static void VarlenSelfAttBlocks(const TBlob& cu_seqlens, index_t total_tokens, index_t block,
+                                std::vector<index_t>* seq_begin,
+                                std::vector<index_t>* seq_len,
+                                std::vector<index_t>* block_begin) {
+  const index_t sequences = cu_seqlens.Size() - 1;
+  CHECK_GE(sequences, 0) << "cu_seqlens should hold num_sequences+1 offsets";
+  seq_begin->resize(sequences);
+  seq_len->resize(sequences);
+  block_begin->clear();
+  MSHADOW_TYPE_SWITCH(cu_seqlens.type_flag_, OType, {
+    const OType* offsets = cu_seqlens.dptr<OType>();
+    CHECK_EQ(static_cast<index_t>(offsets[0]), 0) << "cu_seqlens should start at 0";
+    CHECK_EQ(static_cast<index_t>(offsets[sequences]), total_tokens)
+      << "cu_seqlens should end at the number of packed tokens " << total_tokens;
+    for (index_t b = 0; b < sequences; ++b) {
+      (*seq_begin)[b] = static_cast<index_t>(offsets[b]);
+      (*seq_len)[b] = static_cast<index_t>(offsets[b + 1]) - (*seq_begin)[b];
+      CHECK_GE((*seq_len)[b], 0) << "cu_seqlens should be non-decreasing";
+    }
+  });
+  // a task is (sequence, first row of the block), so that long and short sequences
+  // are split into equally sized pieces of work
+  for (index_t b = 0; b < sequences; ++b) {
+    for (index_t r = 0; r < (*seq_len)[b]; r += block) {
+      block_begin->push_back(b);
+      block_begin->push_back(r);
+    }
+  }
+}
+
+void VarlenSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                      const OpContext &ctx,
+                      const std::vector<TBlob> &inputs,
+                      const std::vector<OpReqType> &req,
+                      const std::vector<TBlob> &outputs) {
+  using namespace fused_attention;
+  const auto& params = nnvm::get<VarlenSelfAttParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+
+  const index_t total_tokens   = inputs[0].shape_[0];
+  const index_t lead_dim       = inputs[0].shape_[1];
+  const index_t embed_dim      = lead_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t block          = params.block_size;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  std::vector<index_t> seq_begin, seq_len, blocks;
+  VarlenSelfAttBlocks(inputs[1], total_tokens, block, &seq_begin, &seq_len, &blocks);
+  const index_t num_tasks = static_cast<index_t>(blocks.size() / 2) * params.heads;
+  float* lse = req[1] == kNullOp ? nullptr : outputs[1].dptr<float>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
+    const DType* queries_keys_values = inputs[0].dptr<DType>();
+    DType* output = outputs[0].dptr<DType>();
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      AttentionScratch ws;
+      ws.Resize(block, head_dim);
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < num_tasks; ++task) {
+        const index_t head = task % params.heads;
+        const index_t seq = blocks[2 * (task / params.heads)];
+        const index_t q_begin = blocks[2 * (task / params.heads) + 1];
+        const index_t first = seq_begin[seq];
+        const DType* q = queries_keys_values + first * lead_dim + head * 3 * head_dim;
+        AttentionForwardQueryBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                   q_begin, std::min(block, seq_len[seq] - q_begin),
+                                   seq_len[seq], 0, head_dim, scale, params.causal, block,
+                                   output + first * embed_dim + head * head_dim, embed_dim,
+                                   req[0],
+                                   lse == nullptr ? nullptr : lse + head * total_tokens + first,
+                                   &ws);
+      }
+    }
+  });
+}
+
+void BackwardVarlenSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace fused_attention;
+  const auto& params = nnvm::get<VarlenSelfAttParam>(attrs.parsed);
+  // inputs: output_grads, queries_keys_values, cu_seqlens, output, lse
+  if (req[1] != kNullOp && req[1] != kAddTo) {
+    MSHADOW_TYPE_SWITCH(outputs[1].type_flag_, OType, {
+      OType* dptr = outputs[1].dptr<OType>();
+      std::fill(dptr, dptr + outputs[1].Size(), OType(0));
+    });
+  }
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+
+  const index_t total_tokens   = inputs[1].shape_[0];
+  const index_t lead_dim       = inputs[1].shape_[1];
+  const index_t embed_dim      = lead_dim / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t block          = params.block_size;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+  std::vector<index_t> seq_begin, seq_len, blocks;
+  VarlenSelfAttBlocks(inputs[2], total_tokens, block, &seq_begin, &seq_len, &blocks);
+  const index_t num_tasks = static_cast<index_t>(blocks.size() / 2) * params.heads;
+  const float* lse = inputs[4].dptr<float>();
+  mshadow::Tensor<cpu, 1, float> delta = ctx.requested[0]
+    .get_space_typed<cpu, 1, float>(mshadow::Shape1(params.heads * total_tokens), s);
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[1].type_flag_, DType, {
+    const DType* output_grads = inputs[0].dptr<DType>();
+    const DType* queries_keys_values = inputs[1].dptr<DType>();
+    const DType* output = inputs[3].dptr<DType>();
+    DType* queries_keys_values_grads = outputs[0].dptr<DType>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (int head = 0; head < params.heads; ++head) {
+      AttentionBackwardDelta(output_grads + head * head_dim, output + head * head_dim,
+                             embed_dim, total_tokens, head_dim,
+                             delta.dptr_ + head * total_tokens);
+    }
+    // keys and values, then queries: every gradient row is written by exactly one task
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      AttentionScratch ws;
+      ws.Resize(block, head_dim);
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < num_tasks; ++task) {
+        const index_t head = task % params.heads;
+        const index_t seq = blocks[2 * (task / params.heads)];
+        const index_t k_begin = blocks[2 * (task / params.heads) + 1];
+        const index_t first = seq_begin[seq];
+        const index_t offset = first * lead_dim + head * 3 * head_dim;
+        const DType* q = queries_keys_values + offset;
+        DType* dq = queries_keys_values_grads + offset;
+        AttentionBackwardKeyBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                  output_grads + first * embed_dim + head * head_dim, embed_dim,
+                                  lse + head * total_tokens + first,
+                                  delta.dptr_ + head * total_tokens + first,
+                                  k_begin, std::min(block, seq_len[seq] - k_begin), seq_len[seq],
+                                  seq_len[seq], 0, head_dim, scale, params.causal, block,
+                                  dq + head_dim, dq + 2 * head_dim, lead_dim, req[0], &ws);
+      }
+      #pragma omp for schedule(dynamic)
+      for (index_t task = 0; task < num_tasks; ++task) {
+        const index_t head = task % params.heads;
+        const index_t seq = blocks[2 * (task / params.heads)];
+        const index_t q_begin = blocks[2 * (task / params.heads) + 1];
+        const index_t first = seq_begin[seq];
+        const index_t offset = first * lead_dim + head * 3 * head_dim;
+        const DType* q = queries_keys_values + offset;
+        AttentionBackwardQueryBlock(q, lead_dim, q + head_dim, q + 2 * head_dim, lead_dim,
+                                    output_grads + first * embed_dim + head * head_dim,
+                                    embed_dim, lse + head * total_tokens + first,
+                                    delta.dptr_ + head * total_tokens + first,
+                                    q_begin, std::min(block, seq_len[seq] - q_begin),
+                                    seq_len[seq], 0, head_dim, scale, params.causal, block,
+                                    queries_keys_values_grads + offset, lead_dim, req[0], &ws);
+      }
+    }
+  });
+}
+
+NNVM_REGISTER_OP(_contrib_varlen_selfatt)
+.describe(R"code(Compute multihead self attention on a packed batch of variable length sequences.
+
+Instead of a padded (seq_length, batch_size, ...) layout, the tokens of all sequences are
+concatenated into a single tensor of interleaved projections of queries, keys and values
+following the layout:
+(total_tokens, num_heads * head_dim * 3)
+
+and `cu_seqlens` holds the num_sequences+1 cumulative offsets of the sequences, i.e.
+sequence `i` is made of the tokens `cu_seqlens[i]` to `cu_seqlens[i+1]`. Such a batch is
+produced by `mxnet.gluon.data.batchify.Pack`. Every token only attends to the tokens of
+its own sequence, and no work is spent on padding.
+
+The output follows the layout (total_tokens, num_heads * head_dim). Layer normalization,
+dense layers and other token-wise operators can be applied to the packed
+(total_tokens, channels) tensors directly.
+
+As `fused_selfatt`, the scores are computed tile by tile with an online softmax and
+never stored.
+
+)code" ADD_FILELINE)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+  [](const NodeAttrs& attrs) { return 1; })
+.set_attr_parser(ParamParser<VarlenSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"queries_keys_values", "cu_seqlens"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "lse"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", VarlenSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", VarlenSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", VarlenSelfAttCPU)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::ObjectPtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads{ograds[0]};
+    heads.insert(heads.end(), n->inputs.begin(), n->inputs.end());
+    heads.emplace_back(n, 0, 0);
+    heads.emplace_back(n, 1, 0);
+    return MakeGradNode("_backward_varlen_selfatt", n, heads, n->attrs.dict);
+  })
+.add_argument("queries_keys_values", "NDArray-or-Symbol",
+              "Interleaved queries, keys and values of the packed tokens")
+.add_argument("cu_seqlens", "NDArray-or-Symbol",
+              "Cumulative offsets of the sequences, of shape (num_sequences+1,)")
+.add_arguments(VarlenSelfAttParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_varlen_selfatt)
+.set_num_inputs(5)
+.set_num_outputs(2)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<VarlenSelfAttParam>)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", BackwardVarlenSelfAttCPU);
+
+static bool KVCacheSelfAttShape(const NodeAttrs& attrs,
+                                mxnet::ShapeVector* in_shape,
+                                mxnet::ShapeVector* out_shape) {
+  const auto& params = nnvm::get<KVCacheSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 4U);
+  const mxnet::TShape& qkv_shape = in_shape->at(0);
+  const mxnet::TShape& cache_shape = in_shape->at(1);
+  if (!mxnet::ndim_is_known(qkv_shape) || !mxnet::ndim_is_known(cache_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 2U)
+    << "Input queries_keys_values should be 2D in batch-3*proj_dim, "
+    << "currently is: " << qkv_shape.ndim() << "D";
+  CHECK_EQ(qkv_shape[1] % (3 * params.heads), 0)
+    << "queries_keys_values.shape[1] should be a multiple of 3 * heads, "
+    << "currently is " << qkv_shape[1];
+  CHECK_EQ(cache_shape.ndim(), 4U)
+    << "Input key_cache should be 4D in batch-heads-capacity-head_dim, "
+    << "currently is: " << cache_shape.ndim() << "D";
+  CHECK_EQ(cache_shape[0], qkv_shape[0]) << "Batch size of key_cache does not match";
+  CHECK_EQ(cache_shape[1], params.heads) << "Number of heads of key_cache does not match";
+  CHECK_EQ(cache_shape[3], qkv_shape[1] / (3 * params.heads))
+    << "Head dimension of key_cache does not match";
+  SHAPE_ASSIGN_CHECK(*in_shape, 2, cache_shape);
+  SHAPE_ASSIGN_CHECK(*in_shape, 3, mxnet::TShape(1, qkv_shape[0]));
+  out_shape->resize(1);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, mxnet::TShape({qkv_shape[0], qkv_shape[1] / 3}));
+  return true;
+}
+
+static bool KVCacheSelfAttType(const NodeAttrs& attrs,
+                               std::vector<int>* in_type,
+                               std::vector<int>* out_type) {
+  CHECK_EQ(in_type->size(), 4U);
+  out_type->resize(1);
+  TYPE_ASSIGN_CHECK(*out_type, 0, in_type->at(0));
+  TYPE_ASSIGN_CHECK(*in_type, 0, out_type->at(0));
+  TYPE_ASSIGN_CHECK(*in_type, 1, out_type->at(0));
+  TYPE_ASSIGN_CHECK(*in_type, 2, out_type->at(0));
+  return in_type->at(0) != -1 && in_type->at(3) != -1;
+}
+
+void KVCacheSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  using namespace fused_attention;
+  const auto& params = nnvm::get<KVCacheSelfAttParam>(attrs.parsed);
+  const index_t sequences      = inputs[0].shape_[0];
+  const index_t embed_dim      = inputs[0].shape_[1] / 3;
+  const index_t head_dim       = embed_dim / params.heads;
+  const index_t attn_batches   = params.heads * sequences;
+  const index_t capacity       = inputs[1].shape_[2];
+  const index_t cache_stride   = capacity * head_dim;
+  const index_t block          = params.block_size;
+  const float scale            = 1.0 / sqrt(static_cast<float>(head_dim));
+
+  std::vector<index_t> lengths(sequences);
+  MSHADOW_TYPE_SWITCH(inputs[3].type_flag_, LType, {
+    const LType* len = inputs[3].dptr<LType>();
+    for (index_t b = 0; b < sequences; ++b) {
+      lengths[b] = static_cast<index_t>(len[b]);
+      CHECK_GE(lengths[b], 0) << "cache_length must be non-negative";
+      CHECK(params.ring || lengths[b] < capacity)
+        << "The cache of sequence " << b << " is full (capacity " << capacity
+        << "), grow the cache or set ring=True";
+    }
+  });
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
+    const DType* queries_keys_values = inputs[0].dptr<DType>();
+    DType* key_cache = inputs[1].dptr<DType>();
+    DType* value_cache = inputs[2].dptr<DType>();
+    DType* output = outputs[0].dptr<DType>();
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      AttentionScratch ws;
+      ws.Resize(block, head_dim);
+      #pragma omp for schedule(dynamic)
+      for (index_t batch = 0; batch < attn_batches; ++batch) {
+        const index_t seq = batch / params.heads;
+        const index_t length = lengths[seq];
+        const DType* q = queries_keys_values + batch * 3 * head_dim;
+        DType* k = key_cache + batch * cache_stride;
+        DType* v = value_cache + batch * cache_stride;
+        // append the new step, then attend over everything cached so far
+        const index_t slot = length % capacity;
+        std::copy(q + head_dim, q + 2 * head_dim, k + slot * head_dim);
+        std::copy(q + 2 * head_dim, q + 3 * head_dim, v + slot * head_dim);
+        // the caches are appended even if the output is not needed
+        if (req[0] == kNullOp) continue;
+        // a wrapped ring holds its keys out of order, which plain softmax attention
+        // does not care about
+        AttentionForwardQueryBlock(q, 3 * head_dim, k, v, head_dim,
+                                   0, 1, std::min(length + 1, capacity), 0, head_dim, scale,
+                                   false, block, output + batch * head_dim, embed_dim,
+                                   req[0], static_cast<float*>(nullptr), &ws);
+      }
+    }
+  });
+
+  MSHADOW_TYPE_SWITCH(inputs[3].type_flag_, LType, {
+    LType* len = inputs[3].dptr<LType>();
+    for (index_t b = 0; b < sequences; ++b) len[b] = static_cast<LType>(lengths[b] + 1);
+  });
+}
+
+NNVM_REGISTER_OP(_contrib_kv_cache_selfatt)
+.describe(R"code(Incremental multihead self attention for autoregressive decoding.
+
+Appends the keys and values of one decoding step to per-sequence caches and computes the
+attention of the new queries over all cached steps, so every step costs O(length) instead
+of recomputing attention over the whole prefix.
+
+The input must be the interleaved projections of queries, keys and values of one step,
+following the layout (batch_size, num_heads * head_dim * 3), i.e. one row of the input of
+`interleaved_matmul_selfatt_qk`. The caches are preallocated with the layout
+(batch_size, num_heads, capacity, head_dim) and `cache_length` of shape (batch_size,)
+holds the number of steps already cached for every sequence, so sequences of different
+lengths can be decoded in one batch.
+
+`key_cache`, `value_cache` and `cache_length` are updated in place. When `ring` is
+false a full cache is an error and the caller is expected to grow the caches, see
+`mxnet.ndarray.contrib.KVCache`; when `ring` is true the oldest step is overwritten,
+giving attention over a sliding window of `capacity` steps.
+
+The output follows the layout (batch_size, num_heads * head_dim).
+
+)code" ADD_FILELINE)
+.set_num_inputs(4)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<KVCacheSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"queries_keys_values", "key_cache", "value_cache",
+                                  "cache_length"};
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const nnvm::NodeAttrs& attrs) {
+    return std::vector<uint32_t>{1, 2, 3};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", KVCacheSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", KVCacheSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", KVCacheSelfAttCPU)
+.add_argument("queries_keys_values", "NDArray-or-Symbol",
+              "Interleaved queries, keys and values of one step")
+.add_argument("key_cache", "NDArray-or-Symbol", "Key cache, updated in place")
+.add_argument("value_cache", "NDArray-or-Symbol", "Value cache, updated in place")
+.add_argument("cache_length", "NDArray-or-Symbol",
+              "Number of cached steps of every sequence, incremented in place")
+.add_arguments(KVCacheSelfAttParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
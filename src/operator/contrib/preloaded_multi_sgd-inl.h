@@ -197,8 +197,10 @@ struct PreloadedMultiSGDKernel {
         w = w + mom;
         if (has_mixed_precision) {
           param.weights32[index][i] = w;
+          KERNEL_ASSIGN(param.out_data[index][i], req, mxnet_op::CastFromFloat32<DType>(w));
+        } else {
+          KERNEL_ASSIGN(param.out_data[index][i], req, w);
         }
-        KERNEL_ASSIGN(param.out_data[index][i], req, w);
       }
     }
   }
@@ -288,7 +290,7 @@ inline void PreloadedMultiSGDUpdate(const nnvm::NodeAttrs& attrs,
                                     const std::vector<TBlob> &outputs) {
   using namespace mxnet_op;
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(outputs[0].type_flag_, DType, {
     using MPDType = typename MPTypeChooser<DType>::type;
     PreloadedMultiSGDKernelParam<DType, MPDType> param =
       FillPreloadedMultiSGDKernelParam<xpu,
@@ -311,7 +313,7 @@ inline void PreloadedMultiSGDMomUpdate(const nnvm::NodeAttrs& attrs,
                                        const std::vector<TBlob> &outputs) {
   using namespace mxnet_op;
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(outputs[0].type_flag_, DType, {
     using MPDType = typename MPTypeChooser<DType>::type;
     PreloadedMultiSGDKernelParam<DType, MPDType> param =
       FillPreloadedMultiSGDMomKernelParam<xpu,
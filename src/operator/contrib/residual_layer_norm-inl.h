@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file residual_layer_norm-inl.h
+ * \brief Fused residual add, dropout and layer normalization over the last axis
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_RESIDUAL_LAYER_NORM_INL_H_
+#define MXNET_OPERATOR_CONTRIB_RESIDUAL_LAYER_NORM_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../nn/dropout-inl.h"
+#include "../random/sampler.h"
+
+namespace mxnet {
+namespace op {
+
+namespace residual_ln {
+enum ResidualLayerNormOpInputs {kData, kResidual, kGamma, kBeta};
+enum ResidualLayerNormOpOutputs {kOut, kMask, kMean, kStd};
+}  // namespace residual_ln
+
+struct ResidualLayerNormParam : public dmlc::Parameter<ResidualLayerNormParam> {
+  float p;
+  int mode;
+  float eps;
+  DMLC_DECLARE_PARAMETER(ResidualLayerNormParam) {
+    DMLC_DECLARE_FIELD(p).set_default(0.5)
+    .set_range(0, 1)
+    .describe("Fraction of the data that gets dropped out during training time.");
+    DMLC_DECLARE_FIELD(mode)
+    .add_enum("training", dropout::kTraining)
+    .add_enum("always", dropout::kAlways)
+    .set_default(dropout::kTraining)
+    .describe("Whether to only turn on dropout during training or to also turn on for inference.");
+    DMLC_DECLARE_FIELD(eps).set_default(1e-5f)
+    .describe("An `epsilon` parameter to prevent division by 0.");
+  }
+};
+
+namespace residual_ln {
+
+/*! \brief accumulation type of the statistics */
+template<typename DType>
+using AccType = typename std::conditional<std::is_same<DType, double>::value,
+                                          double, float>::type;
+
+/*! \brief number of independent Welford accumulators, one vector register of floats */
+const int kLanes = 8;
+
+/*! \brief dropout mask, holding 0 or 1 / pkeep */
+template<typename xpu>
+struct MaskKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t id,
+                                  common::random::RandGenerator<xpu, DType> gen,
+                                  const index_t N,
+                                  const index_t step,
+                                  DType *mask_out,
+                                  const real_t pkeep) {
+    RNG_KERNEL_LOOP(xpu, DType, id, gen, N, step, {
+      const real_t rand_num = static_cast<real_t>(genImpl.uniform());
+      mask_out[i] = mshadow_op::threshold_eq::Map<real_t>(rand_num, pkeep) * (1.0f / pkeep);
+    });
+  }
+};
+
+/*! \brief h = residual + data * mask of one element, mask may be null */
+template<typename DType, typename AType>
+MSHADOW_FORCE_INLINE AType ResidualSum(const DType* data, const DType* residual,
+                                       const DType* mask, index_t j) {
+  return mask == nullptr ?
+    static_cast<AType>(residual[j]) + static_cast<AType>(data[j]) :
+    static_cast<AType>(residual[j]) +
+      static_cast<AType>(data[j]) * static_cast<AType>(mask[j]);
+}
+
+/*!
+ * \brief mean and variance of h over one row in a single pass. Every lane runs
+ *  Welford's update on a strided subset of the row, which vectorizes since all lanes
+ *  share the same count, then the lanes are merged with Chan's formula.
+ */
+template<typename DType, typename AType>
+inline void RowMoments(const DType* data, const DType* residual, const DType* mask,
+                       index_t num, AType* mean_out, AType* var_out) {
+  AType mean[kLanes] = {0};
+  AType m2[kLanes] = {0};
+  const index_t blocks = num / kLanes;
+  for (index_t b = 0; b < blocks; ++b) {
+    const AType inv = AType(1) / static_cast<AType>(b + 1);
+    for (int l = 0; l < kLanes; ++l) {
+      const AType h = ResidualSum<DType, AType>(data, residual, mask, b * kLanes + l);
+      const AType delta = h - mean[l];
+      mean[l] += delta * inv;
+      m2[l] += delta * (h - mean[l]);
+    }
+  }
+  AType count = static_cast<AType>(blocks);
+  AType total_mean = 0, total_m2 = 0, total_count = 0;
+  if (blocks > 0) {
+    for (int l = 0; l < kLanes; ++l) {
+      const AType new_count = total_count + count;
+      const AType delta = mean[l] - total_mean;
+      total_mean += delta * count / new_count;
+      total_m2 += m2[l] + delta * delta * total_count * count / new_count;
+      total_count = new_count;
+    }
+  }
+  for (index_t j = blocks * kLanes; j < num; ++j) {
+    const AType h = ResidualSum<DType, AType>(data, residual, mask, j);
+    total_count += 1;
+    const AType delta = h - total_mean;
+    total_mean += delta / total_count;
+    total_m2 += delta * (h - total_mean);
+  }
+  *mean_out = total_mean;
+  *var_out = total_m2 / static_cast<AType>(num);
+}
+
+}  // namespace residual_ln
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_RESIDUAL_LAYER_NORM_INL_H_
@@ -0,0 +1,266 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file residual_layer_norm.cc
+ * \brief CPU implementation of fused residual add, dropout and layer normalization
+ */
+#include "./residual_layer_norm-inl.h"
+#include "../elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(ResidualLayerNormParam);
+
+static bool ResidualLayerNormShape(const nnvm::NodeAttrs& attrs,
+                                   mxnet::ShapeVector *in_shape,
+                                   mxnet::ShapeVector *out_shape) {
+  using namespace residual_ln;
+  CHECK_EQ(in_shape->size(), 4U) << "Input:[data, residual, gamma, beta]";
+  mxnet::TShape dshape = in_shape->at(kData);
+  if (!mxnet::ndim_is_known(dshape)) {
+    dshape = in_shape->at(kResidual);
+  }
+  if (!mxnet::ndim_is_known(dshape)) return false;
+  CHECK_GE(dshape.ndim(), 1U) << "data should have at least one dimension";
+  SHAPE_ASSIGN_CHECK(*in_shape, kData, dshape);
+  SHAPE_ASSIGN_CHECK(*in_shape, kResidual, dshape);
+  const index_t channel = dshape[dshape.ndim() - 1];
+  SHAPE_ASSIGN_CHECK(*in_shape, kGamma, mxnet::TShape(1, channel));
+  SHAPE_ASSIGN_CHECK(*in_shape, kBeta, mxnet::TShape(1, channel));
+  mxnet::TShape moments_shape(dshape);
+  moments_shape[dshape.ndim() - 1] = 1;
+  out_shape->clear();
+  out_shape->push_back(dshape);
+  out_shape->push_back(dshape);
+  out_shape->push_back(moments_shape);
+  out_shape->push_back(moments_shape);
+  return true;
+}
+
+void ResidualLayerNormComputeCPU(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+  using namespace residual_ln;
+  const ResidualLayerNormParam& param = nnvm::get<ResidualLayerNormParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 4U);
+  CHECK_EQ(outputs.size(), 4U);
+  if (req[kOut] == kNullOp) return;
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  const index_t channel = inputs[kData].shape_[inputs[kData].ndim() - 1];
+  const index_t rows = inputs[kData].Size() / channel;
+  const bool dropout = param.p > 0 && (param.mode == dropout::kAlways || ctx.is_train);
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  MSHADOW_REAL_TYPE_SWITCH(inputs[kData].type_flag_, DType, {
+    using AType = AccType<DType>;
+    DType* mask = outputs[kMask].dptr<DType>();
+    if (dropout) {
+      common::random::RandGenerator<cpu, DType> *pgen =
+        ctx.requested[0].get_parallel_random<cpu, DType>();
+      CHECK_NOTNULL(pgen);
+      LaunchRNG<MaskKernel<cpu>, cpu>(s, pgen, outputs[kMask].Size(), mask,
+                                      1.0f - param.p);
+    } else if (ctx.need_grad) {
+      // the backward pass reads the mask
+      std::fill(mask, mask + outputs[kMask].Size(), DType(1));
+    }
+    const DType* row_mask = dropout ? mask : nullptr;
+    const DType* data = inputs[kData].dptr<DType>();
+    const DType* residual = inputs[kResidual].dptr<DType>();
+    const DType* gamma = inputs[kGamma].dptr<DType>();
+    const DType* beta = inputs[kBeta].dptr<DType>();
+    DType* out = outputs[kOut].dptr<DType>();
+    DType* mean = outputs[kMean].dptr<DType>();
+    DType* std_dev = outputs[kStd].dptr<DType>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t r = 0; r < rows; ++r) {
+      const index_t offset = r * channel;
+      const DType* m = row_mask == nullptr ? nullptr : row_mask + offset;
+      AType row_mean, row_var;
+      RowMoments(data + offset, residual + offset, m, channel, &row_mean, &row_var);
+      const AType row_std = std::sqrt(row_var + static_cast<AType>(param.eps));
+      const AType inv_std = AType(1) / row_std;
+      mean[r] = static_cast<DType>(row_mean);
+      std_dev[r] = static_cast<DType>(row_std);
+      // the row is still in cache, h is recomputed instead of stored
+      DType* out_row = out + offset;
+      for (index_t j = 0; j < channel; ++j) {
+        const AType h = ResidualSum<DType, AType>(data + offset, residual + offset, m, j);
+        const AType val = (h - row_mean) * inv_std * static_cast<AType>(gamma[j]) +
+                          static_cast<AType>(beta[j]);
+        KERNEL_ASSIGN(out_row[j], req[kOut], static_cast<DType>(val));
+      }
+    }
+  });
+}
+
+void ResidualLayerNormGradComputeCPU(const nnvm::NodeAttrs& attrs,
+                                     const OpContext& ctx,
+                                     const std::vector<TBlob>& inputs,
+                                     const std::vector<OpReqType>& req,
+                                     const std::vector<TBlob>& outputs) {
+  using namespace residual_ln;
+  // inputs: ograd, data, residual, gamma, mask, mean, std
+  // outputs: data_grad, residual_grad, gamma_grad, beta_grad
+  CHECK_EQ(inputs.size(), 7U);
+  CHECK_EQ(outputs.size(), 4U);
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  const index_t channel = inputs[1].shape_[inputs[1].ndim() - 1];
+  const index_t rows = inputs[1].Size() / channel;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  MSHADOW_REAL_TYPE_SWITCH(inputs[1].type_flag_, DType, {
+    using AType = AccType<DType>;
+    const DType* ograd = inputs[0].dptr<DType>();
+    const DType* data = inputs[1].dptr<DType>();
+    const DType* residual = inputs[2].dptr<DType>();
+    const DType* gamma = inputs[3].dptr<DType>();
+    const DType* mask = inputs[4].dptr<DType>();
+    const DType* mean = inputs[5].dptr<DType>();
+    const DType* std_dev = inputs[6].dptr<DType>();
+    DType* data_grad = outputs[kData].dptr<DType>();
+    DType* residual_grad = outputs[kResidual].dptr<DType>();
+    // per-thread partial sums of the gamma and beta gradients
+    mshadow::Tensor<cpu, 1, AType> workspace = ctx.requested[0]
+      .get_space_typed<cpu, 1, AType>(mshadow::Shape1(2 * omp_threads * channel), s);
+    AType* partial = workspace.dptr_;
+    std::fill(partial, partial + 2 * omp_threads * channel, AType(0));
+    #pragma omp parallel num_threads(omp_threads)
+    {
+      const int tid = omp_get_thread_num();
+      AType* gamma_sum = partial + 2 * tid * channel;
+      AType* beta_sum = gamma_sum + channel;
+      #pragma omp for
+      for (index_t r = 0; r < rows; ++r) {
+        const index_t offset = r * channel;
+        const DType* g_row = ograd + offset;
+        const DType* m = mask + offset;
+        const AType row_mean = static_cast<AType>(mean[r]);
+        const AType inv_std = AType(1) / static_cast<AType>(std_dev[r]);
+        AType sum_g = 0, sum_gx = 0;
+        for (index_t j = 0; j < channel; ++j) {
+          const AType h = ResidualSum<DType, AType>(data + offset, residual + offset, m, j);
+          const AType xhat = (h - row_mean) * inv_std;
+          const AType dy = static_cast<AType>(g_row[j]);
+          const AType g = dy * static_cast<AType>(gamma[j]);
+          sum_g += g;
+          sum_gx += g * xhat;
+          gamma_sum[j] += dy * xhat;
+          beta_sum[j] += dy;
+        }
+        sum_g /= static_cast<AType>(channel);
+        sum_gx /= static_cast<AType>(channel);
+        for (index_t j = 0; j < channel; ++j) {
+          const AType h = ResidualSum<DType, AType>(data + offset, residual + offset, m, j);
+          const AType xhat = (h - row_mean) * inv_std;
+          const AType g = static_cast<AType>(g_row[j]) * static_cast<AType>(gamma[j]);
+          const AType dh = (g - sum_g - xhat * sum_gx) * inv_std;
+          KERNEL_ASSIGN(residual_grad[offset + j], req[kResidual], static_cast<DType>(dh));
+          KERNEL_ASSIGN(data_grad[offset + j], req[kData],
+                        static_cast<DType>(dh * static_cast<AType>(m[j])));
+        }
+      }
+    }
+    DType* gamma_grad = outputs[kGamma].dptr<DType>();
+    DType* beta_grad = outputs[kBeta].dptr<DType>();
+    for (index_t j = 0; j < channel; ++j) {
+      AType dgamma = 0, dbeta = 0;
+      for (int t = 0; t < omp_threads; ++t) {
+        dgamma += partial[2 * t * channel + j];
+        dbeta += partial[(2 * t + 1) * channel + j];
+      }
+      KERNEL_ASSIGN(gamma_grad[j], req[kGamma], static_cast<DType>(dgamma));
+      KERNEL_ASSIGN(beta_grad[j], req[kBeta], static_cast<DType>(dbeta));
+    }
+  });
+}
+
+NNVM_REGISTER_OP(_contrib_residual_layer_norm)
+.describe(R"code(Fused residual connection, dropout and layer normalization.
+
+Computes, over the last axis of the input:
+
+.. math::
+
+  h = residual + dropout(data)
+
+  out = \frac{h - mean(h)}{\sqrt{var(h) + \epsilon}} * gamma + beta
+
+which is the Add & Norm step of a post-norm transformer block. Compared to running
+``Dropout``, ``elemwise_add`` and ``LayerNorm``, the fused operator reads the inputs once
+for the statistics and once for the output while they are still in cache, and never
+stores ``h``: the backward pass recomputes it from the inputs and the dropout mask.
+The statistics use a vectorized single-pass Welford update.
+
+Dropout follows the semantics of ``Dropout`` with ``axes`` unset. The `subgraph` backend
+``ResidualLayerNorm`` rewrites ``LayerNorm(elemwise_add(residual, Dropout(data)))`` onto
+this operator.
+
+)code" ADD_FILELINE)
+.set_num_inputs(4)
+.set_num_outputs(4)
+.set_attr_parser(ParamParser<ResidualLayerNormParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"data", "residual", "gamma", "beta"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "mask", "mean", "std"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs& attrs) { return 1; })
+.set_attr<mxnet::FInferShape>("FInferShape", ResidualLayerNormShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<4, 4>)
+.set_attr<FCompute>("FCompute<cpu>", ResidualLayerNormComputeCPU)
+.set_attr<nnvm::FGradient>("FGradient", [](const nnvm::ObjectPtr& n,
+                                           const std::vector<nnvm::NodeEntry>& ograds) {
+  std::vector<nnvm::NodeEntry> heads;
+  heads.push_back(ograds[0]);  // ograd
+  heads.push_back(n->inputs[residual_ln::kData]);
+  heads.push_back(n->inputs[residual_ln::kResidual]);
+  heads.push_back(n->inputs[residual_ln::kGamma]);
+  heads.emplace_back(n, residual_ln::kMask, 0);
+  heads.emplace_back(n, residual_ln::kMean, 0);
+  heads.emplace_back(n, residual_ln::kStd, 0);
+  return MakeGradNode("_backward_contrib_residual_layer_norm", n, heads, n->attrs.dict);
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kParallelRandom};
+})
+.add_argument("data", "NDArray-or-Symbol", "Input data, dropout is applied to it")
+.add_argument("residual", "NDArray-or-Symbol", "Residual added to the data")
+.add_argument("gamma", "NDArray-or-Symbol", "gamma array")
+.add_argument("beta", "NDArray-or-Symbol", "beta array")
+.add_arguments(ResidualLayerNormParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_residual_layer_norm)
+.set_num_inputs(7)
+.set_num_outputs(4)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<ResidualLayerNormParam>)
+.set_attr<FCompute>("FCompute<cpu>", ResidualLayerNormGradComputeCPU)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+});
+
+}  // namespace op
+}  // namespace mxnet
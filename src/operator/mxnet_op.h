@@ -85,7 +85,7 @@ inline int get_num_threads<gpu>(const int N) {
 
 template<>
 inline int get_num_threads<cpu>(const int N) {
-  return engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  return engine::OpenMP::Get()->GetRecommendedOMPThreadCountFor(N);
 }
 
 /*! \brief operator request type switch */
@@ -286,6 +286,78 @@ inline int get_num_threads<cpu>(const int N) {
     LOG(FATAL) << "Unknown type enum " << type;            \
   }
 
+/*!
+ * \brief Switch over the floating point types including bfloat16. bfloat16 is only
+ *  implemented for CPU, so the case is rejected when compiling with nvcc.
+ */
+#ifndef __NVCC__
+#define MXNET_REAL_TYPE_SWITCH_WITH_BF16(type, DType, ...) \
+  switch (type) {                                          \
+  case mshadow::kBfloat16:                                 \
+    {                                                      \
+      typedef mshadow::bfloat::bf16_t DType;               \
+      {__VA_ARGS__}                                        \
+    }                                                      \
+    break;                                                 \
+  default:                                                 \
+    MSHADOW_REAL_TYPE_SWITCH(type, DType, __VA_ARGS__);    \
+  }
+#else
+#define MXNET_REAL_TYPE_SWITCH_WITH_BF16(type, DType, ...) \
+  switch (type) {                                          \
+  case mshadow::kBfloat16:                                 \
+    LOG(FATAL) << "bfloat16 is only supported on CPU";     \
+    break;                                                 \
+  default:                                                 \
+    MSHADOW_REAL_TYPE_SWITCH(type, DType, __VA_ARGS__);    \
+  }
+#endif
+
+/*!
+ * \brief Round a float to the nearest bfloat16 bit pattern, ties to even. NaN stays
+ *  a quiet NaN and denormals become zero of the same sign, as vcvtneps2bf16 does.
+ *  bf16_t's own constructor truncates, which biases every update written back from
+ *  an fp32 master copy towards zero.
+ */
+MSHADOW_XINLINE uint16_t FloatToBF16Bits(float value) {
+  union {
+    float f;
+    uint32_t u;
+  } bits;
+  bits.f = value;
+  const uint32_t rounded = bits.u + 0x7fffu + ((bits.u >> 16) & 1u);
+  const bool is_nan = (bits.u & 0x7fffffffu) > 0x7f800000u;
+  const bool is_denormal = (bits.u & 0x7f800000u) == 0;
+  return static_cast<uint16_t>(is_nan ? ((bits.u >> 16) | 0x40u)
+                                      : is_denormal ? ((bits.u >> 16) & 0x8000u)
+                                                    : (rounded >> 16));
+}
+
+/*! \brief Widen a bfloat16 bit pattern to float, this is exact. */
+MSHADOW_XINLINE float BF16BitsToFloat(uint16_t value) {
+  union {
+    float f;
+    uint32_t u;
+  } bits;
+  bits.u = static_cast<uint32_t>(value) << 16;
+  return bits.f;
+}
+
+/*!
+ * \brief Narrow an fp32 value to the storage type of a low precision tensor.
+ */
+template<typename DType>
+MSHADOW_XINLINE DType CastFromFloat32(float value) {
+  return static_cast<DType>(value);
+}
+
+#ifndef __NVCC__
+template<>
+MSHADOW_XINLINE mshadow::bfloat::bf16_t CastFromFloat32<mshadow::bfloat::bf16_t>(float value) {
+  return mshadow::bfloat::bf16_t::Binary(FloatToBF16Bits(value));
+}
+#endif
+
 template <typename T>
 struct AccType {
   using type = T;
@@ -956,7 +1028,7 @@ struct Kernel<OP, cpu> {
   template<typename ...Args>
   inline static bool Launch(mshadow::Stream<cpu> *, const size_t N, Args... args) {
 #ifdef _OPENMP
-    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCountFor(N);
     if (omp_threads < 2) {
       for (size_t i = 0; i < N; ++i) {
         OP::Map(i, args...);
@@ -1020,9 +1092,14 @@ struct Kernel<OP, cpu> {
   template<typename PRIMITIVE_OP, typename DType, typename ...Args>
   static void LaunchTuned(mshadow::Stream<cpu> *, const size_t N, Args... args) {
 #ifdef _OPENMP
-    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-    if (omp_threads < 2 || !tuned_op<PRIMITIVE_OP, DType>::UseOMP(
-      N, static_cast<size_t>(omp_threads))) {
+    int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCountFor(N);
+    if (omp_threads >= 2) {
+      omp_threads = tuned_op<PRIMITIVE_OP, DType>::UseOMP(N, static_cast<size_t>(omp_threads))
+                    ? static_cast<int>(tuned_op<PRIMITIVE_OP, DType>::ThreadCount(
+                        N, static_cast<size_t>(omp_threads)))
+                    : 1;
+    }
+    if (omp_threads < 2) {
       for (size_t i = 0; i < N; ++i) {
         OP::Map(i, args...);
       }
@@ -1049,7 +1126,7 @@ struct Kernel<OP, cpu> {
   template<typename ...Args>
   inline static void LaunchEx(mshadow::Stream<cpu> *s, const size_t N, Args... args) {
 #ifdef _OPENMP
-    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCountFor(N);
     if (omp_threads < 2) {
       OP::Map(0, N, args...);
     } else {
@@ -302,6 +302,23 @@ static bool ConvolutionType(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+static OpCost ConvolutionCost(const nnvm::NodeAttrs& attrs,
+                              const mxnet::ShapeVector& in_shapes,
+                              const std::vector<int>& in_types,
+                              const mxnet::ShapeVector& out_shapes,
+                              const std::vector<int>& out_types) {
+  const ConvolutionParam& param_ = nnvm::get<ConvolutionParam>(attrs.parsed);
+  OpCost cost = ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+  const mxnet::TShape& wshape = in_shapes[conv::kWeight];
+  const mxnet::TShape& oshape = out_shapes[conv::kOut];
+  if (shape_is_known(wshape) && shape_is_known(oshape) && param_.num_filter > 0) {
+    // every output element takes a multiply-add per weight of its filter, plus the bias
+    const uint64_t filter_size = wshape.Size() / param_.num_filter;
+    cost.flops = 2 * oshape.Size() * filter_size + (param_.no_bias ? 0 : oshape.Size());
+  }
+  return cost;
+}
+
 #if MXNET_USE_MKLDNN == 1
 inline static bool ConvStorageType(const nnvm::NodeAttrs& attrs,
                                    const int dev_mask,
@@ -491,6 +508,7 @@ There are other options to tune the performance.
 })
 .set_attr<mxnet::FInferShape>("FInferShape", ConvolutionShape)
 .set_attr<nnvm::FInferType>("FInferType", ConvolutionType)
+.set_attr<FOpCost>("FOpCost", ConvolutionCost)
 #if MXNET_USE_MKLDNN == 1
 .set_attr<FInferStorageType>("FInferStorageType", ConvStorageType)
 #endif
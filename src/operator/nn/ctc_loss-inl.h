@@ -92,29 +92,15 @@ inline void get_workspace_size(const std::vector<int> *label_lengths,
     *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
 
   } else {
-    // cpu can eventually replace all minibatch with
-    // max number of concurrent threads if memory is
-    // really tight
-
-    // per minibatch memory
-    size_t per_minibatch_bytes = 0;
-
-    // output
-    per_minibatch_bytes += sizeof(T) * alphabet_size;
-
-    // alphas
-    per_minibatch_bytes += sizeof(T) * S * maxT;
-
-    // betas
-    per_minibatch_bytes += sizeof(T) * S;
-
-    // labels w/blanks, e_inc, s_inc
-    per_minibatch_bytes += 3 * sizeof(int) * S;
+    // log probs
+    *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
 
-    *size_bytes = per_minibatch_bytes * minibatch;
+    // per sequence alphas with two padding states per step, two columns of betas,
+    // emissions and skip penalties, see compute_ctc_cost in ctc_loss.cc
+    *size_bytes += sizeof(T) * (S + 2) * (maxT + 5) * minibatch;
 
-    // probs
-    *size_bytes += sizeof(T) * alphabet_size * maxT * minibatch;
+    // labels w/blanks
+    *size_bytes += sizeof(int) * (S + 2) * minibatch;
   }
 }
 
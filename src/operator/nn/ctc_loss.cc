@@ -21,24 +21,178 @@
  * \file ctc_loss.cc
  * \brief CPU Implementation of CTC Loss op
  */
+#include <limits>
 #include "./ctc_loss-inl.h"
-#include "../../../3rdparty/ctc_include/detail/cpu_ctc.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+namespace ctc_loss {
+
+/*! \brief log(exp(a) + exp(b) + exp(c)) without branches, so that it vectorizes */
+template<typename DType>
+MSHADOW_XINLINE DType LogSumExp3(DType a, DType b, DType c) {
+  const DType m = std::max(a, std::max(b, c));
+  const DType shift = m == -std::numeric_limits<DType>::infinity() ? DType(0) : m;
+  return shift + std::log(std::exp(a - shift) + std::exp(b - shift) + std::exp(c - shift));
+}
+
+/*!
+ * \brief Loss and gradient of one sequence. The lattice has S = 2L + 1 states, the labels
+ *  interleaved with blanks. Every row of alphas and betas carries two padding states
+ *  holding -inf, so that the recursion over the states has no boundary checks and
+ *  vectorizes; skip[s + 2] holds 0 where the transition from state s - 2 to s is
+ *  allowed and -inf elsewhere. The betas are kept for a single time step and consumed by the
+ *  gradient right away.
+ * \param log_probs log-softmax of the sequence, rows of alphabet_size with stride
+ * \param grad gradient of the sequence with the same layout, nullptr for inference
+ * \return the negative log-likelihood
+ */
+template<typename DType>
+DType SequenceLossAndGrad(const DType* log_probs, index_t stride, int alphabet_size,
+                          const int* labels, int L, int T, int blank, DType* grad,
+                          DType* alphas, DType* betas, DType* emit, DType* skip, int* states) {
+  const DType neg_inf = -std::numeric_limits<DType>::infinity();
+  const int S = 2 * L + 1;
+  const int W = S + 2;
+  for (int s = 0; s < S; ++s) {
+    states[s] = s % 2 == 0 ? blank : labels[s / 2];
+    skip[s + 2] = (s >= 2 && states[s] != blank && states[s] != states[s - 2]) ? 0 : neg_inf;
+  }
+  skip[0] = skip[1] = skip[S + 2] = skip[S + 3] = neg_inf;
+  // forward recursion, alphas[t * W + s + 2] is state s at time t
+  for (int t = 0; t < T; ++t) {
+    const DType* lp = log_probs + t * stride;
+    DType* cur = alphas + t * W;
+    cur[0] = cur[1] = neg_inf;
+    for (int s = 0; s < S; ++s) {
+      emit[s] = lp[states[s]];
+    }
+    if (t == 0) {
+      for (int s = 0; s < S; ++s) {
+        cur[s + 2] = s < 2 ? emit[s] : neg_inf;
+      }
+      continue;
+    }
+    const DType* prev = cur - W;
+    for (int s = 0; s < S; ++s) {
+      cur[s + 2] = LogSumExp3(prev[s + 2], prev[s + 1], prev[s] + skip[s + 2]) + emit[s];
+    }
+  }
+  const DType* last = alphas + (T - 1) * W;
+  const DType loglike = LogSumExp3(last[S + 1], S > 1 ? last[S] : neg_inf, neg_inf);
+  if (loglike == neg_inf) {
+    // no alignment fits into the sequence
+    if (grad != nullptr) {
+      for (int t = 0; t < T; ++t) {
+        std::fill(grad + t * stride, grad + t * stride + alphabet_size, DType(0));
+      }
+    }
+    return 0;
+  }
+  if (grad == nullptr) return -loglike;
+  // backward recursion, betas[s] is state s with two padding states at the end
+  DType* next = betas;
+  DType* cur = betas + W;
+  next[S] = next[S + 1] = cur[S] = cur[S + 1] = neg_inf;
+  for (int t = T - 1; t >= 0; --t) {
+    const DType* lp = log_probs + t * stride;
+    for (int s = 0; s < S; ++s) {
+      emit[s] = lp[states[s]];
+    }
+    if (t == T - 1) {
+      for (int s = 0; s < S; ++s) {
+        cur[s] = s >= S - 2 ? emit[s] : neg_inf;
+      }
+    } else {
+      for (int s = 0; s < S; ++s) {
+        cur[s] = LogSumExp3(next[s], next[s + 1], next[s + 2] + skip[s + 4]) + emit[s];
+      }
+    }
+    // occupancy of state s at time t is alpha * beta / emission
+    const DType* alpha = alphas + t * W + 2;
+    for (int s = 0; s < S; ++s) {
+      emit[s] = std::exp(alpha[s] + cur[s] - emit[s] - loglike);
+    }
+    DType* g = grad + t * stride;
+    for (int k = 0; k < alphabet_size; ++k) {
+      g[k] = std::exp(lp[k]);
+    }
+    for (int s = 0; s < S; ++s) {
+      g[states[s]] -= emit[s];
+    }
+    std::swap(cur, next);
+  }
+  return -loglike;
+}
+
+}  // namespace ctc_loss
+}  // namespace op
+}  // namespace mxnet
 
 namespace mshadow {
 template <typename DType>
-ctcStatus_t compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
-                             DType *costs, DType *grads, int *labels,
-                             int *label_lengths, int *data_lengths,
-                             void *workspace, bool isTraining, int blank_label) {
-  int minibatch = static_cast<int>(activations.size(1));
-  int alphabet_size = static_cast<int>(activations.size(2));
-  mxnet_warpctc::CpuCTC<DType> ctc(alphabet_size, minibatch, workspace, blank_label);
-  if (isTraining) {
-    return ctc.cost_and_grad(activations.dptr_, grads, costs, labels,
-                             label_lengths, data_lengths);
-  } else {
-    return ctc.score_forward(activations.dptr_, costs, labels, label_lengths,
-                             data_lengths);
+void compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
+                      DType *costs, DType *grads, int *labels,
+                      int *label_lengths, int *data_lengths,
+                      void *workspace, bool isTraining, int blank_label) {
+  using namespace mxnet::op::ctc_loss;
+  const int max_seq_len = static_cast<int>(activations.size(0));
+  const int minibatch = static_cast<int>(activations.size(1));
+  const int alphabet_size = static_cast<int>(activations.size(2));
+  const index_t stride = static_cast<index_t>(minibatch) * alphabet_size;
+  const int maxL = *std::max_element(label_lengths, label_lengths + minibatch);
+  const int maxT = *std::max_element(data_lengths, data_lengths + minibatch);
+  const int W = 2 * maxL + 3;
+  // same layout as get_workspace_size
+  DType* log_probs = static_cast<DType*>(workspace);
+  DType* lattice = log_probs + static_cast<size_t>(stride) * maxT;
+  const size_t lattice_size = static_cast<size_t>(W) * (maxT + 5);
+  int* all_states = reinterpret_cast<int*>(lattice + lattice_size * minibatch);
+  std::vector<int> label_offsets(minibatch, 0);
+  for (int b = 1; b < minibatch; ++b) {
+    label_offsets[b] = label_offsets[b - 1] + label_lengths[b - 1];
+  }
+  for (int b = 0; b < minibatch; ++b) {
+    CHECK_LE(data_lengths[b], max_seq_len)
+      << "data_lengths cannot exceed the sequence length of data";
+  }
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  // the sequences have different lengths, balance them dynamically
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(omp_threads)
+  for (int b = 0; b < minibatch; ++b) {
+    const int T = data_lengths[b];
+    const int L = label_lengths[b];
+    const DType* act = activations.dptr_ + static_cast<index_t>(b) * alphabet_size;
+    DType* lp = log_probs + static_cast<index_t>(b) * alphabet_size;
+    DType* grad = isTraining ? grads + static_cast<index_t>(b) * alphabet_size : nullptr;
+    for (int t = 0; t < T; ++t) {
+      const DType* x = act + t * stride;
+      DType* y = lp + t * stride;
+      DType mx = x[0];
+      for (int k = 1; k < alphabet_size; ++k) mx = std::max(mx, x[k]);
+      DType sum = 0;
+      for (int k = 0; k < alphabet_size; ++k) sum += std::exp(x[k] - mx);
+      const DType log_denom = mx + std::log(sum);
+      for (int k = 0; k < alphabet_size; ++k) y[k] = x[k] - log_denom;
+    }
+    if (grad != nullptr) {
+      // time steps past the sequence length have no gradient
+      for (int t = T; t < max_seq_len; ++t) {
+        std::fill(grad + t * stride, grad + t * stride + alphabet_size, DType(0));
+      }
+    }
+    if (T == 0) {
+      costs[b] = 0;
+      continue;
+    }
+    DType* alphas = lattice + lattice_size * b;
+    DType* betas = alphas + static_cast<size_t>(W) * maxT;
+    DType* emit = betas + 2 * W;
+    DType* skip = emit + W;
+    costs[b] = SequenceLossAndGrad(lp, stride, alphabet_size, labels + label_offsets[b], L, T,
+                                   blank_label, grad, alphas, betas, emit, skip,
+                                   all_states + static_cast<size_t>(W) * b);
   }
 }
 }  // namespace mshadow
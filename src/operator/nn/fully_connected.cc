@@ -163,6 +163,22 @@ static bool FullyConnectedType(const nnvm::NodeAttrs& attrs,
       attrs, in_type, out_type, -1);
 }
 
+static OpCost FullyConnectedCost(const nnvm::NodeAttrs& attrs,
+                                 const mxnet::ShapeVector& in_shapes,
+                                 const std::vector<int>& in_types,
+                                 const mxnet::ShapeVector& out_shapes,
+                                 const std::vector<int>& out_types) {
+  const FullyConnectedParam& param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+  OpCost cost = ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+  const mxnet::TShape& wshape = in_shapes[fullc::kWeight];
+  const mxnet::TShape& oshape = out_shapes[fullc::kOut];
+  if (shape_is_known(wshape) && shape_is_known(oshape) && wshape.ndim() == 2) {
+    // a multiply-add per weight for every row, plus the bias
+    cost.flops = 2 * oshape.Size() * wshape[1] + (param.no_bias ? 0 : oshape.Size());
+  }
+  return cost;
+}
+
 struct FullyConnectedGrad {
   const char *op_name;
   std::vector<nnvm::NodeEntry> operator()(const nnvm::ObjectPtr& n,
@@ -310,6 +326,7 @@ If ``no_bias`` is set to be true, then the ``bias`` term is ignored.
 .set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
 .set_attr<mxnet::FInferShape>("FInferShape", FullyConnectedShape)
 .set_attr<nnvm::FInferType>("FInferType", FullyConnectedType)
+.set_attr<FOpCost>("FOpCost", FullyConnectedCost)
 .set_attr<FCompute>("FCompute<cpu>", FullyConnectedCompute<cpu>)
 .set_attr<FComputeEx>("FComputeEx<cpu>", FullyConnectedComputeExCPU)
 .set_attr<nnvm::FGradient>("FGradient", FullyConnectedGrad{"_backward_FullyConnected"})
@@ -63,7 +63,11 @@
 #define MXNET_OPERATOR_NUMPY_NP_EINSUM_OP_INL_H_
 
 #include <mxnet/operator_util.h>
+#include <dmlc/parameter.h>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include "./np_tensordot_op-inl.h"
@@ -433,6 +437,239 @@ class EinsumOp {
   }
 };  // class EinsumOp
 
+/*!
+ * \brief Process-wide cache of contraction paths keyed by subscripts, shapes, dtype and
+ *  device. Imperative calls create a new EinsumOp for every invocation, so the path
+ *  search would otherwise run on every call.
+ */
+class EinsumPathCache {
+ public:
+  static EinsumPathCache* Get() {
+    static EinsumPathCache inst;
+    return &inst;
+  }
+
+  std::vector<Step> Lookup(const std::string& subscripts,
+                           const std::vector<TBlob>& operands,
+                           const RunContext& run_ctx) {
+    std::ostringstream os;
+    os << subscripts << ';' << run_ctx.ctx.dev_mask() << ';' << operands[0].type_flag_;
+    for (const TBlob& operand : operands) {
+      os << ';' << operand.shape_;
+    }
+    const std::string key = os.str();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = paths_.find(key);
+      if (it != paths_.end()) return it->second;
+    }
+    std::vector<Step> paths = einsum_path(subscripts, operands, true, run_ctx, nullptr, nullptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (paths_.size() >= capacity_) {
+      paths_.clear();
+    }
+    if (capacity_ > 0) {
+      paths_.emplace(key, paths);
+    }
+    return paths;
+  }
+
+ private:
+  EinsumPathCache() : capacity_(dmlc::GetEnv("MXNET_EINSUM_PATH_CACHE_SIZE", 1024)) {}
+
+  size_t capacity_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::vector<Step> > paths_;
+};
+
+/*!
+ * \brief Lowering of a two operand contraction onto batched GEMM. The labels fall into
+ *  batch (both operands and output), M (lhs and output), N (rhs and output) and K
+ *  (both operands only) groups. When every operand holds its groups in contiguous runs
+ *  it is viewed as a batch of matrices, transposed or not, without moving any data.
+ */
+struct EinsumGEMM {
+  /*! \brief the output is (batch, M, N) with M taken from the second operand */
+  bool swap;
+  bool trans_lhs, trans_rhs;
+  index_t batch, m, n, k;
+};
+
+/*!
+ * \brief split explicit subscripts of two operands into their terms
+ * \return false when there are not exactly two operands
+ */
+inline bool EinsumSplitTwoOperands(const std::string& subscripts,
+                                   const std::vector<TBlob>& operands,
+                                   std::string* lhs, std::string* rhs, std::string* out) {
+  if (operands.size() != 2U) return false;
+  std::vector<std::string> parsed = _parse_einsum_input(subscripts, operands);
+  std::vector<std::string> terms = split(parsed[0], ",");
+  if (terms.size() != 2U) return false;
+  *lhs = terms[0];
+  *rhs = terms[1];
+  *out = parsed[1];
+  return true;
+}
+
+/*! \brief number of GEMMs of a two operand contraction, sizes its pointer workspace */
+inline index_t EinsumGEMMBatchSize(const std::string& lhs, const std::string& rhs,
+                                   const std::string& out, const TShape& lshape) {
+  index_t batch = 1;
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (rhs.find(lhs[i]) != std::string::npos && out.find(lhs[i]) != std::string::npos) {
+      batch *= lshape[i];
+    }
+  }
+  return batch;
+}
+
+inline bool EinsumGEMMPlan(const std::string& lhs, const std::string& rhs,
+                           const std::string& out, const TShape& lshape,
+                           const TShape& rshape, const TShape& oshape,
+                           int type_flag, const RunContext& run_ctx, EinsumGEMM* plan) {
+  if (!_tensordot_type_check(type_flag, run_ctx)) return false;
+  if (lhs.size() != lshape.ndim() || rhs.size() != rshape.ndim() ||
+      out.size() != oshape.ndim()) {
+    return false;
+  }
+  if (lshape.Size() == 0 || rshape.Size() == 0 || oshape.Size() == 0) return false;
+  // every label has one extent, broadcasting and diagonals are left to the generic kernel
+  dim_t extent[MAXAXIS];
+  int count[MAXAXIS];
+  std::fill(extent, extent + MAXAXIS, -1);
+  std::fill(count, count + MAXAXIS, 0);
+  const std::string* terms[3] = {&lhs, &rhs, &out};
+  const TShape* shapes[3] = {&lshape, &rshape, &oshape};
+  for (int t = 0; t < 3; ++t) {
+    for (size_t i = 0; i < terms[t]->size(); ++i) {
+      const int label = static_cast<unsigned char>((*terms[t])[i]);
+      if (terms[t]->find((*terms[t])[i]) != i) return false;
+      if (extent[label] != -1 && extent[label] != (*shapes[t])[i]) return false;
+      extent[label] = (*shapes[t])[i];
+      ++count[label];
+    }
+  }
+  std::string batch, mgroup, ngroup;
+  for (const char c : out) {
+    const bool in_lhs = lhs.find(c) != std::string::npos;
+    const bool in_rhs = rhs.find(c) != std::string::npos;
+    if (in_lhs && in_rhs) {
+      batch += c;
+    } else if (in_lhs) {
+      mgroup += c;
+    } else if (in_rhs) {
+      ngroup += c;
+    } else {
+      return false;
+    }
+  }
+  plan->swap = false;
+  if (out != batch + mgroup + ngroup) {
+    if (out != batch + ngroup + mgroup) return false;
+    plan->swap = true;
+  }
+  const std::string& a = plan->swap ? rhs : lhs;
+  const std::string& b = plan->swap ? lhs : rhs;
+  if (plan->swap) std::swap(mgroup, ngroup);
+  std::string kgroup;
+  for (const char c : a) {
+    // a label of a single operand would need a reduction first
+    if (count[static_cast<unsigned char>(c)] < 2) return false;
+    if (out.find(c) == std::string::npos) kgroup += c;
+  }
+  for (const char c : b) {
+    if (count[static_cast<unsigned char>(c)] < 2) return false;
+  }
+  if (a == batch + mgroup + kgroup) {
+    plan->trans_lhs = false;
+  } else if (a == batch + kgroup + mgroup) {
+    plan->trans_lhs = true;
+  } else {
+    return false;
+  }
+  if (b == batch + kgroup + ngroup) {
+    plan->trans_rhs = false;
+  } else if (b == batch + ngroup + kgroup) {
+    plan->trans_rhs = true;
+  } else {
+    return false;
+  }
+  auto prod = [&](const std::string& group) {
+    index_t ret = 1;
+    for (const char c : group) ret *= extent[static_cast<unsigned char>(c)];
+    return ret;
+  };
+  plan->batch = prod(batch);
+  plan->m = prod(mgroup);
+  plan->n = prod(ngroup);
+  plan->k = prod(kgroup);
+  return true;
+}
+
+template<typename xpu>
+inline void EinsumGEMMCompute(const EinsumGEMM& plan, const TBlob& lhs, const TBlob& rhs,
+                              const TBlob& out, OpReqType req,
+                              const mshadow::Tensor<xpu, 1, char>& workspace,
+                              mshadow::Stream<xpu> *s) {
+  using namespace mshadow;
+  if (req == kNullOp) return;
+  const TBlob& a = plan.swap ? rhs : lhs;
+  const TBlob& b = plan.swap ? lhs : rhs;
+  MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, DType, {
+    Tensor<xpu, 3, DType> ta = a.get_with_shape<xpu, 3, DType>(
+      plan.trans_lhs ? Shape3(plan.batch, plan.k, plan.m) : Shape3(plan.batch, plan.m, plan.k), s);
+    Tensor<xpu, 3, DType> tb = b.get_with_shape<xpu, 3, DType>(
+      plan.trans_rhs ? Shape3(plan.batch, plan.n, plan.k) : Shape3(plan.batch, plan.k, plan.n), s);
+    Tensor<xpu, 3, DType> tc = out.get_with_shape<xpu, 3, DType>(
+      Shape3(plan.batch, plan.m, plan.n), s);
+    CHECK_GE(workspace.shape_.Size(), 3 * plan.batch * sizeof(DType*));
+    Tensor<xpu, 1, DType*> ptrs(reinterpret_cast<DType**>(workspace.dptr_),
+                                Shape1(3 * plan.batch), s);
+    const DType beta = req == kAddTo ? DType(1) : DType(0);
+    if (plan.trans_lhs && plan.trans_rhs) {
+      BatchGEMM<true, true>(tc, ta, tb, DType(1), beta, ptrs);
+    } else if (plan.trans_lhs) {
+      BatchGEMM<true, false>(tc, ta, tb, DType(1), beta, ptrs);
+    } else if (plan.trans_rhs) {
+      BatchGEMM<false, true>(tc, ta, tb, DType(1), beta, ptrs);
+    } else {
+      BatchGEMM<false, false>(tc, ta, tb, DType(1), beta, ptrs);
+    }
+  });
+}
+
+/*!
+ * \brief gradients of a two operand contraction through batched GEMM where their
+ *  layouts allow it. The requests it serves are set to kNullOp so that the generic
+ *  kernel only computes the remaining ones.
+ * \param inputs output gradient, lhs and rhs
+ * \param outputs lhs and rhs gradients
+ */
+template<typename xpu>
+inline void EinsumGEMMBackward(const std::string& lhs, const std::string& rhs,
+                               const std::string& out, const std::vector<TBlob>& inputs,
+                               std::vector<OpReqType>* req, const std::vector<TBlob>& outputs,
+                               const mshadow::Tensor<xpu, 1, char>& workspace,
+                               const OpContext& ctx) {
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  EinsumGEMM plan;
+  // d lhs = einsum(out, rhs -> lhs)
+  if ((*req)[0] != kNullOp &&
+      EinsumGEMMPlan(out, rhs, lhs, inputs[0].shape_, inputs[2].shape_, outputs[0].shape_,
+                     outputs[0].type_flag_, ctx.run_ctx, &plan)) {
+    EinsumGEMMCompute<xpu>(plan, inputs[0], inputs[2], outputs[0], (*req)[0], workspace, s);
+    (*req)[0] = kNullOp;
+  }
+  // d rhs = einsum(lhs, out -> rhs)
+  if ((*req)[1] != kNullOp &&
+      EinsumGEMMPlan(lhs, out, rhs, inputs[1].shape_, inputs[0].shape_, outputs[1].shape_,
+                     outputs[1].type_flag_, ctx.run_ctx, &plan)) {
+    EinsumGEMMCompute<xpu>(plan, inputs[1], inputs[0], outputs[1], (*req)[1], workspace, s);
+    (*req)[1] = kNullOp;
+  }
+}
+
 template<int dimension, int req, bool back, typename AType>
 struct numpy_einsum{
   template<typename DType>
@@ -805,13 +1042,21 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
   CHECK_EQ(inputs.size(), num_args);
   CHECK_EQ(outputs.size(), 1U);
   if (optimize == 0) {
+    std::string lhs, rhs, out;
+    EinsumGEMM plan;
+    if (EinsumSplitTwoOperands(state.subscripts, inputs, &lhs, &rhs, &out) &&
+        EinsumGEMMPlan(lhs, rhs, out, inputs[0].shape_, inputs[1].shape_, outputs[0].shape_,
+                       outputs[0].type_flag_, ctx.run_ctx, &plan)) {
+      Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+        Shape1(3 * plan.batch * sizeof(void*)), s);
+      EinsumGEMMCompute<xpu>(plan, inputs[0], inputs[1], outputs[0], req[0], workspace, s);
+      return;
+    }
     NumpyEinsumProcess<xpu, 0>(inputs, req, outputs, subscripts, num_args, ctx);
     return;
   }
   std::vector<Step>& paths = state.paths;
-  std::vector<std::vector<int> > pos;
-  std::string string_repr;
-  paths = einsum_path(state.subscripts, inputs, true, ctx.run_ctx, &pos, &string_repr);
+  paths = EinsumPathCache::Get()->Lookup(state.subscripts, inputs, ctx.run_ctx);
   int paths_len = paths.size();
   size_t temp_space_size = 0, max_temp_space_size = 0;
   std::vector<TBlob> operands(inputs), tmp_operands, temp_space_vec(paths_len - 1);
@@ -823,10 +1068,15 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
   }
   temp_space_size += max_temp_space_size;
   MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    state.tempspace.reset<NDArray>(new NDArray(TShape(Shape1(temp_space_size)),
-                                               ctx.run_ctx.ctx,
-                                               false,
-                                               outputs[0].type_flag_));
+    // the intermediate results are kept for backward, reuse them across calls
+    if (state.tempspace == nullptr || state.tempspace->shape().Size() < temp_space_size ||
+        state.tempspace->dtype() != outputs[0].type_flag_ ||
+        state.tempspace->ctx() != ctx.run_ctx.ctx) {
+      state.tempspace.reset<NDArray>(new NDArray(TShape(Shape1(temp_space_size)),
+                                                 ctx.run_ctx.ctx,
+                                                 false,
+                                                 outputs[0].type_flag_));
+    }
     Tensor<xpu, 1, DType> temp_space = state.tempspace->data().FlatTo1D<xpu, DType>();
     size_t begin = max_temp_space_size;
     for (int i = 0; i < paths_len - 1; ++i) {
@@ -892,10 +1142,23 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
                              tensordot_tempspace);
         }
       } else {
-        NumpyEinsumProcess<xpu, 0>(tmp_operands,
-        handle_out ? req : std::vector<OpReqType>{OpReqType::kWriteTo},
-        handle_out ? outputs : std::vector<TBlob>{temp_space_vec[i]},
-        paths[i].einsum_str.c_str(), tmp_operands.size(), ctx);
+        const TBlob& step_out = handle_out ? outputs[0] : temp_space_vec[i];
+        const OpReqType step_req = handle_out ? req[0] : OpReqType::kWriteTo;
+        std::string lhs, rhs, out;
+        EinsumGEMM plan;
+        if (EinsumSplitTwoOperands(paths[i].einsum_str, tmp_operands, &lhs, &rhs, &out) &&
+            EinsumGEMMPlan(lhs, rhs, out, tmp_operands[0].shape_, tmp_operands[1].shape_,
+                           step_out.shape_, step_out.type_flag_, ctx.run_ctx, &plan)) {
+          Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+            Shape1(3 * plan.batch * sizeof(void*)), s);
+          EinsumGEMMCompute<xpu>(plan, tmp_operands[0], tmp_operands[1], step_out, step_req,
+                                 workspace, s);
+        } else {
+          NumpyEinsumProcess<xpu, 0>(tmp_operands,
+          handle_out ? req : std::vector<OpReqType>{OpReqType::kWriteTo},
+          handle_out ? outputs : std::vector<TBlob>{temp_space_vec[i]},
+          paths[i].einsum_str.c_str(), tmp_operands.size(), ctx);
+        }
       }
       if (!handle_out) {
         operands.push_back(temp_space_vec[i]);
@@ -920,7 +1183,18 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
   CHECK_EQ(inputs.size(), 1 + num_args);
   CHECK_EQ(outputs.size(), num_args);
   if (optimize == 0) {
-    NumpyEinsumProcess<xpu, 1>(inputs, req, outputs, subscripts, num_args, ctx);
+    std::vector<OpReqType> remaining_req(req);
+    std::string lhs, rhs, out;
+    if (num_args == 2 &&
+        EinsumSplitTwoOperands(state.subscripts, {inputs[1], inputs[2]}, &lhs, &rhs, &out)) {
+      Tensor<xpu, 1, char> workspace = ctx.requested[0].get_space_typed<xpu, 1, char>(
+        Shape1(3 * EinsumGEMMBatchSize(lhs, rhs, out, inputs[1].shape_) * sizeof(void*)), s);
+      EinsumGEMMBackward<xpu>(lhs, rhs, out, inputs, &remaining_req, outputs, workspace, ctx);
+    }
+    if (std::any_of(remaining_req.begin(), remaining_req.end(),
+                    [](OpReqType r) { return r != kNullOp; })) {
+      NumpyEinsumProcess<xpu, 1>(inputs, remaining_req, outputs, subscripts, num_args, ctx);
+    }
     return;
   }
   // calculate temporary space size for temp_grad
@@ -951,9 +1225,11 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
       op_idx[i].push_back(-static_cast<int>(i - 1));
     }
   }
-  // calculate temporary space size for tensordot
+  // calculate temporary space size for tensordot and the batched GEMM pointers
   size_t tensordot_max_tempspace_size = 0;
   size_t begin_tensordot_tempspace = 0;
+  size_t gemm_max_tempspace_size = 0;
+  size_t begin_gemm_tempspace = 0;
   std::vector<TBlob> temp_inputs, temp_outputs;
   std::vector<OpReqType> temp_req;
   std::vector<size_t> tensordot_tempspace_size;
@@ -1016,9 +1292,21 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
       tensordot_tempspace_size.push_back(cur_tensordot_tempspace_size);
       tensordot_max_tempspace_size = std::max(tensordot_max_tempspace_size,
                                               cur_tensordot_tempspace_size);
+      std::string lhs, rhs, out;
+      if (!paths[i].do_blas && temp_outputs.size() == 2U &&
+          EinsumSplitTwoOperands(paths[i].einsum_str, {temp_inputs[1], temp_inputs[2]},
+                                 &lhs, &rhs, &out)) {
+        gemm_max_tempspace_size = std::max(gemm_max_tempspace_size, 3 * sizeof(void*) *
+          EinsumGEMMBatchSize(lhs, rhs, out, temp_inputs[1].shape_));
+      }
     }
     begin_tensordot_tempspace = temp_space_size;
     temp_space_size += (tensordot_max_tempspace_size + sizeof(DType) - 1) / sizeof(DType);
+    // the pointer array is aligned to a pointer
+    const size_t align = std::max(sizeof(void*) / sizeof(DType), static_cast<size_t>(1));
+    begin_gemm_tempspace = (temp_space_size + align - 1) / align * align;
+    temp_space_size = begin_gemm_tempspace +
+                      (gemm_max_tempspace_size + sizeof(DType) - 1) / sizeof(DType);
   });
   // allocate temporary space and propagate
   std::vector<TBlob> temp_grad(paths_len - 1), temp_data(paths_len - 1);
@@ -1071,7 +1359,7 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
         CHECK_EQ(temp_outputs.size(), 2U);
         CHECK_EQ(temp_req.size(), 2U);
         Tensor<xpu, 1, DType> tensordot_tempspace = temp_space.Slice(begin_tensordot_tempspace,
-                                                                     temp_space_size);
+                                                                     begin_gemm_tempspace);
         Tensor<xpu, 1, char> char_tempspace =
           Tensor<xpu, 1, char>(reinterpret_cast<char*>(tensordot_tempspace.dptr_),
                                                        Shape1(tensordot_tempspace_size[i]),
@@ -1093,10 +1381,23 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
                                      temp_outputs[0], temp_outputs[1], temp_req, char_tempspace);
         }
       } else {
-        NumpyEinsumProcess<xpu, 1>(temp_inputs, temp_req, temp_outputs,
-                                   paths[i].einsum_str.c_str(),
-                                   temp_outputs.size(),
-                                   ctx);
+        std::string lhs, rhs, out;
+        if (temp_outputs.size() == 2U &&
+            EinsumSplitTwoOperands(paths[i].einsum_str, {temp_inputs[1], temp_inputs[2]},
+                                   &lhs, &rhs, &out)) {
+          Tensor<xpu, 1, char> gemm_tempspace(
+            reinterpret_cast<char*>(temp_space.dptr_ + begin_gemm_tempspace),
+            Shape1(gemm_max_tempspace_size), s);
+          EinsumGEMMBackward<xpu>(lhs, rhs, out, temp_inputs, &temp_req, temp_outputs,
+                                  gemm_tempspace, ctx);
+        }
+        if (std::any_of(temp_req.begin(), temp_req.end(),
+                        [](OpReqType r) { return r != kNullOp; })) {
+          NumpyEinsumProcess<xpu, 1>(temp_inputs, temp_req, temp_outputs,
+                                     paths[i].einsum_str.c_str(),
+                                     temp_outputs.size(),
+                                     ctx);
+        }
       }
     }
   });
@@ -521,6 +521,41 @@ inline void LogUnimplementedOp(const nnvm::NodeAttrs& attrs,
     LOG(FATAL) << "Not implemented: " << operator_string(attrs, ctx, inputs, req, outputs);
 }
 
+/*! \brief total bytes of arrays, skipping those of unknown shape or type */
+inline uint64_t ArrayBytes(const mxnet::ShapeVector& shapes, const std::vector<int>& types) {
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < shapes.size() && i < types.size(); ++i) {
+    if (!shape_is_known(shapes[i]) || type_is_none(types[i])) continue;
+    bytes += shapes[i].Size() * mshadow::mshadow_sizeof(types[i]);
+  }
+  return bytes;
+}
+
+/*! \brief cost of an operator reading each input and writing each output once */
+inline OpCost ArrayOpCost(const nnvm::NodeAttrs& attrs,
+                          const mxnet::ShapeVector& in_shapes,
+                          const std::vector<int>& in_types,
+                          const mxnet::ShapeVector& out_shapes,
+                          const std::vector<int>& out_types) {
+  OpCost cost;
+  cost.bytes_read = ArrayBytes(in_shapes, in_types);
+  cost.bytes_written = ArrayBytes(out_shapes, out_types);
+  return cost;
+}
+
+/*! \brief cost of an elementwise operator doing one flop per output element */
+inline OpCost ElemwiseOpCost(const nnvm::NodeAttrs& attrs,
+                             const mxnet::ShapeVector& in_shapes,
+                             const std::vector<int>& in_types,
+                             const mxnet::ShapeVector& out_shapes,
+                             const std::vector<int>& out_types) {
+  OpCost cost = ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+  for (const auto& shape : out_shapes) {
+    if (shape_is_known(shape)) cost.flops += shape.Size();
+  }
+  return cost;
+}
+
 class OpSignature {
   std::vector<int64_t> eles;
   uint64_t hash;
@@ -109,6 +109,18 @@ class OperatorTune : public OperatorTuneByType<DType> {
   using duration_t = OperatorTuneBase::duration_t;
   using OperatorTuneByType<DType>::tuning_mode_;
 
+  /*!
+   * \brief Kernel operator scheduled to be tuned
+   */
+  struct TuneEntry {
+    /*! \brief Demangled name of the tuned_op, the key in the tuning database */
+    std::string name;
+    /*! \brief Function which tunes the operator */
+    void (*tune)();
+    /*! \brief Workload set by the tune function */
+    std::vector<float> *workload;
+  };
+
   /*!
    * \brief Constructor
    */
@@ -171,7 +183,7 @@ class OperatorTune : public OperatorTuneByType<DType> {
         // disabled
         if (!config.empty() && ::isdigit(config[0]) && std::atoi(config.c_str()) == 0) {
           OperatorTuneBase::omp_overhead_ns_ = INT_MAX;
-        } else {
+        } else if (!OperatorTuneBase::LoadTuningDatabase()) {
           OperatorTuneBase::omp_overhead_ns_ = GetOMPLoopOverhead();
         }
         ParseEnablerConfig(config);
@@ -187,14 +199,15 @@ class OperatorTune : public OperatorTuneByType<DType> {
   /*!
    * \brief Schedule a tuning run
    * \tparam OP Operator to tune
+   * \tparam TUNED tuned_op whose workload the tune function sets
    * \param tune_func Function to call which tunes the operator
    * \return true if the tune operation was scheduled
    */
-  template<typename OP>
+  template<typename OP, typename TUNED = mxnet_op::tuned_op<OP, DType>>
   static bool ScheduleTune(void (*tune_func)()) {
 #ifdef MXNET_USE_OPERATOR_TUNING
     if (tune_func) {
-      GetTuningList()->push_back(tune_func);
+      GetTuningList()->push_back({type_name<TUNED>(), tune_func, &TUNED::workload_});
       operator_names_.insert(demangle(typeid(OP).name()));
       return true;
     }
@@ -219,7 +232,7 @@ class OperatorTune : public OperatorTuneByType<DType> {
    */
   static bool TuneAll() {
     Initialize();
-    std::list<void (*)()> *tl = GetTuningList();
+    std::list<TuneEntry> *tl = GetTuningList();
     const size_t size_save = tl->size();  // For checking if anything asynchronous is
     // adding or removing items, which is forbidden
     if (output_tuning_data_ && !tl->empty()) {
@@ -231,9 +244,17 @@ class OperatorTune : public OperatorTuneByType<DType> {
       }
     }
     const Tick start = std::chrono::high_resolution_clock::now();
-    for (auto i : *tl) {
-      (*i)();
+    for (const TuneEntry &entry : *tl) {
+      float workload;
+      // Tuning data is printed as it is measured, so don't use the database then
+      if (!output_tuning_data_ && OperatorTuneBase::LookupWorkload(entry.name, &workload)) {
+        (*entry.workload)[0] = workload;
+      } else {
+        (*entry.tune)();
+        OperatorTuneBase::RecordWorkload(entry.name, (*entry.workload)[0]);
+      }
     }
+    OperatorTuneBase::SaveTuningDatabase();
     if (OperatorTuneBase::verbose_tuning_info_) {
       const duration_t duration = OperatorTune::GetDurationInNanoseconds(start);
       LOG(INFO) << "Op Tuning  for " << type_name<DType>()
@@ -258,7 +279,7 @@ class OperatorTune : public OperatorTuneByType<DType> {
    * \brief Get the list of tuning function calls for the operators
    * \return Pointer to list of tuning function calls
    */
-  static std::list<void (*)()> *GetTuningList();
+  static std::list<TuneEntry> *GetTuningList();
 
   /*!
    * \brief Demangle typeid::name() in order to generate source macros
@@ -367,12 +388,14 @@ class OperatorTune : public OperatorTuneByType<DType> {
       }
       std::vector<duration_t> durations;
       durations.reserve(max_cores - 1);
+      OperatorTuneBase::omp_overhead_by_threads_.assign(2, 0);
       for (size_t omp_threads = 2; omp_threads <= max_cores; ++omp_threads) {
         const duration_t duration = GetOMPLoopOverhead(omp_threads);
         if (OperatorTuneBase::verbose_tuning_info_) {
           LOG(INFO) << "OMP Thread Count: " << omp_threads << ", overhead: " << duration << " ns";
         }
         durations.emplace_back(duration);
+        OperatorTuneBase::omp_overhead_by_threads_.emplace_back(std::max<duration_t>(duration, 0));
       }
       // return median
       std::sort(durations.begin(), durations.end());
@@ -16,13 +16,19 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <dmlc/json.h>
 #include <cfloat>
 #include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
 #include "./mxnet_op.h"
 #include "./mshadow_op.h"
 #include "./tensor/init_op.h"
 #include "./operator_tune-inl.h"
 #include "./tensor/elemwise_binary_broadcast_op.h"
+#include "../common/utils.h"
 
 namespace mxnet {
 namespace op {
@@ -33,6 +39,165 @@ namespace op {
 std::atomic<bool> OperatorTuneBase::calculated_(false);
 bool OperatorTuneBase::verbose_tuning_info_ = false;
 double OperatorTuneBase::tuning_weight_scale_ = 0.0;
+std::vector<OperatorTuneBase::duration_t> OperatorTuneBase::omp_overhead_by_threads_;
+
+namespace {
+/*!
+ * \brief Measurements of one host, kept in MXNET_OPERATOR_TUNING_DIR so that later processes
+ *        don't have to time the kernels again
+ */
+struct TuningDatabase {
+  /*! \brief file of this host, empty if there is no database */
+  std::string path;
+  /*! \brief whether anything was measured since the database was loaded */
+  bool dirty = false;
+  /*! \brief host the measurements were taken on */
+  std::string host;
+  /*! \brief processors of the host */
+  int num_procs = 0;
+  /*! \brief MXNet version that measured them */
+  int version = 0;
+  /*! \brief median OMP overhead in nanoseconds */
+  int64_t omp_overhead = 0;
+  /*! \brief OMP overhead in nanoseconds by number of threads */
+  std::vector<int64_t> omp_overhead_by_threads;
+  /*! \brief workload by tuned kernel */
+  std::map<std::string, float> workloads;
+
+  void Save(dmlc::JSONWriter *writer) const {
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("host", host);
+    writer->WriteObjectKeyValue("num_procs", num_procs);
+    writer->WriteObjectKeyValue("version", version);
+    writer->WriteObjectKeyValue("omp_overhead", omp_overhead);
+    writer->WriteObjectKeyValue("omp_overhead_by_threads", omp_overhead_by_threads);
+    writer->WriteObjectKeyValue("workloads", workloads);
+    writer->EndObject();
+  }
+
+  void Load(dmlc::JSONReader *reader) {
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("host", &host);
+    helper.DeclareField("num_procs", &num_procs);
+    helper.DeclareField("version", &version);
+    helper.DeclareField("omp_overhead", &omp_overhead);
+    helper.DeclareField("omp_overhead_by_threads", &omp_overhead_by_threads);
+    helper.DeclareField("workloads", &workloads);
+    helper.ReadAllFields(reader);
+  }
+
+  static TuningDatabase *Get() {
+    static TuningDatabase db;
+    return &db;
+  }
+};
+
+std::string HostName() {
+#ifdef _WIN32
+  return dmlc::GetEnv("COMPUTERNAME", std::string("localhost"));
+#else
+  char name[256] = {0};
+  if (gethostname(name, sizeof(name) - 1) != 0) {
+    return "localhost";
+  }
+  return name;
+#endif
+}
+}  // namespace
+
+bool OperatorTuneBase::LoadTuningDatabase() {
+  TuningDatabase *db = TuningDatabase::Get();
+  const std::string dir = dmlc::GetEnv("MXNET_OPERATOR_TUNING_DIR", std::string());
+  if (dir.empty()) {
+    return false;
+  }
+  const std::string host = HostName();
+  db->path = dir + "/operator_tune_" + host + ".json";
+  // Anything not loaded is measured and then saved
+  db->dirty = true;
+  if (!dmlc::GetEnv("MXNET_OPERATOR_TUNING_REFRESH", false)) {
+    std::ifstream is(db->path);
+    if (is.good()) {
+      TuningDatabase loaded;
+      try {
+        dmlc::JSONReader reader(&is);
+        loaded.Load(&reader);
+      } catch (const dmlc::Error &e) {
+        LOG(WARNING) << "Ignoring unreadable operator tuning database " << db->path
+                     << ": " << e.what();
+        loaded.version = 0;
+      }
+      if (loaded.host == host && loaded.num_procs == omp_get_num_procs()
+          && loaded.version == MXNET_VERSION) {
+        loaded.path = db->path;
+        loaded.dirty = false;
+        *db = std::move(loaded);
+        omp_overhead_ns_ = db->omp_overhead;
+        omp_overhead_by_threads_.assign(db->omp_overhead_by_threads.begin(),
+                                        db->omp_overhead_by_threads.end());
+        if (verbose_tuning_info_) {
+          LOG(INFO) << "Loaded operator tuning database " << db->path;
+        }
+        return true;
+      }
+    }
+  }
+  db->host = host;
+  db->num_procs = omp_get_num_procs();
+  db->version = MXNET_VERSION;
+  db->workloads.clear();
+  return false;
+}
+
+bool OperatorTuneBase::LookupWorkload(const std::string &name, float *workload) {
+  const TuningDatabase *db = TuningDatabase::Get();
+  const auto it = db->workloads.find(name);
+  if (it == db->workloads.end()) {
+    return false;
+  }
+  *workload = it->second;
+  return true;
+}
+
+void OperatorTuneBase::RecordWorkload(const std::string &name, float workload) {
+  TuningDatabase *db = TuningDatabase::Get();
+  if (!db->path.empty()) {
+    db->workloads[name] = workload;
+    db->dirty = true;
+  }
+}
+
+void OperatorTuneBase::SaveTuningDatabase() {
+  TuningDatabase *db = TuningDatabase::Get();
+  if (db->path.empty() || !db->dirty) {
+    return;
+  }
+  db->omp_overhead = omp_overhead_ns_;
+  db->omp_overhead_by_threads.assign(omp_overhead_by_threads_.begin(),
+                                     omp_overhead_by_threads_.end());
+  // Other processes may read the file at any time, so it is replaced as a whole.
+  std::ostringstream tmp_path;
+  tmp_path << db->path << ".tmp" << common::current_process_id();
+  {
+    std::ofstream os(tmp_path.str());
+    if (os.good()) {
+      dmlc::JSONWriter writer(&os);
+      db->Save(&writer);
+    }
+    if (!os.good()) {
+      LOG(WARNING) << "Can not write operator tuning database " << tmp_path.str();
+      os.close();
+      std::remove(tmp_path.str().c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.str().c_str(), db->path.c_str()) != 0) {
+    LOG(WARNING) << "Can not replace operator tuning database " << db->path;
+    std::remove(tmp_path.str().c_str());
+    return;
+  }
+  db->dirty = false;
+}
 
 /*!
  * \brief Instantiate static variables for OperatorTune<DType>, where 'DType' is specified
@@ -44,8 +209,8 @@ double OperatorTuneBase::tuning_weight_scale_ = 0.0;
   template<> volatile int OperatorTune<__typ$>::volatile_int_ = 9;  /* arbitrary number */ \
   template<> std::unordered_set<std::string> OperatorTune<__typ$>::operator_names_({}); \
   template<> bool OperatorTune<__typ$>::output_tuning_data_ = false; \
-  template<> std::list<void (*)()> *OperatorTune<__typ$>::GetTuningList() { \
-    static std::list<void (*)()> ll; \
+  template<> std::list<OperatorTune<__typ$>::TuneEntry> *OperatorTune<__typ$>::GetTuningList() { \
+    static std::list<OperatorTune<__typ$>::TuneEntry> ll; \
     return &ll; \
   }
 
@@ -146,7 +311,8 @@ struct static_init_var {
       ::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>(N, omp_threads); \
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>:: \
-    init_ = ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>( \
+    init_ = ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, mxnet_op::tuned_op< \
+      ::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>( \
       ::mxnet::op::UnaryOpTune<__typ$>::TuneUnaryBackwardOperator<__op$>)
 
 /*!
@@ -179,7 +345,8 @@ struct static_init_var {
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, \
     __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>(  \
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, mxnet_op::tuned_op< \
+      ::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>( \
       ::mxnet::op::BinaryOpTune<__typ$>::TuneBinaryBackwardOperator<__op$>)
 
 /*!
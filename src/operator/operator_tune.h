@@ -25,6 +25,7 @@
 #include <set>
 #include <atomic>
 #include <string>
+#include <algorithm>
 
 // #define MXNET_DEBUG_TUNING_LAUNCH
 
@@ -77,6 +78,30 @@ class OperatorTuneBase {
   static bool verbose_tuning_info_;
   /*! \brief Tuning scale factor */
   static double tuning_weight_scale_;
+  /*! \brief Time in nanoseconds for OMP overhead, indexed by the number of threads */
+  static std::vector<duration_t> omp_overhead_by_threads_;
+
+  /*!
+   * \brief Load the OMP overheads and workloads measured on this host before
+   *        from MXNET_OPERATOR_TUNING_DIR
+   * \return Whether the database was loaded, if not the caller measures them
+   */
+  static bool LoadTuningDatabase();
+  /*!
+   * \brief Look up the workload of a tuned kernel in the loaded database
+   * \param name Demangled name of the tuned kernel, which includes its data type
+   * \param workload Set to the workload if found
+   * \return Whether the database has the kernel
+   */
+  static bool LookupWorkload(const std::string &name, float *workload);
+  /*!
+   * \brief Add a measured workload to the database, written by SaveTuningDatabase()
+   * \param name Demangled name of the tuned kernel, which includes its data type
+   * \param workload Measured workload
+   */
+  static void RecordWorkload(const std::string &name, float workload);
+  /*! \brief Write the database to MXNET_OPERATOR_TUNING_DIR if anything was measured */
+  static void SaveTuningDatabase();
 
  public:
   typedef std::chrono::high_resolution_clock::time_point Tick;
@@ -155,6 +180,31 @@ class OperatorTuneBase {
     }
     return false;
   }
+
+  /*!
+   * \brief Estimate the time to compute with every number of OMP threads up to thread_count
+   * \param thread_count - Number of OMP threads available to perform the iterations
+   * \param serial_workload - Workload of all the iterations on one thread
+   * \returns The fastest number of threads, 1 to run serially
+   */
+  inline static size_t BestThreadCount(size_t thread_count, const uint64_t serial_workload) {
+    const size_t measured = omp_overhead_by_threads_.size();
+    if (measured < 3) {
+      return thread_count;
+    }
+    uint64_t best_time_ns = serial_workload >> WORKLOAD_COUNT_SHIFT;
+    size_t best = 1;
+    for (size_t threads = 2; threads <= thread_count; ++threads) {
+      // more threads than were measured cost as much as the most that were
+      const uint64_t time_ns = omp_overhead_by_threads_[std::min(threads, measured - 1)]
+                               + ((serial_workload / threads) >> WORKLOAD_COUNT_SHIFT);
+      if (time_ns < best_time_ns) {
+        best_time_ns = time_ns;
+        best = threads;
+      }
+    }
+    return best;
+  }
 };
 
 namespace tune {
@@ -210,6 +260,21 @@ class OperatorTuneByType : public OperatorTuneBase {
 #endif
   }
 
+  /*!
+   * \brief Determine how many OMP threads to use based upon both timing and configuration
+   * \param thread_count - Number of OMP threads available to perform the iterations
+   * \param serial_workload - Workload of all the iterations on one thread
+   * \returns Number of threads to use, 1 to run serially
+   */
+  inline static size_t ThreadCount(size_t thread_count, const uint64_t serial_workload) {
+#ifdef MXNET_USE_OPERATOR_TUNING
+    if (tuning_mode() == tune::kAuto) {
+      return OperatorTuneBase::BestThreadCount(thread_count, serial_workload);
+    }
+#endif
+    return thread_count;
+  }
+
  protected:
   /*! \brief Tuning mode */
   static volatile tune::TuningMode tuning_mode_;
@@ -259,6 +324,17 @@ struct tuned_op : public Operation {
    * \return true if OMP parallelism is recommended
    */
   static bool UseOMP(size_t N, size_t thread_count);
+
+  /*!
+   * \brief Number of OMP threads to use once UseOMP() recommended OMP parallelism
+   * \param N Number of iterations
+   * \param thread_count Number of threads available
+   * \return Number of threads to use, 1 to run serially
+   */
+  static MSHADOW_CINLINE size_t ThreadCount(size_t N, size_t thread_count) {
+    return OperatorTuneByType<DType>::ThreadCount(thread_count,
+                                                  static_cast<uint64_t>(N) * workload_[0]);
+  }
 };
 
 /*!
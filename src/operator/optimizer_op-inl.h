@@ -32,6 +32,8 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
@@ -204,6 +206,83 @@ inline bool MP_MultiSGD_InferType(const nnvm::NodeAttrs& attrs,
   return all_inferred;
 }
 
+/*!
+ * \brief Applies a per-element multi-tensor kernel `OP::Map(t, i, param, args...)` to
+ *  element `i` of tensor `t`. Used by the generic launcher, which iterates over the
+ *  largest tensor and lets every work item visit all tensors.
+ */
+template<typename OP>
+struct MultiTensorElementKernel {
+  template<typename ParamType, typename ...Args>
+  MSHADOW_XINLINE static void Map(index_t i, const ParamType& param, Args... args) {
+    for (int t = 0; t < param.count; ++t) {
+      if (i < static_cast<index_t>(param.sizes[t])) {
+        OP::Map(t, i, param, args...);
+      }
+    }
+  }
+};
+
+/*!
+ * \brief Launches a multi-tensor kernel over all elements of the `param.count` tensors
+ *  described by `param.sizes`.
+ */
+template<typename OP, typename xpu>
+struct MultiTensorKernel {
+  template<typename ParamType, typename ...Args>
+  inline static void Launch(mshadow::Stream<xpu> *s, const ParamType& param, Args... args) {
+    mxnet_op::Kernel<MultiTensorElementKernel<OP>, xpu>::Launch(s, param.max_size, param, args...);
+  }
+};
+
+/*! \brief minimum number of elements given to one OpenMP thread by multi-tensor kernels */
+constexpr index_t kMultiTensorMinElemsPerThread = 4096;
+
+/*!
+ * \brief CPU launcher of multi-tensor kernels. The tensors are concatenated logically and
+ *  the total number of elements is split evenly across threads, so that many small
+ *  tensors and a few large ones are processed in a single parallel pass with balanced work.
+ */
+template<typename OP>
+struct MultiTensorKernel<OP, cpu> {
+  template<typename ParamType, typename ...Args>
+  inline static void Launch(mshadow::Stream<cpu> *s, const ParamType& param, Args... args) {
+    index_t offsets[ParamType::N + 1];
+    offsets[0] = 0;
+    for (int t = 0; t < param.count; ++t) {
+      offsets[t + 1] = offsets[t] + static_cast<index_t>(param.sizes[t]);
+    }
+    const index_t total = offsets[param.count];
+    const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    const int nthreads = static_cast<int>(std::min<index_t>(
+        omp_threads, (total + kMultiTensorMinElemsPerThread - 1) / kMultiTensorMinElemsPerThread));
+    if (nthreads < 2) {
+      for (int t = 0; t < param.count; ++t) {
+        for (index_t i = 0; i < static_cast<index_t>(param.sizes[t]); ++i) {
+          OP::Map(t, i, param, args...);
+        }
+      }
+      return;
+    }
+    #pragma omp parallel num_threads(nthreads)
+    {
+      const int tid = omp_get_thread_num();
+      const index_t begin = total * tid / nthreads;
+      const index_t end = total * (tid + 1) / nthreads;
+      // last tensor starting at or before `begin`; empty tensors are skipped
+      int t = static_cast<int>(std::upper_bound(offsets, offsets + param.count + 1, begin)
+                               - offsets) - 1;
+      for (index_t pos = begin; pos < end; ++t) {
+        const index_t stop = std::min(end, offsets[t + 1]);
+        for (index_t i = pos - offsets[t]; i < stop - offsets[t]; ++i) {
+          OP::Map(t, i, param, args...);
+        }
+        pos = stop;
+      }
+    }
+  }
+};
+
 template<typename DType, typename MPDType>
 struct MultiSGDKernelParam {
   static const int N = 60;
@@ -225,29 +304,27 @@ struct MultiSGDKernelParam {
 template <typename MPDType, bool has_momentum, bool has_mixed_precision>
 struct MultiSGDKernel {
   template<typename DType>
-  MSHADOW_XINLINE static void Map(index_t i, const MultiSGDKernelParam<DType, MPDType>& param,
-    const OpReqType req) {
-    for (int index = 0; index < param.count; ++index) {
-      if (i < static_cast<index_t>(param.sizes[index])) {
-        MPDType w = has_mixed_precision ? param.weights32[index][i] :
-                                          MPDType(param.weights[index][i]);
-        MPDType rescale_grad = param.rescale_grad * static_cast<MPDType>(param.grads[index][i]);
-        if (param.clip_gradient >= 0.0f) {
-          rescale_grad = mshadow_op::clip::Map(rescale_grad, param.clip_gradient);
-        }
-        rescale_grad += param.wds[index] * w;
-        if (has_momentum) {
-          param.mom[index][i] *= param.momentum;
-          param.mom[index][i] -= param.lrs[index] * rescale_grad;
-          w = w + param.mom[index][i];
-        } else {
-          w -= param.lrs[index] * rescale_grad;
-        }
-        if (has_mixed_precision) {
-          param.weights32[index][i] = w;
-        }
-        KERNEL_ASSIGN(param.out_data[index][i], req, w);
-      }
+  MSHADOW_XINLINE static void Map(int index, index_t i,
+    const MultiSGDKernelParam<DType, MPDType>& param, const OpReqType req) {
+    MPDType w = has_mixed_precision ? param.weights32[index][i] :
+                                      MPDType(param.weights[index][i]);
+    MPDType rescale_grad = param.rescale_grad * static_cast<MPDType>(param.grads[index][i]);
+    if (param.clip_gradient >= 0.0f) {
+      rescale_grad = mshadow_op::clip::Map(rescale_grad, param.clip_gradient);
+    }
+    rescale_grad += param.wds[index] * w;
+    if (has_momentum) {
+      param.mom[index][i] *= param.momentum;
+      param.mom[index][i] -= param.lrs[index] * rescale_grad;
+      w = w + param.mom[index][i];
+    } else {
+      w -= param.lrs[index] * rescale_grad;
+    }
+    if (has_mixed_precision) {
+      param.weights32[index][i] = w;
+      KERNEL_ASSIGN(param.out_data[index][i], req, CastFromFloat32<DType>(w));
+    } else {
+      KERNEL_ASSIGN(param.out_data[index][i], req, w);
     }
   }
 };
@@ -269,6 +346,9 @@ MultiSGDKernelParam<DType, MPDType> FillMultiSGDKernelParam(const nnvm::NodeAttr
   param.rescale_grad = p.rescale_grad;
   param.momentum = 0;
   param.count = p.num_weights;
+  CHECK_LE(param.count, static_cast<int>(MultiSGDKernelParam<DType, MPDType>::N))
+    << "Too many weights in a single multi-tensor update: " << param.count
+    << ", maximum is " << MultiSGDKernelParam<DType, MPDType>::N;
   param.max_size = 0;
   for (int i = 0; i < param.count; ++i) {
     param.sizes[i] = inputs[i * input_stride].shape_.Size();
@@ -337,7 +417,7 @@ inline void MultiSGDUpdate(const nnvm::NodeAttrs& attrs,
                            const std::vector<TBlob> &outputs) {
   using namespace mxnet_op;
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(outputs[0].type_flag_, DType, {
     using MPDType = typename MPTypeChooser<DType>::type;
     MultiSGDKernelParam<DType, MPDType> param =
       FillMultiSGDKernelParam<xpu,
@@ -345,10 +425,10 @@ inline void MultiSGDUpdate(const nnvm::NodeAttrs& attrs,
                               MPDType,
                               MultiSGDParam,
                               input_stride>(attrs, ctx, inputs, outputs);
-    Kernel<MultiSGDKernel<MPDType,
-                          false,
-                          !std::is_same<DType, MPDType>::value>,
-                          xpu>::Launch(s, param.max_size, param, req[0]);
+    MultiTensorKernel<MultiSGDKernel<MPDType,
+                                     false,
+                                     !std::is_same<DType, MPDType>::value>,
+                      xpu>::Launch(s, param, req[0]);
   });
 }
 
@@ -360,17 +440,448 @@ inline void MultiSGDMomUpdate(const nnvm::NodeAttrs& attrs,
                               const std::vector<TBlob> &outputs) {
   using namespace mxnet_op;
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(outputs[0].type_flag_, DType, {
     using MPDType = typename MPTypeChooser<DType>::type;
     MultiSGDKernelParam<DType, MPDType> param =
       FillMultiSGDMomKernelParam<xpu,
                                  DType,
                                  MPDType,
                                  input_stride>(attrs, ctx, inputs, outputs);
-    Kernel<MultiSGDKernel<MPDType,
-                          true,
-                          !std::is_same<DType, MPDType>::value>,
-                          xpu>::Launch(s, param.max_size, param, req[0]);
+    MultiTensorKernel<MultiSGDKernel<MPDType,
+                                     true,
+                                     !std::is_same<DType, MPDType>::value>,
+                      xpu>::Launch(s, param, req[0]);
+  });
+}
+
+struct MultiAdamParam : public dmlc::Parameter<MultiAdamParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdamParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates, with the bias correction of the current step applied.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiRMSPropParam : public dmlc::Parameter<MultiRMSPropParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float rho;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  float clip_weights;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiRMSPropParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(rho).set_default(0.95f)
+    .describe("The decay rate of momentum estimates.");
+    DMLC_DECLARE_FIELD(epsilon).set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_weights)
+    .set_default(-1.0f)
+    .describe("Clip weights to the range of [-clip_weights, clip_weights] "
+              "If clip_weights <= 0, weight clipping is turned off. "
+              "weights = max(min(weights, clip_weights), -clip_weights).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiNAGMomParam : public dmlc::Parameter<MultiNAGMomParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float momentum;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiNAGMomParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(momentum)
+    .set_default(0.0f)
+    .describe("The decay rate of momentum estimates at each epoch.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiFTMLParam : public dmlc::Parameter<MultiFTMLParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  mxnet::Tuple<int> ts;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_grad;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiFTMLParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(ts)
+    .describe("Number of updates of every weight.");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.6f)
+    .set_range(0.0f, 1.0f)
+    .describe("Generally close to 0.5.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .set_range(0.0f, 1.0f)
+    .describe("Generally close to 1.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("Epsilon to prevent div 0.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_grad)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiAdagradParam : public dmlc::Parameter<MultiAdagradParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdagradParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1.0e-7)
+    .describe("epsilon");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+/*!
+ * \brief Pointers and per-weight hyper-parameters of a multi-tensor optimizer update.
+ *  Every weight is followed in the inputs by its gradient and up to `kMaxStates` states.
+ *  `coef1` and `coef2` hold step dependent coefficients of optimizers which need them.
+ *  The size is kept below the 4KB limit of CUDA kernel arguments for DType = double.
+ */
+template<typename DType>
+struct MultiTensorKernelParam {
+  static const int N = 40;
+  static const int kMaxStates = 3;
+  int count;
+  size_t max_size;
+  size_t sizes[N];
+  DType * weights[N];
+  DType * grads[N];
+  DType * states[kMaxStates][N];
+  DType * out_data[N];
+  DType lrs[N];
+  DType wds[N];
+  DType coef1[N];
+  DType coef2[N];
+  DType rescale_grad;
+  DType clip_gradient;
+
+  /*! \brief rescaled and clipped gradient of element `i` of weight `t`, with weight decay */
+  MSHADOW_XINLINE DType Grad(int t, index_t i) const {
+    DType grad = rescale_grad * grads[t][i];
+    if (clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, clip_gradient);
+    }
+    return grad + wds[t] * weights[t][i];
+  }
+};
+
+template<typename xpu, typename DType, typename ParamType, int input_stride>
+MultiTensorKernelParam<DType> FillMultiTensorKernelParam(const ParamType& p,
+                                                         const OpContext &ctx,
+                                                         const std::vector<TBlob> &inputs,
+                                                         const std::vector<TBlob> &outputs,
+                                                         const float rescale_grad,
+                                                         const float clip_gradient) {
+  static_assert(input_stride - 2 <= MultiTensorKernelParam<DType>::kMaxStates,
+                "too many optimizer states for a multi-tensor update");
+  MultiTensorKernelParam<DType> param;
+  param.count = p.num_weights;
+  CHECK_LE(param.count, static_cast<int>(MultiTensorKernelParam<DType>::N))
+    << "Too many weights in a single multi-tensor update: " << param.count
+    << ", maximum is " << MultiTensorKernelParam<DType>::N;
+  param.rescale_grad = static_cast<DType>(rescale_grad);
+  param.clip_gradient = static_cast<DType>(clip_gradient);
+  param.max_size = 0;
+  for (int i = 0; i < param.count; ++i) {
+    param.sizes[i] = inputs[i * input_stride].shape_.Size();
+    param.max_size = std::max(param.max_size, param.sizes[i]);
+    param.weights[i] = inputs[i * input_stride].dptr<DType>();
+    param.grads[i] = inputs[i * input_stride + 1].dptr<DType>();
+    for (int j = 0; j < input_stride - 2; ++j) {
+      param.states[j][i] = inputs[i * input_stride + 2 + j].dptr<DType>();
+    }
+    param.out_data[i] = outputs[i].dptr<DType>();
+    param.lrs[i] = static_cast<DType>(p.lrs[i]);
+    param.wds[i] = static_cast<DType>(p.wds[i]);
+    param.coef1[i] = param.coef2[i] = 0;
+  }
+  return param;
+}
+
+struct MultiAdamKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int t, index_t i, const MultiTensorKernelParam<DType>& param,
+    const DType beta1, const DType beta2, const DType epsilon, const OpReqType req) {
+    using namespace mshadow_op;
+    const DType grad = param.Grad(t, i);
+    DType* mean = param.states[0][t];
+    DType* var = param.states[1][t];
+    mean[i] = beta1 * mean[i] + (1.f - beta1) * grad;
+    var[i] = beta2 * var[i] + (1.f - beta2) * grad * grad;
+    KERNEL_ASSIGN(param.out_data[t][i], req, param.weights[t][i] -
+                  param.lrs[t] * mean[i] / (square_root::Map(var[i]) + epsilon));
+  }
+};
+
+struct MultiRMSPropKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int t, index_t i, const MultiTensorKernelParam<DType>& param,
+    const DType rho, const DType epsilon, const DType clip_weights, const OpReqType req) {
+    using namespace mshadow_op;
+    const DType grad = param.Grad(t, i);
+    DType* state_n = param.states[0][t];
+    state_n[i] = (1.f - rho) * square::Map(grad) + rho * state_n[i];
+    DType weight = param.weights[t][i] -
+                   param.lrs[t] * grad / (square_root::Map(state_n[i]) + epsilon);
+    if (clip_weights >= 0.0f) {
+      weight = clip::Map(weight, clip_weights);
+    }
+    KERNEL_ASSIGN(param.out_data[t][i], req, weight);
+  }
+};
+
+struct MultiNAGMomKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int t, index_t i, const MultiTensorKernelParam<DType>& param,
+    const DType momentum, const OpReqType req) {
+    const DType grad = param.Grad(t, i);
+    DType* mom = param.states[0][t];
+    mom[i] *= momentum;
+    mom[i] -= param.lrs[t] * grad;
+    KERNEL_ASSIGN(param.out_data[t][i], req, param.weights[t][i] + (momentum * mom[i])
+                  - (param.lrs[t] * grad));
+  }
+};
+
+/*!
+ * \brief FTML update of several weights, `coef1` and `coef2` hold `1 - beta1^t` and
+ *  `1 - beta2^t` of every weight.
+ */
+struct MultiFTMLKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int t, index_t i, const MultiTensorKernelParam<DType>& param,
+    const DType beta1, const DType beta2, const DType epsilon, const OpReqType req) {
+    using namespace mshadow_op;
+    const DType grad = param.Grad(t, i);
+    const DType weight = param.weights[t][i];
+    DType* d = param.states[0][t];
+    DType* v = param.states[1][t];
+    DType* z = param.states[2][t];
+    v[i] = beta2 * v[i] + (1 - beta2) * square::Map(grad);
+    const DType d_t = param.coef1[t] / param.lrs[t] *
+        (square_root::Map(v[i] / param.coef2[t]) + epsilon);
+    z[i] = beta1 * z[i] + (1 - beta1) * grad - (d_t - beta1 * d[i]) * weight;
+    d[i] = d_t;
+    KERNEL_ASSIGN(param.out_data[t][i], req, - z[i] / d_t);
+  }
+};
+
+struct MultiAdagradKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int t, index_t i, const MultiTensorKernelParam<DType>& param,
+    const DType epsilon, const OpReqType req) {
+    using namespace mshadow_op;
+    const DType grad = param.Grad(t, i);
+    DType* history = param.states[0][t];
+    history[i] += square::Map(grad);
+    KERNEL_ASSIGN(param.out_data[t][i], req, param.weights[t][i] -
+                  param.lrs[t] * grad / (square_root::Map(history[i]) + epsilon));
+  }
+};
+
+template<typename xpu>
+inline void MultiAdamUpdate(const nnvm::NodeAttrs& attrs,
+                            const OpContext &ctx,
+                            const std::vector<TBlob> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<TBlob> &outputs) {
+  const MultiAdamParam& p = nnvm::get<MultiAdamParam>(attrs.parsed);
+  mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MultiTensorKernelParam<DType> param =
+      FillMultiTensorKernelParam<xpu, DType, MultiAdamParam, 4>(p, ctx, inputs, outputs,
+                                                                p.rescale_grad, p.clip_gradient);
+    MultiTensorKernel<MultiAdamKernel, xpu>::Launch(s, param,
+      static_cast<DType>(p.beta1), static_cast<DType>(p.beta2),
+      static_cast<DType>(p.epsilon), req[0]);
+  });
+}
+
+template<typename xpu>
+inline void MultiRMSPropUpdate(const nnvm::NodeAttrs& attrs,
+                               const OpContext &ctx,
+                               const std::vector<TBlob> &inputs,
+                               const std::vector<OpReqType> &req,
+                               const std::vector<TBlob> &outputs) {
+  const MultiRMSPropParam& p = nnvm::get<MultiRMSPropParam>(attrs.parsed);
+  mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MultiTensorKernelParam<DType> param =
+      FillMultiTensorKernelParam<xpu, DType, MultiRMSPropParam, 3>(p, ctx, inputs, outputs,
+                                                                   p.rescale_grad,
+                                                                   p.clip_gradient);
+    MultiTensorKernel<MultiRMSPropKernel, xpu>::Launch(s, param,
+      static_cast<DType>(p.rho), static_cast<DType>(p.epsilon),
+      static_cast<DType>(p.clip_weights), req[0]);
+  });
+}
+
+template<typename xpu>
+inline void MultiNAGMomUpdate(const nnvm::NodeAttrs& attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  const MultiNAGMomParam& p = nnvm::get<MultiNAGMomParam>(attrs.parsed);
+  mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MultiTensorKernelParam<DType> param =
+      FillMultiTensorKernelParam<xpu, DType, MultiNAGMomParam, 3>(p, ctx, inputs, outputs,
+                                                                  p.rescale_grad,
+                                                                  p.clip_gradient);
+    MultiTensorKernel<MultiNAGMomKernel, xpu>::Launch(s, param,
+      static_cast<DType>(p.momentum), req[0]);
+  });
+}
+
+template<typename xpu>
+inline void MultiFTMLUpdate(const nnvm::NodeAttrs& attrs,
+                            const OpContext &ctx,
+                            const std::vector<TBlob> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<TBlob> &outputs) {
+  const MultiFTMLParam& p = nnvm::get<MultiFTMLParam>(attrs.parsed);
+  CHECK_EQ(p.ts.ndim(), p.num_weights)
+    << "Number of update counts is inconsistent with num_weights "
+    << "parameter passed. Expected number of update counts: "
+    << p.num_weights << ", and got " << p.ts.ndim();
+  mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MultiTensorKernelParam<DType> param =
+      FillMultiTensorKernelParam<xpu, DType, MultiFTMLParam, 5>(p, ctx, inputs, outputs,
+                                                                p.rescale_grad, p.clip_grad);
+    for (int i = 0; i < param.count; ++i) {
+      param.coef1[i] = static_cast<DType>(1.0 - std::pow(p.beta1, p.ts[i]));
+      param.coef2[i] = static_cast<DType>(1.0 - std::pow(p.beta2, p.ts[i]));
+    }
+    MultiTensorKernel<MultiFTMLKernel, xpu>::Launch(s, param,
+      static_cast<DType>(p.beta1), static_cast<DType>(p.beta2),
+      static_cast<DType>(p.epsilon), req[0]);
+  });
+}
+
+template<typename xpu>
+inline void MultiAdagradUpdate(const nnvm::NodeAttrs& attrs,
+                               const OpContext &ctx,
+                               const std::vector<TBlob> &inputs,
+                               const std::vector<OpReqType> &req,
+                               const std::vector<TBlob> &outputs) {
+  const MultiAdagradParam& p = nnvm::get<MultiAdagradParam>(attrs.parsed);
+  mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MultiTensorKernelParam<DType> param =
+      FillMultiTensorKernelParam<xpu, DType, MultiAdagradParam, 3>(p, ctx, inputs, outputs,
+                                                                   p.rescale_grad,
+                                                                   p.clip_gradient);
+    MultiTensorKernel<MultiAdagradKernel, xpu>::Launch(s, param,
+      static_cast<DType>(p.epsilon), req[0]);
   });
 }
 
@@ -653,7 +1164,7 @@ struct MP_SGDKernel {
     rescale_grad += param_wd * w;
     w -= param_lr * rescale_grad;
     weight32[i] = w;
-    KERNEL_ASSIGN(out_data[i], req, (DType)w);
+    KERNEL_ASSIGN(out_data[i], req, CastFromFloat32<DType>(w));
   }
 };
 
@@ -666,7 +1177,7 @@ inline void MP_SGDUpdate(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   const SGDParam& param = nnvm::get<SGDParam>(attrs.parsed);
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
     Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> grad = inputs[1].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, float> weight32 = inputs[2].FlatTo2D<xpu, float>(s);
@@ -696,7 +1207,7 @@ struct MP_SGDMomKernel {
     mom_data[i] = mom;
     w = w + mom;
     weight32[i] = w;
-    KERNEL_ASSIGN(out_data[i], req, w);
+    KERNEL_ASSIGN(out_data[i], req, CastFromFloat32<DType>(w));
   }
 };
 
@@ -709,7 +1220,7 @@ inline void MP_SGDMomUpdate(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   SGDMomParam param = nnvm::get<SGDMomParam>(attrs.parsed);
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
     Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> grad = inputs[1].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, float> mom = inputs[2].FlatTo2D<xpu, float>(s);
@@ -1087,7 +1598,7 @@ struct MP_NAGMomKernel {
     mom_data[i] -= param_lr * grad_rescaled;
     w += (param_momentum * mom_data[i]) - (param_lr * grad_rescaled);
     weight32[i] = w;
-    KERNEL_ASSIGN(out_data[i], req, w);
+    KERNEL_ASSIGN(out_data[i], req, CastFromFloat32<DType>(w));
   }
 };
 
@@ -1100,7 +1611,7 @@ inline void MP_NAGMomUpdate(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   NAGMomParam param = nnvm::get<NAGMomParam>(attrs.parsed);
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
     Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> grad = inputs[1].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, float> mom = inputs[2].FlatTo2D<xpu, float>(s);
@@ -1761,7 +2272,7 @@ inline void MPLambUpdatePhaseOne(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   const LambUpdatePhaseOneParam& param = nnvm::get<LambUpdatePhaseOneParam>(attrs.parsed);
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
     float beta1_t = std::pow(param.beta1, param.t);
     float beta2_t = std::pow(param.beta2, param.t);
     Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
@@ -1833,7 +2344,7 @@ struct MPLambUpdatePhaseTwoKernel {
       lr = lr * new_r1 / r2[0];
     }
 
-    KERNEL_ASSIGN(out_data[i], req, weight32_data[i] - lr * g[i]);
+    KERNEL_ASSIGN(out_data[i], req, CastFromFloat32<DType>(weight32_data[i] - lr * g[i]));
   }
 };
 
@@ -1846,7 +2357,7 @@ inline void MPLambUpdatePhaseTwo(const nnvm::NodeAttrs& attrs,
   using namespace mxnet_op;
   const LambUpdatePhaseTwoParam& param = nnvm::get<LambUpdatePhaseTwoParam>(attrs.parsed);
   Stream<xpu>* s = ctx.get_stream<xpu>();
-  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+  MXNET_REAL_TYPE_SWITCH_WITH_BF16(inputs[0].type_flag_, DType, {
     Tensor<xpu, 2, DType> weight = inputs[0].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, float> g = inputs[1].FlatTo2D<xpu, float>(s);
     Tensor<xpu, 2, float> r1 = inputs[2].FlatTo2D<xpu, float>(s);
@@ -33,6 +33,11 @@ DMLC_REGISTER_PARAMETER(SGDParam);
 DMLC_REGISTER_PARAMETER(SGDMomParam);
 DMLC_REGISTER_PARAMETER(MultiSGDParam);
 DMLC_REGISTER_PARAMETER(MultiSGDMomParam);
+DMLC_REGISTER_PARAMETER(MultiAdamParam);
+DMLC_REGISTER_PARAMETER(MultiRMSPropParam);
+DMLC_REGISTER_PARAMETER(MultiNAGMomParam);
+DMLC_REGISTER_PARAMETER(MultiFTMLParam);
+DMLC_REGISTER_PARAMETER(MultiAdagradParam);
 DMLC_REGISTER_PARAMETER(FTMLParam);
 DMLC_REGISTER_PARAMETER(AdamParam);
 DMLC_REGISTER_PARAMETER(NAGParam);
@@ -500,6 +505,181 @@ Where the parameter ``momentum`` is the decay rate of momentum estimates at each
 .add_argument("data", "NDArray-or-Symbol[]", "Weights")
 .add_arguments(MultiSGDMomParam::__FIELDS__());
 
+/*!
+ * \brief Input names of a multi-tensor optimizer update, every weight is followed by its
+ *  gradient and the optimizer states named in `states`.
+ */
+template<typename ParamType>
+std::vector<std::string> MultiTensorListInputNames(const NodeAttrs& attrs,
+                                                   const std::vector<std::string>& states) {
+  const int num_weights = dmlc::get<ParamType>(attrs.parsed).num_weights;
+  std::vector<std::string> ret;
+  for (int i = 0; i < num_weights; ++i) {
+    ret.push_back(std::string("weight_") + std::to_string(i));
+    ret.push_back(std::string("grad_") + std::to_string(i));
+    for (const auto& state : states) {
+      ret.push_back(state + "_" + std::to_string(i));
+    }
+  }
+  return ret;
+}
+
+template<typename ParamType, int input_stride>
+std::vector<uint32_t> MultiTensorMutateInputs(const nnvm::NodeAttrs& attrs) {
+  const int num_weights = dmlc::get<ParamType>(attrs.parsed).num_weights;
+  std::vector<uint32_t> ret;
+  ret.reserve(num_weights * (input_stride - 2));
+  for (int i = 0; i < num_weights; ++i) {
+    for (int j = 2; j < input_stride; ++j) {
+      ret.push_back(i * input_stride + j);
+    }
+  }
+  return ret;
+}
+
+template<typename ParamType, int input_stride>
+uint32_t MultiTensorNumInputs(const nnvm::NodeAttrs& attrs) {
+  return static_cast<uint32_t>(dmlc::get<ParamType>(attrs.parsed).num_weights * input_stride);
+}
+
+template<typename ParamType>
+uint32_t MultiTensorNumOutputs(const nnvm::NodeAttrs& attrs) {
+  return static_cast<uint32_t>(dmlc::get<ParamType>(attrs.parsed).num_weights);
+}
+
+NNVM_REGISTER_OP(multi_adam_update)
+.describe(R"code(Update function for Adam optimizer, applied to multiple weights in a
+single kernel. The weights are processed in one parallel pass, with the work split by the
+total number of elements, which removes the per-weight launch overhead of ``adam_update``
+for models with many small parameters.
+
+It updates every weight using::
+
+ grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+ m = beta1*m + (1-beta1)*grad
+ v = beta2*v + (1-beta2)*(grad**2)
+ w += - learning_rate * m / (sqrt(v) + epsilon)
+
+The bias correction is expected to be folded into ``lrs``.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdamParam, 4>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdamParam>)
+.set_attr_parser(ParamParser<MultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdamParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorListInputNames<MultiAdamParam>(attrs, {"mean", "var"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiAdamParam, 4>)
+.set_attr<FCompute>("FCompute<cpu>", MultiAdamUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means and variances")
+.add_arguments(MultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.describe(R"code(Update function for `RMSProp` optimizer, applied to multiple weights in a
+single kernel.
+
+It updates every weight using::
+
+ grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+ n = (1 - rho) * grad**2 + rho * n
+ w = clip(w - learning_rate * grad / (sqrt(n) + epsilon), clip_weights)
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiRMSPropParam, 3>)
+.set_num_outputs(MultiTensorNumOutputs<MultiRMSPropParam>)
+.set_attr_parser(ParamParser<MultiRMSPropParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiRMSPropParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorListInputNames<MultiRMSPropParam>(attrs, {"n"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiRMSPropParam, 3>)
+.set_attr<FCompute>("FCompute<cpu>", MultiRMSPropUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and states")
+.add_arguments(MultiRMSPropParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.describe(R"code(Update function for Nesterov Accelerated Gradient (NAG) optimizer, applied
+to multiple weights in a single kernel.
+
+It updates every weight using::
+
+ grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+ mom = momentum * mom - learning_rate * grad
+ w += momentum * mom - learning_rate * grad
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiNAGMomParam, 3>)
+.set_num_outputs(MultiTensorNumOutputs<MultiNAGMomParam>)
+.set_attr_parser(ParamParser<MultiNAGMomParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiNAGMomParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorListInputNames<MultiNAGMomParam>(attrs, {"mom"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiNAGMomParam, 3>)
+.set_attr<FCompute>("FCompute<cpu>", MultiNAGMomUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and momentum")
+.add_arguments(MultiNAGMomParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_ftml_update)
+.describe(R"code(The FTML optimizer update applied to multiple weights in a single kernel.
+Every weight has its own update count in ``ts``.
+
+It updates every weight using::
+
+ grad = clip(grad * rescale_grad, clip_grad) + wd * weight
+ v = beta2 * v + (1 - beta2) * grad**2
+ d_t = (1 - beta1**t) / learning_rate * (sqrt(v / (1 - beta2**t)) + epsilon)
+ z = beta1 * z + (1 - beta1) * grad - (d_t - beta1 * d) * weight
+ d = d_t
+ weight = - z / d_t
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiFTMLParam, 5>)
+.set_num_outputs(MultiTensorNumOutputs<MultiFTMLParam>)
+.set_attr_parser(ParamParser<MultiFTMLParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiFTMLParam, 5>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorListInputNames<MultiFTMLParam>(attrs, {"d", "v", "z"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiFTMLParam, 5>)
+.set_attr<FCompute>("FCompute<cpu>", MultiFTMLUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and states d, v, z")
+.add_arguments(MultiFTMLParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_adagrad_update)
+.describe(R"code(Update function for AdaGrad optimizer with dense gradients, applied to
+multiple weights in a single kernel.
+
+It updates every weight using::
+
+ grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+ history += grad**2
+ w -= learning_rate * grad / (sqrt(history) + epsilon)
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdagradParam, 3>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdagradParam>)
+.set_attr_parser(ParamParser<MultiAdagradParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdagradParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorListInputNames<MultiAdagradParam>(attrs, {"history"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiAdagradParam, 3>)
+.set_attr<FCompute>("FCompute<cpu>", MultiAdagradUpdate<cpu>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and histories")
+.add_arguments(MultiAdagradParam::__FIELDS__());
+
 NNVM_REGISTER_OP(sgd_update)
 MXNET_ADD_SPARSE_OP_ALIAS(sgd_update)
 .describe(R"code(Update function for Stochastic Gradient Descent (SGD) optimizer.
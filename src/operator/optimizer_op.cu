@@ -248,6 +248,16 @@ NNVM_REGISTER_OP(multi_mp_sgd_update)
 .set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, single_precision, 3>);
 NNVM_REGISTER_OP(multi_mp_sgd_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", MultiSGDMomUpdate<gpu, single_precision, 4>);
+NNVM_REGISTER_OP(multi_adam_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiAdamUpdate<gpu>);
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiRMSPropUpdate<gpu>);
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiNAGMomUpdate<gpu>);
+NNVM_REGISTER_OP(multi_ftml_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiFTMLUpdate<gpu>);
+NNVM_REGISTER_OP(multi_adagrad_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiAdagradUpdate<gpu>);
 
 NNVM_REGISTER_OP(nag_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", NAGMomUpdate<gpu>);
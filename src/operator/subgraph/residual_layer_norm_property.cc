@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file residual_layer_norm_property.cc
+ * \brief Rewrites LayerNorm(elemwise_add(residual, Dropout(data))) onto
+ *  _contrib_residual_layer_norm
+ */
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./common.h"
+#include "./subgraph_property.h"
+#include "../nn/layer_norm-inl.h"
+#include "../contrib/residual_layer_norm-inl.h"
+
+namespace mxnet {
+namespace op {
+
+/*
+ * Seeds on a LayerNorm over the last axis, then walks up to the elemwise_add feeding it
+ * and optionally to a Dropout feeding the add. Intermediate nodes must have the next
+ * node of the pattern as their only consumer since the fused operator does not
+ * output them.
+ */
+class ResidualLayerNormSelector : public SubgraphSelectorV2 {
+ public:
+  ResidualLayerNormSelector() : add_(nullptr), dropout_(nullptr) {}
+
+  bool Select(const BiDirectedNode &seed_node,
+              const std::shared_ptr<NodeAttr>& node_attr) override {
+    const nnvm::Node* n = seed_node.node;
+    if (n->op() == nullptr || n->op()->name != "LayerNorm") return false;
+    const LayerNormParam& param = nnvm::get<LayerNormParam>(n->attrs.parsed);
+    return param.axis == -1 && !param.output_mean_var;
+  }
+
+  bool SelectInput(const BiDirectedNode &cur_node, const BiDirectedNode &input_node,
+                   const std::shared_ptr<NodeAttr>& node_attr) override {
+    const nnvm::Node* cur = cur_node.node;
+    const nnvm::Node* n = input_node.node;
+    if (n->op() == nullptr || !HasSingleConsumer(input_node)) return false;
+    if (add_ == nullptr && cur->op()->name == "LayerNorm" &&
+        cur->inputs[0].node.get() == n && n->op()->name == "elemwise_add") {
+      add_ = n;
+      return true;
+    }
+    if (dropout_ == nullptr && cur == add_ && n->op()->name == "Dropout" &&
+        nnvm::get<DropoutParam>(n->attrs.parsed).axes.ndim() == 0) {
+      dropout_ = n;
+      return true;
+    }
+    return false;
+  }
+
+  bool SelectOutput(const BiDirectedNode &cur_node, const BiDirectedNode &output_node,
+                    const std::shared_ptr<NodeAttr>& node_attr) override {
+    return false;
+  }
+
+  std::vector<BiDirectedNode*> Filter(const std::vector<BiDirectedNode*>& candidates) override {
+    if (add_ == nullptr) return std::vector<BiDirectedNode*>();
+    return candidates;
+  }
+
+  void Reset() override {
+    add_ = nullptr;
+    dropout_ = nullptr;
+  }
+
+ private:
+  static bool HasSingleConsumer(const BiDirectedNode &node) {
+    return node.outputs.size() == 1 && node.outputs.begin()->second.size() == 1;
+  }
+
+  const nnvm::Node* add_;
+  const nnvm::Node* dropout_;
+};
+
+class ResidualLayerNormProperty : public SubgraphProperty {
+ public:
+  static SubgraphPropertyPtr Create() {
+    static const std::string &name = "Residual add + Dropout + LayerNorm fusion pass";
+    auto property = std::make_shared<ResidualLayerNormProperty>();
+    property->SetAttr<std::string>("property_name", name);
+    if (dmlc::GetEnv("MXNET_DISABLE_RESIDUAL_LAYER_NORM_FUSION", false)) {
+      property->SetAttr<bool>("disable", true);
+    }
+    return property;
+  }
+
+  SubgraphSelectorV2Ptr CreateSubgraphSelectorV2() const override {
+    return std::make_shared<ResidualLayerNormSelector>();
+  }
+
+  nnvm::ObjectPtr CreateSubgraphNode(const nnvm::Symbol &sym,
+                                     const SubgraphSelectorV2Ptr &subgraph_selector,
+                                     const int subgraph_id = 0) const override {
+    const Pattern pattern = MatchPattern(sym);
+    ResidualLayerNormParam param;
+    param.Init(std::vector<std::pair<std::string, std::string>>());
+    param.eps = nnvm::get<LayerNormParam>(pattern.layer_norm->attrs.parsed).eps;
+    if (pattern.dropout != nullptr) {
+      const DropoutParam& dropout_param = nnvm::get<DropoutParam>(pattern.dropout->attrs.parsed);
+      param.p = dropout_param.p;
+      param.mode = dropout_param.mode;
+    } else {
+      param.p = 0;
+    }
+    nnvm::ObjectPtr n = nnvm::Node::Create();
+    n->attrs.name = "residual_layer_norm_" + std::to_string(subgraph_id);
+    n->attrs.op = Op::Get("_contrib_residual_layer_norm");
+    CHECK(n->attrs.op);
+    param.UpdateDict(&n->attrs.dict);
+    n->attrs.parsed = param;
+    n->attrs.subgraphs.emplace_back(std::make_shared<nnvm::Symbol>(sym));
+    return n;
+  }
+
+  void ConnectSubgraphInputs(const nnvm::ObjectPtr subgraph_node,
+                             std::vector<nnvm::NodeEntry*>* input_entries,
+                             std::vector<nnvm::NodeEntry>* orig_input_entries) const override {
+    // the default connects the inputs in topological order, the fused operator
+    // needs them as [data, residual, gamma, beta]
+    const Pattern pattern = MatchPattern(*subgraph_node->attrs.subgraphs[0]);
+    const nnvm::Node* add = pattern.add;
+    const nnvm::NodeEntry* data = &add->inputs[0];
+    const nnvm::NodeEntry* residual = &add->inputs[1];
+    if (pattern.dropout != nullptr) {
+      data = &pattern.dropout->inputs[0];
+      residual = add->inputs[0].node.get() == pattern.dropout ? &add->inputs[1] : &add->inputs[0];
+    }
+    const std::vector<const nnvm::NodeEntry*> order = {
+      data, residual, &pattern.layer_norm->inputs[1], &pattern.layer_norm->inputs[2]};
+    CHECK_EQ(input_entries->size(), order.size());
+    std::vector<nnvm::NodeEntry*> sorted_entries;
+    std::vector<nnvm::NodeEntry> sorted_orig_entries;
+    for (const nnvm::NodeEntry* entry : order) {
+      const auto it = std::find(input_entries->begin(), input_entries->end(), entry);
+      CHECK(it != input_entries->end());
+      sorted_entries.push_back(*it);
+      sorted_orig_entries.push_back(orig_input_entries->at(it - input_entries->begin()));
+    }
+    // keep input_entries aligned with the node inputs for the caller
+    *input_entries = sorted_entries;
+    *orig_input_entries = sorted_orig_entries;
+    subgraph_node->inputs = sorted_orig_entries;
+  }
+
+ private:
+  struct Pattern {
+    const nnvm::Node* layer_norm = nullptr;
+    const nnvm::Node* add = nullptr;
+    const nnvm::Node* dropout = nullptr;
+  };
+
+  static Pattern MatchPattern(const nnvm::Symbol &sym) {
+    Pattern pattern;
+    DFSVisit(sym.outputs, [&](const nnvm::ObjectPtr &node) {
+      if (node->is_variable()) return;
+      if (node->op()->name == "LayerNorm") {
+        pattern.layer_norm = node.get();
+      } else if (node->op()->name == "elemwise_add") {
+        pattern.add = node.get();
+      } else if (node->op()->name == "Dropout") {
+        pattern.dropout = node.get();
+      }
+    });
+    CHECK(pattern.layer_norm != nullptr && pattern.add != nullptr);
+    return pattern;
+  }
+};
+
+MXNET_REGISTER_SUBGRAPH_BACKEND(ResidualLayerNorm);
+MXNET_REGISTER_SUBGRAPH_PROPERTY(ResidualLayerNorm, ResidualLayerNormProperty);
+
+}  // namespace op
+}  // namespace mxnet
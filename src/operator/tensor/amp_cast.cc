@@ -24,12 +24,83 @@
 
 #include "./amp_cast.h"
 
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 10
+#include <immintrin.h>
+#define MXNET_AMP_CAST_AVX512_BF16 1
+#endif
+
 namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(AMPCastParam);
 DMLC_REGISTER_PARAMETER(AMPMultiCastParam);
 
+namespace {
+
+// elements converted by one omp task, large enough to amortize the fork
+constexpr index_t kBF16CastBlock = 1 << 16;
+
+void CastFloat32ToBF16Block(const float* in, uint16_t* out, index_t size) {
+  // branchless, so that the compiler vectorizes it for the target ISA
+  for (index_t i = 0; i < size; ++i) {
+    out[i] = mxnet_op::FloatToBF16Bits(in[i]);
+  }
+}
+
+void CastBF16ToFloat32Block(const uint16_t* in, float* out, index_t size) {
+  for (index_t i = 0; i < size; ++i) {
+    out[i] = mxnet_op::BF16BitsToFloat(in[i]);
+  }
+}
+
+#ifdef MXNET_AMP_CAST_AVX512_BF16
+__attribute__((target("avx512f,avx512bf16,avx512vl")))
+void CastFloat32ToBF16BlockAVX512(const float* in, uint16_t* out, index_t size) {
+  index_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m256bh v = _mm512_cvtneps_pbh(_mm512_loadu_ps(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), (__m256i)v);  // NOLINT(*)
+  }
+  CastFloat32ToBF16Block(in + i, out + i, size - i);
+}
+
+bool HasAVX512BF16() {
+  static const bool supported = __builtin_cpu_supports("avx512bf16");
+  return supported;
+}
+#endif  // MXNET_AMP_CAST_AVX512_BF16
+
+template<typename SrcType, typename DstType, typename Fn>
+void ParallelCastBlocks(const SrcType* in, DstType* out, index_t size, Fn fn) {
+  const index_t num_blocks = (size + kBF16CastBlock - 1) / kBF16CastBlock;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  if (num_blocks <= 1 || omp_threads <= 1) {
+    fn(in, out, size);
+    return;
+  }
+  #pragma omp parallel for num_threads(omp_threads) schedule(static)
+  for (index_t b = 0; b < num_blocks; ++b) {
+    const index_t start = b * kBF16CastBlock;
+    fn(in + start, out + start, std::min(kBF16CastBlock, size - start));
+  }
+}
+
+}  // namespace
+
+void CastFloat32ToBF16(const float* in, uint16_t* out, index_t size) {
+#ifdef MXNET_AMP_CAST_AVX512_BF16
+  if (HasAVX512BF16()) {
+    ParallelCastBlocks(in, out, size, CastFloat32ToBF16BlockAVX512);
+    return;
+  }
+#endif  // MXNET_AMP_CAST_AVX512_BF16
+  ParallelCastBlocks(in, out, size, CastFloat32ToBF16Block);
+}
+
+void CastBF16ToFloat32(const uint16_t* in, float* out, index_t size) {
+  ParallelCastBlocks(in, out, size, CastBF16ToFloat32Block);
+}
+
 #if MXNET_USE_MKLDNN == 1
 static void AMPCastExCPU(const nnvm::NodeAttrs& attrs,
                     const OpContext& ctx,
@@ -124,6 +124,38 @@ inline bool AMPMultiCastShape(const nnvm::NodeAttrs& attrs,
   return all_inferred;
 }
 
+/*!
+ * \brief Vectorized fp32 <-> bf16 conversion on CPU. Narrowing rounds to nearest
+ *  even, and uses the AVX512-BF16 instructions when the CPU supports them.
+ */
+void CastFloat32ToBF16(const float* in, uint16_t* out, index_t size);
+void CastBF16ToFloat32(const uint16_t* in, float* out, index_t size);
+
+/*!
+ * \brief Run the dedicated fp32 <-> bf16 conversion when it applies.
+ * \return whether the cast was handled
+ */
+template<typename xpu>
+inline bool FastBF16Cast(const TBlob& in, const TBlob& out, OpReqType req) {
+  return false;
+}
+
+template<>
+inline bool FastBF16Cast<cpu>(const TBlob& in, const TBlob& out, OpReqType req) {
+  using mshadow::kFloat32;
+  using mshadow::kBfloat16;
+  if (req != kWriteTo) return false;
+  if (in.type_flag_ == kFloat32 && out.type_flag_ == kBfloat16) {
+    CastFloat32ToBF16(in.dptr<float>(), reinterpret_cast<uint16_t*>(out.dptr_), in.Size());
+    return true;
+  }
+  if (in.type_flag_ == kBfloat16 && out.type_flag_ == kFloat32) {
+    CastBF16ToFloat32(reinterpret_cast<const uint16_t*>(in.dptr_), out.dptr<float>(), in.Size());
+    return true;
+  }
+  return false;
+}
+
 template<typename xpu>
 void AMPCastCompute(const nnvm::NodeAttrs& attrs,
                     const OpContext& ctx,
@@ -133,6 +165,7 @@ void AMPCastCompute(const nnvm::NodeAttrs& attrs,
   using namespace mshadow;
   using namespace mshadow::expr;
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  if (FastBF16Cast<xpu>(inputs[0], outputs[0], req[0])) return;
   MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DstDType, {
     Tensor<xpu, 1, DstDType> out = outputs[0].FlatTo1D<xpu, DstDType>(s);
     MSHADOW_TYPE_SWITCH(inputs[0].type_flag_, SrcDType, {
@@ -155,6 +188,7 @@ void AMPMultiCastCompute(const nnvm::NodeAttrs& attrs,
   using namespace mshadow::expr;
   Stream<xpu> *s = ctx.get_stream<xpu>();
   for (size_t i = 0; i < outputs.size(); ++i) {
+    if (FastBF16Cast<xpu>(inputs[i], outputs[i], req[i])) continue;
     MSHADOW_TYPE_SWITCH(outputs[i].type_flag_, DstDType, {
       Tensor<xpu, 1, DstDType> out = outputs[i].FlatTo1D<xpu, DstDType>(s);
       MSHADOW_TYPE_SWITCH(inputs[i].type_flag_, SrcDType, {
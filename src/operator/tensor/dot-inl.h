@@ -348,39 +348,113 @@ inline bool DotBackwardInferStorageType(const nnvm::NodeAttrs& attrs,
   return dispatched;
 }
 
+/*!
+ * \brief out += lhs_row * dns for the non-zeros [begin, end) of one csr row.
+ * The output columns are processed in blocks held in registers while the non-zeros
+ * are streamed, so every output element is loaded and stored once per block.
+ */
+template<typename DType, typename IType, typename CType>
+MSHADOW_CINLINE void CsrRowDotDns(DType* out,
+                                  const DType* data_l,
+                                  const CType* col_idx_l,
+                                  const DType* data_r,
+                                  const IType begin,
+                                  const IType end,
+                                  const nnvm::dim_t num_cols) {
+  using nnvm::dim_t;
+  const dim_t kBlock = 32;
+  dim_t col = 0;
+  for (; col + kBlock <= num_cols; col += kBlock) {
+    DType acc[kBlock] = {0};
+    for (IType k = begin; k < end; ++k) {
+      const DType val = data_l[k];
+      const DType* row_r = data_r + col_idx_l[k] * num_cols + col;
+      for (dim_t l = 0; l < kBlock; ++l) acc[l] += row_r[l] * val;
+    }
+    for (dim_t l = 0; l < kBlock; ++l) out[col + l] += acc[l];
+  }
+  if (col == num_cols) return;
+  const dim_t rest = num_cols - col;
+  DType acc[kBlock] = {0};
+  for (IType k = begin; k < end; ++k) {
+    const DType val = data_l[k];
+    const DType* row_r = data_r + col_idx_l[k] * num_cols + col;
+    for (dim_t l = 0; l < rest; ++l) acc[l] += row_r[l] * val;
+  }
+  for (dim_t l = 0; l < rest; ++l) out[col + l] += acc[l];
+}
+
+/*!
+ * \brief find the coordinate where the merge path of the csr row ends (indptr[1:]) and
+ *  the non-zero indices crosses a diagonal, i.e. the number of rows and of non-zeros
+ *  consumed once `diagonal` of both are consumed in total
+ */
+template<typename IType>
+MSHADOW_CINLINE void CsrMergePathSearch(const nnvm::dim_t diagonal,
+                                        const IType* row_end,
+                                        const nnvm::dim_t num_rows,
+                                        const nnvm::dim_t nnz,
+                                        nnvm::dim_t* row,
+                                        nnvm::dim_t* nz) {
+  using nnvm::dim_t;
+  dim_t lo = std::max<dim_t>(0, diagonal - nnz);
+  dim_t hi = std::min(diagonal, num_rows);
+  while (lo < hi) {
+    const dim_t mid = (lo + hi) / 2;
+    if (static_cast<dim_t>(row_end[mid]) <= diagonal - mid - 1) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *row = lo;
+  *nz = diagonal - lo;
+}
+
 /*!
  * \brief CPU Kernel of dot(csr, dns1) = dns2
- * Parallelization by row blocks
+ * Parallelization by merge path: every part gets the same number of rows plus
+ * non-zeros, so rows with many non-zeros are split across parts. The sum of the last,
+ * partial row of a part is written to `carry` and added to the output afterwards.
  */
-struct DotCsrDnsDnsByRowBlocks {
+struct DotCsrDnsDnsByMergePath {
   /*!
    * \brief
-   * \param i the i-th thread
+   * \param i the i-th part
    */
   template<typename DType, typename IType, typename CType>
   MSHADOW_CINLINE static void Map(int i,
                                   DType* out,
+                                  DType* carry,
+                                  nnvm::dim_t* carry_row,
                                   const DType* data_l,
                                   const IType* indptr_l,
                                   const CType* col_idx_l,
                                   const DType* data_r,
-                                  const nnvm::dim_t seg_len,
+                                  const nnvm::dim_t items_per_part,
                                   const nnvm::dim_t num_rows,
                                   const nnvm::dim_t num_cols) {
     using nnvm::dim_t;
-    const dim_t seg_start = i * seg_len;
-    if (seg_start >= num_rows) return;
-    const dim_t seg_end = std::min(seg_start + seg_len, num_rows);
-    for (dim_t j = seg_start; j < seg_end; ++j) {
-      if (indptr_l[j] == indptr_l[j+1]) continue;
-      const dim_t offset_out = j * num_cols;
-      for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
-        const DType val = data_l[k];
-        const dim_t offset_r = col_idx_l[k] * num_cols;
-        for (dim_t l = 0; l < num_cols; ++l) {
-          out[offset_out+l] += data_r[offset_r+l] * val;
-        }
-      }
+    const dim_t nnz = static_cast<dim_t>(indptr_l[num_rows]);
+    const dim_t total = num_rows + nnz;
+    const dim_t diag_start = std::min(i * items_per_part, total);
+    const dim_t diag_end = std::min(diag_start + items_per_part, total);
+    dim_t row, nz, row_end, nz_end;
+    CsrMergePathSearch(diag_start, indptr_l + 1, num_rows, nnz, &row, &nz);
+    CsrMergePathSearch(diag_end, indptr_l + 1, num_rows, nnz, &row_end, &nz_end);
+    for (; row < row_end; ++row) {
+      const dim_t next = static_cast<dim_t>(indptr_l[row + 1]);
+      CsrRowDotDns(out + row * num_cols, data_l, col_idx_l, data_r,
+                   static_cast<IType>(nz), static_cast<IType>(next), num_cols);
+      nz = next;
+    }
+    carry_row[i] = num_rows;
+    if (row_end < num_rows && nz < nz_end) {
+      DType* carry_out = carry + i * num_cols;
+      std::fill(carry_out, carry_out + num_cols, DType(0));
+      CsrRowDotDns(carry_out, data_l, col_idx_l, data_r,
+                   static_cast<IType>(nz), static_cast<IType>(nz_end), num_cols);
+      carry_row[i] = row_end;
     }
   }
 };
@@ -792,32 +866,39 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
           mxnet_op::Kernel<mxnet_op::set_zero, cpu>::Launch(
               s, num_threads, data_out.dptr<DType>());
         }
-        num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
-        bool dynamic = false;
-        const dim_t large_matrix_threshold = 1024 * 10;
-        if (data_out.shape_[0] > large_matrix_threshold) {
-          dynamic = true;
-          // each unit of work processes at least 1024 elements in the output
-          const dim_t unit_work_per_thread = 1024;
-          num_threads = data_out.Size() / unit_work_per_thread;
-        }
-        dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
         if (trans_lhs) {
+          num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
+          dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
           mxnet_op::Kernel<DotCsrTransDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
               col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
               lhs.shape()[0], data_out.shape_[0], data_out.shape_[1]);
         } else {
-          if (dynamic) {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::LaunchDynamic(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
-          } else {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
+          // balance rows plus non-zeros instead of rows, power-law rows would
+          // otherwise leave most threads idle
+          const dim_t num_rows = data_out.shape_[0];
+          const dim_t num_cols = data_out.shape_[1];
+          const dim_t total = num_rows + static_cast<dim_t>(indptr_l.dptr<IType>()[num_rows]);
+          const dim_t num_parts = std::max<dim_t>(1, std::min<dim_t>(
+              engine::OpenMP::Get()->GetRecommendedOMPThreadCount(), total));
+          const dim_t items_per_part = (total + num_parts - 1) / num_parts;
+          // the rows go first, so that both arrays are aligned for any DType
+          const size_t carry_row_bytes = num_parts * sizeof(dim_t);
+          mshadow::Tensor<cpu, 1, char> workspace = ctx.requested[0]
+            .get_space_typed<cpu, 1, char>(
+              mshadow::Shape1(carry_row_bytes + num_parts * num_cols * sizeof(DType)), s);
+          dim_t* carry_row = reinterpret_cast<dim_t*>(workspace.dptr_);
+          DType* carry = reinterpret_cast<DType*>(workspace.dptr_ + carry_row_bytes);
+          DType* out = data_out.dptr<DType>();
+          mxnet_op::Kernel<DotCsrDnsDnsByMergePath, cpu>::Launch(s, num_parts,
+              out, carry, carry_row, data_l.dptr<DType>(), indptr_l.dptr<IType>(),
+              col_idx_l.dptr<CType>(), data_r.dptr<DType>(), items_per_part,
+              num_rows, num_cols);
+          for (dim_t i = 0; i < num_parts; ++i) {
+            if (carry_row[i] == num_rows) continue;
+            DType* out_row = out + carry_row[i] * num_cols;
+            const DType* carry_out = carry + i * num_cols;
+            for (dim_t l = 0; l < num_cols; ++l) out_row[l] += carry_out[l];
           }
         }
       });
@@ -1452,6 +1533,38 @@ inline bool BatchDotShape(const nnvm::NodeAttrs& attrs,
   return shape_is_known((*out_attrs)[0]);
 }
 
+inline OpCost DotCost(const nnvm::NodeAttrs& attrs,
+                      const mxnet::ShapeVector& in_shapes,
+                      const std::vector<int>& in_types,
+                      const mxnet::ShapeVector& out_shapes,
+                      const std::vector<int>& out_types) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  OpCost cost = ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+  const mxnet::TShape& lshape = in_shapes[0];
+  if (shape_is_known(lshape) && shape_is_known(out_shapes[0]) && lshape.ndim() > 0) {
+    // a multiply-add along the reduced axis of lhs for every output element
+    const index_t k = param.transpose_a ? lshape[0] : lshape[lshape.ndim() - 1];
+    cost.flops = 2 * out_shapes[0].Size() * k;
+  }
+  return cost;
+}
+
+inline OpCost BatchDotCost(const nnvm::NodeAttrs& attrs,
+                           const mxnet::ShapeVector& in_shapes,
+                           const std::vector<int>& in_types,
+                           const mxnet::ShapeVector& out_shapes,
+                           const std::vector<int>& out_types) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  OpCost cost = ArrayOpCost(attrs, in_shapes, in_types, out_shapes, out_types);
+  const mxnet::TShape& lshape = in_shapes[0];
+  if (shape_is_known(lshape) && shape_is_known(out_shapes[0]) && lshape.ndim() >= 2) {
+    const int ndim = lshape.ndim();
+    const index_t k = param.transpose_a ? lshape[ndim - 2] : lshape[ndim - 1];
+    cost.flops = 2 * out_shapes[0].Size() * k;
+  }
+  return cost;
+}
+
 }  // namespace op
 }  // namespace mxnet
 
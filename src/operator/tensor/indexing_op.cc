@@ -363,6 +363,123 @@ void TakeOpForward<cpu>(const nnvm::NodeAttrs& attrs,
   });
 }
 
+/*!
+ * \brief stable parallel LSD radix sort of (key, value) pairs with keys in [0, max_key]
+ * \param keys the keys, sorted in place or into keys_buf
+ * \param values the values moved along with the keys
+ * \param keys_buf scratch of n keys
+ * \param values_buf scratch of n values
+ * \return true if the sorted pairs end up in keys_buf and values_buf
+ */
+static bool ParallelRadixSortPairs(nnvm::dim_t* keys, nnvm::dim_t* values,
+                                   nnvm::dim_t* keys_buf, nnvm::dim_t* values_buf,
+                                   const nnvm::dim_t n, const nnvm::dim_t max_key,
+                                   const int num_threads) {
+  using nnvm::dim_t;
+  const int kRadixBits = 8;
+  const dim_t kRadix = 1 << kRadixBits;
+  const dim_t chunk = (n + num_threads - 1) / num_threads;
+  std::vector<dim_t> offsets(num_threads * kRadix);
+  bool swapped = false;
+  for (int shift = 0; shift == 0 || (max_key >> shift) > 0; shift += kRadixBits) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    #pragma omp parallel for num_threads(num_threads)
+    for (int t = 0; t < num_threads; ++t) {
+      dim_t* hist = offsets.data() + t * kRadix;
+      const dim_t end = std::min(n, (t + 1) * chunk);
+      for (dim_t i = t * chunk; i < end; ++i) ++hist[(keys[i] >> shift) & (kRadix - 1)];
+    }
+    // exclusive scan in (digit, thread) order keeps the sort stable
+    dim_t total = 0;
+    for (dim_t d = 0; d < kRadix; ++d) {
+      for (int t = 0; t < num_threads; ++t) {
+        const dim_t count = offsets[t * kRadix + d];
+        offsets[t * kRadix + d] = total;
+        total += count;
+      }
+    }
+    #pragma omp parallel for num_threads(num_threads)
+    for (int t = 0; t < num_threads; ++t) {
+      dim_t* pos = offsets.data() + t * kRadix;
+      const dim_t end = std::min(n, (t + 1) * chunk);
+      for (dim_t i = t * chunk; i < end; ++i) {
+        const dim_t dst = pos[(keys[i] >> shift) & (kRadix - 1)]++;
+        keys_buf[dst] = keys[i];
+        values_buf[dst] = values[i];
+      }
+    }
+    std::swap(keys, keys_buf);
+    std::swap(values, values_buf);
+    swapped = !swapped;
+  }
+  return swapped;
+}
+
+/*!
+ * \brief row sparse embedding gradient for vocabularies much larger than the batch:
+ *  sorts the indices instead of flagging every row of the vocabulary, so the work and
+ *  the temporary storage are proportional to the number of indices only
+ */
+template<typename IType, typename DType, typename RType>
+static void SparseEmbeddingBackwardSortedCPU(const OpContext& ctx,
+                                             const TBlob& ograd,
+                                             const TBlob& data,
+                                             const NDArray& output) {
+  using namespace mshadow;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape()[1];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  Tensor<cpu, 1, dim_t> workspace =
+    ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, dim_t>(
+      Shape1(4 * data_size + 1), s);
+  dim_t* keys = workspace.dptr_;
+  dim_t* values = keys + data_size;
+  dim_t* keys_buf = values + data_size;
+  dim_t* values_buf = keys_buf + data_size;
+  const IType* data_ptr = data.dptr<IType>();
+  #pragma omp parallel for num_threads(num_threads)
+  for (dim_t i = 0; i < data_size; ++i) {
+    keys[i] = static_cast<dim_t>(data_ptr[i]);
+    values[i] = i;
+  }
+  if (ParallelRadixSortPairs(keys, values, keys_buf, values_buf, data_size, num_rows - 1,
+                             num_threads)) {
+    std::swap(keys, keys_buf);
+    std::swap(values, values_buf);
+  }
+  // the first position of every distinct row, the unused sort buffer is free again
+  dim_t* segments = keys_buf;
+  dim_t nnr = 0;
+  for (dim_t i = 0; i < data_size; ++i) {
+    if (i == 0 || keys[i] != keys[i - 1]) segments[nnr++] = i;
+  }
+  segments[nnr] = data_size;
+  if (nnr == 0) {
+    FillZerosRspImpl(s, output);
+    return;
+  }
+  output.CheckAndAlloc({Shape1(nnr)});
+  RType* grad_row_idx = output.aux_data(kIdx).dptr<RType>();
+  DType* grad_data = output.data().dptr<DType>();
+  const DType* ograd_ptr = ograd.dptr<DType>();
+  // every gradient row is the sum of the output gradients of its segment
+  #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64)
+  for (dim_t j = 0; j < nnr; ++j) {
+    grad_row_idx[j] = static_cast<RType>(keys[segments[j]]);
+    DType* grad_row = grad_data + j * row_length;
+    const DType* first = ograd_ptr + values[segments[j]] * row_length;
+    std::copy(first, first + row_length, grad_row);
+    for (dim_t i = segments[j] + 1; i < segments[j + 1]; ++i) {
+      const DType* ograd_row = ograd_ptr + values[i] * row_length;
+      for (dim_t k = 0; k < row_length; ++k) grad_row[k] += ograd_row[k];
+    }
+  }
+}
+
 template<>
 inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
                                                   const OpContext& ctx,
@@ -379,17 +496,9 @@ inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
   CHECK_EQ(req, kWriteTo) << "SparseEmbedding layer doesn't support "
                           << "weight gradient calculation with req != write";
 
-  // Request temporary storage for marking non-zero rows and prefix sum
   Stream<cpu> *s = ctx.get_stream<cpu>();
   dim_t num_rows = output.shape()[0];
   dim_t row_length = output.shape()[1];
-  size_t workspace_size = num_rows * sizeof(dim_t);
-  Tensor<cpu, 1, char> workspace =
-    ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, char>(
-      Shape1(workspace_size), s);
-  dim_t* row_flg = reinterpret_cast<dim_t*>(workspace.dptr_);
-  // prefix sum array re-uses the row_flg array temp space
-  dim_t* prefix_sum = row_flg;
   dim_t data_size = static_cast<dim_t>(data.shape_.Size());
 
   MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
@@ -404,6 +513,19 @@ inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
           bool is_valid = CheckIndexOutOfBound(data_ptr, data.shape_.Size(), min, max);
           CHECK(is_valid) << "Embedding input contains data out of bound";
         }
+        // for large vocabularies, flagging and scanning every row costs more than
+        // sorting the indices
+        if (num_rows > data_size) {
+          SparseEmbeddingBackwardSortedCPU<IType, DType, RType>(ctx, ograd, data, output);
+          return;
+        }
+        // Request temporary storage for marking non-zero rows and prefix sum
+        Tensor<cpu, 1, char> workspace =
+          ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, char>(
+            Shape1(num_rows * sizeof(dim_t)), s);
+        dim_t* row_flg = reinterpret_cast<dim_t*>(workspace.dptr_);
+        // prefix sum array re-uses the row_flg array temp space
+        dim_t* prefix_sum = row_flg;
         // mark row flags
         Fill<false>(s, TBlob(row_flg, Shape1(num_rows), cpu::kDevMask), kWriteTo, 0);
         Kernel<MarkRowFlgKernel, cpu>::Launch(s, data_size, row_flg, data.dptr<IType>());
@@ -222,46 +222,76 @@ struct fill_ind {
   }
 };
 
+/*!
+ * \brief strict total order of indices by their values, ties are broken by the
+ *  smaller index first so that the result does not depend on the selection algorithm
+ */
+template<typename DType>
+struct TopKIndexCompare {
+  const DType* vals;
+  bool is_ascend;
+  bool operator()(const index_t& i1, const index_t& i2) const {
+    if (vals[i1] == vals[i2]) return i1 < i2;
+    return is_ascend ? vals[i1] < vals[i2] : vals[i1] > vals[i2];
+  }
+};
+
+/*!
+ * \brief moves the K first indices of [first, last) in the order of `cmp` to the front,
+ *  sorted. Selection is O(N), only the K selected indices are sorted.
+ */
+template<typename DType>
+inline void TopKSelect(index_t* first, index_t* last, index_t K,
+                       const TopKIndexCompare<DType>& cmp) {
+  if (K < last - first) {
+    std::nth_element(first, first + K, last, cmp);
+  }
+  std::sort(first, first + std::min<index_t>(K, last - first), cmp);
+}
+
 template<typename DType>
 MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
                                    const Tensor<cpu, 1, index_t>& ind,
                                    const Tensor<cpu, 1, char>& work,
                                    index_t K, index_t N, bool is_ascend,
                                    Stream<cpu> *s) {
-  // Use full sort when K is relatively large.
-  const bool full_sort(K*8 > N);
   // Batch size.
   const index_t M(work.size(0)/(sizeof(DType)*N));
   const int omp_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
+  // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
+  const TopKIndexCompare<DType> cmp{reinterpret_cast<DType*>(work.dptr_), is_ascend};
+  // Few very long rows, e.g. scores of many candidates: split every row into chunks,
+  // select the top K of every chunk in parallel, then select among the candidates.
+  const index_t min_chunk = 1 << 15;
+  const index_t num_chunks = std::min<index_t>(omp_threads, N / std::max(min_chunk, 4 * K));
+  if (M < omp_threads && num_chunks > 1) {
+    const index_t chunk = (N + num_chunks - 1) / num_chunks;
+    for (index_t i = 0; i < M; ++i) {
+      index_t *indices = ind.dptr_+i*N;
+      #pragma omp parallel for num_threads(omp_threads)
+      for (index_t c = 0; c < num_chunks; ++c) {
+        TopKSelect(indices + c * chunk, indices + std::min(N, (c + 1) * chunk), K, cmp);
+      }
+      // chunk c >= K indices long, so moving its candidates to c*K never overtakes
+      // a chunk that was not moved yet
+      for (index_t c = 1; c < num_chunks; ++c) {
+        std::copy(indices + c * chunk, indices + c * chunk + K, indices + c * K);
+      }
+      TopKSelect(indices, indices + num_chunks * K, K, cmp);
+      DType *sorted_vals = dat.dptr_+i*N;
+      for (index_t j = 0; j < K; ++j) {
+        sorted_vals[j] = cmp.vals[indices[j]];
+      }
+    }
+    return;
+  }
   #pragma omp parallel for num_threads(omp_threads)
   for (index_t i = 0; i < M; ++i) {
-    // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
-    DType *vals = reinterpret_cast<DType*>(work.dptr_);
     DType *sorted_vals = dat.dptr_+i*N;
     index_t *indices = ind.dptr_+i*N;
-    if (is_ascend) {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
-      }
-    } else {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
-      }
-    }
+    TopKSelect(indices, indices + N, K, cmp);
     for (index_t j = 0; j < K; ++j) {
-      sorted_vals[j] = vals[indices[j]];
+      sorted_vals[j] = cmp.vals[indices[j]];
     }
   }
 }
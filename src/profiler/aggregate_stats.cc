@@ -47,6 +47,19 @@ inline float ByteToKilobyte(const DType byte) {
   return static_cast<float>(static_cast<double>(byte) / 1000);
 }
 
+/*! \brief billions of flops or bytes per second over a duration in microseconds */
+inline float GigaPerSecond(const uint64_t units, const uint64_t micro) {
+  return micro ? static_cast<float>(static_cast<double>(units) / micro / 1000) : 0;
+}
+
+/*! \brief whether any operator of the category has a cost to report throughput from */
+inline bool HasCost(const std::unordered_map<std::string, AggregateStats::StatData>& map) {
+  for (const auto& iter : map) {
+    if (iter.second.total_flops_ || iter.second.total_bytes_) return true;
+  }
+  return false;
+}
+
 inline std::priority_queue<pi>
   BuildHeap(const std::unordered_map<std::string, AggregateStats::StatData>& map,
             int sort_by, int ascending) {
@@ -90,6 +103,10 @@ void AggregateStats::OnProfileStat(const ProfileStat& stat) {
   std::unique_lock<std::mutex> lk(m_);
   if (stat.enable_aggregate_) {
     stat.SaveAggregate(&stats_[stat.categories_.c_str()][stat.name_.c_str()]);
+    const char *group = stat.AggregateGroup();
+    if (group) {
+      stat.SaveAggregate(&stats_["CachedOp"][group]);
+    }
   }
 }
 
@@ -105,6 +122,7 @@ void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
     const std::string& type = stat.first;
     const std::unordered_map<std::string, StatData>& mm = stat.second;
     bool is_memory = (type == "Device Storage"  || type == "Pool Memory");
+    const bool has_cost = !is_memory && HasCost(mm);
     os << type << std::endl << "=================" << std::endl;
     os << std::setw(25) << std::left  << "Name"
         << std::setw(16) << std::right << "Total Count"
@@ -119,8 +137,12 @@ void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
         << (is_memory ? "Max Use  (kB)" : "Max Time (ms)")
         << " "
         << std::setw(16) << std::right
-        << (is_memory ? "Avg Use  (kB)" : "Avg Time (ms)")
-        << std::endl;
+        << (is_memory ? "Avg Use  (kB)" : "Avg Time (ms)");
+    if (has_cost) {
+      os << " " << std::setw(16) << std::right << "GFLOP/s"
+         << " " << std::setw(16) << std::right << "GB/s";
+    }
+    os << std::endl;
     os << std::setw(25) << std::left  << "----"
         << std::setw(16) << std::right << "-----------"
         << " "
@@ -134,8 +156,12 @@ void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
         << "-------------"
         << " "
         << std::setw(16) << std::right
-        << "-------------"
-        << std::endl;
+        << "-------------";
+    if (has_cost) {
+      os << " " << std::setw(16) << std::right << "-------"
+         << " " << std::setw(16) << std::right << "----";
+    }
+    os << std::endl;
     auto heap = BuildHeap(mm, sort_by, ascending);
     while (!heap.empty()) {
       const std::string& name = heap.top().second;
@@ -157,6 +183,12 @@ void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
            << (data.type_ == AggregateStats::StatData::kCounter ?
                     ByteToKilobyte((data.max_aggregate_ - data.min_aggregate_) / 2) :
                     MicroToMilli(static_cast<double>(data.total_aggregate_)/ data.total_count_));
+        if (has_cost) {
+          os << " " << std::fixed << std::setw(16) << std::setprecision(4) << std::right
+             << GigaPerSecond(data.total_flops_, data.total_aggregate_)
+             << " " << std::fixed << std::setw(16) << std::setprecision(4) << std::right
+             << GigaPerSecond(data.total_bytes_, data.total_aggregate_);
+        }
         os << std::endl;
       }
       heap.pop();
@@ -217,8 +249,18 @@ void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
             << std::setprecision(4)
             << (data.type_ == AggregateStats::StatData::kCounter ?
                  ByteToKilobyte((data.max_aggregate_ - data.min_aggregate_) / 2) :
-                 MicroToMilli(static_cast<double>(data.total_aggregate_) /  data.total_count_))
-            << std::endl
+                 MicroToMilli(static_cast<double>(data.total_aggregate_) /  data.total_count_));
+        if (!is_memory && (data.total_flops_ || data.total_bytes_)) {
+          *ss << "," << std::endl
+              << "                \"GFLOP/s\": "
+              << std::setprecision(4)
+              << GigaPerSecond(data.total_flops_, data.total_aggregate_)
+              << "," << std::endl
+              << "                \"GB/s\": "
+              << std::setprecision(4)
+              << GigaPerSecond(data.total_bytes_, data.total_aggregate_);
+        }
+        *ss << std::endl
             << "            }" << std::endl;
       }
       heap.pop();
@@ -49,6 +49,10 @@ class AggregateStats {
     uint64_t  total_aggregate_ = 0;
     uint64_t  max_aggregate_ = 0;
     uint64_t  min_aggregate_ = INT_MAX;
+    /*! \brief floating point operations of the operators with a cost */
+    uint64_t  total_flops_ = 0;
+    /*! \brief bytes read and written by the operators with a cost */
+    uint64_t  total_bytes_ = 0;
   };
 
   /*!
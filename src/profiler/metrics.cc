@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file metrics.cc
+ * \brief Runtime metrics exported in the OpenMetrics text format
+ */
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include "./metrics.h"
+#include "./op_histogram.h"
+
+namespace mxnet {
+namespace profiler {
+
+namespace {
+
+/*! \brief upper bounds in seconds of the buckets exported for latency histograms */
+const double kLatencyBounds[] = {
+  1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3,
+  5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+void WriteValue(std::ostream& os, double value) {
+  if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+    os << static_cast<int64_t>(value);
+  } else {
+    os << std::setprecision(std::numeric_limits<double>::digits10) << value;
+  }
+}
+
+void WriteLabels(std::ostream& os, const Metrics::Labels& labels, const char* le = nullptr) {
+  if (labels.empty() && le == nullptr) return;
+  os << '{';
+  const char* sep = "";
+  for (const auto& label : labels) {
+    os << sep << label.first << "=\"";
+    for (char c : label.second) {
+      if (c == '\\' || c == '"') {
+        os << '\\' << c;
+      } else if (c == '\n') {
+        os << "\\n";
+      } else {
+        os << c;
+      }
+    }
+    os << '"';
+    sep = ",";
+  }
+  if (le != nullptr) os << sep << "le=\"" << le << '"';
+  os << '}';
+}
+
+void WriteFamily(std::ostream& os, const std::string& name, const char* type,
+                 const std::string& help) {
+  os << "# TYPE " << name << ' ' << type << '\n'
+     << "# HELP " << name << ' ' << help << '\n';
+}
+
+/*!
+ * \brief write the histograms of a category with one series per name, or a single
+ *  series when label is null. A fine bucket is counted in the first exported bucket
+ *  holding all of it, so cumulative counts are low by at most 1/16 of the bound.
+ */
+void WriteHistograms(std::ostream& os, const std::string& name, const std::string& help,
+                     OpHistograms::Category category, const char* label) {
+  std::map<std::string, OpHistograms::Total> totals = OpHistograms::Get()->Totals(category);
+  if (label == nullptr && totals.size() > 1) {
+    OpHistograms::Total merged;
+    for (const auto& kv : totals) {
+      for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+        merged.counts[i] += kv.second.counts[i];
+      }
+      merged.sum += kv.second.sum;
+    }
+    totals.clear();
+    totals.emplace("", std::move(merged));
+  }
+  WriteFamily(os, name, "histogram", help);
+  for (const auto& kv : totals) {
+    Metrics::Labels labels;
+    if (label != nullptr) labels.emplace_back(label, kv.first);
+    const OpHistograms::Total& total = kv.second;
+    uint64_t count = 0;
+    int i = 0;
+    for (double bound : kLatencyBounds) {
+      const uint64_t bound_ns = static_cast<uint64_t>(bound * 1e9);
+      for (; i < LatencyHistogram::kNumBuckets &&
+             LatencyHistogram::BucketUpperBound(i) - 1 <= bound_ns; ++i) {
+        count += total.counts[i];
+      }
+      std::ostringstream le;
+      le << bound;
+      os << name << "_bucket";
+      WriteLabels(os, labels, le.str().c_str());
+      os << ' ' << count << '\n';
+    }
+    for (; i < LatencyHistogram::kNumBuckets; ++i) count += total.counts[i];
+    os << name << "_bucket";
+    WriteLabels(os, labels, "+Inf");
+    os << ' ' << count << '\n';
+    os << name << "_count";
+    WriteLabels(os, labels);
+    os << ' ' << count << '\n';
+    os << name << "_sum";
+    WriteLabels(os, labels);
+    os << ' ';
+    WriteValue(os, total.sum / 1e9);
+    os << '\n';
+  }
+}
+
+}  // namespace
+
+Metrics* Metrics::Get() {
+  // Never destroyed, since engines and storage remove their collectors at exit.
+  static Metrics* inst = new Metrics();
+  return inst;
+}
+
+std::atomic<uint64_t>* Metrics::Counter(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<CounterEntry>& entry = counters_[name];
+  if (!entry) {
+    entry.reset(new CounterEntry());
+    entry->help = help;
+  }
+  return &entry->value;
+}
+
+int Metrics::AddCollector(Collector collector) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const int id = next_collector_id_++;
+  collectors_.emplace(id, std::move(collector));
+  return id;
+}
+
+void Metrics::RemoveCollector(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  collectors_.erase(id);
+}
+
+void Metrics::Render(std::ostream& os) {
+  std::vector<Gauge> gauges;
+  std::map<std::string, std::pair<std::string, uint64_t>> counters;
+  {
+    // Collectors run under the lock, so their owners cannot go away meanwhile.
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& kv : collectors_) kv.second(&gauges);
+    for (const auto& kv : counters_) {
+      counters[kv.first] = {kv.second->help, kv.second->value.load(std::memory_order_relaxed)};
+    }
+  }
+  std::map<std::string, std::vector<const Gauge*>> families;
+  for (const Gauge& gauge : gauges) families[gauge.name].push_back(&gauge);
+  for (const auto& kv : families) {
+    WriteFamily(os, kv.first, "gauge", kv.second.front()->help);
+    for (const Gauge* gauge : kv.second) {
+      os << gauge->name;
+      WriteLabels(os, gauge->labels);
+      os << ' ';
+      WriteValue(os, gauge->value);
+      os << '\n';
+    }
+  }
+  for (const auto& kv : counters) {
+    WriteFamily(os, kv.first, "counter", kv.second.first);
+    os << kv.first << "_total " << kv.second.second << '\n';
+  }
+  WriteHistograms(os, "mxnet_operator_latency_seconds",
+                  "Latency of the operators run by the engine, from start to completion.",
+                  OpHistograms::kOperator, "op");
+  WriteHistograms(os, "mxnet_node_latency_seconds",
+                  "Latency of the nodes of hybridized graphs run in bulked segments on CPU.",
+                  OpHistograms::kNode, "node");
+  WriteHistograms(os, "mxnet_dataloader_wait_seconds",
+                  "Time the DataLoader iterators block for the next batch.",
+                  OpHistograms::kDataLoader, nullptr);
+  os << "# EOF\n";
+}
+
+}  // namespace profiler
+}  // namespace mxnet
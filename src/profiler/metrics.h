@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file metrics.h
+ * \brief Runtime metrics exported in the OpenMetrics text format
+ */
+#ifndef MXNET_PROFILER_METRICS_H_
+#define MXNET_PROFILER_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace profiler {
+
+/*!
+ * \brief Registry of the runtime metrics scraped by Prometheus or any other
+ *  OpenMetrics collector, independent of the profiler state.
+ *
+ *  Counters are atomics that their owners increment. Gauges describe state such
+ *  as queue depths or pooled memory, and are read on demand by collectors that
+ *  components add when created and remove when destroyed. The operator and
+ *  DataLoader latency histograms come from OpHistograms.
+ */
+class Metrics {
+ public:
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+  /*! \brief a gauge value read by a collector */
+  struct Gauge {
+    std::string name;
+    std::string help;
+    Labels labels;
+    double value;
+  };
+  using Collector = std::function<void(std::vector<Gauge>*)>;
+
+  static Metrics* Get();
+
+  /*! \brief the counter of a name, created on first use and valid forever */
+  std::atomic<uint64_t>* Counter(const std::string& name, const std::string& help);
+  /*! \brief add a collector of gauges, returning the id to remove it with */
+  int AddCollector(Collector collector);
+  /*! \brief remove a collector, waiting for a render that runs it to finish */
+  void RemoveCollector(int id);
+
+  /*! \brief write every metric in the OpenMetrics text format */
+  void Render(std::ostream& os);
+
+ private:
+  struct CounterEntry {
+    std::string help;
+    std::atomic<uint64_t> value{0};
+  };
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<CounterEntry>> counters_;
+  std::map<int, Collector> collectors_;
+  int next_collector_id_{0};
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_PROFILER_METRICS_H_
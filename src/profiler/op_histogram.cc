@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file op_histogram.cc
+ * \brief Always-on latency histograms of operators
+ */
+#include <dmlc/json.h>
+#include <dmlc/parameter.h>
+#include <dmlc/thread_local.h>
+#include <unordered_map>
+#include "./op_histogram.h"
+
+namespace mxnet {
+namespace profiler {
+
+namespace {
+
+/*! \brief histograms of the calling thread */
+struct LocalHistograms {
+  std::unordered_map<std::string, LatencyHistogram*> tables[OpHistograms::kNumCategories];
+};
+
+/*! \brief histograms of one name merged over threads */
+struct HistogramSummary {
+  std::vector<uint64_t> counts = std::vector<uint64_t>(LatencyHistogram::kNumBuckets, 0);
+  uint64_t sum{0};
+  uint64_t min{std::numeric_limits<uint64_t>::max()};
+  uint64_t max{0};
+
+  /*! \brief highest duration of the bucket holding the quantile, bounded by the max */
+  uint64_t Quantile(uint64_t count, double q) const {
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return std::min(LatencyHistogram::BucketUpperBound(i) - 1, max);
+      }
+    }
+    return max;
+  }
+
+  void Save(dmlc::JSONWriter* writer) const {
+    uint64_t count = 0;
+    std::vector<std::vector<uint64_t>> buckets;
+    for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+      if (counts[i] == 0) continue;
+      count += counts[i];
+      buckets.push_back({LatencyHistogram::BucketLowerBound(i),
+                         LatencyHistogram::BucketUpperBound(i), counts[i]});
+    }
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("count", count);
+    writer->WriteObjectKeyValue("sum_ns", sum);
+    writer->WriteObjectKeyValue("min_ns", count ? min : 0);
+    writer->WriteObjectKeyValue("max_ns", max);
+    writer->WriteObjectKeyValue("p50_ns", count ? Quantile(count, 0.5) : 0);
+    writer->WriteObjectKeyValue("p90_ns", count ? Quantile(count, 0.9) : 0);
+    writer->WriteObjectKeyValue("p99_ns", count ? Quantile(count, 0.99) : 0);
+    writer->WriteObjectKeyValue("p999_ns", count ? Quantile(count, 0.999) : 0);
+    // lower bound, upper bound and count of the buckets that are not empty
+    writer->WriteObjectKeyValue("buckets", buckets);
+    writer->EndObject();
+  }
+};
+
+}  // namespace
+
+std::atomic<bool> OpHistograms::enabled_{dmlc::GetEnv("MXNET_OP_HISTOGRAMS", false)};
+
+OpHistograms* OpHistograms::Get() {
+  // Never destroyed, since engine threads may record while the process exits.
+  static OpHistograms* inst = new OpHistograms();
+  return inst;
+}
+
+LatencyHistogram* OpHistograms::Register(Category category, const std::string& name) {
+  std::unique_ptr<Entry> entry(new Entry());
+  entry->category = category;
+  entry->name = name;
+  LatencyHistogram* hist = &entry->hist;
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.push_back(std::move(entry));
+  return hist;
+}
+
+void OpHistograms::Record(Category category, const std::string& name, uint64_t ns) {
+  auto& table = dmlc::ThreadLocalStore<LocalHistograms>::Get()->tables[category];
+  auto it = table.find(name);
+  if (it == table.end()) {
+    it = table.emplace(name, Register(category, name)).first;
+  }
+  it->second->Record(ns);
+}
+
+void OpHistograms::Snapshot(std::ostream& os, bool reset) {
+  static const char* category_names[kNumCategories] = {"operator", "node", "dataloader"};
+  std::map<std::string, std::map<std::string, HistogramSummary>> summaries;
+  for (const char* category : category_names) summaries[category];
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+      HistogramSummary& summary = summaries[category_names[entry->category]][entry->name];
+      LatencyHistogram& hist = entry->hist;
+      for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+        const uint64_t count = hist.count(i);
+        summary.counts[i] += count - entry->baseline[i];
+        if (reset) entry->baseline[i] = count;
+      }
+      const uint64_t sum = hist.sum();
+      summary.sum += sum - entry->sum_baseline;
+      if (reset) entry->sum_baseline = sum;
+      summary.min = std::min(summary.min, hist.TakeMin(reset));
+      summary.max = std::max(summary.max, hist.TakeMax(reset));
+    }
+  }
+  dmlc::JSONWriter writer(&os);
+  writer.Write(summaries);
+}
+
+std::map<std::string, OpHistograms::Total> OpHistograms::Totals(Category category) {
+  std::map<std::string, Total> totals;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& entry : entries_) {
+    if (entry->category != category) continue;
+    Total& total = totals[entry->name];
+    for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+      total.counts[i] += entry->hist.count(i);
+    }
+    total.sum += entry->hist.sum();
+  }
+  return totals;
+}
+
+}  // namespace profiler
+}  // namespace mxnet
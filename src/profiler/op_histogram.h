@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file op_histogram.h
+ * \brief Always-on latency histograms of operators
+ */
+#ifndef MXNET_PROFILER_OP_HISTOGRAM_H_
+#define MXNET_PROFILER_OP_HISTOGRAM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace profiler {
+
+/*!
+ * \brief Latency histogram with power of two ranges split into kSubBuckets linear
+ *  buckets, so a bucket spans at most 1/kSubBuckets of its lower bound.
+ *
+ *  Only the thread owning the histogram records into it, with relaxed loads and
+ *  stores instead of read-modify-write instructions. Readers see every count
+ *  untorn, and reset the extremes with atomic exchanges.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  /*! \brief durations of 2^kMaxBits ns, about 18 minutes, or longer share the last bucket */
+  static constexpr int kMaxBits = 40;
+  static constexpr int kNumBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+  LatencyHistogram() {
+    for (auto& count : counts_) count.store(0, std::memory_order_relaxed);
+  }
+
+  /*! \brief bucket of a duration in ns */
+  static int BucketIndex(uint64_t ns) {
+    ns = std::min<uint64_t>(ns, (uint64_t(1) << kMaxBits) - 1);
+    if (ns < kSubBuckets) return static_cast<int>(ns);
+    int msb = 63;
+    while (!(ns >> msb)) --msb;
+    const int shift = msb - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + static_cast<int>((ns >> shift) - kSubBuckets);
+  }
+  /*! \brief smallest duration in the bucket */
+  static uint64_t BucketLowerBound(int index) {
+    if (index < kSubBuckets) return index;
+    const int shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+  }
+  /*! \brief smallest duration past the bucket */
+  static uint64_t BucketUpperBound(int index) {
+    if (index < kSubBuckets) return index + 1;
+    const int shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets + 1) << shift;
+  }
+
+  /*! \brief record a duration, only called by the owning thread */
+  void Record(uint64_t ns) {
+    auto& count = counts_[BucketIndex(ns)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum_.store(sum_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    // The extremes are reset by readers, so they are only updated by compare and
+    // swap, which is rare once they settle.
+    uint64_t cur = min_.load(std::memory_order_relaxed);
+    while (ns < cur && !min_.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+    cur = max_.load(std::memory_order_relaxed);
+    while (ns > cur && !max_.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+  }
+
+  uint64_t count(int index) const { return counts_[index].load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  /*! \brief extremes recorded since the last reset, optionally starting over */
+  uint64_t TakeMin(bool reset) {
+    return reset ? min_.exchange(std::numeric_limits<uint64_t>::max())
+                 : min_.load(std::memory_order_relaxed);
+  }
+  uint64_t TakeMax(bool reset) {
+    return reset ? max_.exchange(0) : max_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> counts_[kNumBuckets];
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> min_{std::numeric_limits<uint64_t>::max()};
+  std::atomic<uint64_t> max_{0};
+};
+
+/*!
+ * \brief Per operator latency histograms, enabled with MXNET_OP_HISTOGRAMS or
+ *  MXProfileSetOpHistograms and independent of the profiler state.
+ *
+ *  Every thread records into histograms of its own, found through a thread local
+ *  table, so recording takes no lock. A snapshot merges the histograms of all
+ *  threads; resetting it moves a baseline instead of clearing the counts under
+ *  the recording threads.
+ */
+class OpHistograms {
+ public:
+  /*! \brief what a histogram measures */
+  enum Category {
+    /*! \brief operators run by the engine, from start to completion */
+    kOperator = 0,
+    /*! \brief nodes of CachedOp graphs run in bulked segments on CPU */
+    kNode = 1,
+    /*! \brief time the DataLoader iterator blocks for the next batch */
+    kDataLoader = 2,
+    kNumCategories = 3
+  };
+  /*! \brief counts and sum of the histograms of one name, merged over threads */
+  struct Total {
+    std::vector<uint64_t> counts = std::vector<uint64_t>(LatencyHistogram::kNumBuckets, 0);
+    uint64_t sum{0};
+  };
+
+  static OpHistograms* Get();
+
+  /*! \brief whether recording is enabled */
+  static bool Enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  /*! \brief enable or disable recording, returning the previous state */
+  static bool SetEnabled(bool enabled) {
+    return enabled_.exchange(enabled);
+  }
+  /*! \brief current time for durations passed to Record */
+  static uint64_t NowInNanosec() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /*! \brief record a duration in the histogram of the calling thread */
+  void Record(Category category, const std::string& name, uint64_t ns);
+
+  /*!
+   * \brief write the merged histograms as JSON, keyed on the category and the name
+   * \param reset whether the next snapshot only covers durations recorded after this one
+   */
+  void Snapshot(std::ostream& os, bool reset);
+
+  /*!
+   * \brief the merged histograms of a category keyed on the name, counting every
+   *  duration since the start regardless of the resets of Snapshot
+   */
+  std::map<std::string, Total> Totals(Category category);
+
+ private:
+  struct Entry {
+    Category category;
+    std::string name;
+    LatencyHistogram hist;
+    // counts and sum at the last reset
+    std::vector<uint64_t> baseline = std::vector<uint64_t>(LatencyHistogram::kNumBuckets, 0);
+    uint64_t sum_baseline{0};
+  };
+  /*! \brief the histogram of the calling thread, created on first use */
+  LatencyHistogram* Register(Category category, const std::string& name);
+
+  static std::atomic<bool> enabled_;
+  std::mutex mutex_;
+  // entries of all threads, never freed so that thread local tables stay valid
+  std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_PROFILER_OP_HISTOGRAM_H_
@@ -128,11 +128,14 @@ void Profiler::SetConfig(int mode,
                          std::string output_filename,
                          bool continuous_dump,
                          float dump_period,
-                         bool aggregate_stats) {
+                         bool aggregate_stats,
+                         bool binary_trace) {
   CHECK(!continuous_dump || dump_period > 0);
   std::lock_guard<std::recursive_mutex> lock{this->m_};
   this->mode_ = mode;
   this->filename_ = output_filename;
+  this->binary_trace_ = binary_trace;
+  this->trace_header_written_ = false;
   // Remove the output file to start
   if (!this->filename_.empty()) {
     ::unlink(this->filename_.c_str());
@@ -141,10 +144,10 @@ void Profiler::SetConfig(int mode,
   // Adjust whether storing aggregate stats as necessary
   if (aggregate_stats) {
     if (!aggregate_stats_) {
-      aggregate_stats_ = std::make_shared<AggregateStats>();
+      std::atomic_store(&aggregate_stats_, std::make_shared<AggregateStats>());
     }
   } else if (aggregate_stats_) {
-    aggregate_stats_.reset();
+    std::atomic_store(&aggregate_stats_, std::shared_ptr<AggregateStats>());
   }
 }
 
@@ -168,6 +171,10 @@ void Profiler::DumpProfile(bool perform_cleanup) {
   if (!IsEnableOutput()) {
     return;
   }
+  if (binary_trace_) {
+    DumpTrace(perform_cleanup);
+    return;
+  }
   if (perform_cleanup) {
     SetContinuousProfileDump(false, 1.0f);
   }
@@ -253,6 +260,51 @@ void Profiler::DumpProfile(bool perform_cleanup) {
                                                     // Otherwise, profiling stops.
 }
 
+void Profiler::DumpTrace(bool perform_cleanup) {
+  std::lock_guard<std::recursive_mutex> lock{this->m_};
+  if (perform_cleanup) {
+    SetContinuousProfileDump(false, 1.0f);
+  }
+  const bool new_file = !trace_header_written_;
+  const bool last_pass = perform_cleanup || !continuous_dump_;
+  ++profile_dump_count_;
+  std::ofstream file(filename_, std::ios::binary | std::ios::out |
+                                (new_file ? std::ios::trunc : std::ios::app));
+  if (new_file) {
+    const uint32_t header[] = {TraceRecord::kVersion, sizeof(TraceRecord)};
+    file.write("MXTRACE", 8);
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    const uint32_t dev_num = DeviceCount();
+    const uint32_t chunk[] = {TraceRecord::kDeviceChunk, dev_num};
+    file.write(reinterpret_cast<const char *>(chunk), sizeof(chunk));
+    for (uint32_t pid = 0; pid < dev_num; ++pid) {
+      const std::string &name = profile_stat[pid].dev_name_;
+      const uint32_t entry[] = {pid, static_cast<uint32_t>(name.size())};
+      file.write(reinterpret_cast<const char *>(entry), sizeof(entry));
+      file.write(name.data(), name.size());
+    }
+    trace_header_written_ = true;
+  }
+  // Statistics queued before the binary trace was configured, recorded as if this
+  // thread ran them.
+  for (uint32_t i = 0; i < DeviceCount(); ++i) {
+    ProfileStat *_opr_stat;
+    while (profile_stat[i].opr_exec_stats_->try_dequeue(_opr_stat)) {
+      std::unique_ptr<ProfileStat> opr_stat(_opr_stat);
+      opr_stat->EmitTrace(i);
+      OnTraceStat(*opr_stat);
+    }
+  }
+  ProfileStat *_profile_stat;
+  while (general_stats_.opr_exec_stats_->try_dequeue(_profile_stat)) {
+    std::unique_ptr<ProfileStat> profile_stat(_profile_stat);
+    profile_stat->EmitTrace(TraceRecord::kNoDevice);
+    OnTraceStat(*profile_stat);
+  }
+  TraceBuffer::Get()->Flush(&file, new_file);
+  enable_output_ = continuous_dump_ && !last_pass;
+}
+
 static constexpr char TIMER_THREAD_NAME[] = "DumpProfileTimer";
 
 void Profiler::SetContinuousProfileDump(bool continuous_dump, float delay_in_seconds) {
@@ -27,6 +27,7 @@
 
 #include <dmlc/concurrentqueue.h>
 #include <dmlc/thread_group.h>
+#include <dmlc/thread_local.h>
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -36,6 +37,7 @@
 #include "./vtune.h"
 #include "./aggregate_stats.h"
 #include "./nvtx.h"
+#include "./trace_buffer.h"
 #include "../common/utils.h"
 
 
@@ -173,6 +175,26 @@ struct ProfileStat {
     }
   }
 
+  /*!
+   * \brief Append the sub-events to the binary trace of the calling thread
+   * \param pid Device index, or TraceRecord::kNoDevice
+   */
+  void EmitTrace(uint32_t pid) const {
+    TraceBuffer *buffer = TraceBuffer::Get();
+    TraceRecord record = {};
+    record.value = TraceValue();
+    record.name = buffer->Intern(name_.c_str());
+    record.category = buffer->Intern(categories_.c_str());
+    record.pid = pid;
+    for (const SubEvent &ev : items_) {
+      if (ev.enabled_) {
+        record.timestamp = ev.timestamp_;
+        record.phase = static_cast<char>(ev.event_type_);
+        buffer->Append(record);
+      }
+    }
+  }
+
   /*!
    * \brief Virtual destructor
    */
@@ -188,6 +210,12 @@ struct ProfileStat {
     }
   }
 
+  /*!
+   * \brief Override to also aggregate this stat under the CachedOp that caused it
+   * \return Name of the CachedOp, or nullptr
+   */
+  virtual const char *AggregateGroup() const { return nullptr; }
+
  protected:
   /*!
    * \brief Override to emit extra items within the json event data block. Append with a comma ",".
@@ -196,6 +224,12 @@ struct ProfileStat {
    */
   virtual void EmitExtra(std::ostream *os, size_t idx) {}
 
+  /*!
+   * \brief Override to keep the data of EmitExtra that the binary trace format supports
+   * \return Value of the trace records, see TraceRecord::value
+   */
+  virtual uint64_t TraceValue() const { return 0; }
+
   /*!
    * \brief Emit sub-event statistics
    * \param os Output stream
@@ -278,11 +312,14 @@ class Profiler {
    * \param output_filename profile output file name
    * \param continuous_dump true if profile information should be periodically dumped
    * \param dump_period Period (in seconds) of profile info dumping
+   * \param aggregate_stats Whether to maintain aggregate stats
+   * \param binary_trace Whether to write the binary trace format instead of chrome trace json
    */
   void SetConfig(int mode, std::string output_filename,
                  bool continuous_dump,
                  float dump_period,
-                 bool aggregate_stats);
+                 bool aggregate_stats,
+                 bool binary_trace = false);
 
   /*! \return mode of profiler */
   inline int GetMode() const {
@@ -322,9 +359,16 @@ class Profiler {
   template<typename StatType, typename SetExtraInfoFunction, typename ...Args>
   void AddNewProfileStat(SetExtraInfoFunction set_extra_info_function, Args... args) {
     if (!paused_) {
-      std::unique_ptr<StatType> stat = CreateProfileStat<StatType>(args...);
-      set_extra_info_function(stat.get());
-      AddProfileStat(&stat);
+      if (binary_trace_) {
+        // Recorded right away, so the statistic object need not outlive this call
+        StatType stat(args...);
+        set_extra_info_function(&stat);
+        RecordTrace(stat);
+      } else {
+        std::unique_ptr<StatType> stat = CreateProfileStat<StatType>(args...);
+        set_extra_info_function(stat.get());
+        AddProfileStat(&stat);
+      }
     }
   }
 
@@ -434,9 +478,34 @@ class Profiler {
     general_stats_.opr_exec_stats_->enqueue(stat->release());
   }
 
+  /*!
+   * \brief Append a profile statistic to the binary trace of the calling thread
+   * \tparam StatType Type of the statistic object
+   * \param stat The statistic object
+   */
+  template<typename StatType>
+  inline void RecordTrace(const StatType &stat) {
+    stat.EmitTrace(TraceRecord::kNoDevice);
+    OnTraceStat(stat);
+  }
+
+  /*! \brief add a statistic of the binary trace to the aggregate stats */
+  inline void OnTraceStat(const ProfileStat &stat) {
+    std::shared_ptr<AggregateStats> stats = std::atomic_load(&aggregate_stats_);
+    if (stats) {
+      stats->OnProfileStat(stat);
+    }
+  }
+
   /*! \brief generate device information following chrome profile file format */
   void EmitPid(std::ostream *os, const std::string& name, size_t pid);
 
+  /*!
+   * \brief dump the binary trace, see DumpProfile
+   * \param perform_cleanup Stop the continuous dump (ie last pass)
+   */
+  void DumpTrace(bool perform_cleanup);
+
   /*!
    * \brief Set continuous asynchronous profile dump
    * \param continuous_dump Whether to continuously dump profile information
@@ -454,6 +523,10 @@ class Profiler {
   int mode_ = kSymbolic | kAPI | kMemory;
   /*! \brief filename to output profile file */
   std::string filename_ = "profile.json";
+  /*! \brief write the binary trace format instead of chrome trace json */
+  volatile bool binary_trace_ = false;
+  /*! \brief whether the header of the binary trace file is written */
+  bool trace_header_written_ = false;
   /*! \brief profile statistics consist of multiple device statistics */
   std::unique_ptr<DeviceStats[]> profile_stat;
   /*! \brief Stats not associated directly with a device */
@@ -651,6 +724,10 @@ struct ProfileCounter : public ProfileObject {
       *os << "        \"args\": { \"" << name_.c_str() << "\": " << value_ << " },\n";
     }
 
+    uint64_t TraceValue() const override {
+      return value_;
+    }
+
     /*!
      * \brief Save aggregate data for this stat
      * \param data Stat data
@@ -835,6 +912,9 @@ struct ProfileTask : public ProfileDuration {
       DurationStat::EmitExtra(os, idx);
       *os << "        \"id\": " << std::hash<std::thread::id>{}(thread_id_) << ",\n";
     }
+    uint64_t TraceValue() const override {
+      return std::hash<std::thread::id>{}(thread_id_);
+    }
   };
 
  private:
@@ -1072,6 +1152,9 @@ struct ProfileMarker {
       ProfileStat::EmitExtra(os, idx);
       *os << "        \"s\": \"" << scope_char_ << "\",\n";
     }
+    uint64_t TraceValue() const override {
+      return static_cast<uint64_t>(scope_char_);
+    }
     const char scope_char_;
   };
 
@@ -1116,6 +1199,66 @@ struct ProfileMarker {
 
 static ProfileDomain custom_op_domain("Custom Operator");
 
+/*!
+ * \brief Work of an engine operator, from which the aggregate stats report the
+ *  achieved GFLOP/s and GB/s of the operators and of the CachedOps pushing them
+ */
+struct OprCost {
+  /*! \brief floating point operations */
+  uint64_t flops{0};
+  /*! \brief bytes read and written */
+  uint64_t bytes{0};
+  /*! \brief name of the CachedOp pushing the operator, or empty */
+  std::string group;
+};
+
+/*!
+ * \brief Sets the cost of the next engine operator that the calling thread creates,
+ *  or the CachedOp of the operators it creates, until the scope exits.
+ *
+ *  The engines take the flops and bytes when they create an operator, so they are
+ *  never counted twice, and keep the CachedOp name.
+ */
+class OprCostScope {
+ public:
+  /*! \brief cost of the next operator, in the CachedOp of the enclosing scope */
+  OprCostScope(uint64_t flops, uint64_t bytes) : prev_(*Current()) {
+    Current()->flops = flops;
+    Current()->bytes = bytes;
+  }
+  /*! \brief operators created in the scope belong to the CachedOp */
+  explicit OprCostScope(const std::string& group) : prev_(*Current()) {
+    Current()->group = group;
+  }
+  /*! \brief cost of the next operator and its CachedOp */
+  explicit OprCostScope(const OprCost& cost) : prev_(*Current()) {
+    *Current() = cost;
+  }
+  ~OprCostScope() {
+    *Current() = std::move(prev_);
+  }
+  /*! \brief cost set by the innermost scope of the calling thread */
+  static OprCost* Current() {
+    return dmlc::ThreadLocalStore<OprCost>::Get();
+  }
+  /*!
+   * \brief take the cost of an operator being created
+   * \return whether there was a cost to take
+   */
+  static bool Take(OprCost* cost) {
+    OprCost* current = Current();
+    if (current->flops == 0 && current->bytes == 0) return false;
+    cost->flops = current->flops;
+    cost->bytes = current->bytes;
+    cost->group = current->group;
+    current->flops = current->bytes = 0;
+    return true;
+  }
+
+ private:
+  OprCost prev_;
+};
+
 /*!
  * \brief Operator profiler object. Logs as both an independent event and a task in
  * the operator domain
@@ -1231,19 +1374,76 @@ struct ProfileOperator : public ProfileEvent {
       items_[kStart].timestamp_ = start_time;
       items_[kStop].timestamp_ = stop_time;
     }
+    void SaveAggregate(AggregateStats::StatData *data) const override {
+      DurationStat::SaveAggregate(data);
+      if (data) {
+        data->total_flops_ += flops_;
+        data->total_bytes_ += bytes_;
+      }
+    }
+    const char *AggregateGroup() const override {
+      return group_.c_str()[0] ? group_.c_str() : nullptr;
+    }
+    void EmitExtra(std::ostream *os, size_t idx) override {
+      DurationStat::EmitExtra(os, idx);
+      if (id_ && idx == kStart) {
+        *os << "        \"args\": {\"id\": " << id_ << ", \"deps\": [";
+        for (size_t i = 0; i < deps_.size(); ++i) {
+          *os << (i ? ", " : "") << deps_[i];
+        }
+        *os << "]},\n";
+      }
+    }
+    uint64_t TraceValue() const override {
+      return id_;
+    }
     /*! \brief device type: CPU: 1, GPU: 2, CPUPinned: 3 */
     mxnet::Context::DeviceType dev_type_;
     /*! \brief device id */
     uint32_t dev_id_;
+    /*! \brief floating point operations of the operator */
+    uint64_t flops_ = 0;
+    /*! \brief bytes read and written by the operator */
+    uint64_t bytes_ = 0;
+    /*! \brief CachedOp that pushed the operator */
+    profile_stat_string group_;
+    /*! \brief engine id of the operator, 0 if it is not known */
+    uint64_t id_ = 0;
+    /*! \brief ids of the operators that last wrote the variables this operator uses */
+    std::vector<uint64_t> deps_;
   };
 
+  /*!
+   * \brief Set the work of the operator, reported by the aggregate stats
+   * \param cost Flops and bytes of the operator
+   */
+  void SetCost(const OprCost& cost) {
+    cost_ = cost;
+  }
+
+  /*!
+   * \brief Set the place of the operator in the engine's dependency graph
+   * \param id Engine id of the operator
+   * \param deps Engine ids of the operators it waited for
+   */
+  void SetDependencies(uint64_t id, std::vector<uint64_t> *deps) {
+    id_ = id;
+    deps_.swap(*deps);
+  }
+
  private:
   /*!
    * \brief Send this object's statistical datapoint to the profiler
    */
   void SendStat() override {
     Profiler::Get()->AddNewProfileStat<OprExecStat>(
-      [](OprExecStat *stat) {}, name_.c_str(), dev_type_, dev_id_,
+      [this](OprExecStat *stat) {
+        stat->flops_ = cost_.flops;
+        stat->bytes_ = cost_.bytes;
+        stat->group_.set(cost_.group.c_str());
+        stat->id_ = id_;
+        stat->deps_.swap(deps_);
+      }, name_.c_str(), dev_type_, dev_id_,
       start_time_, ProfileStat::NowInMicrosec(),
       attributes_.get());
   }
@@ -1273,6 +1473,12 @@ struct ProfileOperator : public ProfileEvent {
   static ProfileDomain domain_;
   /*! \brief Optional operator attributes */
   std::unique_ptr<Attributes> attributes_;
+  /*! \brief Work of the operator, if known */
+  OprCost cost_;
+  /*! \brief Engine id of the operator, 0 if it is not known */
+  uint64_t id_ = 0;
+  /*! \brief Engine ids of the operators this operator waited for */
+  std::vector<uint64_t> deps_;
   /*! \brief Whether to profile or not */
   const bool profiling_;
 };
@@ -1317,6 +1523,33 @@ inline void Profiler::AddProfileStat<ProfileOperator::OprExecStat>(
   dev_stat.opr_exec_stats_->enqueue((*opr_stat).release());
 }
 
+/*!
+ * \brief Explicit 'Profiler::RecordTrace' override for 'OprExecStat'
+ * \param opr_stat The operator statistic, recorded under its device
+ */
+template<>
+inline void Profiler::RecordTrace<ProfileOperator::OprExecStat>(
+  const ProfileOperator::OprExecStat &opr_stat) {
+  const size_t idx = DeviceIndex(opr_stat.dev_type_, opr_stat.dev_id_);
+  CHECK_LT(idx, DeviceCount());
+  if (!opr_stat.deps_.empty()) {
+    // the dependencies precede the begin record that they belong to
+    TraceBuffer *buffer = TraceBuffer::Get();
+    TraceRecord record = {};
+    record.timestamp = opr_stat.items_[ProfileOperator::OprExecStat::kStart].timestamp_;
+    record.name = buffer->Intern(opr_stat.name_.c_str());
+    record.category = buffer->Intern(opr_stat.categories_.c_str());
+    record.pid = static_cast<uint32_t>(idx);
+    record.phase = static_cast<char>(ProfileStat::kFlowEnd);
+    for (uint64_t dep : opr_stat.deps_) {
+      record.value = dep;
+      buffer->Append(record);
+    }
+  }
+  opr_stat.EmitTrace(static_cast<uint32_t>(idx));
+  OnTraceStat(opr_stat);
+}
+
 #undef VTUNE_ONLY_CODE  // This macro not meant to be used outside of this file
 
 class ProfilerScope {
@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file trace_buffer.cc
+ * \brief Per-thread ring buffers of the binary trace format of the profiler
+ */
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <dmlc/thread_local.h>
+#include <algorithm>
+#include "./trace_buffer.h"
+
+namespace mxnet {
+namespace profiler {
+
+/*! \brief ring and name cache of a thread */
+struct TraceBuffer::ThreadEntry {
+  Ring* ring = nullptr;
+  std::unordered_map<std::string, uint32_t> name_ids;
+  ~ThreadEntry() {
+    if (ring != nullptr) ring->orphaned.store(true, std::memory_order_release);
+  }
+};
+
+namespace {
+
+size_t TraceBufferCapacity() {
+  size_t capacity = 1;
+  const size_t requested = std::max<size_t>(
+      dmlc::GetEnv("MXNET_PROFILER_TRACE_BUFFER_SIZE", size_t(1) << 16), 2);
+  while (capacity < requested) capacity <<= 1;
+  return capacity;
+}
+
+}  // namespace
+
+TraceBuffer* TraceBuffer::Get() {
+  // Never destroyed, since threads may record while the process exits.
+  static TraceBuffer* inst = new TraceBuffer();
+  return inst;
+}
+
+TraceBuffer::TraceBuffer() : capacity_(TraceBufferCapacity()) {}
+
+TraceBuffer::Ring* TraceBuffer::NewRing() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rings_.emplace_back(new Ring(capacity_, next_tid_++));
+  return rings_.back().get();
+}
+
+uint32_t TraceBuffer::Intern(const char* name) {
+  auto& name_ids = dmlc::ThreadLocalStore<ThreadEntry>::Get()->name_ids;
+  auto it = name_ids.find(name);
+  if (it != name_ids.end()) return it->second;
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto global = name_ids_.find(name);
+    if (global == name_ids_.end()) {
+      global = name_ids_.emplace(name, static_cast<uint32_t>(names_.size())).first;
+      names_.emplace_back(name);
+    }
+    id = global->second;
+  }
+  name_ids.emplace(name, id);
+  return id;
+}
+
+void TraceBuffer::Append(TraceRecord record) {
+  ThreadEntry* entry = dmlc::ThreadLocalStore<ThreadEntry>::Get();
+  if (entry->ring == nullptr) entry->ring = NewRing();
+  Ring* ring = entry->ring;
+  record.tid = ring->tid;
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  ring->records[head & ring->mask] = record;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void TraceBuffer::WriteChunk(std::ostream* os, uint32_t kind, uint32_t count) {
+  os->write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+  os->write(reinterpret_cast<const char*>(&count), sizeof(count));
+}
+
+void TraceBuffer::Flush(std::ostream* os, bool new_file) {
+  std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+  std::vector<Ring*> rings;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& ring : rings_) rings.push_back(ring.get());
+  }
+  // Copy the records first, so that every name they use is interned by now.
+  std::vector<TraceRecord> records;
+  uint64_t dropped = 0;
+  std::vector<Ring*> drained;
+  for (Ring* ring : rings) {
+    const bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+    const uint64_t capacity = ring->mask + 1;
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t tail = ring->tail;
+    if (head - tail > capacity) {
+      dropped += head - tail - capacity;
+      tail = head - capacity;
+    }
+    const size_t start = records.size();
+    for (uint64_t i = tail; i < head; ++i) {
+      records.push_back(ring->records[i & ring->mask]);
+    }
+    // The owner may have overwritten the oldest records while they were copied,
+    // in which case the copies are discarded. The slot at new_head may be half
+    // written already, so it counts as overwritten too.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t new_head = ring->head.load(std::memory_order_relaxed);
+    if (new_head + 1 > tail + capacity) {
+      const uint64_t torn = std::min(new_head + 1 - capacity - tail, head - tail);
+      records.erase(records.begin() + start, records.begin() + start + torn);
+      dropped += torn;
+    }
+    ring->tail = head;
+    if (orphaned) drained.push_back(ring);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (new_file) names_written_ = 0;
+    if (names_written_ < names_.size()) {
+      WriteChunk(os, TraceRecord::kNameChunk, names_.size() - names_written_);
+      for (; names_written_ < names_.size(); ++names_written_) {
+        const std::string& name = names_[names_written_];
+        const uint32_t id = names_written_;
+        const uint32_t length = name.size();
+        os->write(reinterpret_cast<const char*>(&id), sizeof(id));
+        os->write(reinterpret_cast<const char*>(&length), sizeof(length));
+        os->write(name.data(), length);
+      }
+    }
+    // Rings of exited threads are drained for good, since nothing appends to them.
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [&drained](const std::unique_ptr<Ring>& ring) {
+                                  return std::find(drained.begin(), drained.end(),
+                                                   ring.get()) != drained.end();
+                                }), rings_.end());
+  }
+  if (!records.empty()) {
+    WriteChunk(os, TraceRecord::kRecordChunk, records.size());
+    os->write(reinterpret_cast<const char*>(records.data()),
+              records.size() * sizeof(TraceRecord));
+  }
+  if (dropped) {
+    WriteChunk(os, TraceRecord::kDropChunk, dropped);
+  }
+}
+
+}  // namespace profiler
+}  // namespace mxnet
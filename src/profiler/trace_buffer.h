@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file trace_buffer.h
+ * \brief Per-thread ring buffers of the binary trace format of the profiler
+ */
+#ifndef MXNET_PROFILER_TRACE_BUFFER_H_
+#define MXNET_PROFILER_TRACE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace profiler {
+
+/*!
+ * \brief Fixed size record of the binary trace format, one per chrome trace event.
+ *
+ *  A trace file starts with the 8 bytes "MXTRACE\0", the format version and the
+ *  record size as uint32, followed by chunks of a uint32 kind and a uint32 count:
+ *  - kNameChunk: count names as a uint32 id, a uint32 length and the characters
+ *  - kDeviceChunk: count device names, with the device index as id
+ *  - kRecordChunk: count records
+ *  - kDropChunk: count records overwritten before they were written to the file
+ *  Integers are in the byte order of the writing machine, so far always little endian.
+ */
+struct TraceRecord {
+  enum ChunkKind : uint32_t {
+    kNameChunk = 'N',
+    kDeviceChunk = 'D',
+    kRecordChunk = 'R',
+    kDropChunk = 'L'
+  };
+  static constexpr uint32_t kVersion = 1;
+  /*! \brief pid of events not bound to a device, which are grouped by category */
+  static constexpr uint32_t kNoDevice = 0xFFFFFFFF;
+
+  /*! \brief timestamp in microseconds */
+  uint64_t timestamp;
+  /*! \brief counter value, id of async events or scope of instant events */
+  uint64_t value;
+  /*! \brief interned name */
+  uint32_t name;
+  /*! \brief interned category */
+  uint32_t category;
+  /*! \brief device index, or kNoDevice */
+  uint32_t pid;
+  /*! \brief index of the recording thread */
+  uint32_t tid;
+  /*! \brief chrome trace event type */
+  char phase;
+  char reserved[7];
+};
+static_assert(sizeof(TraceRecord) == 40, "TraceRecord is part of the trace file format");
+
+/*!
+ * \brief Per-thread ring buffers of trace records, drained into a trace file by the
+ *  thread dumping the profile.
+ *
+ *  Every thread appends to a ring of its own without locks or read-modify-write
+ *  instructions. A ring keeps the latest MXNET_PROFILER_TRACE_BUFFER_SIZE records,
+ *  overwriting the oldest ones when it is not drained in time, so the trace of a long
+ *  capture holds the latest window and the number of records lost.
+ */
+class TraceBuffer {
+ public:
+  static TraceBuffer* Get();
+
+  /*! \brief id of a name, the same for every thread and every trace file */
+  uint32_t Intern(const char* name);
+  /*! \brief append a record to the ring of the calling thread, setting its tid */
+  void Append(TraceRecord record);
+  /*!
+   * \brief write the names and the records that are not in the file yet
+   * \param new_file whether the names written to a previous file are written again
+   */
+  void Flush(std::ostream* os, bool new_file);
+
+ private:
+  struct Ring {
+    Ring(size_t capacity, uint32_t tid)
+      : records(new TraceRecord[capacity]), mask(capacity - 1), tid(tid) {}
+    std::unique_ptr<TraceRecord[]> records;
+    const uint64_t mask;
+    const uint32_t tid;
+    // number of records appended, only written by the owning thread
+    std::atomic<uint64_t> head{0};
+    // number of records drained, only accessed while flushing
+    uint64_t tail{0};
+    // set when the owning thread exits, so that the ring is freed once drained
+    std::atomic<bool> orphaned{false};
+  };
+  struct ThreadEntry;
+
+  TraceBuffer();
+  Ring* NewRing();
+  static void WriteChunk(std::ostream* os, uint32_t kind, uint32_t count);
+
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  uint32_t next_tid_{0};
+  // interned names, by id
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+  size_t names_written_{0};
+  // serializes the flushes
+  std::mutex flush_mutex_;
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_PROFILER_TRACE_BUFFER_H_
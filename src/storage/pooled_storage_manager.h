@@ -123,7 +123,9 @@ class PooledStorageManager : public StorageManager,
   void Free(Storage::Handle handle) override {
     // Insert returned memory in cache
     std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
-    StoringMethod::InsertInCache(BucketingStrategy::get_bucket(handle.size), handle.dptr);
+    const auto bucket_id = BucketingStrategy::get_bucket(handle.size);
+    StoringMethod::InsertInCache(bucket_id, handle.dptr);
+    pooled_memory_ += BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
   }
 
   void DirectFree(Storage::Handle handle) override {
@@ -141,10 +143,18 @@ class PooledStorageManager : public StorageManager,
     ReleaseAllNoLock();
   }
 
+  bool MemoryUsage(size_t* allocated, size_t* pooled) override {
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+    *allocated = used_memory_;
+    *pooled = pooled_memory_;
+    return true;
+  }
+
  private:
   void ReleaseAllNoLock(bool set_device = true) {
     SET_DEVICE(device_store, contextHelper_, contextHelper_->initilal_context(), set_device);
     used_memory_ -= StoringMethod::ReleaseAllNoLock(contextHelper_.get(), this);
+    pooled_memory_ = 0;
     UNSET_DEVICE(device_store);
   }
 
@@ -157,6 +167,8 @@ class PooledStorageManager : public StorageManager,
   Context::DeviceType dev_type_;
   // used memory
   size_t used_memory_ = 0;
+  // part of the used memory in the pool
+  size_t pooled_memory_ = 0;
   // minimum amount of memory, which will never be allocated
   size_t memory_allocation_limit_ = 0;
   // Pointer to the Helper, supporting some context-specific operations in GPU/CPU/CPUPinned context
@@ -201,6 +213,7 @@ void PooledStorageManager<BucketingStrategy, StoringMethod>::Alloc(Storage::Hand
     // Reusing memory
     handle->dptr = reuse_pool->back();
     reuse_pool->pop_back();
+    pooled_memory_ -= BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
   }
 #if MXNET_USE_CUDA
   SET_GPU_PROFILER(profilerGPU, contextHelper_);
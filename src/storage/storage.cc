@@ -21,6 +21,8 @@
  * Copyright (c) 2015 by Contributors
  */
 #include <mxnet/storage.h>
+#include <sstream>
+#include <vector>
 #include "./storage_manager.h"
 #include "./naive_storage_manager.h"
 #include "./pooled_storage_manager.h"
@@ -30,6 +32,7 @@
 #include "./pinned_memory_storage.h"
 #include "../common/lazy_alloc_array.h"
 #include "../profiler/storage_profiler.h"
+#include "../profiler/metrics.h"
 
 namespace mxnet {
 namespace storage {
@@ -43,10 +46,19 @@ class StorageImpl : public Storage {
   void ReleaseAll(Context ctx) override   { storage_manager(ctx)->ReleaseAll(); }
 
   void SharedIncrementRefCount(Handle handle) override;
-  StorageImpl() = default;
-  ~StorageImpl() override = default;
+  StorageImpl() {
+    metrics_collector_ = profiler::Metrics::Get()->AddCollector(
+        [this](std::vector<profiler::Metrics::Gauge>* gauges) {
+          this->CollectMemoryUsage(gauges);
+        });
+  }
+  ~StorageImpl() override {
+    profiler::Metrics::Get()->RemoveCollector(metrics_collector_);
+  }
 
  private:
+  void CollectMemoryUsage(std::vector<profiler::Metrics::Gauge>* gauges);
+
   std::shared_ptr<StorageManager> storage_manager(const Context &ctx) {
     auto &&device = storage_managers_.at(ctx.dev_type);
     std::shared_ptr<StorageManager> manager = device.Get(
@@ -61,6 +73,8 @@ class StorageImpl : public Storage {
   // internal storage managers
   std::array<common::LazyAllocArray<StorageManager>, kMaxNumberOfDevices> storage_managers_;
   profiler::DeviceStorageProfiler profiler_;
+  // id of the collector exporting the memory usage of the pooled storage managers
+  int metrics_collector_{-1};
 };  // struct Storage::Impl
 
 StorageManager *CreateStorageManager(const Context &ctx, const char *context,
@@ -237,6 +251,28 @@ void StorageImpl::SharedIncrementRefCount(Storage::Handle handle) {
 #endif  // !defined(ANDROID) && !defined(__ANDROID__)
 }
 
+void StorageImpl::CollectMemoryUsage(std::vector<profiler::Metrics::Gauge>* gauges) {
+  for (size_t dev_type = 0; dev_type < kMaxNumberOfDevices; ++dev_type) {
+    storage_managers_[dev_type].ForEach([&](size_t dev_id, StorageManager* manager) {
+      size_t allocated = 0, pooled = 0;
+      if (!manager->MemoryUsage(&allocated, &pooled)) return;
+      Context ctx;
+      ctx.dev_type = static_cast<Context::DeviceType>(dev_type);
+      ctx.dev_id = static_cast<int32_t>(dev_id);
+      std::ostringstream device;
+      device << ctx;
+      gauges->push_back({"mxnet_memory_in_use_bytes",
+                         "Memory of the pooled storage managers held by arrays.",
+                         {{"device", device.str()}},
+                         static_cast<double>(allocated - pooled)});
+      gauges->push_back({"mxnet_memory_pooled_bytes",
+                         "Memory of the pooled storage managers kept in the pool for reuse.",
+                         {{"device", device.str()}},
+                         static_cast<double>(pooled)});
+    });
+  }
+}
+
 const std::string env_var_name(const char* dev_type, env_var_type type) {
   static const std::array<std::string, 5> name = {
                         "MEM_POOL_TYPE",
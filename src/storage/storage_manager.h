@@ -60,6 +60,12 @@ class StorageManager {
   * For non-pool memory managers this has no effect.
   */
   virtual void ReleaseAll() {}
+  /*!
+   * \brief Memory allocated from the device and the part of it kept in the pool
+   *  for reuse, exported as runtime metrics.
+   * \return false for storage managers that do not track their memory.
+   */
+  virtual bool MemoryUsage(size_t* /*allocated*/, size_t* /*pooled*/) { return false; }
   /*!
    * \brief Destructor.
    */
@@ -18,10 +18,44 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
 
 #include "../include/test_util.h"
 #include "../../src/engine/openmp.h"
 
+TEST(OMPBehaviour, share_threads) {
+    /*
+     * Check that operators running on several CPU workers at once split the threads, and that
+     * small loops don't get more threads than iterations.
+     */
+    using namespace mxnet::engine;
+    auto openmp = OpenMP::Get();
+    const int alone = openmp->GetRecommendedOMPThreadCount();
+    {
+        OpenMP::OperatorScope first(true), second(true), gpu(false);
+        EXPECT_EQ(openmp->busy_workers(), 2);
+        const int shared = openmp->GetRecommendedOMPThreadCount();
+        EXPECT_LE(shared, alone);
+        if (!getenv("OMP_NUM_THREADS") && !getenv("MXNET_OMP_SHARE_THREADS") &&
+            !getenv("MXNET_ENFORCE_DETERMINISM")) {
+            EXPECT_EQ(shared, std::max(alone / 2, 1));
+        }
+    }
+    EXPECT_EQ(openmp->busy_workers(), 0);
+    EXPECT_EQ(openmp->GetRecommendedOMPThreadCount(), alone);
+    EXPECT_EQ(openmp->GetRecommendedOMPThreadCountFor(1), 1);
+    {
+        // An operator keeps the share it started with while other workers come and go
+        OpenMP::OperatorScope op(true);
+        EXPECT_EQ(openmp->GetRecommendedOMPThreadCount(), alone);
+        openmp->on_start_operator();
+        EXPECT_EQ(openmp->GetRecommendedOMPThreadCount(), alone);
+        openmp->on_finish_operator();
+    }
+    EXPECT_EQ(openmp->busy_workers(), 0);
+}
+
 #if defined(unix) || defined(__unix__) || defined(__unix)
 #include <unistd.h>
 #include <sys/types.h>
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file row_store_test.cc
+ * \brief row store tests
+*/
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/kvstore/row_store.h"
+
+using mxnet::kvstore::RowStore;
+using mxnet::kvstore::RowStoreParam;
+
+TEST(RowStore, LazyMaterialization) {
+  RowStoreParam param;
+  param.Init(std::vector<std::pair<std::string, std::string>>{});
+  RowStore store(1000000, 4, param, 16, 1);
+  std::vector<int64_t> rows = {3, 999999};
+  std::vector<float> vals = {1, 2, 3, 4, 0, 0, 0, 0};
+  store.Init(rows.data(), vals.data(), rows.size());
+  // initial values are not materialized
+  EXPECT_EQ(store.NumMaterialized(), 0);
+
+  std::vector<int64_t> pull_rows = {7, 3};
+  std::vector<float> out(8, -1.f);
+  store.Pull(pull_rows.data(), pull_rows.size(), out.data());
+  const std::vector<float> expected = {0, 0, 0, 0, 1, 2, 3, 4};
+  EXPECT_EQ(out, expected);
+  EXPECT_EQ(store.NumMaterialized(), 0);
+}
+
+TEST(RowStore, MaterializeFromInitialValue) {
+  RowStoreParam param;
+  param.Init(std::vector<std::pair<std::string, std::string>>{
+    {"optimizer", "sgd"}, {"learning_rate", "1"}});
+  const int64_t num_rows = 1000;
+  RowStore store(num_rows, 2, param, 4, 1);
+  std::vector<int64_t> rows(num_rows);
+  std::vector<float> vals(num_rows * 2);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    rows[i] = i;
+    vals[2 * i] = i;
+    vals[2 * i + 1] = -i;
+  }
+  store.Init(rows.data(), vals.data(), num_rows);
+  EXPECT_EQ(store.NumMaterialized(), 0);
+  // the first push starts from the initial value of the row
+  std::vector<int64_t> pushed = {42};
+  std::vector<float> grad = {1, 1};
+  store.Update(pushed.data(), grad.data(), 1);
+  EXPECT_EQ(store.NumMaterialized(), 1);
+  std::vector<int64_t> pull_rows = {42, 43};
+  std::vector<float> out(4);
+  store.Pull(pull_rows.data(), pull_rows.size(), out.data());
+  const std::vector<float> expected = {41, -43, 43, -43};
+  EXPECT_EQ(out, expected);
+}
+
+TEST(RowStore, DenseInitKeepsNonZeroRows) {
+  RowStoreParam param;
+  param.Init(std::vector<std::pair<std::string, std::string>>{
+    {"optimizer", "sgd"}, {"learning_rate", "1"}});
+  const int64_t num_rows = 10000;
+  RowStore store(num_rows, 2, param, 4, 1);
+  std::vector<int64_t> rows(num_rows);
+  std::vector<float> vals(num_rows * 2, 0.f);
+  for (int64_t i = 0; i < num_rows; ++i) rows[i] = i;
+  vals[2 * 7] = 1;
+  vals[2 * 5000 + 1] = 2;
+  store.Init(rows.data(), vals.data(), num_rows);
+  // only the two non-zero rows are kept, none is materialized
+  EXPECT_EQ(store.NumInitial(), 2);
+  EXPECT_EQ(store.NumMaterialized(), 0);
+
+  std::vector<int64_t> pushed = {7, 9};
+  std::vector<float> grad = {1, 1, 1, 1};
+  store.Update(pushed.data(), grad.data(), pushed.size());
+  EXPECT_EQ(store.NumMaterialized(), 2);
+  std::vector<int64_t> pull_rows = {7, 9, 5000, 3};
+  std::vector<float> out(8, -1.f);
+  store.Pull(pull_rows.data(), pull_rows.size(), out.data());
+  const std::vector<float> expected = {0, -1, -1, -1, 0, 2, 0, 0};
+  EXPECT_EQ(out, expected);
+}
+
+TEST(RowStore, LazySGDMomentum) {
+  RowStoreParam param;
+  param.Init(std::vector<std::pair<std::string, std::string>>{
+    {"optimizer", "sgd"}, {"learning_rate", "0.5"}, {"momentum", "0.9"}});
+  RowStore store(100, 2, param, 4, 1);
+  std::vector<int64_t> rows = {5};
+  std::vector<float> grad = {1, -2};
+  // two workers push the same row, the sum is applied once
+  store.Accumulate(rows.data(), grad.data(), 1);
+  store.Accumulate(rows.data(), grad.data(), 1);
+  store.ApplyPending();
+  std::vector<float> out(2);
+  store.Pull(rows.data(), 1, out.data());
+  EXPECT_FLOAT_EQ(out[0], -1.f);
+  EXPECT_FLOAT_EQ(out[1], 2.f);
+  // second step uses the momentum of the row, and is served through the hot row cache
+  store.Update(rows.data(), grad.data(), 1);
+  store.Pull(rows.data(), 1, out.data());
+  EXPECT_FLOAT_EQ(out[0], -1.f - 0.9f - 0.5f);
+  EXPECT_FLOAT_EQ(out[1], 2.f + 1.8f + 1.f);
+  EXPECT_EQ(store.NumMaterialized(), 1);
+}
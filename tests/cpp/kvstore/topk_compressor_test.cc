@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file topk_compressor_test.cc
+ * \brief top-k compressor tests
+*/
+
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../src/kvstore/compressor/impl/topk-inl.h"
+
+using mxnet::kvstore::compressor::DecodeSparseIndex;
+using mxnet::kvstore::compressor::TopKCompressor;
+
+namespace {
+
+mxnet::TBlob MakeBlob(std::vector<float>* data) {
+  return mxnet::TBlob(data->data(), mxnet::TShape(mshadow::Shape1(data->size())),
+                      mshadow::cpu::kDevMask);
+}
+
+void CheckPairs(const std::vector<float>& compr,
+                const std::vector<std::pair<int32_t, float>>& expected) {
+  ASSERT_EQ(compr.size(), 2 * expected.size());
+  for (size_t j = 0; j < expected.size(); ++j) {
+    EXPECT_EQ(DecodeSparseIndex(compr[2 * j]), expected[j].first);
+    EXPECT_EQ(compr[2 * j + 1], expected[j].second);
+  }
+}
+
+}  // namespace
+
+TEST(TopKCompressor, RoundTrip) {
+  TopKCompressor compressor;
+  // every compressed value stands for 2 values, so a block of 8 values keeps 2 pairs
+  compressor.Init({{"ratio", "0.25"}, {"pairs_per_block", "2"}});
+  EXPECT_EQ(compressor.GetCompressFactor(), 2);
+  EXPECT_EQ(compressor.GetCompressBlockSize(), 4);
+  // one full block and a tail of 4 values which keeps a single pair
+  EXPECT_EQ(compressor.GetCompressedSize(8), 4);
+  EXPECT_EQ(compressor.GetCompressedSize(12), 6);
+
+  mxnet::RunContext rctx = {mxnet::Context::CPU(), nullptr, nullptr, false};
+  std::vector<float> grad = {1, -5, 2, 0.5, 3, 0, -4, 0.125,
+                             0.25, 0.125, -0.5, 0};
+  std::vector<float> residual(grad.size(), 0);
+  std::vector<float> compr(compressor.GetCompressedSize(grad.size()), 0);
+  mxnet::TBlob grad_blob = MakeBlob(&grad);
+  mxnet::TBlob residual_blob = MakeBlob(&residual);
+  mxnet::TBlob compr_blob = MakeBlob(&compr);
+
+  compressor.Compress(rctx, grad_blob, compr_blob, residual_blob);
+  // the largest magnitudes of every block, in index order
+  CheckPairs(compr, {{1, -5}, {6, -4}, {2, -0.5}});
+  const std::vector<float> expected_residual = {1, 0, 2, 0.5, 3, 0, 0, 0.125,
+                                                0.25, 0.125, 0, 0};
+  EXPECT_EQ(residual, expected_residual);
+
+  std::vector<float> out(grad.size(), -1);
+  mxnet::TBlob out_blob = MakeBlob(&out);
+  compressor.Decompress(rctx, compr_blob, out_blob);
+  const std::vector<float> expected_out = {0, -5, 0, 0, 0, 0, -4, 0,
+                                           0, 0, -0.5, 0};
+  EXPECT_EQ(out, expected_out);
+
+  // values which were not sent are added to the next gradient
+  std::fill(grad.begin(), grad.end(), 0);
+  grad[0] = 2.5;
+  compressor.Compress(rctx, grad_blob, compr_blob, residual_blob);
+  CheckPairs(compr, {{0, 3.5}, {4, 3}, {0, 0.25}});
+  compressor.Decompress(rctx, compr_blob, out_blob);
+  const std::vector<float> expected_out2 = {3.5, 0, 0, 0, 3, 0, 0, 0,
+                                            0.25, 0, 0, 0};
+  EXPECT_EQ(out, expected_out2);
+}
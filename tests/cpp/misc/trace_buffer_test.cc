@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ * \file trace_buffer_test.cc
+ * \brief Test draining the trace rings while threads append to them
+ */
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../../../src/profiler/trace_buffer.h"
+
+using mxnet::profiler::TraceBuffer;
+using mxnet::profiler::TraceRecord;
+
+TEST(TraceBuffer, ContinuousDump) {
+  /*
+   * One thread appends while another keeps dumping, wrapping the ring many times.
+   * Every record written out must be whole and in order, and the records written
+   * plus the ones reported lost must add up to the records appended.
+   */
+  TraceBuffer* buffer = TraceBuffer::Get();
+  const uint32_t name = buffer->Intern("trace_buffer_continuous_dump");
+  const uint64_t num_records = uint64_t(1) << 22;
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    for (uint64_t i = 0; i < num_records; ++i) {
+      TraceRecord record{};
+      record.timestamp = i;
+      record.value = ~i;
+      record.name = name;
+      record.category = name;
+      record.pid = static_cast<uint32_t>(i);
+      record.phase = 'i';
+      buffer->Append(record);
+    }
+    done.store(true);
+  });
+  std::ostringstream os;
+  while (!done.load()) buffer->Flush(&os, false);
+  writer.join();
+  buffer->Flush(&os, false);
+
+  const std::string data = os.str();
+  uint64_t written = 0, dropped = 0;
+  bool first = true;
+  uint64_t last = 0;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    uint32_t kind, count;
+    std::memcpy(&kind, &data[offset], sizeof(kind));
+    std::memcpy(&count, &data[offset + sizeof(kind)], sizeof(count));
+    offset += sizeof(kind) + sizeof(count);
+    if (kind == TraceRecord::kNameChunk) {
+      for (uint32_t i = 0; i < count; ++i) {
+        uint32_t length;
+        std::memcpy(&length, &data[offset + sizeof(uint32_t)], sizeof(length));
+        offset += 2 * sizeof(uint32_t) + length;
+      }
+    } else if (kind == TraceRecord::kRecordChunk) {
+      for (uint32_t i = 0; i < count; ++i, offset += sizeof(TraceRecord)) {
+        TraceRecord record;
+        std::memcpy(&record, &data[offset], sizeof(record));
+        if (record.name != name) continue;
+        ASSERT_EQ(record.value, ~record.timestamp);
+        ASSERT_EQ(record.pid, static_cast<uint32_t>(record.timestamp));
+        ASSERT_EQ(record.category, name);
+        if (!first) ASSERT_GT(record.timestamp, last);
+        first = false;
+        last = record.timestamp;
+        ++written;
+      }
+    } else if (kind == TraceRecord::kDropChunk) {
+      dropped += count;
+    } else {
+      FAIL() << "unexpected chunk " << kind;
+    }
+  }
+  EXPECT_GT(written, 0U);
+  EXPECT_EQ(written + dropped, num_records);
+}
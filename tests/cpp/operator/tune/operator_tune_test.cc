@@ -174,5 +174,28 @@ TEST(OMP_TUNING, EvaluateTuneTestInt64) {
   std::cout << "Success rate for type " << test::type_name<DType>() << ": " << result << std::endl;
 }
 
+/*! \brief Exposes the per-thread OMP overheads to the tests */
+struct OverheadTune : public mxnet::op::OperatorTuneBase {
+  static std::vector<duration_t> *overheads() { return &omp_overhead_by_threads_; }
+};
+
+/*! \brief The thread count trades the OMP overhead of every thread count against the work */
+TEST(OMP_TUNING, BestThreadCount) {
+  using mxnet::op::OperatorTuneBase;
+  std::vector<OperatorTuneBase::duration_t> saved = *OverheadTune::overheads();
+  // 1us to start 2 threads, 2us for 3 threads and 10us for 4 or more
+  *OverheadTune::overheads() = {0, 0, 1000, 2000, 10000};
+  const uint64_t us = OperatorTuneBase::WORKLOAD_COUNT * 1000;
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(8, 1 * us), 1U);
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(8, 4 * us), 2U);
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(8, 30 * us), 3U);
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(8, 1000 * us), 8U);
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(2, 1000 * us), 2U);
+  // without measurements every available thread is used
+  OverheadTune::overheads()->clear();
+  EXPECT_EQ(OperatorTuneBase::BestThreadCount(8, 1 * us), 8U);
+  *OverheadTune::overheads() = saved;
+}
+
 #endif  // MXNET_USE_OPERATOR_TUNING
 
@@ -434,6 +434,22 @@ def test_gluon_trainer_sparse_step():
     check_trainer_sparse_step()
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_sparse_step')
 
+def test_p3_slices():
+    # run with the p3 van, which splits the big key into slices on several server keys.
+    # every slice must be updated with the hyper-parameters of the key
+    key = 1
+    kv.init(key, mx.nd.ones(big_shape))
+    optimizer = mx.optimizer.SGD(learning_rate=0.1, wd=0.1, rescale_grad=1.0 / nworker,
+                                 param_idx2name={key: 'fc_bias'})
+    # biases are not decayed
+    optimizer.set_lr_mult({'fc_bias': 0.5})
+    kv.set_optimizer(optimizer)
+    kv.push(key, mx.nd.ones(big_shape))
+    val = mx.nd.zeros(big_shape)
+    kv.pull(key, out=val)
+    assert_almost_equal(val.asnumpy(), np.full(big_shape, 1 - 0.1 * 0.5))
+    print('worker ' + str(my_rank) + ' passed test_p3_slices')
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='test distributed kvstore in dist_sync mode')
     parser.add_argument('--nrepeat', type=int, default=7)
@@ -455,6 +471,8 @@ if __name__ == "__main__":
         kv = init_kv()
         kv = set_optimizer(use_multiprecision=opt.multiprecision)
         test_sync_push_pull(opt.nrepeat)
+    elif opt.type == 'p3_slices_cpu':
+        test_p3_slices()
     elif opt.type == 'compressed_cpu':
         kv, threshold = init_kv_compressed(kv)
         kv = set_optimizer(use_multiprecision=opt.multiprecision)
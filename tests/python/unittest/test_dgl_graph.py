@@ -182,6 +182,98 @@ def test_non_uniform_sample():
     assert (len(out) == 4)
     check_non_uniform(out, num_hops=1, max_num_vertices=5)
 
+def check_layer_sample(out, g, fanouts, max_num_vertices):
+    sample_id = out[0].asnumpy()
+    sub_csr = out[1]
+    layer = out[-1].asnumpy()
+    num_vertices = sample_id[-1]
+    vertices = sample_id[:num_vertices]
+    assert np.all(vertices[1:] > vertices[:-1])
+    sub_csr.check_format(full_check=True)
+    indptr = sub_csr.indptr.asnumpy()
+    indices = sub_csr.indices.asnumpy()
+    data = sub_csr.data.asnumpy()
+    assert np.all(indptr[num_vertices:] == indptr[num_vertices])
+    for i, v in enumerate(vertices):
+        assert layer[i] <= len(fanouts)
+        row = slice(indptr[i], indptr[i + 1])
+        if layer[i] == len(fanouts):
+            assert indptr[i] == indptr[i + 1]
+            continue
+        assert indptr[i + 1] - indptr[i] == min(fanouts[layer[i]], g.indptr[v + 1] - g.indptr[v])
+        assert len(np.unique(indices[row])) == len(indices[row])
+        # every sampled edge exists in the graph with its edge id
+        assert np.all(g[v, indices[row]].toarray().ravel() == data[row])
+
+def test_layer_sample():
+    sp_g, g = generate_graph(100)
+    prob = mx.nd.random.uniform(shape=(100,))
+    seed = mx.nd.array(np.unique(np.random.randint(0, 100, size=(5,))), dtype=np.int64)
+    for fanouts in [(3,), (4, 2), (2, 2, 2)]:
+        out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(g, seed, seed, num_args=3, fanouts=fanouts,
+                                                          max_num_vertices=100)
+        assert (len(out) == 6)
+        check_layer_sample(out[0::2], sp_g, fanouts, 100)
+        check_layer_sample(out[1::2], sp_g, fanouts, 100)
+        out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(g, prob, seed, num_args=3, fanouts=fanouts,
+                                                          max_num_vertices=100, non_uniform=True)
+        assert (len(out) == 4)
+        check_non_uniform(out, num_hops=len(fanouts), max_num_vertices=100)
+        check_layer_sample(out, sp_g, fanouts, 100)
+        num_vertices = out[0][-1].asnumpy()[0]
+        assert_almost_equal(out[2][:num_vertices].asnumpy(),
+                            prob.asnumpy()[out[0][:num_vertices].asnumpy()])
+
+    # truncated by max_num_vertices
+    out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(g, seed, num_args=2, fanouts=(10, 10),
+                                                      max_num_vertices=20)
+    check_uniform(out, num_hops=2, max_num_vertices=20)
+    assert out[0][-1].asnumpy()[0] <= 20
+
+def test_layer_sample_reproducible():
+    _, g = generate_graph(500)
+    # more frontier vertices than one block of the parallel sampling loop
+    seed = mx.nd.arange(0, 500, step=2, dtype=np.int64)
+    prob = mx.nd.random.uniform(shape=(500,))
+
+    def sample(*args, **kwargs):
+        mx.random.seed(1234)
+        out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(g, *args, fanouts=(5, 3),
+                                                          max_num_vertices=500, **kwargs)
+        return [o.asnumpy() if o.stype == 'default' else o.indices.asnumpy() for o in out]
+
+    for args, kwargs in [((seed,), dict(num_args=2)),
+                         ((prob, seed), dict(num_args=3, non_uniform=True))]:
+        expected = sample(*args, **kwargs)
+        for _ in range(3):
+            for a, b in zip(sample(*args, **kwargs), expected):
+                assert_array_equal(a, b)
+
+def test_layer_sample_new_probability():
+    # vertex 0 links to every other vertex
+    num_vertices = 9
+    indptr = np.array([0] + [num_vertices - 1] * num_vertices, dtype=np.int64)
+    indices = np.arange(1, num_vertices, dtype=np.int64)
+    data = np.arange(0, num_vertices - 1, dtype=np.int64)
+    g = mx.nd.sparse.csr_matrix((data, indices, indptr), shape=(num_vertices, num_vertices))
+    seed = mx.nd.array([0], dtype=np.int64)
+
+    def sample(target):
+        weights = np.zeros((num_vertices,), dtype=np.float32)
+        weights[target] = 1
+        prob = mx.nd.array(weights)
+        out = mx.nd.contrib.dgl_csr_neighbor_layer_sample(g, prob, seed, num_args=3, fanouts=(1,),
+                                                          max_num_vertices=num_vertices,
+                                                          non_uniform=True)
+        sampled = out[0].asnumpy()
+        return sampled[:sampled[-1]].tolist()
+
+    # the probability array of each call is freed before the next one allocates
+    # its own of the same shape, which may get the same storage
+    for target in range(1, num_vertices):
+        assert sample(target) == [0, target]
+        mx.nd.waitall()
+
 def test_edge_id():
     shape = rand_shape_2d()
     data = rand_ndarray(shape, stype='csr', density=0.4)
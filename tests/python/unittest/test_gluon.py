@@ -1641,6 +1641,57 @@ def test_hybrid_static_memory_switching(static_alloc, static_shape):
         y.backward()
     mx.nd.waitall()
 
+
+@pytest.mark.parametrize('static_alloc', [False, True])
+def test_hybrid_cached_op_disk_cache(tmpdir, static_alloc):
+    net = gluon.model_zoo.vision.get_resnet(
+        1, 18, pretrained=False, ctx=mx.context.current_context())
+    net.initialize()
+    x = mx.nd.random.uniform(shape=(2, 3, 32, 32))
+
+    def test(net, x):
+        with mx.autograd.record():
+            y = net(x)
+            y.backward()
+        grads = {k: v.grad().copy() for k, v in net.collect_params().items()
+                 if v.grad_req != 'null'}
+        return net(x), y, grads
+
+    def cache_files():
+        files = os.listdir(str(tmpdir))
+        plans = [f for f in files if '_plan_' in f]
+        return len(files) - len(plans), len(plans)
+
+    with environment('MXNET_CACHED_OP_CACHE_DIR', str(tmpdir)):
+        net.hybridize(static_alloc=static_alloc)
+        out1, y1, grads1 = test(net, x)
+        num_graphs, num_plans = cache_files()
+        assert num_graphs == 1
+        assert num_plans >= 1
+        # hybridizing again builds a new CachedOp from the saved graphs and plans
+        net.hybridize(static_alloc=static_alloc)
+        out2, y2, grads2 = test(net, x)
+        assert cache_files() == (num_graphs, num_plans)
+
+    assert_almost_equal(out1, out2)
+    assert_almost_equal(y1, y2)
+    for key in grads1:
+        assert_almost_equal(grads1[key], grads2[key])
+
+
+def test_hybrid_cached_op_disk_cache_max_plans(tmpdir):
+    net = nn.HybridSequential()
+    net.add(nn.Dense(4))
+    net.initialize()
+    with environment({'MXNET_CACHED_OP_CACHE_DIR': str(tmpdir),
+                      'MXNET_CACHED_OP_CACHE_MAX_PLANS': '1'}):
+        net.hybridize()
+        for batch_size in range(1, 5):
+            net(mx.nd.ones((batch_size, 3))).wait_to_read()
+    plans = [f for f in os.listdir(str(tmpdir)) if '_plan_' in f]
+    assert len(plans) == 1
+
+
 def test_hook():
     global hook_call_count
     hook_call_count = 0
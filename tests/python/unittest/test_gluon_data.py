@@ -576,6 +576,15 @@ def test_batchify_pad():
                          [[ 9., 10., -1., -1.], [-1., -1., -1., -1.]]])
     assert mx.test_utils.almost_equal(d.asnumpy(), expected)
 
+def test_batchify_pack():
+    a = np.array([[1, 2], [3, 4], [5, 6]])
+    b = np.array([[7, 8]])
+    c = np.array([[9, 10], [11, 12]])
+    data, offsets = mx.gluon.data.batchify.Pack()([a, b, c])
+    assert mx.test_utils.almost_equal(data.asnumpy(), np.concatenate((a, b, c)))
+    assert offsets.dtype == np.int32
+    assert mx.test_utils.almost_equal(offsets.asnumpy(), np.array([0, 3, 4, 6]))
+
 def test_batchify_group():
     a = [np.array([[1, 2, 3, 4], [5, 6, 7, 8]]), np.array([[1, 2, 3, 4], [11, 12, 13, 14]])]
     b = [np.array([[1, 2, 3, 4], [5, 6, 7, 8]]), np.array([[4, 5, 6]])]
@@ -0,0 +1,127 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+
+import mxnet as mx
+from mxnet import autograd
+from mxnet.test_utils import assert_almost_equal
+
+
+def _compute(a, b):
+    c = mx.nd.elemwise_add(a, b)
+    d = mx.nd.relu(c) * 2
+    e = mx.nd.dot(d, b.T)
+    return [mx.nd.sum(e, axis=1), mx.nd.exp(-d)]
+
+
+def test_lazy_scope():
+    assert not mx.lazy.is_lazy()
+    with mx.lazy.scope():
+        assert mx.lazy.is_lazy()
+        with mx.lazy.scope(False):
+            assert not mx.lazy.is_lazy()
+        assert mx.lazy.is_lazy()
+    assert not mx.lazy.is_lazy()
+
+
+def test_lazy_matches_eager():
+    a = mx.nd.random.uniform(-1, 1, shape=(4, 5))
+    b = mx.nd.random.uniform(-1, 1, shape=(4, 5))
+    expected = [x.asnumpy() for x in _compute(a, b)]
+    with mx.lazy.scope():
+        # the same sequence of calls reuses the cached graph
+        for _ in range(3):
+            outputs = _compute(a, b)
+            for out, exp in zip(outputs, expected):
+                assert out.shape == exp.shape
+                assert_almost_equal(out.asnumpy(), exp)
+
+
+def test_lazy_flush_on_scope_exit():
+    a = mx.nd.ones((3, 3))
+    with mx.lazy.scope():
+        b = a + 1
+        c = b * 3
+        del b
+    assert_almost_equal(c.asnumpy(), np.full((3, 3), 6))
+
+
+def test_lazy_inplace_update():
+    a = mx.nd.ones((2, 3))
+    with mx.lazy.scope():
+        b = a * 2
+        # writes to an existing array run eagerly after the recorded reads
+        a += 1
+        a[:] = np.zeros((2, 3))
+        c = a + b
+    assert_almost_equal(b.asnumpy(), np.full((2, 3), 2))
+    assert_almost_equal(c.asnumpy(), np.full((2, 3), 2))
+
+
+def test_lazy_detach():
+    a = mx.nd.ones((2, 2))
+    with mx.lazy.scope():
+        b = (a + 1).detach()
+    assert_almost_equal(b.asnumpy(), np.full((2, 2), 2))
+
+
+def test_lazy_autograd():
+    x = mx.nd.random.uniform(shape=(3, 4))
+    w = mx.nd.random.uniform(shape=(5, 4))
+    x.attach_grad()
+    w.attach_grad()
+
+    def loss_fn():
+        with autograd.record():
+            h = mx.nd.tanh(mx.nd.FullyConnected(x, w, no_bias=True, num_hidden=5))
+            loss = mx.nd.sum(h * h)
+        loss.backward()
+        return loss.asnumpy(), x.grad.asnumpy(), w.grad.asnumpy()
+
+    expected = loss_fn()
+    with mx.lazy.scope():
+        for _ in range(2):
+            for out, exp in zip(loss_fn(), expected):
+                assert_almost_equal(out, exp, rtol=1e-5, atol=1e-6)
+
+
+def test_lazy_kvstore():
+    kv = mx.kv.create('local')
+    kv.init(3, mx.nd.zeros((2, 3)))
+    x = mx.nd.ones((2, 3))
+    w = mx.nd.ones((2, 3))
+    with mx.lazy.scope():
+        # the pushed value is still pending in the trace
+        y = x * 2
+        kv.push(3, y)
+        # the pull overwrites w, which a recorded operator still reads
+        z = w + 1
+        kv.pull(3, out=w)
+    assert_almost_equal(w.asnumpy(), np.full((2, 3), 2))
+    assert_almost_equal(z.asnumpy(), np.full((2, 3), 2))
+
+
+def test_lazy_copyto():
+    a = mx.nd.ones((2, 3))
+    b = mx.nd.zeros((2, 3))
+    with mx.lazy.scope():
+        c = a * 3
+        d = b + 1
+        c.copyto(b)
+    assert_almost_equal(b.asnumpy(), np.full((2, 3), 3))
+    assert_almost_equal(d.asnumpy(), np.full((2, 3), 1))
@@ -2063,3 +2063,37 @@ def test_readable_bfloat16_print():
     arr_float = arr_bfloat16.astype(float)
     assert (arr_bfloat16.__str__() == arr_float.__str__())
     assert (arr_bfloat16.__repr__().find(arr_uint16.__str__()) != -1)
+
+def test_bfloat16_amp_cast_rounding():
+    bfloat16 = np.dtype([('bfloat16', np.uint16)])
+    # ties round to even, everything else to nearest, denormals flush to zero as with
+    # AVX512-BF16; large enough to run in parallel
+    data = np.array([1.0, 1.00390625, 1.01171875, 1.0 + 2.0 ** -8 + 2.0 ** -20,
+                     -3.0, np.inf, -np.inf, 0.0, 2.0 ** -126, 2.0 ** -127, -2.0 ** -140],
+                    dtype=np.float32)
+    expected = np.array([1.0, 1.0, 1.015625, 1.0078125, -3.0, np.inf, -np.inf, 0.0,
+                         2.0 ** -126, 0.0, -0.0], dtype=np.float32)
+    data = np.tile(data, 1 << 15)
+    expected = np.tile(expected, 1 << 15)
+    arr_bf16 = mx.nd.amp_cast(mx.nd.array(data), dtype=bfloat16)
+    assert arr_bf16.dtype == bfloat16
+    assert_array_equal(mx.nd.amp_cast(arr_bf16, dtype='float32').asnumpy(), expected)
+    nan_bf16 = mx.nd.amp_cast(mx.nd.array([np.nan]), dtype=bfloat16)
+    assert np.isnan(mx.nd.amp_cast(nan_bf16, dtype='float32').asnumpy()).all()
+
+def test_repeated_invoke_attributes():
+    # repeated calls reuse inferred attributes, which must follow the parameters,
+    # shapes, dtypes and storage types of every call
+    a = mx.nd.arange(6).reshape((2, 3))
+    for _ in range(2):
+        assert mx.nd.sum(a, axis=0).shape == (3,)
+        assert mx.nd.sum(a, axis=1).shape == (2,)
+        assert mx.nd.sum(a.reshape((3, 2)), axis=0).shape == (2,)
+        assert mx.nd.sum(a.astype('float64'), axis=0).dtype == np.float64
+        assert mx.nd.cast_storage(a, stype='csr').stype == 'csr'
+        out = mx.nd.zeros((2, 3))
+        mx.nd.elemwise_add(a, a, out=out)
+        assert_array_equal(out.asnumpy(), 2 * a.asnumpy())
+        assertRaises(mx.base.MXNetError, mx.nd.elemwise_add, a, a, out=mx.nd.zeros((3, 2)))
+    with mx.np_shape():
+        assert mx.nd.sum(a, axis=0).shape == (3,)
@@ -8190,6 +8190,13 @@ def test_np_einsum():
         ('...ij, ...jc -> ...ic', [(2, 1, 5, 4), (2, 1, 4, 2)], lambda *args: (
                                                             _np.tile(args[1].sum(axis=3)[:, :, None, :], [1, 1, 5, 1]),
                                                              _np.tile(args[0].sum(axis=2)[:, :, : ,None], [1, 1, 1, 2]))),
+        # batched GEMM lowering, with and without transposed operands
+        ('bhqd, bhkd -> bhqk', [(2, 3, 4, 5), (2, 3, 6, 5)], lambda *args: (
+                                                            _np.tile(args[1].sum(axis=2)[:, :, None, :], [1, 1, 4, 1]),
+                                                            _np.tile(args[0].sum(axis=2)[:, :, None, :], [1, 1, 6, 1]))),
+        ('bij, bjk -> bki', [(2, 3, 4), (2, 4, 5)], lambda *args: (
+                                                            _np.tile(args[1].sum(axis=2)[:, None, :], [1, 3, 1]),
+                                                            _np.tile(args[0].sum(axis=1)[:, :, None], [1, 1, 5]))),
         # issue #16576
         # commented due to long running time
         # ('abiz,abjz->abij', [(64, 8, 128, 512), (64, 8, 128, 512)], lambda *args: (_np.matmul(_np.ones((64, 8, 128, 128)), args[1]),
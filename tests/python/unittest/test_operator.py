@@ -4078,6 +4078,20 @@ def test_order():
                     is_ascend=True)])
 
 
+def test_topk_ties_and_long_rows():
+    # ties are broken by the smaller index first, independently of the selection path
+    data = np.random.randint(0, 20, size=(2, 300000)).astype(np.float32)
+    for is_ascend in [False, True]:
+        for k in [1, 7, 1000]:
+            order = np.argsort(data if is_ascend else -data, axis=-1, kind='stable')[:, :k]
+            ind = mx.nd.topk(mx.nd.array(data), axis=-1, k=k, ret_typ='indices',
+                             is_ascend=is_ascend, dtype='int64')
+            assert_array_equal(ind.asnumpy(), order)
+            val = mx.nd.topk(mx.nd.array(data), axis=-1, k=k, ret_typ='value',
+                             is_ascend=is_ascend)
+            assert_array_equal(val.asnumpy(), np.take_along_axis(data, order, axis=-1))
+
+
 def test_blockgrad():
     a = mx.sym.Variable('a')
     b = mx.sym.BlockGrad(a)
@@ -5237,6 +5251,87 @@ def test_ctc_loss_grad():
         for label in ['first', 'last']:
             check_ctc_loss_grad(label, contrib=contrib)
 
+def _ctc_loss_reference(acts, label, blank):
+    """Negative log-likelihood and gradient of one sequence, in float64. A label that
+    does not fit into the sequence has zero loss and gradient."""
+    lp = acts - acts.max(axis=1, keepdims=True)
+    lp = lp - np.log(np.exp(lp).sum(axis=1, keepdims=True))
+    T = acts.shape[0]
+    ext = [blank]
+    for l in label:
+        ext += [l, blank]
+    S = len(ext)
+    skip = [s >= 2 and ext[s] != blank and ext[s] != ext[s - 2] for s in range(S)]
+    alpha = np.full((T, S), -np.inf)
+    alpha[0, 0] = lp[0, ext[0]]
+    if S > 1:
+        alpha[0, 1] = lp[0, ext[1]]
+    for t in range(1, T):
+        for s in range(S):
+            a = alpha[t - 1, s]
+            if s >= 1:
+                a = np.logaddexp(a, alpha[t - 1, s - 1])
+            if skip[s]:
+                a = np.logaddexp(a, alpha[t - 1, s - 2])
+            alpha[t, s] = a + lp[t, ext[s]]
+    loglike = alpha[T - 1, S - 1]
+    if S > 1:
+        loglike = np.logaddexp(loglike, alpha[T - 1, S - 2])
+    if loglike == -np.inf:
+        return 0., np.zeros_like(acts)
+    # beta[t, s] excludes the emission at time t
+    beta = np.full((T, S), -np.inf)
+    beta[T - 1, S - 1] = 0
+    if S > 1:
+        beta[T - 1, S - 2] = 0
+    for t in range(T - 2, -1, -1):
+        for s in range(S):
+            b = beta[t + 1, s] + lp[t + 1, ext[s]]
+            if s + 1 < S:
+                b = np.logaddexp(b, beta[t + 1, s + 1] + lp[t + 1, ext[s + 1]])
+            if s + 2 < S and skip[s + 2]:
+                b = np.logaddexp(b, beta[t + 1, s + 2] + lp[t + 1, ext[s + 2]])
+            beta[t, s] = b
+    grad = np.exp(lp)
+    for s in range(S):
+        grad[:, ext[s]] -= np.exp(alpha[:, s] + beta[:, s] - loglike)
+    return -loglike, grad
+
+@pytest.mark.parametrize('blank_label', ['first', 'last'])
+def test_ctc_loss_ragged_against_reference(blank_label):
+    max_seq_len, alphabet_size = 8, 5
+    offset = 1 if blank_label == 'first' else 0
+    blank = 0 if blank_label == 'first' else alphabet_size - 1
+    # ragged lengths, repeated consecutive labels which need a blank in between, and
+    # a last sequence too short for its labels
+    data_lengths = [8, 5, 6, 3]
+    labels = [[0, 1, 2], [1, 1], [2, 2, 0, 0], [1, 1, 1]]
+    max_label_len = max(len(l) for l in labels)
+    padded = np.array([[l + offset for l in label] + [offset - 1] * (max_label_len - len(label))
+                       for label in labels], dtype=np.float32)
+    rng = np.random.RandomState(1234)
+    acts = rng.uniform(-2, 2, size=(max_seq_len, len(labels), alphabet_size)).astype(np.float32)
+
+    expected_loss = np.zeros(len(labels))
+    expected_grad = np.zeros(acts.shape)
+    for b, label in enumerate(labels):
+        T = data_lengths[b]
+        expected_loss[b], expected_grad[:T, b] = _ctc_loss_reference(
+            acts[:T, b].astype(np.float64), [l + offset for l in label], blank)
+    assert expected_loss[3] == 0
+
+    data = mx.nd.array(acts)
+    data.attach_grad()
+    with mx.autograd.record():
+        loss = mx.nd.ctc_loss(data, mx.nd.array(padded),
+                              data_lengths=mx.nd.array(data_lengths),
+                              label_lengths=mx.nd.array([len(l) for l in labels]),
+                              use_data_lengths=True, use_label_lengths=True,
+                              blank_label=blank_label)
+    loss.backward()
+    assert_almost_equal(loss, expected_loss, rtol=1e-4, atol=1e-5)
+    assert_almost_equal(data.grad, expected_grad, rtol=1e-4, atol=1e-5)
+
 def test_quantization_op():
     min0 = mx.nd.array([0.0])
     max0 = mx.nd.array([1.0])
@@ -9105,6 +9200,163 @@ def test_multihead_attention_encdec():
     for dtype in dtypes:
         check_multihead_attention_encdec(dtype=dtype)
 
+def _fused_selfatt_reference(qkv, heads, causal, valid_length):
+    seq_len, batch_size, proj_dim = qkv.shape
+    head_dim = proj_dim // (3 * heads)
+    def project(index):
+        x = mx.nd.slice_axis(qkv.reshape((seq_len, batch_size, heads, 3, head_dim)),
+                             axis=3, begin=index, end=index + 1)
+        x = x.reshape((seq_len, batch_size, heads, head_dim)).transpose((1, 2, 0, 3))
+        return x.reshape((batch_size * heads, seq_len, head_dim))
+    q, k, v = project(0), project(1), project(2)
+    scores = mx.nd.batch_dot(q, k, transpose_b=True) / math.sqrt(head_dim)
+    mask = np.zeros((batch_size * heads, seq_len, seq_len), dtype=np.float32)
+    for b in range(batch_size):
+        for h in range(heads):
+            if valid_length is not None:
+                mask[b * heads + h, :, valid_length[b]:] = -1e9
+            if causal:
+                mask[b * heads + h][np.triu_indices(seq_len, 1)] = -1e9
+    att = mx.nd.softmax(scores + mx.nd.array(mask, dtype=qkv.dtype), axis=-1)
+    out = mx.nd.batch_dot(att, v).reshape((batch_size, heads, seq_len, head_dim))
+    return out.transpose((2, 0, 1, 3)).reshape((seq_len, batch_size, heads * head_dim))
+
+@pytest.mark.parametrize('causal', [False, True])
+@pytest.mark.parametrize('use_length', [False, True])
+def test_fused_selfatt(causal, use_length):
+    seq_len, batch_size, heads, head_dim = 37, 3, 2, 8
+    lengths = [37, 1, 20]
+    ctx = mx.cpu()
+    qkv_np = np.random.uniform(-1, 1, (seq_len, batch_size, 3 * heads * head_dim))
+    ograd_np = np.random.uniform(-1, 1, (seq_len, batch_size, heads * head_dim))
+    valid_length = mx.nd.array(lengths, ctx=ctx) if use_length else None
+    args = [valid_length] if use_length else []
+
+    qkv = mx.nd.array(qkv_np, ctx=ctx)
+    qkv.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.contrib.fused_selfatt(qkv, *args, heads=heads, causal=causal,
+                                          use_length=use_length, block_size=8)
+    out.backward(mx.nd.array(ograd_np, ctx=ctx))
+
+    qkv_ref = mx.nd.array(qkv_np, ctx=ctx)
+    qkv_ref.attach_grad()
+    with mx.autograd.record():
+        out_ref = _fused_selfatt_reference(qkv_ref, heads, causal,
+                                           lengths if use_length else None)
+    out_ref.backward(mx.nd.array(ograd_np, ctx=ctx))
+    assert_almost_equal(out, out_ref, rtol=1e-4, atol=1e-5)
+    assert_almost_equal(qkv.grad, qkv_ref.grad, rtol=1e-4, atol=1e-5)
+
+    # reduced precision inputs still accumulate in float32
+    for dtype in [np.float16, np.dtype([('bfloat16', np.uint16)])]:
+        low = mx.nd.array(qkv_np, ctx=ctx).astype(dtype)
+        out_low = mx.nd.contrib.fused_selfatt(low, *args, heads=heads, causal=causal,
+                                              use_length=use_length, block_size=8)
+        assert_almost_equal(out_low.astype('float32'), out_ref, rtol=5e-2, atol=5e-2)
+
+@pytest.mark.parametrize('causal', [False, True])
+def test_varlen_selfatt(causal):
+    heads, head_dim = 2, 8
+    lengths = [37, 1, 0, 20]
+    ctx = mx.cpu()
+    samples = [np.random.uniform(-1, 1, (l, 3 * heads * head_dim)) for l in lengths]
+    qkv_np, cu_seqlens = mx.gluon.data.batchify.Pack(dtype='float64')(samples)
+    ograd = mx.nd.random.uniform(-1, 1, (qkv_np.shape[0], heads * head_dim), ctx=ctx)
+
+    qkv = qkv_np.astype('float32')
+    qkv.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.contrib.varlen_selfatt(qkv, cu_seqlens, heads=heads, causal=causal,
+                                           block_size=8)
+    out.backward(ograd)
+
+    offsets = cu_seqlens.asnumpy()
+    for b, length in enumerate(lengths):
+        if length == 0:
+            continue
+        begin, end = offsets[b], offsets[b + 1]
+        qkv_ref = mx.nd.array(samples[b], ctx=ctx).expand_dims(1)
+        qkv_ref.attach_grad()
+        with mx.autograd.record():
+            out_ref = _fused_selfatt_reference(qkv_ref, heads, causal, None)
+        out_ref.backward(ograd[begin:end].expand_dims(1))
+        assert_almost_equal(out[begin:end], out_ref[:, 0], rtol=1e-4, atol=1e-5)
+        assert_almost_equal(qkv.grad[begin:end], qkv_ref.grad[:, 0], rtol=1e-4, atol=1e-5)
+
+@pytest.mark.parametrize('ring', [False, True])
+def test_kv_cache_selfatt(ring):
+    steps, batch_size, heads, head_dim, capacity = 13, 2, 2, 8, 4
+    ctx = mx.cpu()
+    qkv_np = np.random.uniform(-1, 1, (steps, batch_size, 3 * heads * head_dim))
+    cache = mx.nd.contrib.KVCache(batch_size, heads, head_dim, capacity=capacity,
+                                  ring=ring, ctx=ctx)
+    # the second sequence starts over at step 5, decoding sequences of different lengths
+    restart = 5
+    for t in range(steps):
+        if t == restart:
+            cache.reset(1)
+        out = cache.step(mx.nd.array(qkv_np[t], ctx=ctx), block_size=3)
+        for b, start in enumerate([0, restart if t >= restart else 0]):
+            if ring:
+                start = max(start, t + 1 - capacity)
+            prefix = mx.nd.array(qkv_np[start:t + 1, b:b + 1], ctx=ctx)
+            expected = _fused_selfatt_reference(prefix, heads, True, None)[-1, 0]
+            assert_almost_equal(out[b], expected, rtol=1e-4, atol=1e-5)
+    expected_lengths = [steps, steps - restart]
+    assert_array_equal(cache.lengths.asnumpy(), expected_lengths)
+    if ring:
+        assert cache.capacity == capacity
+    else:
+        assert cache.capacity == 16
+        full = mx.nd.contrib.KVCache(1, heads, head_dim, capacity=1, ctx=ctx)
+        step = mx.nd.array(qkv_np[0, :1], ctx=ctx)
+        full.step(step)
+        assertRaises(MXNetError, lambda: mx.nd.contrib.kv_cache_selfatt(
+            step, full.key_cache, full.value_cache, full.lengths, heads=heads).asnumpy())
+
+@pytest.mark.parametrize('dtype', [np.float32, np.float64])
+@pytest.mark.parametrize('shape', [(2, 3, 16), (5, 37)])
+def test_residual_layer_norm(dtype, shape):
+    rtol, atol = (1e-4, 1e-5) if dtype == np.float32 else (1e-8, 1e-10)
+    data = mx.nd.random.normal(shape=shape, dtype=dtype)
+    residual = mx.nd.random.normal(shape=shape, dtype=dtype)
+    gamma = mx.nd.random.uniform(0.5, 1.5, shape=shape[-1:], dtype=dtype)
+    beta = mx.nd.random.normal(shape=shape[-1:], dtype=dtype)
+    ograd = mx.nd.random.normal(shape=shape, dtype=dtype)
+    args = [data, residual, gamma, beta]
+
+    # without dropout it matches LayerNorm(residual + data), gradients included
+    for x in args:
+        x.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.contrib.residual_layer_norm(*args, p=0)
+    out.backward(ograd)
+    grads = [x.grad.copy() for x in args]
+    with mx.autograd.record():
+        out_ref = mx.nd.LayerNorm(residual + data, gamma, beta)
+    out_ref.backward(ograd)
+    assert_almost_equal(out, out_ref, rtol=rtol, atol=atol)
+    for grad, x in zip(grads, args):
+        assert_almost_equal(grad, x.grad, rtol=rtol, atol=atol)
+
+    # with dropout, the mask is recovered from the gradients and replayed
+    p = 0.3
+    with mx.autograd.record():
+        out = mx.nd.contrib.residual_layer_norm(*args, p=p, mode='always')
+    out.backward(ograd)
+    data_grad, residual_grad = data.grad.asnumpy(), residual.grad.asnumpy()
+    keep = np.abs(data_grad) > 0.5 * np.abs(residual_grad)
+    mask = keep / (1 - p)
+    assert_almost_equal(data_grad, residual_grad * mask, rtol=rtol, atol=atol)
+    assert 0 < keep.mean() < 1
+    out_ref = mx.nd.LayerNorm(residual + data * mx.nd.array(mask, dtype=dtype), gamma, beta)
+    assert_almost_equal(out, out_ref, rtol=rtol, atol=atol)
+
+    # dropout is off at inference in training mode
+    out = mx.nd.contrib.residual_layer_norm(*args, p=p)
+    assert_almost_equal(out, mx.nd.LayerNorm(residual + data, gamma, beta), rtol=rtol, atol=atol)
+
 @pytest.mark.serial
 def test_im2col_col2im():
     def compute_output_size(spatial, kernel, stride=1, dilate=1, pad=0):
@@ -834,6 +834,109 @@ def test_adagrad():
                               opt2(use_fused_step=True, **kwarg), shapes, dtype)
 
 
+def test_multi_tensor_uneven_sizes():
+    # small and large weights are mixed so that the element-balanced split of the
+    # multi-tensor kernels starts and ends threads in the middle of weights
+    shapes = [(3,), (20011,), (7, 5), (1,), (300, 101), (13,)]
+    optimizers = [(mx.optimizer.Adam, {}),
+                  (mx.optimizer.RMSProp, {'clip_weights': 0.9}),
+                  (mx.optimizer.NAG, {'momentum': 0.9}),
+                  (mx.optimizer.FTML, {}),
+                  (mx.optimizer.AdaGrad, {})]
+    for opt, opt_kwarg in optimizers:
+        for agg in [2, 4, np.inf]:
+            kwarg = dict(opt_kwarg, wd=0.01, clip_gradient=0.5, aggregate_num=agg)
+            compare_optimizer(opt(use_fused_step=False, **kwarg),
+                              opt(use_fused_step=True, **kwarg), shapes, np.float32,
+                              rtol=1e-4, atol=2e-5)
+
+
+def test_multi_tensor_max_weights():
+    # the optimizers slice their weights by the limit of the multi-tensor kernels
+    from mxnet.optimizer.utils import _MAX_MULTI_TENSOR_WEIGHTS
+
+    def update(num_weights):
+        weights = [mx.nd.ones((2,)) for _ in range(num_weights)]
+        args = [[w, mx.nd.ones((2,)), mx.nd.zeros((2,))] for w in weights]
+        mx.nd.multi_adagrad_update(*[a for arg in args for a in arg], out=weights,
+                                   num_weights=num_weights, lrs=[0.1] * num_weights,
+                                   wds=[0.] * num_weights)
+        mx.nd.waitall()
+
+    update(_MAX_MULTI_TENSOR_WEIGHTS)
+    with pytest.raises(mx.MXNetError):
+        update(_MAX_MULTI_TENSOR_WEIGHTS + 1)
+
+
+def test_bfloat16_multi_precision():
+    # the mp_* kernels on bfloat16 weights must match the generic path, which updates
+    # the float32 master copy with the unfused ops and rounds it back with amp_cast
+    bfloat16 = np.dtype([('bfloat16', np.uint16)])
+    shapes = [(3,), (20011,), (7, 5)]
+    optimizers = [(mx.optimizer.SGD, {}),
+                  (mx.optimizer.SGD, {'momentum': 0.9}),
+                  (mx.optimizer.NAG, {'momentum': 0.9}),
+                  (mx.optimizer.LAMB, {})]
+    for opt, opt_kwarg in optimizers:
+        for agg in [1, 4]:
+            kwarg = dict(opt_kwarg, wd=0.01, clip_gradient=0.5, aggregate_num=agg,
+                         multi_precision=True)
+            opt1 = opt(use_fused_step=False, **kwarg)
+            opt2 = opt(use_fused_step=True, **kwarg)
+            indices = list(range(len(shapes)))
+            w1 = [mx.nd.random.uniform(shape=s).astype(bfloat16) for s in shapes]
+            w2 = [w.copy() for w in w1]
+            s1 = [opt1.create_state_multi_precision(i, w) for i, w in zip(indices, w1)]
+            s2 = [opt2.create_state_multi_precision(i, w) for i, w in zip(indices, w2)]
+            for _ in range(3):
+                g = [mx.nd.random.normal(shape=s).astype(bfloat16) for s in shapes]
+                opt1.update_multi_precision(indices, w1, g, s1)
+                opt2.update_multi_precision(indices, w2, g, s2)
+            for a, b, sa, sb in zip(w1, w2, s1, s2):
+                assert a.dtype == bfloat16 and b.dtype == bfloat16
+                assert_almost_equal(sa[0], sb[0], rtol=1e-4, atol=1e-5)
+                assert_almost_equal(a.astype('float32'), b.astype('float32'),
+                                    rtol=1e-2, atol=1e-2)
+
+
+def _round_to_bfloat16(x):
+    # round float32 to the nearest bfloat16 value, ties to even
+    bits = x.astype(np.float32).view(np.uint32).astype(np.uint64)
+    bits = ((bits + 0x7fff + ((bits >> 16) & 1)) >> 16) << 16
+    return bits.astype(np.uint32).view(np.float32)
+
+
+@pytest.mark.parametrize('opt,use_fused_step', [
+    (mx.optimizer.Adam, False),
+    (mx.optimizer.Adam, True),
+    (mx.optimizer.AdamW, False),
+    (mx.optimizer.AdamW, True),
+])
+def test_bfloat16_multi_precision_adam(opt, use_fused_step):
+    # the float32 master copy follows the float32 optimizer, and the bfloat16 weights
+    # are the master copy rounded to nearest even
+    bfloat16 = np.dtype([('bfloat16', np.uint16)])
+    shapes = [(3,), (20011,), (7, 5)]
+    kwarg = dict(wd=0.01, clip_gradient=0.5, use_fused_step=use_fused_step)
+    opt_bf16 = opt(multi_precision=True, **kwarg)
+    opt_fp32 = opt(**kwarg)
+    indices = list(range(len(shapes)))
+    w_bf16 = [mx.nd.random.uniform(shape=s).astype(bfloat16) for s in shapes]
+    w_fp32 = [w.astype('float32') for w in w_bf16]
+    s_bf16 = [opt_bf16.create_state_multi_precision(i, w) for i, w in zip(indices, w_bf16)]
+    s_fp32 = [opt_fp32.create_state(i, w) for i, w in zip(indices, w_fp32)]
+    for _ in range(3):
+        g_bf16 = [mx.nd.random.normal(shape=s).astype(bfloat16) for s in shapes]
+        g_fp32 = [g.astype('float32') for g in g_bf16]
+        opt_bf16.update_multi_precision(indices, w_bf16, g_bf16, s_bf16)
+        opt_fp32.update(indices, w_fp32, g_fp32, s_fp32)
+    for w, s, ref in zip(w_bf16, s_bf16, w_fp32):
+        assert w.dtype == bfloat16
+        master = s[0].asnumpy()
+        assert_almost_equal(master, ref, rtol=1e-4, atol=1e-5)
+        np.testing.assert_array_equal(w.astype('float32').asnumpy(), _round_to_bfloat16(master))
+
+
 @xfail_when_nonstandard_decimal_separator
 def test_sparse_adagrad():
     opt1 = PySparseAdaGrad
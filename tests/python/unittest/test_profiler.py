@@ -240,6 +240,36 @@ def test_continuous_profile_and_instant_marker():
     profiler.set_state('stop')
 
 
+def test_binary_trace(tmpdir):
+    trace_file = str(tmpdir.join('test_binary_trace.mxtrace'))
+    json_file = str(tmpdir.join('test_binary_trace.json'))
+    profiler.set_config(profile_all=True, filename=trace_file, continuous_dump=False,
+                        aggregate_stats=True, trace_format='binary')
+    profiler.set_state('run')
+    python_domain = profiler.Domain('PythonDomain::test_binary_trace')
+    counter = profiler.Counter(python_domain, 'PythonCounter::test_binary_trace')
+    counter.set_value(5)
+    profiler.Marker(python_domain, 'PythonMarker::test_binary_trace').mark('process')
+    mx.nd.sqrt(mx.nd.ones((10, 10))).wait_to_read()
+    profiler.set_state('stop')
+    stats = json.loads(profiler.dumps(format='json'))
+    profiler.dump(True)
+    # the aggregate stats are kept as with json traces
+    assert any(name.startswith('sqrt') for name in stats['Time']['operator'])
+
+    assert profiler.convert_trace(trace_file, json_file) == 0
+    with open(json_file) as f:
+        events = json.load(f)['traceEvents']
+    sqrt = [e for e in events if e['name'].startswith('sqrt') and e['cat'] == 'operator']
+    assert sorted(e['ph'] for e in sqrt) == ['B', 'E']
+    assert sqrt[0]['ts'] <= sqrt[1]['ts']
+    counts = [e for e in events if e['name'] == 'PythonCounter::test_binary_trace']
+    assert counts[0]['ph'] == 'C'
+    assert counts[0]['args'] == {'PythonCounter::test_binary_trace': 5}
+    assert any(e['ph'] == 'i' and e['s'] == 'p' for e in events)
+    profiler.set_config(filename='profile.json', trace_format='json')
+
+
 def test_aggregate_stats_valid_json_return():
     file_name = 'test_aggregate_stats_json_return.json'
     enable_profiler(file_name, True, True, True)
@@ -281,6 +311,78 @@ def test_aggregate_stats_sorting():
     profiler.set_state('stop')
 
 
+def test_op_histograms():
+    prev = profiler.set_op_histograms(True)
+    try:
+        profiler.op_histograms(reset=True)
+        inp = mx.nd.zeros(shape=(100, 100))
+        for _ in range(3):
+            inp = mx.nd.sqrt(inp)
+        mx.nd.waitall()
+        hists = profiler.op_histograms(reset=True)
+        sqrt = hists['operator']['sqrt']
+        assert sqrt['count'] == 3
+        assert sum(b[2] for b in sqrt['buckets']) == 3
+        assert sqrt['min_ns'] <= sqrt['p50_ns'] <= sqrt['p99_ns'] <= sqrt['max_ns']
+        assert sqrt['min_ns'] * 3 <= sqrt['sum_ns'] <= sqrt['max_ns'] * 3
+        for lower, upper, _ in sqrt['buckets']:
+            assert lower < upper
+
+        hists = profiler.op_histograms()
+        assert 'sqrt' not in hists['operator'] or hists['operator']['sqrt']['count'] == 0
+
+        profiler.set_op_histograms(False)
+        mx.nd.sqrt(inp).wait_to_read()
+        hists = profiler.op_histograms()
+        assert 'sqrt' not in hists['operator'] or hists['operator']['sqrt']['count'] == 0
+    finally:
+        profiler.set_op_histograms(prev)
+
+
+def test_metrics():
+    def sample(text, name):
+        lines = [l for l in text.splitlines() if l.startswith(name + ' ')]
+        assert len(lines) <= 1, name
+        return float(lines[0].split()[-1]) if lines else 0
+
+    prev = profiler.set_op_histograms(True)
+    try:
+        before = profiler.metrics()
+        kv = mx.kv.create('local')
+        kv.init('metrics', mx.nd.ones((10, 10)))
+        kv.push('metrics', mx.nd.ones((10, 10)))
+        out = mx.nd.zeros((10, 10))
+        kv.pull('metrics', out=out)
+        loader = mx.gluon.data.DataLoader(mx.gluon.data.ArrayDataset(np.ones((8, 2))),
+                                          batch_size=2)
+        for _ in loader:
+            pass
+        mx.nd.sqrt(out).wait_to_read()
+        text = profiler.metrics()
+    finally:
+        profiler.set_op_histograms(prev)
+    assert text.endswith('# EOF\n')
+    for name in ['mxnet_kvstore_pushed_bytes_total', 'mxnet_kvstore_pulled_bytes_total',
+                 'mxnet_dataloader_wait_seconds_count']:
+        assert sample(text, name) - sample(before, name) == (4 if 'dataloader' in name else 400)
+    assert sample(text, 'mxnet_dataloader_wait_seconds_sum') > 0
+    assert sample(text, 'mxnet_engine_pending_operators') >= 0
+    assert 'mxnet_operator_latency_seconds_count{op="sqrt"}' in text
+    assert 'mxnet_memory_pooled_bytes{device="cpu(0)"}' in text
+    assert 'mxnet_dataloader_wait_seconds_bucket{le="+Inf"}' in text
+
+    import urllib.request
+    server = profiler.start_metrics_server()
+    try:
+        url = 'http://127.0.0.1:{}/metrics'.format(server.server_address[1])
+        with urllib.request.urlopen(url) as resp:
+            assert resp.headers['Content-Type'].startswith('application/openmetrics-text')
+            assert resp.read().decode('utf-8').endswith('# EOF\n')
+    finally:
+        server.shutdown()
+        server.server_close()
+
+
 @pytest.mark.skip(reason='https://github.com/apache/incubator-mxnet/issues/18564')
 def test_aggregate_duplication():
     file_name = 'test_aggregate_duplication.json'
@@ -307,6 +409,61 @@ def test_aggregate_duplication():
     profiler.set_state('stop')
 
 
+def test_aggregate_throughput():
+    enable_profiler('test_aggregate_throughput.json', run=True, aggregate_stats=True)
+    profiler.dumps(reset=True)
+    a = mx.nd.ones((256, 512))
+    b = mx.nd.ones((512, 256))
+    mx.nd.dot(a, b).wait_to_read()
+    mx.nd.sqrt(a).wait_to_read()
+    net = nn.HybridSequential()
+    net.add(nn.Dense(16, in_units=512))
+    net.initialize()
+    net.hybridize(static_alloc=True)
+    net(a).wait_to_read()
+    mx.nd.waitall()
+    stats = json.loads(profiler.dumps(format='json'))
+    profiler.set_state('stop')
+    operators = stats['Time']['operator']
+    dot = next(s for name, s in operators.items() if name.startswith('dot'))
+    sqrt = next(s for name, s in operators.items() if name.startswith('sqrt'))
+    # dot registers its flops, sqrt only counts the bytes of its arrays
+    assert dot['GFLOP/s'] > 0 and dot['GB/s'] > 0
+    assert sqrt['GFLOP/s'] == 0 and sqrt['GB/s'] > 0
+    cached_ops = stats['Time']['CachedOp']
+    assert len(cached_ops) == 1
+    assert all(s['GFLOP/s'] > 0 for s in cached_ops.values())
+
+
+def test_critical_path(tmpdir):
+    trace_file = str(tmpdir.join('test_critical_path.json'))
+    profiler.set_config(profile_all=True, filename=trace_file, continuous_dump=False)
+    profiler.set_state('run')
+    a = mx.nd.ones((256, 256))
+    b = mx.nd.dot(a, a)
+    c = mx.nd.dot(b, a)
+    mx.nd.dot(c, a)
+    mx.nd.sqrt(a)
+    mx.nd.waitall()
+    profiler.set_state('stop')
+    profiler.dump(True)
+    with open(trace_file) as f:
+        events = json.load(f)['traceEvents']
+    dots = [ev['args'] for ev in events if ev['name'].startswith('dot') and ev['ph'] == 'B']
+    # every dot waits for the dot that produced its input
+    assert dots[1]['deps'].count(dots[0]['id']) == 1
+    assert dots[2]['deps'].count(dots[1]['id']) == 1
+
+    result = profiler.critical_path(trace_file)
+    names = [name for name, _ in result['critical_path']]
+    assert sum(name.startswith('dot') for name in names) == 3
+    assert not any(name.startswith('sqrt') for name in names)
+    assert result['critical_time'] <= result['span']
+    assert all(idle >= 0 for idle in result['idle'].values())
+    assert result['speedup'][0][0].startswith('dot')
+    profiler.set_config(filename='profile.json')
+
+
 def test_custom_operator_profiling(seed=None, file_name=None):
     class Sigmoid(mx.operator.CustomOp):
         def forward(self, is_train, req, in_data, out_data, aux):
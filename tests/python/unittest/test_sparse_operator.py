@@ -1404,6 +1404,26 @@ def test_sparse_dot_determinism():
     check_dot_determinism('csr', 'default', 0.1, 1.0, True, False, 'default')
 
 
+def test_sparse_dot_skewed_rows():
+    # power-law rows: a few rows hold most of the non-zeros and are split across threads
+    num_rows, num_cols = 200, 300
+    dense = np.zeros((num_rows, num_cols), dtype=np.float32)
+    for row in [0, 7, 150]:
+        dense[row] = np.random.uniform(-1, 1, num_cols)
+    for row in range(num_rows):
+        cols = np.random.randint(0, num_cols, size=2)
+        dense[row, cols] = np.random.uniform(-1, 1, 2)
+    dense[-20:] = 0
+    lhs = mx.nd.array(dense).tostype('csr')
+    for rhs_cols in [1, 31, 70]:
+        rhs = np.random.uniform(-1, 1, (num_cols, rhs_cols)).astype(np.float32)
+        out = mx.nd.sparse.dot(lhs, mx.nd.array(rhs))
+        assert_almost_equal(out.asnumpy(), np.dot(dense, rhs), rtol=1e-4, atol=1e-4)
+        # an existing output is overwritten
+        out_prev = mx.nd.ones((num_rows, rhs_cols))
+        mx.nd.sparse.dot(lhs, mx.nd.array(rhs), out=out_prev)
+        assert_almost_equal(out_prev.asnumpy(), np.dot(dense, rhs), rtol=1e-4, atol=1e-4)
+
 def test_sparse_slice():
     def check_csr_slice(shape, slice_input):
         storage_type = 'csr'
@@ -1783,12 +1803,12 @@ def test_sparse_embedding():
             assert(grad_map["embed_weight"].stype == target_stype)
 
     densities = [0, 0.5, 1]
-    in_dim = 50
     out_dim = 3
-    batch = 8
     sparse_grads = [True, False]
-    for sparse_grad in sparse_grads:
-        check_sparse_embedding(in_dim, out_dim, batch, densities, sparse_grad)
+    # vocabularies larger and smaller than the batch, with repeated indices
+    for in_dim, batch in [(50, 8), (300, 100), (8, 50)]:
+        for sparse_grad in sparse_grads:
+            check_sparse_embedding(in_dim, out_dim, batch, densities, sparse_grad)
 
 def test_sparse_broadcast_add_sub():
     def check_broadcast_add(mx_lhs, mx_rhs, np_lhs, np_rhs, dtype):
@@ -17,6 +17,7 @@
 
 import os
 import ctypes
+import json
 import mxnet as mx
 from mxnet.base import SymbolHandle, check_call, _LIB, mx_uint, c_str_array, c_str, mx_real_t
 from mxnet.symbol import Symbol
@@ -517,6 +518,34 @@ def test_subgraph_backend_gluon_ext2(tmpdir):
         assert_almost_equal((outputs1[i] - outputs2[i]).abs().sum().asnumpy(), np.zeros(shape=(1,)))
 
 
+@pytest.mark.parametrize('use_dropout', [False, True])
+def test_residual_layer_norm_fusion(use_dropout):
+    data = mx.sym.var('data')
+    residual = mx.sym.var('residual')
+    h = mx.sym.Dropout(data, p=0.1) if use_dropout else data
+    sym = mx.sym.LayerNorm(residual + h, mx.sym.var('gamma'), mx.sym.var('beta'))
+    sym = mx.sym.relu(sym)
+    shape = (4, 10, 32)
+    args = {'data': mx.nd.random.normal(shape=shape),
+            'residual': mx.nd.random.normal(shape=shape),
+            'gamma': mx.nd.random.uniform(shape=(shape[-1],)),
+            'beta': mx.nd.random.normal(shape=(shape[-1],))}
+    part_sym = sym.optimize_for('ResidualLayerNorm')
+    op_names = [node['op'] for node in json.loads(part_sym.tojson())['nodes']]
+    assert '_contrib_residual_layer_norm' in op_names
+    assert 'LayerNorm' not in op_names and 'elemwise_add' not in op_names
+    out = sym._bind(mx.cpu(), args=args).forward()[0]
+    part_out = part_sym._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(out, part_out, rtol=1e-5, atol=1e-6)
+
+    # the add is not fused when its output is used elsewhere
+    shared = residual + data
+    sym = mx.sym.LayerNorm(shared, mx.sym.var('gamma'), mx.sym.var('beta')) + shared
+    part_sym = sym.optimize_for('ResidualLayerNorm')
+    op_names = [node['op'] for node in json.loads(part_sym.tojson())['nodes']]
+    assert '_contrib_residual_layer_norm' not in op_names
+
+
 if __name__ == "__main__":
     import datetime
     tmpdir = datetime.datetime.now().strftime('mylogfile_%H_%M_%S_%f_%d_%m_%Y.log')
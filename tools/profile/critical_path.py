@@ -0,0 +1,45 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Print the chain of dependent operators that determines the step time of a profile,
+the idle time of every worker and the operators worth optimizing.
+"""
+import argparse
+
+from mxnet.profiler import critical_path
+
+parser = argparse.ArgumentParser(description='Analyze the critical path of an MXNet trace')
+parser.add_argument('trace', type=str, help='chrome trace json written by the profiler')
+parser.add_argument('--top', type=int, default=5,
+                    help='number of operators to report as worth optimizing')
+args = parser.parse_args()
+
+result = critical_path(args.trace, args.top)
+print('span of the operators: %d us, longest dependency chain: %d us'
+      % (result['span'], result['critical_time']))
+print('\ncritical path:')
+for name, duration in result['critical_path']:
+    print('  %10d us  %s' % (duration, name))
+print('\nidle time per worker:')
+for (pid, tid), idle in sorted(result['idle'].items(), key=lambda w: w[1]):
+    print('  %10d us  pid %s tid %s' % (idle, pid, tid))
+print('\nstep time saved if the operator took no time:')
+for name, saved in result['speedup']:
+    print('  %10d us  %s' % (saved, name))
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Convert a profile written with trace_format='binary' to chrome trace json,
+which chrome://tracing and the Perfetto UI open.
+"""
+import argparse
+import sys
+
+from mxnet.profiler import convert_trace
+
+parser = argparse.ArgumentParser(description='Convert a binary MXNet trace to chrome trace json')
+parser.add_argument('trace', type=str, help='the binary trace to read')
+parser.add_argument('output', type=str, help='the json file to write')
+args = parser.parse_args()
+
+dropped = convert_trace(args.trace, args.output)
+if dropped:
+    print('%d records were overwritten before they were dumped, increase '
+          'MXNET_PROFILER_TRACE_BUFFER_SIZE or dump more often to keep them' % dropped,
+          file=sys.stderr)
@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Measure the operator tuning database of this host offline, so that MXNet processes started
+with MXNET_OPERATOR_TUNING_DIR load it instead of timing the kernels, and print how many OMP
+threads every tuned kernel uses for each range of sizes.
+"""
+import argparse
+import json
+import os
+import socket
+import subprocess
+import sys
+
+WORKLOAD_COUNT_SHIFT = 11
+
+
+def best_thread_count(db, workload, size, threads):
+    """The same choice as OperatorTuneBase::IsOMPFaster and BestThreadCount"""
+    serial = int(size * workload)
+    serial_time = serial >> WORKLOAD_COUNT_SHIFT
+    if threads < 2 or db['omp_overhead'] + ((serial // threads) >> WORKLOAD_COUNT_SHIFT) \
+            >= serial_time:
+        return 1
+    overheads = db['omp_overhead_by_threads']
+    if len(overheads) < 3:
+        return threads
+    best, best_time = 1, serial_time
+    for count in range(2, threads + 1):
+        time = overheads[min(count, len(overheads) - 1)] + \
+            ((serial // count) >> WORKLOAD_COUNT_SHIFT)
+        if time < best_time:
+            best, best_time = count, time
+    return best
+
+
+def size_ranges(db, workload, threads, max_shift=32):
+    """[(smallest size, thread count)] for sizes that are powers of two"""
+    ranges = []
+    for shift in range(max_shift + 1):
+        count = best_thread_count(db, workload, 1 << shift, threads)
+        if not ranges or ranges[-1][1] != count:
+            ranges.append((1 << shift, count))
+    return ranges
+
+
+parser = argparse.ArgumentParser(description='Measure and show the operator tuning database')
+parser.add_argument('dir', type=str, help='the MXNET_OPERATOR_TUNING_DIR to write')
+parser.add_argument('--show', action='store_true',
+                    help='only show the database measured before')
+parser.add_argument('--cores', type=int, default=0,
+                    help='the largest number of threads to time, '
+                         'MXNET_USE_NUM_CORES_OPERATOR_TUNING (default half the processors)')
+parser.add_argument('--threads', type=int, default=os.cpu_count(),
+                    help='the OMP threads available to a kernel in the table')
+parser.add_argument('--filter', type=str, default='',
+                    help='only show the kernels whose name contains this')
+args = parser.parse_args()
+
+if not args.show:
+    env = dict(os.environ, MXNET_OPERATOR_TUNING_DIR=args.dir, MXNET_OPERATOR_TUNING_REFRESH='1')
+    if args.cores:
+        env['MXNET_USE_NUM_CORES_OPERATOR_TUNING'] = str(args.cores)
+    subprocess.check_call([sys.executable, '-c', 'import mxnet'], env=env)
+
+path = os.path.join(args.dir, 'operator_tune_%s.json' % socket.gethostname())
+with open(path) as f:
+    db = json.load(f)
+print('%s: %d processors, OMP overhead %d ns' % (path, db['num_procs'], db['omp_overhead']))
+for threads, overhead in enumerate(db['omp_overhead_by_threads']):
+    if threads >= 2:
+        print('  %3d threads: %d ns' % (threads, overhead))
+for name, workload in sorted(db['workloads'].items()):
+    if args.filter in name:
+        ranges = ', '.join('%d from %d' % (count, size)
+                           for size, count in size_ranges(db, workload, args.threads))
+        print('%s: threads %s' % (name, ranges))